@@ -4,6 +4,7 @@ setlocal
 :: Parse command line arguments
 if "%1"=="test" set test=1
 if "%1"=="main" set main=1
+if "%1"=="bench" set bench=1
 if "%1"=="help" goto :help
 if "%1"=="-h" goto :help
 if "%1"=="?" goto :help
@@ -11,7 +12,7 @@ if "%1"=="?" goto :help
 if not exist build mkdir build
 
 :: Compiler flags with include paths
-set cl_common=/I../src /I../src/base /nologo /FC /Z7 /EHsc
+set cl_common=/I../src /I../src/base /nologo /FC /Z7 /EHsc /std:c++20
 set compile=call cl %cl_common%
 
 :: Build targets
@@ -19,6 +20,11 @@ if "%test%"=="1" (
     set target=../src/tester/tester_main.cpp
     set output=test.exe
     echo Building tests
+) else if "%bench%"=="1" (
+    set target=../src/bench/bench_main.cpp
+    set output=bench.exe
+    set compile=%compile% /O2
+    echo Building benchmarks
 ) else if "%main%"=="1" (
     set target=../src/entry/main.cpp
     set output=main.exe
@@ -48,6 +54,7 @@ echo.
 echo Targets:
 echo   test    - Build test executable
 echo   main    - Build main executable
+echo   bench   - Build optimised benchmark executable
 echo   (none)  - Build main executable (default)
 echo.
 echo Examples:
@@ -223,15 +223,26 @@ std::unique_ptr<ExpressionNode> Parser::parseNaryExpression(std::unique_ptr<Expr
     //first left and operand
 
     ExprKind kind;
-    if (curToken.Type == token::PLUS) { kind = ExprKind::PLUS;} 
+    if (curToken.Type == token::PLUS) { kind = ExprKind::PLUS;}
     else if (curToken.Type == token::MULT || curToken.Type == token::IMPLICIT_MULT ) { kind = ExprKind::MULTIPLY; }
-        
+
+    int precedence = currentPrecedence(); // get lbp
+
+    // If the left side is already an n-ary node of the same kind (a+b in a+b+c),
+    // keep appending to it instead of nesting a new node on top of it.
+    // Only n-ary nodes carry the PLUS/MULTIPLY kinds, so the cast is safe.
+    if (left && left->getKind() == kind) {
+        NaryExpressionNode* open = static_cast<NaryExpressionNode*>(left.get());
+        nextToken();
+        open->Operands.push_back(parseExpression(precedence));
+        return left;
+    }
+
     std::vector<std::unique_ptr<ExpressionNode>> operands;
     operands.push_back(std::move(left));
 
     std::unique_ptr<NaryExpressionNode> expr = std::make_unique<NaryExpressionNode>(curToken, *(curToken.Literal.c_str()), kind, std::move(operands));
 
-    int precedence = currentPrecedence(); // get lbp
     nextToken();
     expr->Operands.push_back(parseExpression(precedence));
 
@@ -0,0 +1,431 @@
+//////////////////
+// Sort
+
+// hi orders first: degree descending then kind for terms, kind for factors.
+// lo is the structural hash.
+struct CanonSortItem 
+{
+    U64 lo;
+    U32 hi;
+    U32 index;
+};
+
+#define CANON_INSERTION_SORT_MAX 48
+
+// LSD radix sort on bytes, skipping bytes every key shares. Returns whichever
+// of items and tmp ends up holding the sorted order.
+internal CanonSortItem *
+CanonSort(CanonSortItem *items, CanonSortItem *tmp, U64 count)
+{
+    if (count <= CANON_INSERTION_SORT_MAX)
+    {
+        for (U64 i = 1; i < count; i += 1)
+        {
+            CanonSortItem item = items[i];
+            U64 j = i;
+            for (; j > 0 && (items[j - 1].hi > item.hi || (items[j - 1].hi == item.hi && items[j - 1].lo > item.lo)); j -= 1) { items[j] = items[j - 1]; }
+            items[j] = item;
+        }
+        return items;
+    }
+
+    // One counting pass for all twelve digit positions
+    U32 histograms[12][256] = {};
+    for (U64 i = 0; i < count; i += 1)
+    {
+        for (U32 d = 0; d < 8; d += 1) { histograms[d][(items[i].lo >> (d * 8)) & 0xFF] += 1; }
+        for (U32 d = 0; d < 4; d += 1) { histograms[8 + d][(items[i].hi >> (d * 8)) & 0xFF] += 1; }
+    }
+    for (U32 d = 0; d < 12; d += 1)
+    {
+        U32 *histogram = histograms[d];
+        U32 digit0 = d < 8 ? (U32)((items[0].lo >> (d * 8)) & 0xFF) : (items[0].hi >> ((d - 8) * 8)) & 0xFF;
+        if (histogram[digit0] == count) { continue; }
+        U32 offset = 0;
+        for (U32 b = 0; b < 256; b += 1)
+        {
+            U32 n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (U64 i = 0; i < count; i += 1)
+        {
+            U32 digit = d < 8 ? (U32)((items[i].lo >> (d * 8)) & 0xFF) : (items[i].hi >> ((d - 8) * 8)) & 0xFF;
+            tmp[histogram[digit]++] = items[i];
+        }
+        CanonSortItem *swap = items;
+        items = tmp;
+        tmp = swap;
+    }
+    return items;
+}
+
+// Leaves before operators in a product, constants first. In a sum constants go last.
+internal U32 
+CanonKindRank(ExprKind kind, B32 sum)
+{
+    if (ExprKindIsInteger(kind)) { return sum ? 0xFF : 0; }
+    return (U32)kind + 1;
+}
+
+//////////////////
+// Terms
+
+struct CanonTerm 
+{
+    Expr *expr;             // the operand as written, kept when nothing changes
+    Expr *mono;             // the monomial when it is a node of its own
+    Expr **factors;         // monomial factors when it is not, a product's tail
+    U32 count;              // factors, 0 for a constant
+    B32 neg;                // read through a negation or the right of a difference
+    Integer coef;           // a negated one in scratch
+    U64 hash;               // of the monomial
+};
+
+internal Expr *
+CanonFactor(CanonTerm const *term, U32 index)
+{
+    return term->factors ? term->factors[index] : term->mono;
+}
+
+// Canonical products put their constant first, so coefficients are found there.
+// 0 when scratch runs out.
+internal B32 
+CanonReadTerm(Arena *scratch, Expr *expr, B32 neg, CanonTerm *out)
+{
+    *out = {expr, expr, nullptr, 1, neg, IntFromS64(1), 0};
+    if (ExprKindIsInteger(expr->kind))
+    {
+        out->mono = nullptr;
+        out->count = 0;
+        out->coef = ExprInteger(expr);
+    }
+    else if (expr->kind == ExprKind::MULTIPLY && ExprKindIsInteger(expr->operands[0]->kind))
+    {
+        out->coef = ExprInteger(expr->operands[0]);
+        out->count = expr->count - 1;
+        if (out->count == 1) { out->mono = expr->operands[1]; }
+        else                 { out->mono = nullptr; out->factors = expr->operands + 1; }
+
+        // 2*(x*y) reads like 2*x*y
+        if (out->mono && out->mono->kind == ExprKind::MULTIPLY)
+        {
+            out->count = out->mono->count;
+            out->factors = out->mono->operands;
+        }
+    }
+    else if (expr->kind == ExprKind::MULTIPLY)
+    {
+        out->count = expr->count;
+        out->factors = expr->operands;
+    }
+
+    if (neg && !IntNegate(scratch, out->coef, &out->coef)) { return 0; }
+
+    if (out->count == 1) { out->hash = CanonFactor(out, 0)->hash; }
+    else if (out->count > 1)
+    {
+        U64 acc = 0;
+        for (U32 i = 0; i < out->count; i += 1) { acc = ExprHashNaryAdd(acc, out->factors[i]->hash); }
+        out->hash = ExprHashNary(ExprKind::MULTIPLY, acc, out->count);
+    }
+    return 1;
+}
+
+internal CanonSortItem 
+CanonTermKey(CanonTerm const *term, U32 index)
+{
+    U32 degree = 0;
+    for (U32 i = 0; i < term->count; i += 1) { degree += CanonFactor(term, i)->kind == ExprKind::VAR; }
+    ExprKind kind = term->count ? CanonFactor(term, 0)->kind : ExprKind::NUM;
+    U32 hi = ((0xFFFF - ClampTop<U32>(degree, 0xFFFF)) << 8) | CanonKindRank(kind, 1);
+    return {term->hash, hi, index};
+}
+
+internal B32 
+CanonSameMonomial(Arena *scratch, CanonTerm const *a, CanonTerm const *b)
+{
+    if (a->count != b->count || a->hash != b->hash) { return 0; }
+    for (U32 i = 0; i < a->count; i += 1)
+    {
+        Expr *fa = CanonFactor(a, i);
+        Expr *fb = CanonFactor(b, i);
+        if (fa != fb && !ExprMatch(scratch, fa, fb)) { return 0; }
+    }
+    return 1;
+}
+
+// coef times the monomial, reusing the operand as written when it is unchanged
+internal Expr *
+CanonBuildTerm(Arena *arena, Arena *scratch, CanonTerm const *term, Integer coef, B32 changed)
+{
+    if (!changed) { return term->expr; }
+    if (term->count == 0) { return ExprPushInteger(arena, coef); }
+    Expr *mono = term->mono;
+    if (IntIsSmall(coef) && (coef.small == 1 || coef.small == -1))
+    {
+        if (!mono && !(mono = ExprPushNary(arena, ExprKind::MULTIPLY, term->factors, term->count))) { return nullptr; }
+        return coef.small == 1 ? mono : ExprPushUnary(arena, mono);
+    }
+
+    // Any other coefficient goes in front of the monomial's factors
+    U32 count = term->count;
+    Expr **factors = term->factors;
+    if (mono && mono->kind == ExprKind::MULTIPLY) { count = mono->count; factors = mono->operands; }
+    else if (mono)                                { count = 1; factors = &mono; }
+    U64 pos = scratch->ArenaGetPos();
+    Expr **ops = scratch->PushArrayNoZero<Expr *>((U64)count + 1);
+    Expr *num = ops ? ExprPushInteger(arena, coef) : nullptr;
+    Expr *product = nullptr;
+    if (num)
+    {
+        ops[0] = num;
+        MemoryCopy(ops + 1, factors, sizeof(Expr *) * count);
+        product = ExprPushNary(arena, ExprKind::MULTIPLY, ops, count + 1);
+    }
+    scratch->ArenaSetPosBack(pos);
+    return product;
+}
+
+//////////////////
+// Rewrites
+
+internal B32 
+CanonInSum(ExprKind kind)
+{
+    return kind == ExprKind::PLUS || kind == ExprKind::DIFFERENCE;
+}
+
+// Reads the whole region under root, sorts and collects, and rewrites root into
+// the sum of what is left
+internal Expr *
+CanonSum(Arena *arena, Arena *scratch, Expr *root, CanonReport *report)
+{
+    struct Signed { Expr *expr; B32 neg; };
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0, term_count = 0, term_cap = 0;
+    Signed *stack = ArenaGrowArray(scratch, (Signed *)nullptr, count, &cap);
+    CanonTerm *terms = ArenaGrowArray(scratch, (CanonTerm *)nullptr, term_count, &term_cap);
+    B32 ok = stack && terms;
+    if (ok) { stack[count++] = {root, 0}; }
+    while (ok && count)
+    {
+        Signed top = stack[--count];
+        Expr *expr = top.expr;
+        U32 children = ExprChildCount(expr);
+        B32 region = CanonInSum(expr->kind) || (expr->kind == ExprKind::PRE_UNARY_MINUS && top.expr != root);
+        if (!region)
+        {
+            if (term_count == term_cap && !(terms = ArenaGrowArray(scratch, terms, term_count, &term_cap))) { ok = 0; break; }
+            ok = CanonReadTerm(scratch, expr, top.neg, &terms[term_count++]);
+            continue;
+        }
+        // Reversed so terms are read left to right
+        for (U32 i = children; i > 0; i -= 1)
+        {
+            B32 flip = expr->kind == ExprKind::PRE_UNARY_MINUS || (expr->kind == ExprKind::DIFFERENCE && i == 2);
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {ExprChild(expr, i - 1), top.neg ^ flip};
+        }
+    }
+
+    CanonSortItem *items = ok ? scratch->PushArrayNoZero<CanonSortItem>(term_count) : nullptr;
+    CanonSortItem *tmp = ok ? scratch->PushArrayNoZero<CanonSortItem>(term_count) : nullptr;
+    U8 *absorbed = ok ? scratch->PushArray<U8>(term_count) : nullptr;
+    Expr **out = ok ? scratch->PushArrayNoZero<Expr *>(term_count) : nullptr;
+    ok = items && tmp && absorbed && out;
+    U64 out_count = 0;
+    if (ok)
+    {
+        for (U64 i = 0; i < term_count; i += 1) { items[i] = CanonTermKey(&terms[i], (U32)i); }
+        items = CanonSort(items, tmp, term_count);
+
+        // Equal monomials share a key, so each run of equal keys is collected on
+        // its own. Within a run everything usually matches the first term, the
+        // quadratic scan only sees hash collisions.
+        for (U64 start = 0; ok && start < term_count; )
+        {
+            U64 end = start + 1;
+            while (end < term_count && items[end].lo == items[start].lo && items[end].hi == items[start].hi) { end += 1; }
+            for (U64 i = start; ok && i < end; i += 1)
+            {
+                if (absorbed[i]) { continue; }
+                CanonTerm *first = &terms[items[i].index];
+                Integer coef = first->coef;
+                B32 changed = first->neg;
+                for (U64 j = i + 1; ok && j < end; j += 1)
+                {
+                    CanonTerm *other = &terms[items[j].index];
+                    if (absorbed[j] || !CanonSameMonomial(scratch, first, other)) { continue; }
+                    ok = IntAdd(scratch, coef, other->coef, &coef);
+                    changed = 1;
+                    absorbed[j] = 1;
+                }
+                if (!ok) { break; }
+                if (IntSign(coef) == 0) { continue; }
+                Expr *term = CanonBuildTerm(arena, scratch, first, coef, changed);
+                if (!term) { ok = 0; break; }
+                out[out_count++] = term;
+            }
+            start = end;
+        }
+    }
+
+    Expr *result = nullptr;
+    if (ok)
+    {
+        report->sums += 1;
+        report->terms_in += term_count;
+        report->terms_out += out_count;
+        if (out_count == 0)      { result = ExprPushNum(arena, 0); }
+        else if (out_count == 1) { result = out[0]; }
+        else
+        {
+            // In place when the node already has room, the usual case for a PLUS root
+            Expr **dst = root->kind == ExprKind::PLUS && out_count <= root->count ? root->operands : arena->PushArrayNoZero<Expr *>(out_count);
+            if (dst)
+            {
+                MemoryCopy(dst, out, sizeof(Expr *) * out_count);
+                U64 acc = 0;
+                for (U64 i = 0; i < out_count; i += 1) { acc = ExprHashNaryAdd(acc, dst[i]->hash); }
+                root->kind = ExprKind::PLUS;
+                root->count = (U32)out_count;
+                root->operands = dst;
+                root->hash = ExprHashNary(ExprKind::PLUS, acc, (U32)out_count);
+                result = root;
+            }
+        }
+    }
+    scratch->ArenaSetPosBack(pos);
+    return result;
+}
+
+// Constant factors fold into one in front, the rest are sorted
+internal Expr *
+CanonProduct(Arena *arena, Arena *scratch, Expr *expr, CanonReport *report)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U32 count = expr->count;
+    CanonSortItem *items = scratch->PushArrayNoZero<CanonSortItem>(count);
+    CanonSortItem *tmp = scratch->PushArrayNoZero<CanonSortItem>(count);
+    Expr **ops = scratch->PushArrayNoZero<Expr *>(count);
+    if (!items || !tmp || !ops) { scratch->ArenaSetPosBack(pos); return nullptr; }
+
+    Integer constant = IntFromS64(1);
+    U32 constants = 0, kept = 0;
+    Expr *first_constant = nullptr;
+    for (U32 i = 0; i < count; i += 1)
+    {
+        Expr *op = expr->operands[i];
+        if (ExprKindIsInteger(op->kind))
+        {
+            if (!IntMul(scratch, constant, ExprInteger(op), &constant)) { scratch->ArenaSetPosBack(pos); return nullptr; }
+            constants += 1;
+            if (!first_constant) { first_constant = op; }
+            continue;
+        }
+        items[kept] = {op->hash, CanonKindRank(op->kind, 0), kept};
+        ops[kept++] = op;
+    }
+    items = CanonSort(items, tmp, kept);
+
+    Expr *result = expr;
+    B32 one = IntCompare(constant, IntFromS64(1)) == 0;
+    if (IntSign(constant) == 0 || kept == 0) { result = ExprPushInteger(arena, constant); }
+    else if (kept == 1 && one)               { result = ops[0]; }
+    else
+    {
+        U32 lead = !one;
+        Expr *num = constants == 1 ? first_constant : lead ? ExprPushInteger(arena, constant) : nullptr;
+        if (lead && !num) { result = nullptr; }
+        else
+        {
+            // Never more operands than before, so the array is reused
+            U64 acc = 0;
+            if (lead) { expr->operands[0] = num; }
+            for (U32 i = 0; i < kept; i += 1) { expr->operands[lead + i] = ops[items[i].index]; }
+            expr->count = lead + kept;
+            for (U32 i = 0; i < expr->count; i += 1) { acc = ExprHashNaryAdd(acc, expr->operands[i]->hash); }
+            expr->hash = ExprHashNary(ExprKind::MULTIPLY, acc, expr->count);
+        }
+    }
+    report->products += 1;
+    scratch->ArenaSetPosBack(pos);
+    return result;
+}
+
+//////////////////
+// Pass
+
+internal Expr *
+ExprCanonicalize(Arena *arena, Arena *scratch, Expr *root, CanonReport *report)
+{
+    // Postorder. A node inside a sum region only takes its children's results,
+    // the region's root reads the region in one go once they are all in.
+    struct Frame { Expr *expr; U32 next; B32 inner; };
+
+    CanonReport counts = {};
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0, done_count = 0, done_cap = 0;
+    Frame *stack = nullptr;
+    Expr **done = nullptr;
+
+    Expr *result = nullptr;
+    B32 ok = (stack = ArenaGrowArray(scratch, stack, count, &cap)) != nullptr;
+    if (ok) { stack[count++] = {root, 0, 0}; }
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        U32 children = ExprChildCount(expr);
+        if (top->next < children)
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            B32 region = CanonInSum(expr->kind) || (expr->kind == ExprKind::PRE_UNARY_MINUS && top->inner);
+            B32 inner = region && (CanonInSum(child->kind) || child->kind == ExprKind::PRE_UNARY_MINUS);
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0, inner};
+            continue;
+        }
+
+        // Children's results go back into the node, rehashed unless it is rebuilt below
+        Expr **ops = done + done_count - children;
+        switch (expr->kind)
+        {
+            case ExprKind::PRE_UNARY_MINUS: { expr->operand = ops[0]; expr->hash = ExprHashUnary(ops[0]->hash); } break;
+            case ExprKind::DIFFERENCE:
+            case ExprKind::QUOTIENT:
+            {
+                expr->bin.left = ops[0];
+                expr->bin.right = ops[1];
+                expr->hash = ExprHashBinary(expr->kind, ops[0]->hash, ops[1]->hash);
+            } break;
+            case ExprKind::PLUS:
+            case ExprKind::MULTIPLY: { MemoryCopy(expr->operands, ops, sizeof(Expr *) * children); } break;
+            default: break;
+        }
+        done_count -= children;
+
+        Expr *rewritten = expr;
+        if (!top->inner && CanonInSum(expr->kind))  { rewritten = CanonSum(arena, scratch, expr, &counts); }
+        else if (expr->kind == ExprKind::MULTIPLY)  { rewritten = CanonProduct(arena, scratch, expr, &counts); }
+        else if (expr->kind == ExprKind::PLUS)
+        {
+            U64 acc = 0;
+            for (U32 i = 0; i < children; i += 1) { acc = ExprHashNaryAdd(acc, ops[i]->hash); }
+            expr->hash = ExprHashNary(ExprKind::PLUS, acc, children);
+        }
+        if (!rewritten) { ok = 0; break; }
+
+        count -= 1;
+        if (count == 0) { result = rewritten; break; }
+        if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+        done[done_count++] = rewritten;
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (report) { *report = counts; }
+    return ok ? result : nullptr;
+}
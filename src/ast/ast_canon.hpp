@@ -0,0 +1,32 @@
+/*
+ast_canon.hpp
+
+Canonical operand order with like terms collected. Every maximal sum (PLUS,
+DIFFERENCE and the negations inside them) is read as signed terms, a term being
+an integer coefficient times a monomial: 2x + 3x + y - x has the terms 2*x, 3*x,
+1*y and -1*x. Each term gets a sort key (degree, kind, structural hash of the
+monomial), the keys are radix sorted so equal monomials end up next to each
+other, and one sweep adds up their coefficients: 4*x + y. Products are sorted
+the same way with their constant factors folded in front.
+
+Equal inputs up to commutativity come out as the same tree. The order within a
+degree follows the hash, so it is deterministic but not alphabetical.
+Coefficients are exact integers of any size. Work is linear in the tree apart
+from the sort.
+*/
+#ifndef AST_CANON_HPP
+#define AST_CANON_HPP
+
+struct CanonReport 
+{
+    U64 sums;               // sum regions rebuilt
+    U64 products;           // products sorted
+    U64 terms_in;           // terms read from the sums
+    U64 terms_out;          // terms left after collecting, zero terms dropped
+};
+
+// Sum roots and products are rewritten in place, so root is consumed. The
+// result may be a new node or a descendant of root, nullptr when an arena runs out.
+internal Expr *ExprCanonicalize(Arena *arena, Arena *scratch, Expr *root, CanonReport *report = nullptr);
+
+#endif // AST_CANON_HPP
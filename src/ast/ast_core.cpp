@@ -0,0 +1,299 @@
+//////////////////
+// Kind helpers
+
+internal char 
+ExprKindOperator(ExprKind kind)
+{
+    switch (kind)
+    {
+        case ExprKind::PRE_UNARY_MINUS: return '-';
+        case ExprKind::PLUS:            return '+';
+        case ExprKind::MULTIPLY:        return '*';
+        case ExprKind::DIFFERENCE:      return '-';
+        case ExprKind::QUOTIENT:        return '/';
+        default:                        return 0;
+    }
+}
+
+// Same scale as the binding powers in parse_grammar.hpp
+internal int 
+ExprKindPrecedence(ExprKind kind)
+{
+    switch (kind)
+    {
+        case ExprKind::PLUS:
+        case ExprKind::DIFFERENCE:      return 10;
+        case ExprKind::MULTIPLY:
+        case ExprKind::QUOTIENT:        return 20;
+        case ExprKind::PRE_UNARY_MINUS: return 30;
+        default:                        return 40;
+    }
+}
+
+internal B32 
+ExprChildNeedsParens(ExprKind parent, ExprKind child, U32 index)
+{
+    int parent_power = ExprKindPrecedence(parent);
+    int child_power = ExprKindPrecedence(child);
+    // Everything is left associative, a - (b - c) and a + (b + c) keep theirs
+    return child_power < parent_power || (child_power == parent_power && index > 0);
+}
+
+//////////////////
+// Hashing
+
+internal U64 
+ExprHashNum(S64 value)
+{
+    return HashCombine(HashU64((U64)ExprKind::NUM + 1), (U64)value);
+}
+
+internal U64 
+ExprHashInteger(Integer value)
+{
+    if (!value.big) { return ExprHashNum(value.small); }
+    U64 limbs = HashBytes(value.big->limbs, sizeof(U64) * value.big->count, value.big->neg);
+    return HashCombine(HashU64((U64)ExprKind::BIG_NUM + 1), limbs);
+}
+
+internal U64 
+ExprHashVar(String8 name)
+{
+    return HashCombine(HashU64((U64)ExprKind::VAR + 1), HashBytes(name.str, name.size, 0));
+}
+
+internal U64 
+ExprHashUnary(U64 operand)
+{
+    return HashCombine(HashU64((U64)ExprKind::PRE_UNARY_MINUS + 1), operand);
+}
+
+internal U64 
+ExprHashBinary(ExprKind kind, U64 left, U64 right)
+{
+    return HashCombine(HashCombine(HashU64((U64)kind + 1), left), right);
+}
+
+internal U64 
+ExprHashNaryAdd(U64 acc, U64 operand)
+{
+    // A wrapping sum of mixed hashes: order free, and repeats still count
+    return acc + HashU64(operand);
+}
+
+internal U64 
+ExprHashNary(ExprKind kind, U64 acc, U32 count)
+{
+    return HashCombine(HashCombine(HashU64((U64)kind + 1), count), acc);
+}
+
+internal U64 
+ExprHash(Expr *expr)
+{
+    return expr->hash;
+}
+
+internal B32 
+ExprMaybeEqual(Expr *a, Expr *b)
+{
+    return a->hash == b->hash;
+}
+
+//////////////////
+// Construction
+
+internal Expr *
+ExprPushNum(Arena *arena, S64 value)
+{
+    Expr *expr = arena->PushArray<Expr>(1);
+    if (!expr) { return nullptr; }
+    expr->kind = ExprKind::NUM;
+    expr->num = value;
+    expr->hash = ExprHashNum(value);
+    return expr;
+}
+
+internal Expr *
+ExprPushInteger(Arena *arena, Integer value)
+{
+    if (!value.big) { return ExprPushNum(arena, value.small); }
+    Expr *expr = arena->PushArray<Expr>(1);
+    if (!expr || !IntCopy(arena, value, &value)) { return nullptr; }
+    expr->kind = ExprKind::BIG_NUM;
+    expr->big = value.big;
+    expr->hash = ExprHashInteger(value);
+    return expr;
+}
+
+internal Expr *
+ExprPushVar(Arena *arena, String8 name)
+{
+    Expr *expr = arena->PushArray<Expr>(1);
+    if (!expr) { return nullptr; }
+    expr->kind = ExprKind::VAR;
+    expr->var = PushStr8Copy(arena, name);
+    if (!expr->var.str) { return nullptr; }
+    expr->hash = ExprHashVar(name);
+    return expr;
+}
+
+internal Expr *
+ExprPushUnary(Arena *arena, Expr *operand)
+{
+    Expr *expr = arena->PushArray<Expr>(1);
+    if (!expr) { return nullptr; }
+    expr->kind = ExprKind::PRE_UNARY_MINUS;
+    expr->operand = operand;
+    expr->hash = ExprHashUnary(operand ? operand->hash : 0);
+    return expr;
+}
+
+internal Expr *
+ExprPushBinary(Arena *arena, ExprKind kind, Expr *left, Expr *right)
+{
+    Expr *expr = arena->PushArray<Expr>(1);
+    if (!expr) { return nullptr; }
+    expr->kind = kind;
+    expr->bin.left = left;
+    expr->bin.right = right;
+    expr->hash = ExprHashBinary(kind, left ? left->hash : 0, right ? right->hash : 0);
+    return expr;
+}
+
+internal Expr *
+ExprPushNary(Arena *arena, ExprKind kind, Expr **ops, U32 count)
+{
+    Expr *expr = arena->PushArray<Expr>(1);
+    Expr **copy = arena->PushArrayNoZero<Expr *>(count);
+    if (!expr || !copy) { return nullptr; }
+    MemoryCopy(copy, ops, sizeof(Expr *) * count);
+    expr->kind = kind;
+    expr->count = count;
+    expr->operands = copy;
+    U64 acc = 0;
+    for (U32 i = 0; i < count; i += 1) { acc = ExprHashNaryAdd(acc, ops[i] ? ops[i]->hash : 0); }
+    expr->hash = ExprHashNary(kind, acc, count);
+    return expr;
+}
+
+//////////////////
+// Children access
+
+internal U32 
+ExprChildCount(Expr *expr)
+{
+    switch (expr->kind)
+    {
+        case ExprKind::PRE_UNARY_MINUS: return 1;
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT:        return 2;
+        case ExprKind::PLUS:
+        case ExprKind::MULTIPLY:        return expr->count;
+        default:                        return 0;
+    }
+}
+
+internal Expr *
+ExprChild(Expr *expr, U32 index)
+{
+    switch (expr->kind)
+    {
+        case ExprKind::PRE_UNARY_MINUS: return expr->operand;
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT:        return index == 0 ? expr->bin.left : expr->bin.right;
+        case ExprKind::PLUS:
+        case ExprKind::MULTIPLY:        return expr->operands[index];
+        default:                        return nullptr;
+    }
+}
+
+internal Integer 
+ExprInteger(Expr *expr)
+{
+    if (expr->kind == ExprKind::BIG_NUM) { return {0, expr->big}; }
+    return IntFromS64(expr->num);
+}
+
+//////////////////
+// Comparison
+
+internal B32 
+ExprMatchNode(Expr *a, Expr *b)
+{
+    if (a->kind != b->kind || a->hash != b->hash) { return 0; }
+    switch (a->kind)
+    {
+        case ExprKind::NUM: return a->num == b->num;
+        case ExprKind::BIG_NUM: return IntCompare(ExprInteger(a), ExprInteger(b)) == 0;
+        case ExprKind::VAR: return Str8Match(a->var, b->var);
+        case ExprKind::PLUS:
+        case ExprKind::MULTIPLY: return a->count == b->count;
+        default: return 1;
+    }
+}
+
+internal B32 
+ExprMatch(Arena *scratch, Expr *a, Expr *b)
+{
+    struct Pair { Expr *a, *b; };
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0;
+    Pair *stack = nullptr;
+
+    B32 match = 1;
+    Pair top = {a, b};
+    for (;;)
+    {
+        if (top.a != top.b)
+        {
+            if (!top.a || !top.b || !ExprMatchNode(top.a, top.b)) { match = 0; break; }
+            U32 children = ExprChildCount(top.a);
+            for (U32 i = 0; i < children && match; i += 1)
+            {
+                if (count == cap)
+                {
+                    stack = ArenaGrowArray(scratch, stack, count, &cap);
+                    if (!stack) { match = 0; break; }
+                }
+                stack[count++] = {ExprChild(top.a, i), ExprChild(top.b, i)};
+            }
+            if (!match) { break; }
+        }
+        if (count == 0) { break; }
+        top = stack[--count];
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    return match;
+}
+
+internal U64 
+ExprDedup(Arena *scratch, Expr **exprs, U64 count, U32 *ids)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U64 cap = 16;
+    while (cap < count * 2) { cap <<= 1; }
+    U64 *table = scratch->PushArray<U64>(cap);    // index into exprs + 1, 0 is empty
+    if (!table) { return 0; }
+
+    // Probe on the cached hash, only a hash hit pays for the full compare
+    U64 unique = 0;
+    for (U64 i = 0; i < count; i += 1)
+    {
+        U64 slot = exprs[i]->hash & (cap - 1);
+        for (; table[slot]; slot = (slot + 1) & (cap - 1))
+        {
+            Expr *other = exprs[table[slot] - 1];
+            if (other->hash == exprs[i]->hash && ExprMatch(scratch, other, exprs[i])) { break; }
+        }
+        if (!table[slot])
+        {
+            table[slot] = i + 1;
+            ids[i] = (U32)unique++;
+        }
+        else { ids[i] = ids[table[slot] - 1]; }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    return unique;
+}
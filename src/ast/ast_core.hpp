@@ -0,0 +1,100 @@
+/*
+ast_core.hpp
+
+Arena allocated expression nodes. Replaces the unique_ptr/virtual hierarchy in old/ast.hpp,
+kinds keep their old names so the two can be read side by side.
+*/
+#ifndef AST_CORE_HPP
+#define AST_CORE_HPP
+
+// BIG_NUM is an integer literal outside S64, it only appears where NUM would
+enum class ExprKind : U8 {NUM, VAR, PRE_UNARY_MINUS, PLUS, MULTIPLY, DIFFERENCE, QUOTIENT, BIG_NUM, COUNT};
+
+// Plain data, no constructors. Build through the ExprPush* helpers below.
+struct Expr 
+{
+    ExprKind kind;
+    U32 count;                              // operand count, PLUS/MULTIPLY only
+    U64 hash;                               // structural, set at construction, see ExprHash*
+
+    union 
+    {
+        S64 num;                            // NUM
+        BigInt *big;                        // BIG_NUM, limbs in the arena
+        String8 var;                        // VAR, name copied into the arena
+        Expr *operand;                      // PRE_UNARY_MINUS
+        struct { Expr *left, *right; } bin; // DIFFERENCE, QUOTIENT
+        Expr **operands;                    // PLUS, MULTIPLY
+    };
+};
+static_assert(sizeof(Expr) >= 16 && sizeof(Expr) <= 32, "Expr should stay within 16-32 bytes");
+
+//////////////////
+// Kind helpers
+
+// constexpr so compile-time parsing (parse_static.hpp) can use them
+internal constexpr B32 ExprKindIsNary(ExprKind kind) { return kind == ExprKind::PLUS || kind == ExprKind::MULTIPLY; }
+internal constexpr B32 ExprKindIsBinary(ExprKind kind) { return kind == ExprKind::DIFFERENCE || kind == ExprKind::QUOTIENT; }
+internal constexpr B32 ExprKindIsInteger(ExprKind kind) { return kind == ExprKind::NUM || kind == ExprKind::BIG_NUM; }
+internal constexpr B32 ExprKindIsLeaf(ExprKind kind) { return ExprKindIsInteger(kind) || kind == ExprKind::VAR; }
+internal char ExprKindOperator(ExprKind kind);
+// Binding strength when printing, leaves bind tightest
+internal int ExprKindPrecedence(ExprKind kind);
+// Whether child, at operand position index of parent, must be parenthesised to
+// read back as the same tree
+internal B32 ExprChildNeedsParens(ExprKind parent, ExprKind child, U32 index);
+
+//////////////////
+// Construction
+// All return nullptr when the arena runs out
+
+internal Expr *ExprPushNum(Arena *arena, S64 value);
+// NUM when the value fits S64, BIG_NUM with the limbs copied otherwise
+internal Expr *ExprPushInteger(Arena *arena, Integer value);
+internal Expr *ExprPushVar(Arena *arena, String8 name);
+internal Expr *ExprPushUnary(Arena *arena, Expr *operand);
+internal Expr *ExprPushBinary(Arena *arena, ExprKind kind, Expr *left, Expr *right);
+// Copies the operand pointers, so ops can live in scratch memory
+internal Expr *ExprPushNary(Arena *arena, ExprKind kind, Expr **ops, U32 count);
+
+//////////////////
+// Children access, uniform over all kinds
+
+internal U32 ExprChildCount(Expr *expr);
+internal Expr *ExprChild(Expr *expr, U32 index);
+// Value of a NUM or BIG_NUM, sharing the node's limbs
+internal Integer ExprInteger(Expr *expr);
+
+//////////////////
+// Hashing
+// Merkle style: a node's hash covers its literal and its children's hashes.
+// PLUS/MULTIPLY combine operands commutatively, so a + b and b + a hash equal.
+// Equal trees always hash equal, different hashes mean different trees.
+
+internal U64 ExprHashNum(S64 value);
+// Same as ExprHashNum for values that fit S64
+internal U64 ExprHashInteger(Integer value);
+internal U64 ExprHashVar(String8 name);
+internal U64 ExprHashUnary(U64 operand);
+internal U64 ExprHashBinary(ExprKind kind, U64 left, U64 right);
+// Operands are folded into acc one at a time, starting from 0, in any order
+internal U64 ExprHashNaryAdd(U64 acc, U64 operand);
+internal U64 ExprHashNary(ExprKind kind, U64 acc, U32 count);
+
+internal U64 ExprHash(Expr *expr);
+// Cheap rejection before a full ExprMatch
+internal B32 ExprMaybeEqual(Expr *a, Expr *b);
+
+//////////////////
+// Comparison
+
+// Structural equality, walks both trees with an explicit stack in scratch.
+// Also reports 0 if scratch runs out.
+internal B32 ExprMatch(Arena *scratch, Expr *a, Expr *b);
+
+// Numbers a batch of expressions so that ExprMatch-equal ones share an id, ids
+// count up from 0 in order of first appearance. Returns the number of distinct
+// expressions, or 0 if scratch runs out.
+internal U64 ExprDedup(Arena *scratch, Expr **exprs, U64 count, U32 *ids);
+
+#endif // AST_CORE_HPP
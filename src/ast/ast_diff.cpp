@@ -0,0 +1,437 @@
+//////////////////
+// State
+
+struct Diff 
+{
+    ExprInterner *interner;
+    Arena *scratch;
+    String8 var;
+    Expr *zero;
+    Expr *one;
+    Expr **keys;                    // node -> its derivative, open addressing
+    Expr **values;
+    U64 cap;
+    U64 count;
+    DiffReport report;
+    B32 ok;
+};
+
+internal B32 
+DiffIsNum(Expr *expr, S64 value)
+{
+    return expr->kind == ExprKind::NUM && expr->num == value;
+}
+
+internal Expr * 
+DiffDone(Diff *d, Expr *expr)
+{
+    U64 slot = HashU64((U64)(uintptr_t)expr) & (d->cap - 1);
+    while (d->keys[slot])
+    {
+        if (d->keys[slot] == expr) { return d->values[slot]; }
+        slot = (slot + 1) & (d->cap - 1);
+    }
+    return nullptr;
+}
+
+internal void 
+DiffSetDone(Diff *d, Expr *expr, Expr *derivative)
+{
+    if ((d->count + 1) * 2 > d->cap)
+    {
+        U64 cap = d->cap * 2;
+        Expr **keys = d->scratch->PushArray<Expr *>(cap);
+        Expr **values = d->scratch->PushArrayNoZero<Expr *>(cap);
+        if (!keys || !values) { d->ok = 0; return; }
+        for (U64 i = 0; i < d->cap; i += 1)
+        {
+            if (!d->keys[i]) { continue; }
+            U64 slot = HashU64((U64)(uintptr_t)d->keys[i]) & (cap - 1);
+            while (keys[slot]) { slot = (slot + 1) & (cap - 1); }
+            keys[slot] = d->keys[i];
+            values[slot] = d->values[i];
+        }
+        d->keys = keys;
+        d->values = values;
+        d->cap = cap;
+    }
+    U64 slot = HashU64((U64)(uintptr_t)expr) & (d->cap - 1);
+    while (d->keys[slot]) { slot = (slot + 1) & (d->cap - 1); }
+    d->keys[slot] = expr;
+    d->values[slot] = derivative;
+    d->count += 1;
+}
+
+internal Expr ** 
+DiffOps(Diff *d, U64 count)
+{
+    Expr **ops = d->scratch->PushArrayNoZero<Expr *>(Max<U64>(count, 1));
+    if (!ops) { d->ok = 0; }
+    return ops;
+}
+
+internal Expr * 
+DiffCheck(Diff *d, Expr *expr)
+{
+    if (!expr) { d->ok = 0; }
+    return expr;
+}
+
+//////////////////
+// Simplifying constructors
+// All take interned operands and return nullptr with d->ok cleared when an arena runs out
+
+internal Expr * 
+DiffNum(Diff *d, S64 value)
+{
+    if (value == 0) { return d->zero; }
+    if (value == 1) { return d->one; }
+    return DiffCheck(d, ExprInternNum(d->interner, value));
+}
+
+internal Expr * 
+DiffNegate(Diff *d, Expr *a)
+{
+    if (!d->ok) { return nullptr; }
+    S64 value;
+    if (a->kind == ExprKind::NUM && MulS64Checked(a->num, -1, &value))
+    {
+        d->report.simplified += 1;
+        return DiffNum(d, value);
+    }
+    if (a->kind == ExprKind::PRE_UNARY_MINUS)
+    {
+        d->report.simplified += 1;
+        return a->operand;
+    }
+    return DiffCheck(d, ExprInternUnary(d->interner, a));
+}
+
+// ops is consumed
+internal Expr * 
+DiffSum(Diff *d, Expr **ops, U32 count)
+{
+    if (!d->ok) { return nullptr; }
+    S64 constant = 0;
+    U32 kept = 0;
+    for (U32 i = 0; i < count; i += 1)
+    {
+        S64 sum;
+        if (ops[i]->kind == ExprKind::NUM && AddS64Checked(constant, ops[i]->num, &sum))
+        {
+            if (ops[i]->num == 0 || constant != 0) { d->report.simplified += 1; }
+            constant = sum;
+            continue;
+        }
+        ops[kept++] = ops[i];
+    }
+    if (constant != 0) { ops[kept++] = DiffNum(d, constant); }
+    if (!d->ok) { return nullptr; }
+    if (kept == 0) { return d->zero; }
+    if (kept == 1) { return ops[0]; }
+    return DiffCheck(d, ExprInternNary(d->interner, ExprKind::PLUS, ops, kept));
+}
+
+// ops is consumed. Negated factors and the sign of the constant are pulled out
+// in front, the remaining constant goes first.
+internal Expr * 
+DiffProduct(Diff *d, Expr **ops, U32 count)
+{
+    if (!d->ok) { return nullptr; }
+    S64 constant = 1;
+    B32 negate = 0;
+    U32 kept = 0;
+    for (U32 i = 0; i < count; i += 1)
+    {
+        Expr *op = ops[i];
+        if (DiffIsNum(op, 0))
+        {
+            d->report.simplified += 1;
+            return d->zero;
+        }
+        while (op->kind == ExprKind::PRE_UNARY_MINUS)
+        {
+            negate = !negate;
+            op = op->operand;
+            d->report.simplified += 1;
+        }
+        S64 product;
+        if (op->kind == ExprKind::NUM && MulS64Checked(constant, op->num, &product))
+        {
+            if (op->num == 1 || constant != 1) { d->report.simplified += 1; }
+            constant = product;
+            continue;
+        }
+        ops[kept++] = op;
+    }
+    S64 positive;
+    if (constant == 0) { return d->zero; }
+    if (constant < 0 && MulS64Checked(constant, -1, &positive))
+    {
+        constant = positive;
+        negate = !negate;
+    }
+
+    Expr *result = nullptr;
+    if (kept == 0) { result = DiffNum(d, constant); }
+    else if (constant == 1 && kept == 1) { result = ops[0]; }
+    else
+    {
+        if (constant != 1)
+        {
+            // The constant goes first, the op it displaces goes last
+            ops[kept++] = ops[0];
+            ops[0] = DiffNum(d, constant);
+        }
+        if (!d->ok) { return nullptr; }
+        result = DiffCheck(d, ExprInternNary(d->interner, ExprKind::MULTIPLY, ops, kept));
+    }
+    if (!d->ok) { return nullptr; }
+    return negate ? DiffNegate(d, result) : result;
+}
+
+internal Expr * 
+DiffProduct2(Diff *d, Expr *a, Expr *b)
+{
+    Expr **ops = DiffOps(d, 3);
+    if (!ops) { return nullptr; }
+    ops[0] = a;
+    ops[1] = b;
+    return DiffProduct(d, ops, 2);
+}
+
+internal Expr * 
+DiffDifference(Diff *d, Expr *a, Expr *b)
+{
+    if (!d->ok) { return nullptr; }
+    S64 value;
+    if (a == b)
+    {
+        d->report.simplified += 1;
+        return d->zero;
+    }
+    if (DiffIsNum(b, 0))
+    {
+        d->report.simplified += 1;
+        return a;
+    }
+    if (DiffIsNum(a, 0))
+    {
+        d->report.simplified += 1;
+        return DiffNegate(d, b);
+    }
+    if (a->kind == ExprKind::NUM && b->kind == ExprKind::NUM && SubS64Checked(a->num, b->num, &value))
+    {
+        d->report.simplified += 1;
+        return DiffNum(d, value);
+    }
+    if (b->kind == ExprKind::PRE_UNARY_MINUS)
+    {
+        d->report.simplified += 1;
+        Expr **ops = DiffOps(d, 2);
+        if (!ops) { return nullptr; }
+        ops[0] = a;
+        ops[1] = b->operand;
+        return DiffSum(d, ops, 2);
+    }
+    return DiffCheck(d, ExprInternBinary(d->interner, ExprKind::DIFFERENCE, a, b));
+}
+
+internal Expr * 
+DiffQuotient(Diff *d, Expr *a, Expr *b)
+{
+    if (!d->ok) { return nullptr; }
+    if (DiffIsNum(a, 0) || DiffIsNum(b, 1))
+    {
+        d->report.simplified += 1;
+        return a;
+    }
+    // -1 goes through DiffNegate, so S64 min / -1 never reaches the division
+    if (DiffIsNum(b, -1)) { return DiffNegate(d, a); }
+    if (a->kind == ExprKind::NUM && b->kind == ExprKind::NUM && b->num != 0 && a->num % b->num == 0)
+    {
+        d->report.simplified += 1;
+        return DiffNum(d, a->num / b->num);
+    }
+    return DiffCheck(d, ExprInternBinary(d->interner, ExprKind::QUOTIENT, a, b));
+}
+
+//////////////////
+// Rules
+
+// Product rule. Short products write every term out in full; from DIFF_CHAIN_MIN
+// factors on, term i is prefix(i) * f_i' * suffix(i + 1) with the prefixes and
+// suffixes built once as chains of two factor products.
+internal Expr * 
+DiffMultiply(Diff *d, Expr *expr)
+{
+    U32 n = expr->count;
+    Expr **factors = expr->operands;
+    Expr **derivs = DiffOps(d, n);
+    if (!derivs) { return nullptr; }
+    U32 first = n, last = 0, varying = 0;
+    for (U32 i = 0; i < n; i += 1)
+    {
+        derivs[i] = DiffDone(d, factors[i]);
+        if (DiffIsNum(derivs[i], 0)) { continue; }
+        first = Min(first, i);
+        last = i;
+        varying += 1;
+    }
+    if (varying == 0) { return d->zero; }
+
+    Expr **terms = DiffOps(d, varying);
+    if (!terms) { return nullptr; }
+    U32 term_count = 0;
+    if (n < DIFF_CHAIN_MIN || varying == 1)
+    {
+        for (U32 i = first; d->ok && i <= last; i += 1)
+        {
+            if (DiffIsNum(derivs[i], 0)) { continue; }
+            Expr **ops = DiffOps(d, n + 1);
+            if (!ops) { return nullptr; }
+            MemoryCopy(ops, factors, sizeof(Expr *) * n);
+            ops[i] = derivs[i];
+            terms[term_count++] = DiffProduct(d, ops, n);
+        }
+        return DiffSum(d, terms, term_count);
+    }
+
+    // prefix[i] is f_0 ... f_(i-1), suffix[i] is f_i ... f_(n-1), nullptr for an empty product
+    Expr **prefix = DiffOps(d, n + 1);
+    Expr **suffix = DiffOps(d, n + 1);
+    if (!prefix || !suffix) { return nullptr; }
+    prefix[0] = nullptr;
+    for (U32 i = 0; d->ok && i < last; i += 1) { prefix[i + 1] = prefix[i] ? DiffProduct2(d, prefix[i], factors[i]) : factors[i]; }
+    suffix[n] = nullptr;
+    for (U32 i = n; d->ok && i > first + 1; i -= 1) { suffix[i - 1] = suffix[i] ? DiffProduct2(d, factors[i - 1], suffix[i]) : factors[i - 1]; }
+
+    for (U32 i = first; d->ok && i <= last; i += 1)
+    {
+        if (DiffIsNum(derivs[i], 0)) { continue; }
+        Expr **ops = DiffOps(d, 4);
+        if (!ops) { return nullptr; }
+        U32 count = 0;
+        if (prefix[i]) { ops[count++] = prefix[i]; }
+        ops[count++] = derivs[i];
+        if (suffix[i + 1]) { ops[count++] = suffix[i + 1]; }
+        terms[term_count++] = DiffProduct(d, ops, count);
+    }
+    return DiffSum(d, terms, term_count);
+}
+
+// Derivative of expr, all of whose children are done
+internal Expr * 
+DiffNode(Diff *d, Expr *expr)
+{
+    switch (expr->kind)
+    {
+        case ExprKind::NUM:
+        case ExprKind::BIG_NUM: return d->zero;
+        case ExprKind::VAR: return Str8Match(expr->var, d->var) ? d->one : d->zero;
+        case ExprKind::PRE_UNARY_MINUS: return DiffNegate(d, DiffDone(d, expr->operand));
+        case ExprKind::PLUS:
+        {
+            Expr **ops = DiffOps(d, expr->count);
+            if (!ops) { return nullptr; }
+            for (U32 i = 0; i < expr->count; i += 1) { ops[i] = DiffDone(d, expr->operands[i]); }
+            return DiffSum(d, ops, expr->count);
+        }
+        case ExprKind::MULTIPLY: return DiffMultiply(d, expr);
+        case ExprKind::DIFFERENCE: return DiffDifference(d, DiffDone(d, expr->bin.left), DiffDone(d, expr->bin.right));
+        case ExprKind::QUOTIENT:
+        {
+            // (u/v)' = (u'v - uv') / (v*v), with the halves that vanish left out
+            Expr *u = expr->bin.left, *v = expr->bin.right;
+            Expr *du = DiffDone(d, u), *dv = DiffDone(d, v);
+            if (DiffIsNum(dv, 0)) { return DiffQuotient(d, du, v); }
+            Expr *square = DiffProduct2(d, v, v);
+            Expr *udv = DiffProduct2(d, u, dv);
+            if (DiffIsNum(du, 0)) { return d->ok ? DiffNegate(d, DiffQuotient(d, udv, square)) : nullptr; }
+            Expr *duv = DiffProduct2(d, du, v);
+            return d->ok ? DiffQuotient(d, DiffDifference(d, duv, udv), square) : nullptr;
+        }
+        default: return nullptr;
+    }
+}
+
+//////////////////
+// Entry points
+
+internal B32 
+DiffInit(Diff *d, ExprInterner *interner, Arena *scratch, String8 var)
+{
+    MemoryZeroStruct(*d);
+    d->interner = interner;
+    d->scratch = scratch;
+    d->var = var;
+    d->zero = ExprInternNum(interner, 0);
+    d->one = ExprInternNum(interner, 1);
+    d->cap = 64;
+    d->keys = scratch->PushArray<Expr *>(d->cap);
+    d->values = scratch->PushArrayNoZero<Expr *>(d->cap);
+    d->ok = d->zero && d->one && d->keys && d->values;
+    return d->ok;
+}
+
+internal Expr * 
+ExprDifferentiate(ExprInterner *interner, Arena *scratch, Expr *root, String8 var, DiffReport *report)
+{
+    // Postorder over distinct nodes: a child already done is not visited again
+    struct Frame { Expr *expr; U32 next; };
+
+    U64 pos = scratch->ArenaGetPos();
+    Diff d;
+    U64 count = 0, cap = 0;
+    Frame *stack = nullptr;
+    if (DiffInit(&d, interner, scratch, var) && (stack = ArenaGrowArray(scratch, stack, count, &cap)))
+    {
+        stack[count++] = {root, 0};
+    }
+    else
+    {
+        d.ok = 0;
+    }
+
+    while (d.ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        if (top->next < ExprChildCount(expr))
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (DiffDone(&d, child)) { continue; }
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { d.ok = 0; break; }
+            stack[count++] = {child, 0};
+            continue;
+        }
+
+        count -= 1;
+        if (DiffDone(&d, expr)) { continue; }
+        Expr *derivative = DiffNode(&d, expr);
+        if (!derivative) { d.ok = 0; break; }
+        DiffSetDone(&d, expr, derivative);
+        d.report.visited += 1;
+    }
+
+    Expr *result = d.ok ? DiffDone(&d, root) : nullptr;
+    if (report)
+    {
+        report->visited += d.report.visited;
+        report->simplified += d.report.simplified;
+    }
+    scratch->ArenaSetPosBack(pos);
+    return result;
+}
+
+internal B32 
+ExprGradient(ExprInterner *interner, Arena *scratch, Expr *root, String8 const *vars, U32 var_count, Expr **out, DiffReport *report)
+{
+    for (U32 i = 0; i < var_count; i += 1)
+    {
+        out[i] = ExprDifferentiate(interner, scratch, root, vars[i], report);
+        if (!out[i]) { return 0; }
+    }
+    return 1;
+}
@@ -0,0 +1,37 @@
+/*
+ast_diff.hpp
+
+Symbolic derivatives built as DAGs. Every node of the result comes from an
+ExprInterner, so the derivative points into the original expression instead of
+copying it, and each distinct node of the input is differentiated once however
+often it is referenced. That is what keeps repeated differentiation linear: the
+second derivative of a shared DAG is another shared DAG.
+
+The rules are applied through constructors that simplify as they build: sums
+and products drop zeros and ones and fold their constants, a product with a zero
+factor is zero, negations cancel, and x - x is 0. The product rule on n factors
+uses prefix and suffix products, so each term is three factors and the whole
+derivative is O(n) nodes rather than n copies of n - 1 factors.
+
+Values are treated as reals, like ExprSimplify: 0*(1/x) is 0.
+*/
+#ifndef AST_DIFF_HPP
+#define AST_DIFF_HPP
+
+#define DIFF_CHAIN_MIN 4            // products this long use prefix/suffix chains
+
+struct DiffReport 
+{
+    U64 visited;                    // distinct nodes differentiated
+    U64 simplified;                 // zeros, ones, constants and negations folded while building
+};
+
+// d root / d var. root and everything it references must come from interner
+// (see ExprIntern), and so does the result. nullptr when an arena runs out.
+internal Expr *ExprDifferentiate(ExprInterner *interner, Arena *scratch, Expr *root, String8 var, DiffReport *report = nullptr);
+// One derivative per name in vars, all sharing nodes through interner. Ready for
+// BytecodeCompileBatch. 0 when an arena runs out.
+internal B32 ExprGradient(ExprInterner *interner, Arena *scratch, Expr *root, String8 const *vars, U32 var_count, Expr **out,
+                          DiffReport *report = nullptr);
+
+#endif // AST_DIFF_HPP
@@ -0,0 +1,423 @@
+//////////////////
+// Layout
+
+#define EXPR_FLAT_HEADER_SIZE 16
+
+internal U64 
+ExprFlatBlockSize(U64 count, U64 num_count, U64 var_count, U64 name_bytes)
+{
+    return EXPR_FLAT_HEADER_SIZE + sizeof(S64) * num_count + sizeof(U32) * (3 * count + var_count + 1) + count + name_bytes;
+}
+
+internal B32 
+ExprFlatBind(U8 *data, U64 size, ExprFlat *out)
+{
+    if (size < EXPR_FLAT_HEADER_SIZE) { return 0; }
+    U32 counts[4];
+    MemoryCopy(counts, data, sizeof(counts));
+    if (ExprFlatBlockSize(counts[0], counts[1], counts[2], counts[3]) != size) { return 0; }
+
+    ExprFlat flat = {};
+    flat.count = counts[0];
+    flat.num_count = counts[1];
+    flat.var_count = counts[2];
+    flat.name_bytes = counts[3];
+    flat.data = data;
+    flat.size = size;
+
+    // Widest first so every array stays aligned
+    U8 *at = data + EXPR_FLAT_HEADER_SIZE;
+    flat.nums = (S64 *)at;              at += sizeof(S64) * flat.num_count;
+    flat.arity = (U32 *)at;             at += sizeof(U32) * flat.count;
+    flat.skip = (U32 *)at;              at += sizeof(U32) * flat.count;
+    flat.payload = (U32 *)at;           at += sizeof(U32) * flat.count;
+    flat.name_offsets = (U32 *)at;      at += sizeof(U32) * (flat.var_count + 1);
+    flat.kinds = (ExprKind *)at;        at += flat.count;
+    flat.names = at;
+    *out = flat;
+    return 1;
+}
+
+internal B32 
+ExprFlatCopy(Arena *arena, ExprFlat const *flat, ExprFlat *out)
+{
+    U8 *data = arena->PushArrayNoZero<U8>(flat->size);
+    if (!data) { return 0; }
+    MemoryCopy(data, flat->data, flat->size);
+    return ExprFlatBind(data, flat->size, out);
+}
+
+internal String8 
+ExprFlatVarName(ExprFlat const *flat, U32 var)
+{
+    return Str8(flat->names + flat->name_offsets[var], flat->name_offsets[var + 1] - flat->name_offsets[var]);
+}
+
+// A BIG_NUM's limbs stay in nums, storage only holds the count and sign
+internal Integer 
+ExprFlatInteger(ExprFlat const *flat, U32 node, BigInt *storage)
+{
+    S64 const *at = flat->nums + flat->payload[node];
+    if (flat->kinds[node] == ExprKind::NUM) { return IntFromS64(*at); }
+    storage->limbs = (U64 *)(at + 1);
+    storage->count = (U32)(*at < 0 ? -*at : *at);
+    storage->neg = *at < 0;
+    return {0, storage};
+}
+
+//////////////////
+// Conversion
+
+internal B32 
+ExprFlatFromExpr(Arena *arena, Arena *scratch, Expr *root, ExprFlat *out)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = ExprNodeCount(scratch, root);
+    if (count == 0 || count >= max_U32) { return 0; }
+
+    // Preorder into scratch first, the block size depends on the literals found.
+    // nums is last so big literals can grow it.
+    ExprKind *kinds = scratch->PushArrayNoZero<ExprKind>(count);
+    U32 *arity = scratch->PushArrayNoZero<U32>(count);
+    U32 *payload = scratch->PushArrayNoZero<U32>(count);
+    String8 *names = scratch->PushArrayNoZero<String8>(count);
+    Expr **stack = scratch->PushArrayNoZero<Expr *>(count);
+    U64 table_cap = 16;
+    while (table_cap < count * 2) { table_cap <<= 1; }
+    U32 *table = scratch->PushArray<U32>(table_cap);    // variable id + 1, 0 is empty
+    U64 num_cap = count;
+    S64 *nums = scratch->PushArrayNoZero<S64>(num_cap);
+    if (!kinds || !arity || !payload || !nums || !names || !stack || !table)
+    {
+        scratch->ArenaSetPosBack(pos);
+        return 0;
+    }
+
+    U64 num_count = 0;
+    U32 var_count = 0;
+    U64 name_bytes = 0;
+    U64 top = 0;
+    stack[top++] = root;
+    for (U32 i = 0; top; i += 1)
+    {
+        Expr *expr = stack[--top];
+        U32 children = ExprChildCount(expr);
+        kinds[i] = expr->kind;
+        arity[i] = children;
+        payload[i] = 0;
+        if (ExprKindIsInteger(expr->kind))
+        {
+            U64 limbs = expr->kind == ExprKind::BIG_NUM ? expr->big->count : 0;
+            while (num_count + limbs + 1 > num_cap && nums)
+            {
+                nums = ArenaGrowArray(scratch, nums, num_count, &num_cap);
+            }
+            if (!nums || num_count + limbs + 1 > max_U32)
+            {
+                scratch->ArenaSetPosBack(pos);
+                return 0;
+            }
+            payload[i] = (U32)num_count;
+            if (limbs)
+            {
+                nums[num_count++] = expr->big->neg ? -(S64)limbs : (S64)limbs;
+                MemoryCopy(nums + num_count, expr->big->limbs, sizeof(U64) * limbs);
+                num_count += limbs;
+            }
+            else { nums[num_count++] = expr->num; }
+        }
+        else if (expr->kind == ExprKind::VAR)
+        {
+            U64 slot = HashBytes(expr->var.str, expr->var.size, 0) & (table_cap - 1);
+            while (table[slot] && !Str8Match(names[table[slot] - 1], expr->var)) { slot = (slot + 1) & (table_cap - 1); }
+            if (!table[slot])
+            {
+                names[var_count] = expr->var;
+                name_bytes += expr->var.size;
+                table[slot] = ++var_count;
+            }
+            payload[i] = table[slot] - 1;
+        }
+        for (U32 c = children; c > 0; c -= 1) { stack[top++] = ExprChild(expr, c - 1); }
+    }
+
+    U64 size = ExprFlatBlockSize(count, num_count, var_count, name_bytes);
+    U8 *data = arena->PushArrayNoZero<U8>(size);
+    if (!data || name_bytes > max_U32)
+    {
+        scratch->ArenaSetPosBack(pos);
+        return 0;
+    }
+    U32 counts[4] = {(U32)count, (U32)num_count, var_count, (U32)name_bytes};
+    MemoryCopy(data, counts, sizeof(counts));
+    ExprFlat flat;
+    ExprFlatBind(data, size, &flat);
+
+    MemoryCopy(flat.kinds, kinds, count);
+    MemoryCopy(flat.arity, arity, sizeof(U32) * count);
+    MemoryCopy(flat.payload, payload, sizeof(U32) * count);
+    MemoryCopy(flat.nums, nums, sizeof(S64) * num_count);
+    U32 offset = 0;
+    for (U32 v = 0; v < var_count; v += 1)
+    {
+        flat.name_offsets[v] = offset;
+        MemoryCopy(flat.names + offset, names[v].str, names[v].size);
+        offset += (U32)names[v].size;
+    }
+    flat.name_offsets[var_count] = offset;
+
+    // Subtree ends, children always sit after their parent so one backward pass does it
+    for (U64 i = count; i > 0; i -= 1)
+    {
+        U32 node = (U32)(i - 1);
+        U32 end = node + 1;
+        for (U32 c = 0; c < flat.arity[node]; c += 1) { end = flat.skip[end]; }
+        flat.skip[node] = end;
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    *out = flat;
+    return 1;
+}
+
+internal Expr * 
+ExprFromFlat(Arena *arena, Arena *scratch, ExprFlat const *flat)
+{
+    U64 pos = scratch->ArenaGetPos();
+    Expr **stack = scratch->PushArrayNoZero<Expr *>(flat->count);
+    if (!stack) { return nullptr; }
+
+    // Backward, so the children of a node are on top of the stack first one uppermost
+    U64 top = 0;
+    Expr *result = nullptr;
+    for (U64 i = flat->count; i > 0; i -= 1)
+    {
+        U32 node = (U32)(i - 1);
+        U32 children = flat->arity[node];
+        Expr *expr = nullptr;
+        switch (flat->kinds[node])
+        {
+            case ExprKind::NUM: expr = ExprPushNum(arena, flat->nums[flat->payload[node]]); break;
+            case ExprKind::BIG_NUM:
+            {
+                BigInt big;
+                expr = ExprPushInteger(arena, ExprFlatInteger(flat, node, &big));
+            } break;
+            case ExprKind::VAR: expr = ExprPushVar(arena, ExprFlatVarName(flat, flat->payload[node])); break;
+            case ExprKind::PRE_UNARY_MINUS: expr = ExprPushUnary(arena, stack[top - 1]); break;
+            case ExprKind::DIFFERENCE:
+            case ExprKind::QUOTIENT: expr = ExprPushBinary(arena, flat->kinds[node], stack[top - 1], stack[top - 2]); break;
+            default:
+            {
+                Expr **ops = stack + top - children;
+                for (U32 a = 0, b = children - 1; a < b; a += 1, b -= 1) { Expr *t = ops[a]; ops[a] = ops[b]; ops[b] = t; }
+                expr = ExprPushNary(arena, flat->kinds[node], ops, children);
+            } break;
+        }
+        if (!expr) { break; }
+        top -= children;
+        stack[top++] = expr;
+        if (node == 0) { result = expr; }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    return result;
+}
+
+//////////////////
+// Passes
+
+internal B32 
+ExprFlatEval(Arena *scratch, ExprFlat const *flat, U32 node, F64 const *values, F64 *out)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U32 end = flat->skip[node];
+    F64 *stack = scratch->PushArrayNoZero<F64>(end - node);
+    if (!stack) { return 0; }
+
+    U64 top = 0;
+    for (U32 i = end; i > node; i -= 1)
+    {
+        U32 at = i - 1;
+        U32 children = flat->arity[at];
+        F64 *ops = stack + top - children;     // ops[children - 1] is the first operand
+        F64 value;
+        switch (flat->kinds[at])
+        {
+            case ExprKind::NUM: value = (F64)flat->nums[flat->payload[at]]; break;
+            case ExprKind::BIG_NUM:
+            {
+                BigInt big;
+                value = IntToF64(ExprFlatInteger(flat, at, &big));
+            } break;
+            case ExprKind::VAR: value = values[flat->payload[at]]; break;
+            case ExprKind::PRE_UNARY_MINUS: value = -ops[0]; break;
+            case ExprKind::DIFFERENCE: value = ops[1] - ops[0]; break;
+            case ExprKind::QUOTIENT: value = ops[1] / ops[0]; break;
+            case ExprKind::PLUS:
+            {
+                value = ops[children - 1];
+                for (U32 c = children - 1; c > 0; c -= 1) { value += ops[c - 1]; }
+            } break;
+            default:
+            {
+                value = ops[children - 1];
+                for (U32 c = children - 1; c > 0; c -= 1) { value *= ops[c - 1]; }
+            } break;
+        }
+        top -= children;
+        stack[top++] = value;
+    }
+
+    *out = stack[0];
+    scratch->ArenaSetPosBack(pos);
+    return 1;
+}
+
+internal U64 
+ExprFlatHash(Arena *scratch, ExprFlat const *flat, U32 node)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U32 end = flat->skip[node];
+    U64 *stack = scratch->PushArrayNoZero<U64>(end - node);
+    U64 *var_hashes = scratch->PushArrayNoZero<U64>(flat->var_count + 1);
+    if (!stack || !var_hashes) { return 0; }
+    for (U32 v = 0; v < flat->var_count; v += 1)
+    {
+        String8 name = ExprFlatVarName(flat, v);
+        var_hashes[v] = ExprHashVar(name);
+    }
+
+    U64 top = 0;
+    for (U32 i = end; i > node; i -= 1)
+    {
+        U32 at = i - 1;
+        U32 children = flat->arity[at];
+        U64 *ops = stack + top - children;     // ops[children - 1] is the first operand
+        U64 hash;
+        switch (flat->kinds[at])
+        {
+            case ExprKind::NUM: hash = ExprHashNum(flat->nums[flat->payload[at]]); break;
+            case ExprKind::BIG_NUM:
+            {
+                BigInt big;
+                hash = ExprHashInteger(ExprFlatInteger(flat, at, &big));
+            } break;
+            case ExprKind::VAR: hash = var_hashes[flat->payload[at]]; break;
+            case ExprKind::PRE_UNARY_MINUS: hash = ExprHashUnary(ops[0]); break;
+            case ExprKind::DIFFERENCE:
+            case ExprKind::QUOTIENT: hash = ExprHashBinary(flat->kinds[at], ops[1], ops[0]); break;
+            default:
+            {
+                U64 acc = 0;
+                for (U32 c = 0; c < children; c += 1) { acc = ExprHashNaryAdd(acc, ops[c]); }
+                hash = ExprHashNary(flat->kinds[at], acc, children);
+            } break;
+        }
+        top -= children;
+        stack[top++] = hash;
+    }
+
+    U64 hash = stack[0];
+    scratch->ArenaSetPosBack(pos);
+    return hash;
+}
+
+internal U32 * 
+ExprFlatFreeVars(Arena *arena, Arena *scratch, ExprFlat const *flat, U32 node, U32 *count)
+{
+    *count = 0;
+    U64 pos = scratch->ArenaGetPos();
+    U64 words = (flat->var_count + 63) / 64;
+    U64 *seen = scratch->PushArray<U64>(words + 1);
+    if (!seen) { return nullptr; }
+
+    U32 found = 0;
+    for (U32 i = node; i < flat->skip[node]; i += 1)
+    {
+        if (flat->kinds[i] != ExprKind::VAR) { continue; }
+        U32 var = flat->payload[i];
+        U64 bit = 1ull << (var & 63);
+        found += (seen[var >> 6] & bit) == 0;
+        seen[var >> 6] |= bit;
+    }
+
+    U32 *vars = arena->PushArrayNoZero<U32>(Max<U32>(found, 1));
+    if (vars)
+    {
+        for (U32 v = 0; v < flat->var_count; v += 1)
+        {
+            if (seen[v >> 6] & (1ull << (v & 63))) { vars[(*count)++] = v; }
+        }
+    }
+    scratch->ArenaSetPosBack(pos);
+    return vars;
+}
+
+internal String8 
+ExprFlatPrint(Arena *arena, Arena *scratch, ExprFlat const *flat, U32 node)
+{
+    // Open operators, child is the operand being printed
+    struct Frame { U32 node; U32 child; U32 index; B32 parens; };
+
+    U64 scratch_pos = scratch->ArenaGetPos();
+    U64 pos = arena->ArenaGetPos();
+    Frame *stack = scratch->PushArrayNoZero<Frame>(flat->skip[node] - node);
+    if (!stack) { return Str8(nullptr, 0); }
+
+    ExprWriter writer;
+    ExprWriterInitArena(&writer, arena);
+    U64 top = 0;
+    U32 at = node;
+    B32 parens = 0;
+    while (writer.ok)
+    {
+        ExprKind kind = flat->kinds[at];
+        if (ExprKindIsLeaf(kind))
+        {
+            if (kind == ExprKind::VAR)
+            {
+                String8 name = ExprFlatVarName(flat, flat->payload[at]);
+                ExprWrite(&writer, name.str, name.size);
+            }
+            else
+            {
+                BigInt big;
+                ExprWriteInteger(&writer, scratch, ExprFlatInteger(flat, at, &big));
+            }
+
+            // Climb until some operator still has operands to print
+            for (; top; top -= 1)
+            {
+                Frame *frame = &stack[top - 1];
+                frame->index += 1;
+                ExprKind parent = flat->kinds[frame->node];
+                if (frame->index < flat->arity[frame->node])
+                {
+                    ExprPrintBetween(&writer, ExprPrintMode::INFIX, parent);
+                    frame->child = flat->skip[frame->child];
+                    at = frame->child;
+                    parens = ExprChildNeedsParens(parent, flat->kinds[at], frame->index);
+                    break;
+                }
+                ExprPrintClose(&writer, ExprPrintMode::INFIX, parent, frame->parens);
+            }
+            if (top == 0) { break; }
+            continue;
+        }
+
+        ExprPrintOpen(&writer, ExprPrintMode::INFIX, kind, parens);
+        stack[top++] = {at, at + 1, 0, parens};
+        parens = ExprChildNeedsParens(kind, flat->kinds[at + 1], 0);
+        at += 1;
+    }
+
+    ExprWrite(&writer, "", 1);
+    scratch->ArenaSetPosBack(scratch_pos);
+    if (!ExprWriterFlush(&writer))
+    {
+        arena->ArenaSetPosBack(pos);
+        return Str8(nullptr, 0);
+    }
+    return Str8(arena->memory + pos, writer.total - 1);
+}
@@ -0,0 +1,61 @@
+/*
+ast_flat.hpp
+
+Whole tree as parallel arrays, nodes addressed by U32 index in preorder. A node's
+subtree is the range [node, skip[node]), its first child is node + 1 and every
+next sibling starts at the previous one's skip. Whole tree passes become linear
+scans: forward for printing, backward with a value stack for eval and hashing.
+
+Everything lives in one block that starts with its own counts, so a tree is
+copied or written out with one memcpy and read back with ExprFlatBind.
+*/
+#ifndef AST_FLAT_HPP
+#define AST_FLAT_HPP
+
+struct ExprFlat 
+{
+    U32 count;              // nodes, root at 0
+    U32 num_count;
+    U32 var_count;          // distinct variable names
+    U32 name_bytes;
+
+    U8 *data;               // the block, starts with the four counts above
+    U64 size;
+
+    S64 *nums;              // [num_count] a BIG_NUM takes its signed limb count then the limbs
+    U32 *arity;             // [count]
+    U32 *skip;              // [count] one past the last node of the subtree
+    U32 *payload;           // [count] NUM, BIG_NUM: index into nums, VAR: variable id
+    U32 *name_offsets;      // [var_count + 1] variable id -> range in names
+    ExprKind *kinds;        // [count]
+    U8 *names;              // [name_bytes]
+};
+
+//////////////////
+// Conversion
+// All return 0/nullptr when an arena runs out
+
+// Lays root out in arena. Variables are numbered in order of first appearance.
+internal B32 ExprFlatFromExpr(Arena *arena, Arena *scratch, Expr *root, ExprFlat *out);
+internal Expr *ExprFromFlat(Arena *arena, Arena *scratch, ExprFlat const *flat);
+
+// Points out at a block produced by ExprFlatFromExpr, after checking its counts add up to size
+internal B32 ExprFlatBind(U8 *data, U64 size, ExprFlat *out);
+internal B32 ExprFlatCopy(Arena *arena, ExprFlat const *flat, ExprFlat *out);
+
+internal String8 ExprFlatVarName(ExprFlat const *flat, U32 var);
+
+//////////////////
+// Passes, over the subtree at node
+
+// values is indexed by variable id
+internal B32 ExprFlatEval(Arena *scratch, ExprFlat const *flat, U32 node, F64 const *values, F64 *out);
+// Same value as ExprHash of the tree ExprFromFlat would build
+internal U64 ExprFlatHash(Arena *scratch, ExprFlat const *flat, U32 node);
+// Sorted ids of the variables used under node
+internal U32 *ExprFlatFreeVars(Arena *arena, Arena *scratch, ExprFlat const *flat, U32 node, U32 *count);
+// Infix with only the parentheses needed to parse back to the same tree.
+// The text is appended to arena as it is written, so scratch must be a different arena.
+internal String8 ExprFlatPrint(Arena *arena, Arena *scratch, ExprFlat const *flat, U32 node);
+
+#endif // AST_FLAT_HPP
@@ -0,0 +1,590 @@
+//////////////////
+// Regions
+
+// Where a node sits: ROOT starts a region (or is a quotient between regions),
+// SUM and PRODUCT are inside one, LEAF needs no visit
+enum class HornerRole : U8 {ROOT, SUM, PRODUCT, LEAF};
+
+struct HornerPair 
+{
+    U32 atom;
+    U32 exp;
+};
+
+struct HornerTerm 
+{
+    Integer coef;       // in scratch
+    U64 first;          // into pairs, sorted by atom
+    U32 count;
+};
+
+// A result with its sign kept aside, so negative parts subtract instead of negating
+struct HornerSigned 
+{
+    Expr *expr;
+    B32 neg;
+};
+
+struct Horner 
+{
+    Arena *arena;
+    Arena *scratch;
+    B32 ok;                 // cleared when an arena runs out
+
+    // Rewritten region roots and quotients, keyed by the original node
+    Expr **done_keys;
+    Expr **done_values;
+    U64 done_mask;
+
+    // Region being rewritten, all in scratch
+    Expr **atom_keys;       // original factor
+    Expr **atom_exprs;      // rewritten factor
+    U32 atom_count;
+    U64 atom_cap;
+    U32 *atom_table;        // open addressing over atom index + 1
+    U64 atom_mask;
+    B32 atoms_changed;
+    U32 *atom_uses;
+    Expr **factors;         // stack for reading one product
+    U64 factor_cap;
+    HornerPair *pairs;
+    U64 pair_count, pair_cap;
+    HornerTerm *terms;
+    U64 term_count, term_cap;
+    U64 old_ops;            // operations in the region as written
+    U64 new_ops;            // operations built for it so far
+    U8 *arena_start;        // nodes at or after this were built for the region
+};
+
+internal HornerRole 
+HornerChildRole(Expr *parent, HornerRole parent_role, Expr *child)
+{
+    if (ExprKindIsLeaf(child->kind)) { return HornerRole::LEAF; }
+    if (parent->kind == ExprKind::QUOTIENT) { return HornerRole::ROOT; }
+    B32 product = parent->kind == ExprKind::MULTIPLY || (parent->kind == ExprKind::PRE_UNARY_MINUS && parent_role == HornerRole::PRODUCT);
+    switch (child->kind)
+    {
+        case ExprKind::MULTIPLY:        return HornerRole::PRODUCT;
+        case ExprKind::PRE_UNARY_MINUS: return product ? HornerRole::PRODUCT : HornerRole::SUM;
+        case ExprKind::PLUS:
+        case ExprKind::DIFFERENCE:      return product ? HornerRole::ROOT : HornerRole::SUM;
+        default:                        return HornerRole::ROOT;
+    }
+}
+
+internal Expr * 
+HornerDone(Horner *h, Expr *expr)
+{
+    U64 slot = HashU64((U64)(uintptr_t)expr) & h->done_mask;
+    while (h->done_keys[slot])
+    {
+        if (h->done_keys[slot] == expr) { return h->done_values[slot]; }
+        slot = (slot + 1) & h->done_mask;
+    }
+    return nullptr;
+}
+
+internal void 
+HornerSetDone(Horner *h, Expr *expr, Expr *rewritten)
+{
+    U64 slot = HashU64((U64)(uintptr_t)expr) & h->done_mask;
+    while (h->done_keys[slot] && h->done_keys[slot] != expr) { slot = (slot + 1) & h->done_mask; }
+    h->done_keys[slot] = expr;
+    h->done_values[slot] = rewritten;
+}
+
+internal Expr * 
+HornerRewritten(Horner *h, Expr *expr)
+{
+    Expr *done = HornerDone(h, expr);
+    return done ? done : expr;
+}
+
+template <typename T>
+internal B32 
+HornerReserve(Horner *h, T **items, U64 count, U64 *cap, U64 extra)
+{
+    while (h->ok && count + extra > *cap)
+    {
+        *items = ArenaGrowArray(h->scratch, *items, count, cap);
+        h->ok = *items != nullptr;
+    }
+    return h->ok;
+}
+
+//////////////////
+// Reading a region as a polynomial
+
+// Index of factor, adding it the first time it is seen
+internal U32 
+HornerAtom(Horner *h, Expr *factor)
+{
+    if ((U64)(h->atom_count + 1) * 2 > h->atom_mask + 1)
+    {
+        U64 cap = (h->atom_mask + 1) * 2;
+        U32 *table = h->scratch->PushArray<U32>(cap);
+        if (!table) { h->ok = 0; return 0; }
+        for (U32 i = 0; i < h->atom_count; i += 1)
+        {
+            U64 slot = h->atom_keys[i]->hash & (cap - 1);
+            while (table[slot]) { slot = (slot + 1) & (cap - 1); }
+            table[slot] = i + 1;
+        }
+        h->atom_table = table;
+        h->atom_mask = cap - 1;
+    }
+
+    U64 slot = factor->hash & h->atom_mask;
+    while (h->atom_table[slot])
+    {
+        U32 atom = h->atom_table[slot] - 1;
+        if (ExprMatch(h->scratch, h->atom_keys[atom], factor)) { return atom; }
+        slot = (slot + 1) & h->atom_mask;
+    }
+
+    if (h->atom_count == h->atom_cap)
+    {
+        U64 cap = h->atom_cap;
+        h->atom_keys = ArenaGrowArray(h->scratch, h->atom_keys, h->atom_count, &cap);
+        h->atom_exprs = h->atom_keys ? ArenaGrowArray(h->scratch, h->atom_exprs, h->atom_count, &h->atom_cap) : nullptr;
+        if (!h->atom_keys || !h->atom_exprs) { h->ok = 0; return 0; }
+    }
+    Expr *rewritten = HornerRewritten(h, factor);
+    h->atoms_changed |= rewritten != factor;
+    h->atom_keys[h->atom_count] = factor;
+    h->atom_exprs[h->atom_count] = rewritten;
+    h->atom_table[slot] = h->atom_count + 1;
+    return h->atom_count++;
+}
+
+// Reads one product into a term: coefficient times atoms with exponents
+internal void 
+HornerAddTerm(Horner *h, Expr *expr, S64 sign)
+{
+    U64 count = 0;
+    if (!HornerReserve(h, &h->factors, count, &h->factor_cap, 1)) { return; }
+    h->factors[count++] = expr;
+
+    Integer coef = IntFromS64(sign);
+    U64 first = h->pair_count;
+    while (count && h->ok)
+    {
+        Expr *factor = h->factors[--count];
+        switch (factor->kind)
+        {
+            case ExprKind::MULTIPLY:
+            {
+                h->old_ops += factor->count - 1;
+                if (!HornerReserve(h, &h->factors, count, &h->factor_cap, factor->count)) { break; }
+                for (U32 i = factor->count; i > 0; i -= 1) { h->factors[count++] = factor->operands[i - 1]; }
+            } break;
+            case ExprKind::PRE_UNARY_MINUS:
+            {
+                h->old_ops += 1;
+                h->ok = IntNegate(h->scratch, coef, &coef);
+                if (HornerReserve(h, &h->factors, count, &h->factor_cap, 1)) { h->factors[count++] = factor->operand; }
+            } break;
+            case ExprKind::NUM:
+            case ExprKind::BIG_NUM:
+            {
+                h->ok = IntMul(h->scratch, coef, ExprInteger(factor), &coef);
+            } break;
+            default:
+            {
+                U32 atom = HornerAtom(h, factor);
+                if (HornerReserve(h, &h->pairs, h->pair_count, &h->pair_cap, 1)) { h->pairs[h->pair_count++] = {atom, 1}; }
+            } break;
+        }
+    }
+    if (!h->ok) { return; }
+
+    // Sort by atom and merge repeats, x*y*x is x^2 y. Products are short.
+    HornerPair *pairs = h->pairs + first;
+    U64 n = h->pair_count - first;
+    for (U64 i = 1; i < n; i += 1)
+    {
+        HornerPair p = pairs[i];
+        U64 j = i;
+        while (j > 0 && pairs[j - 1].atom > p.atom) { pairs[j] = pairs[j - 1]; j -= 1; }
+        pairs[j] = p;
+    }
+    U64 merged = 0;
+    for (U64 i = 0; i < n; i += 1)
+    {
+        if (merged && pairs[merged - 1].atom == pairs[i].atom) { pairs[merged - 1].exp += pairs[i].exp; }
+        else { pairs[merged++] = pairs[i]; }
+    }
+    h->pair_count = first + merged;
+
+    if (IntSign(coef) == 0) { h->pair_count = first; return; }
+    if (HornerReserve(h, &h->terms, h->term_count, &h->term_cap, 1)) { h->terms[h->term_count++] = {coef, first, (U32)merged}; }
+}
+
+internal B32 
+HornerSamePairs(Horner *h, HornerTerm const *a, HornerTerm const *b)
+{
+    if (a->count != b->count) { return 0; }
+    for (U32 i = 0; i < a->count; i += 1)
+    {
+        HornerPair pa = h->pairs[a->first + i], pb = h->pairs[b->first + i];
+        if (pa.atom != pb.atom || pa.exp != pb.exp) { return 0; }
+    }
+    return 1;
+}
+
+// Adds up terms with the same atoms, keeping the first of each in place
+internal void 
+HornerCombineLikeTerms(Horner *h)
+{
+    U64 cap = 16;
+    while (cap < h->term_count * 2) { cap <<= 1; }
+    U32 *table = h->scratch->PushArray<U32>(cap);
+    if (!table) { h->ok = 0; return; }
+
+    U64 kept = 0;
+    for (U64 i = 0; i < h->term_count && h->ok; i += 1)
+    {
+        HornerTerm term = h->terms[i];
+        U64 slot = HashBytes(h->pairs + term.first, sizeof(HornerPair) * term.count, 0) & (cap - 1);
+        while (table[slot] && !HornerSamePairs(h, &h->terms[table[slot] - 1], &term)) { slot = (slot + 1) & (cap - 1); }
+        if (table[slot])
+        {
+            HornerTerm *like = &h->terms[table[slot] - 1];
+            h->ok = IntAdd(h->scratch, like->coef, term.coef, &like->coef);
+            continue;
+        }
+        h->terms[kept] = term;
+        table[slot] = (U32)++kept;
+    }
+
+    // Cancelled terms go
+    U64 nonzero = 0;
+    for (U64 i = 0; i < kept; i += 1)
+    {
+        if (IntSign(h->terms[i].coef)) { h->terms[nonzero++] = h->terms[i]; }
+    }
+    h->term_count = nonzero;
+}
+
+//////////////////
+// Building the factored form
+
+internal Expr * 
+HornerNary(Horner *h, ExprKind kind, Expr **ops, U32 count)
+{
+    if (count == 1) { return ops[0]; }
+    h->new_ops += count - 1;
+    Expr *expr = ExprPushNary(h->arena, kind, ops, count);
+    h->ok &= expr != nullptr;
+    return expr;
+}
+
+// base^exp by repeated squaring, each square reusing its operand
+internal Expr * 
+HornerPow(Horner *h, Expr *base, U32 exp)
+{
+    Expr *result = nullptr;
+    while (exp && h->ok)
+    {
+        if (exp & 1)
+        {
+            Expr *ops[] = {result, base};
+            result = result ? HornerNary(h, ExprKind::MULTIPLY, ops, 2) : base;
+        }
+        exp >>= 1;
+        if (exp)
+        {
+            Expr *ops[] = {base, base};
+            base = HornerNary(h, ExprKind::MULTIPLY, ops, 2);
+        }
+    }
+    return result;
+}
+
+// atom^exp * part, with coefficients first and products built here kept flat
+internal HornerSigned 
+HornerMulPow(Horner *h, HornerSigned part, U32 atom, U32 exp)
+{
+    Expr *power = HornerPow(h, h->atom_exprs[atom], exp);
+    Expr *e = part.expr;
+    if (!h->ok || (e->kind == ExprKind::NUM && e->num == 1)) { return {power, part.neg}; }
+
+    Expr *pair[2] = {power, e};
+    if (ExprKindIsInteger(e->kind)) { pair[0] = e; pair[1] = power; }
+    Expr **ops = pair;
+    U32 count = 2;
+    if (e->kind == ExprKind::MULTIPLY && (U8 *)e >= h->arena_start)
+    {
+        ops = h->scratch->PushArrayNoZero<Expr *>(e->count + 1);
+        if (!ops) { h->ok = 0; return part; }
+        ops[0] = power;
+        MemoryCopy(ops + 1, e->operands, sizeof(Expr *) * e->count);
+        count = e->count + 1;
+        h->new_ops -= e->count - 1;
+    }
+    return {HornerNary(h, ExprKind::MULTIPLY, ops, count), part.neg};
+}
+
+// Greedy multivariate Horner: factor the atom most terms share out of them,
+// recurse on what is left of those terms, repeat for the rest
+internal HornerSigned 
+HornerBuild(Horner *h, U32 *terms, U32 count)
+{
+    Expr **pos_ops = h->scratch->PushArrayNoZero<Expr *>(count + 1);
+    Expr **neg_ops = h->scratch->PushArrayNoZero<Expr *>(count + 1);
+    U32 reduced_count = 0;
+    U32 *reduced = h->scratch->PushArrayNoZero<U32>(count + 1);
+    if (!pos_ops || !neg_ops || !reduced) { h->ok = 0; return {nullptr, 0}; }
+    U32 pos_count = 0, neg_count = 0;
+    Integer constant = IntFromS64(0);
+
+    while (count && h->ok)
+    {
+        U32 best = max_U32, best_uses = 0;
+        for (U32 i = 0; i < count; i += 1)
+        {
+            HornerTerm const *term = &h->terms[terms[i]];
+            for (U32 p = 0; p < term->count; p += 1)
+            {
+                U32 atom = h->pairs[term->first + p].atom;
+                U32 uses = ++h->atom_uses[atom];
+                if (uses > best_uses || (uses == best_uses && atom < best)) { best = atom; best_uses = uses; }
+            }
+        }
+        for (U32 i = 0; i < count; i += 1)
+        {
+            HornerTerm const *term = &h->terms[terms[i]];
+            for (U32 p = 0; p < term->count; p += 1) { h->atom_uses[h->pairs[term->first + p].atom] = 0; }
+        }
+
+        if (best == max_U32)
+        {
+            for (U32 i = 0; i < count && h->ok; i += 1) { h->ok = IntAdd(h->scratch, constant, h->terms[terms[i]].coef, &constant); }
+            break;
+        }
+
+        // Terms with best to the front, their smallest power of it comes out
+        U32 min_exp = max_U32, with = 0;
+        for (U32 i = 0; i < count; i += 1)
+        {
+            HornerTerm const *term = &h->terms[terms[i]];
+            for (U32 p = 0; p < term->count; p += 1)
+            {
+                HornerPair pair = h->pairs[term->first + p];
+                if (pair.atom != best) { continue; }
+                min_exp = Min(min_exp, pair.exp);
+                U32 swap = terms[i];
+                terms[i] = terms[with];
+                terms[with++] = swap;
+                break;
+            }
+        }
+
+        // Copies of those terms with best divided out
+        reduced_count = 0;
+        for (U32 i = 0; i < with && h->ok; i += 1)
+        {
+            HornerTerm term = h->terms[terms[i]];
+            if (!HornerReserve(h, &h->pairs, h->pair_count, &h->pair_cap, term.count) ||
+                !HornerReserve(h, &h->terms, h->term_count, &h->term_cap, 1)) { break; }
+            U64 first = h->pair_count;
+            for (U32 p = 0; p < term.count; p += 1)
+            {
+                HornerPair pair = h->pairs[term.first + p];
+                if (pair.atom == best) { pair.exp -= min_exp; }
+                if (pair.exp) { h->pairs[h->pair_count++] = pair; }
+            }
+            h->terms[h->term_count] = {term.coef, first, (U32)(h->pair_count - first)};
+            reduced[reduced_count++] = (U32)h->term_count++;
+        }
+        if (!h->ok) { break; }
+
+        HornerSigned part = HornerBuild(h, reduced, reduced_count);
+        if (!h->ok) { break; }
+        part = HornerMulPow(h, part, best, min_exp);
+        if (part.neg) { neg_ops[neg_count++] = part.expr; }
+        else          { pos_ops[pos_count++] = part.expr; }
+        terms += with;
+        count -= with;
+    }
+    if (!h->ok) { return {nullptr, 0}; }
+
+    S32 sign = IntSign(constant);
+    if (sign || pos_count + neg_count == 0)
+    {
+        Integer magnitude = constant;
+        Expr *num = sign >= 0 || IntNegate(h->scratch, constant, &magnitude) ? ExprPushInteger(h->arena, magnitude) : nullptr;
+        h->ok &= num != nullptr;
+        if (sign < 0) { neg_ops[neg_count++] = num; }
+        else          { pos_ops[pos_count++] = num; }
+    }
+
+    Expr *plus = pos_count ? HornerNary(h, ExprKind::PLUS, pos_ops, pos_count) : nullptr;
+    Expr *minus = neg_count ? HornerNary(h, ExprKind::PLUS, neg_ops, neg_count) : nullptr;
+    if (!h->ok) { return {nullptr, 0}; }
+    if (plus && minus)
+    {
+        h->new_ops += 1;
+        Expr *diff = ExprPushBinary(h->arena, ExprKind::DIFFERENCE, plus, minus);
+        h->ok &= diff != nullptr;
+        return {diff, 0};
+    }
+    return plus ? HornerSigned{plus, 0} : HornerSigned{minus, 1};
+}
+
+// The rewritten region rooted at root, or root itself when that is no better
+internal Expr * 
+HornerRegion(Horner *h, Expr *root)
+{
+    U64 scratch_pos = h->scratch->ArenaGetPos();
+    U64 arena_pos = h->arena->ArenaGetPos();
+    h->atom_count = 0;
+    h->atom_cap = 0;
+    h->atom_keys = h->atom_exprs = nullptr;
+    h->atoms_changed = 0;
+    h->factors = nullptr;
+    h->factor_cap = 0;
+    h->pairs = nullptr;
+    h->terms = nullptr;
+    h->pair_count = h->pair_cap = h->term_count = h->term_cap = 0;
+    h->old_ops = h->new_ops = 0;
+    h->arena_start = h->arena->memory + arena_pos;
+    h->atom_mask = 15;
+    h->atom_table = h->scratch->PushArray<U32>(h->atom_mask + 1);
+    h->ok &= h->atom_table != nullptr;
+
+    // Sum layer: signed terms
+    struct Signed { Expr *expr; S64 sign; };
+    U64 count = 0, cap = 0;
+    Signed *stack = h->ok ? ArenaGrowArray(h->scratch, (Signed *)nullptr, count, &cap) : nullptr;
+    h->ok &= stack != nullptr;
+    if (h->ok) { stack[count++] = {root, 1}; }
+    while (count && h->ok)
+    {
+        Signed top = stack[--count];
+        Expr *expr = top.expr;
+        U32 children = 0;
+        Signed next[2];
+        switch (expr->kind)
+        {
+            case ExprKind::PLUS:
+            {
+                h->old_ops += expr->count - 1;
+                for (U32 i = expr->count; i > 0; i -= 1)
+                {
+                    if (count == cap && !(stack = ArenaGrowArray(h->scratch, stack, count, &cap))) { h->ok = 0; break; }
+                    stack[count++] = {expr->operands[i - 1], top.sign};
+                }
+            } break;
+            case ExprKind::DIFFERENCE:      { h->old_ops += 1; next[0] = {expr->bin.right, -top.sign}; next[1] = {expr->bin.left, top.sign}; children = 2; } break;
+            case ExprKind::PRE_UNARY_MINUS: { h->old_ops += 1; next[0] = {expr->operand, -top.sign}; children = 1; } break;
+            default:                        { HornerAddTerm(h, expr, top.sign); } break;
+        }
+        for (U32 i = 0; i < children; i += 1)
+        {
+            if (count == cap && !(stack = ArenaGrowArray(h->scratch, stack, count, &cap))) { h->ok = 0; break; }
+            stack[count++] = next[i];
+        }
+    }
+
+    Expr *result = root;
+    if (h->ok) { HornerCombineLikeTerms(h); }
+    if (h->ok)
+    {
+        h->atom_uses = h->scratch->PushArray<U32>(h->atom_count + 1);
+        U32 *terms = h->scratch->PushArrayNoZero<U32>(h->term_count + 1);
+        h->ok &= h->atom_uses && terms;
+        for (U32 i = 0; h->ok && i < h->term_count; i += 1) { terms[i] = i; }
+
+        HornerSigned built = h->ok ? HornerBuild(h, terms, (U32)h->term_count) : HornerSigned{};
+        if (h->ok && built.neg)
+        {
+            h->new_ops += 1;
+            built.expr = ExprPushUnary(h->arena, built.expr);
+            h->ok &= built.expr != nullptr;
+        }
+        if (h->ok && (h->new_ops < h->old_ops || (h->new_ops == h->old_ops && h->atoms_changed)))
+        {
+            result = built.expr;
+        }
+    }
+
+    h->scratch->ArenaSetPosBack(scratch_pos);
+    if (result == root) { h->arena->ArenaSetPosBack(arena_pos); }
+    return result;
+}
+
+//////////////////
+// Driver
+
+internal Expr * 
+ExprHorner(Arena *arena, Arena *scratch, Expr *root, HornerReport *report)
+{
+    HornerReport stats = {};
+    if (report && !ExprFlopCount(scratch, root, &stats.before)) { return nullptr; }
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 nodes = ExprNodeCount(scratch, root);
+    U64 cap = 16;
+    while (cap < nodes * 2) { cap <<= 1; }
+
+    Horner h = {};
+    h.arena = arena;
+    h.scratch = scratch;
+    h.done_keys = scratch->PushArray<Expr *>(cap);
+    h.done_values = scratch->PushArrayNoZero<Expr *>(cap);
+    h.done_mask = cap - 1;
+    h.ok = nodes && h.done_keys && h.done_values;
+
+    // Post order, so every factor a region uses is rewritten before the region
+    struct Frame { Expr *expr; U32 next; HornerRole role; };
+    U64 count = 0, frame_cap = 0;
+    Frame *stack = h.ok ? ArenaGrowArray(scratch, (Frame *)nullptr, count, &frame_cap) : nullptr;
+    h.ok &= stack != nullptr;
+    if (h.ok) { stack[count++] = {root, 0, HornerRole::ROOT}; }
+    while (count && h.ok)
+    {
+        Frame *top = &stack[count - 1];
+        if (top->next < ExprChildCount(top->expr))
+        {
+            Expr *child = ExprChild(top->expr, top->next++);
+            HornerRole role = HornerChildRole(top->expr, top->role, child);
+            if (role == HornerRole::LEAF || (role == HornerRole::ROOT && HornerDone(&h, child))) { continue; }
+            if (count == frame_cap && !(stack = ArenaGrowArray(scratch, stack, count, &frame_cap))) { h.ok = 0; break; }
+            stack[count++] = {child, 0, role};
+            continue;
+        }
+
+        Frame frame = stack[--count];
+        if (frame.role != HornerRole::ROOT) { continue; }
+        Expr *expr = frame.expr;
+        Expr *rewritten = expr;
+        if (expr->kind == ExprKind::QUOTIENT)
+        {
+            Expr *left = HornerRewritten(&h, expr->bin.left);
+            Expr *right = HornerRewritten(&h, expr->bin.right);
+            if (left != expr->bin.left || right != expr->bin.right)
+            {
+                rewritten = ExprPushBinary(arena, ExprKind::QUOTIENT, left, right);
+                h.ok &= rewritten != nullptr;
+            }
+        }
+        else if (!ExprKindIsLeaf(expr->kind))
+        {
+            // The region stack and tables go above the frames, which are done growing for now
+            rewritten = HornerRegion(&h, expr);
+            stats.regions += 1;
+            stats.rewritten += rewritten != expr;
+        }
+        HornerSetDone(&h, expr, rewritten);
+    }
+
+    Expr *result = h.ok ? HornerRewritten(&h, root) : nullptr;
+    scratch->ArenaSetPosBack(pos);
+    if (result && report)
+    {
+        if (!ExprFlopCount(scratch, result, &stats.after)) { return nullptr; }
+        *report = stats;
+    }
+    return result;
+}
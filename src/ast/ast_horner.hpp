@@ -0,0 +1,30 @@
+/*
+ast_horner.hpp
+
+Optional rewrite run before compiling for evaluation. Every maximal sum of
+products (PLUS, DIFFERENCE, negation and MULTIPLY over numbers and variables) is
+read as a polynomial: like terms are combined, the most common multiplicand is
+factored out of the terms that share it, recursively, which is Horner's rule for a
+single variable, and the powers left over are built by repeated squaring.
+Anything else in a product (a quotient, a nested sum) is an opaque factor that is
+rewritten on its own and matched structurally.
+
+Squarings share their operand, so the result is a DAG. ExprFlopCount counts what
+an evaluator that reuses shared nodes does.
+*/
+#ifndef AST_HORNER_HPP
+#define AST_HORNER_HPP
+
+struct HornerReport 
+{
+    ExprFlops before;
+    ExprFlops after;
+    U64 regions;            // sums of products looked at
+    U64 rewritten;          // of those, replaced with fewer operations
+};
+
+// Never more operations than root, regions that would grow are left as they were.
+// nullptr when an arena runs out.
+internal Expr *ExprHorner(Arena *arena, Arena *scratch, Expr *root, HornerReport *report = nullptr);
+
+#endif // AST_HORNER_HPP
@@ -0,0 +1,11 @@
+#include "ast_core.cpp"
+#include "ast_walk.cpp"
+#include "ast_print.cpp"
+#include "ast_flat.cpp"
+#include "ast_intern.cpp"
+#include "ast_horner.cpp"
+#include "ast_simplify.cpp"
+#include "ast_canon.cpp"
+#include "ast_poly.cpp"
+#include "ast_diff.cpp"
+#include "ast_rewrite.cpp"
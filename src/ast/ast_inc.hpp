@@ -0,0 +1,16 @@
+#ifndef AST_INC_HPP
+#define AST_INC_HPP
+
+#include "ast_core.hpp"
+#include "ast_walk.hpp"
+#include "ast_print.hpp"
+#include "ast_flat.hpp"
+#include "ast_intern.hpp"
+#include "ast_horner.hpp"
+#include "ast_simplify.hpp"
+#include "ast_canon.hpp"
+#include "ast_poly.hpp"
+#include "ast_diff.hpp"
+#include "ast_rewrite.hpp"
+
+#endif // AST_INC_HPP
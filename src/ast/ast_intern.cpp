@@ -0,0 +1,199 @@
+#define EXPR_INTERN_DEFAULT_CAP 1024
+
+internal B32 
+ExprInternerInit(ExprInterner *interner, Arena *arena, U64 cap)
+{
+    U64 pow2 = 16;
+    while (pow2 < cap) { pow2 <<= 1; }
+    if (cap == 0) { pow2 = EXPR_INTERN_DEFAULT_CAP; }
+
+    MemoryZeroStruct(*interner);
+    interner->arena = arena;
+    interner->slots = arena->PushArray<Expr *>(pow2);
+    interner->hashes = arena->PushArrayNoZero<U64>(pow2);
+    interner->cap = pow2;
+    return interner->slots && interner->hashes;
+}
+
+//////////////////
+// Table
+
+// A leaf's own structural hash, child identities for operators: children are
+// interned already, so their addresses stand for their structure
+internal U64 
+ExprInternHash(ExprKind kind, Expr *leaf, Expr **children, U32 count)
+{
+    if (ExprKindIsLeaf(kind)) { return leaf->hash; }
+    U64 hash = HashU64((U64)kind + 1);
+    for (U32 i = 0; i < count; i += 1) { hash = HashCombine(hash, (U64)(uintptr_t)children[i]); }
+    return hash;
+}
+
+internal B32 
+ExprInternSame(Expr *expr, ExprKind kind, Expr *leaf, Expr **children, U32 count)
+{
+    if (expr->kind != kind) { return 0; }
+    switch (kind)
+    {
+        case ExprKind::NUM:
+        case ExprKind::BIG_NUM:
+        case ExprKind::VAR: return ExprMatchNode(expr, leaf);
+        case ExprKind::PRE_UNARY_MINUS: return expr->operand == children[0];
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT: return expr->bin.left == children[0] && expr->bin.right == children[1];
+        default: return expr->count == count && std::memcmp(expr->operands, children, sizeof(Expr *) * count) == 0;
+    }
+}
+
+internal B32 
+ExprInternGrow(ExprInterner *interner)
+{
+    U64 cap = interner->cap * 2;
+    Expr **slots = interner->arena->PushArray<Expr *>(cap);
+    U64 *hashes = interner->arena->PushArrayNoZero<U64>(cap);
+    if (!slots || !hashes) { return 0; }
+    for (U64 i = 0; i < interner->cap; i += 1)
+    {
+        if (!interner->slots[i]) { continue; }
+        U64 slot = interner->hashes[i] & (cap - 1);
+        while (slots[slot]) { slot = (slot + 1) & (cap - 1); }
+        slots[slot] = interner->slots[i];
+        hashes[slot] = interner->hashes[i];
+    }
+    interner->slots = slots;
+    interner->hashes = hashes;
+    interner->cap = cap;
+    return 1;
+}
+
+// Finds the node or builds it, children are only copied on a miss
+internal Expr *
+ExprInternFind(ExprInterner *interner, ExprKind kind, Expr *leaf, Expr **children, U32 count)
+{
+    for (U32 i = 0; i < count; i += 1)
+    {
+        if (!children[i]) { return nullptr; }
+    }
+
+    U64 hash = ExprInternHash(kind, leaf, children, count);
+    U64 mask = interner->cap - 1;
+    U64 slot = hash & mask;
+    for (; interner->slots[slot]; slot = (slot + 1) & mask)
+    {
+        if (interner->hashes[slot] == hash && ExprInternSame(interner->slots[slot], kind, leaf, children, count))
+        {
+            return interner->slots[slot];
+        }
+    }
+
+    Arena *arena = interner->arena;
+    Expr *expr = nullptr;
+    switch (kind)
+    {
+        case ExprKind::NUM:
+        case ExprKind::BIG_NUM: expr = ExprPushInteger(arena, ExprInteger(leaf)); break;
+        case ExprKind::VAR: expr = ExprPushVar(arena, leaf->var); break;
+        case ExprKind::PRE_UNARY_MINUS: expr = ExprPushUnary(arena, children[0]); break;
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT: expr = ExprPushBinary(arena, kind, children[0], children[1]); break;
+        default: expr = ExprPushNary(arena, kind, children, count); break;
+    }
+    if (!expr) { return nullptr; }
+
+    interner->slots[slot] = expr;
+    interner->hashes[slot] = hash;
+    interner->count += 1;
+    if (interner->count * 2 > interner->cap && !ExprInternGrow(interner)) { return nullptr; }
+    return expr;
+}
+
+//////////////////
+// Construction
+
+internal Expr *
+ExprInternLeaf(ExprInterner *interner, Expr *leaf)
+{
+    return ExprInternFind(interner, leaf->kind, leaf, nullptr, 0);
+}
+
+internal Expr *
+ExprInternNum(ExprInterner *interner, S64 value)
+{
+    Expr leaf = {};
+    leaf.kind = ExprKind::NUM;
+    leaf.num = value;
+    leaf.hash = ExprHashNum(value);
+    return ExprInternLeaf(interner, &leaf);
+}
+
+internal Expr *
+ExprInternVar(ExprInterner *interner, String8 name)
+{
+    Expr leaf = {};
+    leaf.kind = ExprKind::VAR;
+    leaf.var = name;
+    leaf.hash = ExprHashVar(name);
+    return ExprInternLeaf(interner, &leaf);
+}
+
+internal Expr *
+ExprInternUnary(ExprInterner *interner, Expr *operand)
+{
+    return ExprInternFind(interner, ExprKind::PRE_UNARY_MINUS, nullptr, &operand, 1);
+}
+
+internal Expr *
+ExprInternBinary(ExprInterner *interner, ExprKind kind, Expr *left, Expr *right)
+{
+    Expr *children[2] = {left, right};
+    return ExprInternFind(interner, kind, nullptr, children, 2);
+}
+
+internal Expr *
+ExprInternNary(ExprInterner *interner, ExprKind kind, Expr **ops, U32 count)
+{
+    return ExprInternFind(interner, kind, nullptr, ops, count);
+}
+
+internal Expr *
+ExprIntern(ExprInterner *interner, Arena *scratch, Expr *root)
+{
+    // Postorder: a node is interned once all of its children are, their
+    // interned versions wait on done until then
+    struct Frame { Expr *expr; U32 next; };
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0, done_count = 0, done_cap = 0;
+    Frame *stack = nullptr;
+    Expr **done = nullptr;
+
+    Expr *result = nullptr;
+    B32 ok = (stack = ArenaGrowArray(scratch, stack, count, &cap)) != nullptr;
+    if (ok) { stack[count++] = {root, 0}; }
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        U32 children = ExprChildCount(expr);
+        if (top->next < children)
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0};
+            continue;
+        }
+
+        Expr **ops = done + done_count - children;
+        Expr *interned = ExprInternFind(interner, expr->kind, expr, ops, children);
+        if (!interned) { ok = 0; break; }
+        done_count -= children;
+        count -= 1;
+        if (count == 0) { result = interned; break; }
+        if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+        done[done_count++] = interned;
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    return ok ? result : nullptr;
+}
@@ -0,0 +1,38 @@
+/*
+ast_intern.hpp
+
+Hash-consing node factory. Every (kind, literal, children) combination is built
+once, so structurally equal subtrees are the same node and comparing them is a
+pointer compare. Children passed in must come from the same interner.
+*/
+#ifndef AST_INTERN_HPP
+#define AST_INTERN_HPP
+
+struct ExprInterner 
+{
+    Arena *arena;           // nodes, operand arrays, names and the table itself
+    Expr **slots;           // open addressing, nullptr is empty
+    U64 *hashes;            // hash of the node in the same slot
+    U64 cap;                // power of two
+    U64 count;              // distinct nodes
+};
+
+// cap is rounded up to a power of two, 0 picks a default
+internal B32 ExprInternerInit(ExprInterner *interner, Arena *arena, U64 cap);
+
+//////////////////
+// Construction
+// Same shapes as ExprPush*, all return nullptr when the arena runs out
+
+// A NUM, BIG_NUM or VAR equal to leaf, which can live anywhere
+internal Expr *ExprInternLeaf(ExprInterner *interner, Expr *leaf);
+internal Expr *ExprInternNum(ExprInterner *interner, S64 value);
+internal Expr *ExprInternVar(ExprInterner *interner, String8 name);
+internal Expr *ExprInternUnary(ExprInterner *interner, Expr *operand);
+internal Expr *ExprInternBinary(ExprInterner *interner, ExprKind kind, Expr *left, Expr *right);
+internal Expr *ExprInternNary(ExprInterner *interner, ExprKind kind, Expr **ops, U32 count);
+
+// Interns an existing tree bottom up, the result shares every repeated subtree
+internal Expr *ExprIntern(ExprInterner *interner, Arena *scratch, Expr *root);
+
+#endif // AST_INTERN_HPP
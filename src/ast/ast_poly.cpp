@@ -0,0 +1,614 @@
+//////////////////
+// Ring
+
+internal U32 
+PolyShift(PolyRing const *ring, U32 var)
+{
+    return (ring->var_count - 1 - var) * ring->bits;
+}
+
+internal B32 
+PolyRingFromExpr(Arena *arena, Arena *scratch, Expr *root, PolyRing *out)
+{
+    String8 names[POLY_MAX_VARS];
+    U64 hashes[POLY_MAX_VARS];
+    U32 var_count = 0;
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0;
+    Expr **stack = nullptr;
+    B32 ok = 1;
+    Expr *expr = root;
+    while (ok)
+    {
+        if (expr->kind == ExprKind::VAR)
+        {
+            U32 i = 0;
+            while (i < var_count && !(hashes[i] == expr->hash && Str8Match(names[i], expr->var))) { i += 1; }
+            if (i == var_count)
+            {
+                if (var_count == POLY_MAX_VARS) { ok = 0; break; }
+                names[var_count] = expr->var;
+                hashes[var_count++] = expr->hash;
+            }
+        }
+        U32 children = ExprChildCount(expr);
+        if (children == 0)
+        {
+            if (count == 0) { break; }
+            expr = stack[--count];
+            continue;
+        }
+        for (U32 i = children - 1; i > 0; i -= 1)
+        {
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = ExprChild(expr, i);
+        }
+        expr = ExprChild(expr, 0);
+    }
+    scratch->ArenaSetPosBack(pos);
+    if (!ok) { return 0; }
+
+    // Sorted by name so terms print in the same order whatever the input order
+    for (U32 i = 1; i < var_count; i += 1)
+    {
+        String8 name = names[i];
+        U32 j = i;
+        for (; j > 0; j -= 1)
+        {
+            String8 prev = names[j - 1];
+            int order = memcmp(prev.str, name.str, Min(prev.size, name.size));
+            if (order < 0 || (order == 0 && prev.size <= name.size)) { break; }
+            names[j] = prev;
+        }
+        names[j] = name;
+    }
+
+    PolyRing ring = {};
+    ring.var_count = var_count;
+    ring.bits = var_count ? Min<U32>(32, 64 / var_count) : 32;
+    if (var_count && !(ring.vars = arena->PushArrayNoZero<String8>(var_count))) { return 0; }
+    for (U32 i = 0; i < var_count; i += 1)
+    {
+        if (!(ring.vars[i] = PushStr8Copy(arena, names[i])).str) { return 0; }
+        ring.guards |= (U64)1 << (PolyShift(&ring, i) + ring.bits - 1);
+    }
+    *out = ring;
+    return 1;
+}
+
+internal S32 
+PolyRingVar(PolyRing const *ring, String8 name)
+{
+    for (U32 i = 0; i < ring->var_count; i += 1)
+    {
+        if (Str8Match(ring->vars[i], name)) { return (S32)i; }
+    }
+    return -1;
+}
+
+internal U32 
+PolyExponent(PolyRing const *ring, U64 exps, U32 var)
+{
+    return (U32)((exps >> PolyShift(ring, var)) & (((U64)1 << ring->bits) - 1));
+}
+
+internal U32 
+PolyDegree(PolyRing const *ring, U64 exps)
+{
+    U32 degree = 0;
+    for (U32 i = 0; i < ring->var_count; i += 1) { degree += PolyExponent(ring, exps, i); }
+    return degree;
+}
+
+//////////////////
+// Addition
+
+internal B32 
+PolySubS64Checked(S64 a, S64 b, S64 *out)
+{
+    S64 negated = 0;
+    return MulS64Checked(b, -1, &negated) && AddS64Checked(a, negated, out);
+}
+
+// Merges two term lists into dst, which has room for both. Equal monomials add
+// up, zero sums drop out, sums past S64 go in arena.
+internal B32 
+PolyMerge(Arena *arena, PolyTerm const *a, U64 a_count, PolyTerm const *b, U64 b_count, PolyTerm *dst, U64 *count)
+{
+    U64 i = 0, j = 0, n = 0;
+    while (i < a_count && j < b_count)
+    {
+        if (a[i].exps > b[j].exps)      { dst[n++] = a[i++]; }
+        else if (a[i].exps < b[j].exps) { dst[n++] = b[j++]; }
+        else
+        {
+            Integer coef;
+            if (!IntAdd(arena, a[i].coef, b[j].coef, &coef)) { return 0; }
+            if (IntSign(coef)) { dst[n++] = {a[i].exps, coef}; }
+            i += 1;
+            j += 1;
+        }
+    }
+    for (; i < a_count; i += 1) { dst[n++] = a[i]; }
+    for (; j < b_count; j += 1) { dst[n++] = b[j]; }
+    *count = n;
+    return 1;
+}
+
+internal B32 
+PolyAdd(Arena *arena, Poly const *a, Poly const *b, Poly *out)
+{
+    Poly sum = {};
+    U64 cap = a->count + b->count;
+    if (cap && !(sum.terms = arena->PushArrayNoZero<PolyTerm>(cap))) { return 0; }
+    if (!PolyMerge(arena, a->terms, a->count, b->terms, b->count, sum.terms, &sum.count)) { return 0; }
+    *out = sum;
+    return 1;
+}
+
+internal B32 
+PolyNegate(Arena *arena, Poly *poly)
+{
+    for (U64 i = 0; i < poly->count; i += 1)
+    {
+        if (!IntNegate(arena, poly->terms[i].coef, &poly->terms[i].coef)) { return 0; }
+    }
+    return 1;
+}
+
+internal B32 
+PolyEqual(Poly const *a, Poly const *b)
+{
+    if (a->count != b->count) { return 0; }
+    for (U64 i = 0; i < a->count; i += 1)
+    {
+        if (a->terms[i].exps != b->terms[i].exps || IntCompare(a->terms[i].coef, b->terms[i].coef) != 0) { return 0; }
+    }
+    return 1;
+}
+
+//////////////////
+// Heap multiplication
+
+struct PolyHeapEntry 
+{
+    U64 exps;               // of a[i] * b[j]
+    U32 i;
+    U32 j;
+};
+
+internal void 
+PolyHeapPush(PolyHeapEntry *heap, U64 *count, PolyHeapEntry entry)
+{
+    U64 at = (*count)++;
+    while (at > 0)
+    {
+        U64 parent = (at - 1) / 2;
+        if (heap[parent].exps >= entry.exps) { break; }
+        heap[at] = heap[parent];
+        at = parent;
+    }
+    heap[at] = entry;
+}
+
+internal PolyHeapEntry 
+PolyHeapPop(PolyHeapEntry *heap, U64 *count)
+{
+    PolyHeapEntry top = heap[0];
+    PolyHeapEntry last = heap[--(*count)];
+    U64 at = 0;
+    for (;;)
+    {
+        U64 child = at * 2 + 1;
+        if (child >= *count) { break; }
+        if (child + 1 < *count && heap[child + 1].exps > heap[child].exps) { child += 1; }
+        if (heap[child].exps <= last.exps) { break; }
+        heap[at] = heap[child];
+        at = child;
+    }
+    if (*count) { heap[at] = last; }
+    return top;
+}
+
+// Packed product of two monomials, 0 when a field overflows into its guard bit
+internal B32 
+PolyMonomialMul(PolyRing const *ring, U64 a, U64 b, U64 *out)
+{
+    *out = a + b;
+    return (*out & ring->guards) == 0;
+}
+
+// A single term times b keeps b's order, no merging needed
+internal B32 
+PolyMulTerm(Arena *arena, PolyRing const *ring, PolyTerm term, Poly const *b, Poly *out)
+{
+    Poly product = {};
+    if (!(product.terms = arena->PushArrayNoZero<PolyTerm>(b->count))) { return 0; }
+    for (U64 j = 0; j < b->count; j += 1)
+    {
+        PolyTerm *dst = &product.terms[j];
+        if (!PolyMonomialMul(ring, term.exps, b->terms[j].exps, &dst->exps)) { return 0; }
+        if (!IntMul(arena, term.coef, b->terms[j].coef, &dst->coef)) { return 0; }
+    }
+    product.count = b->count;
+    *out = product;
+    return 1;
+}
+
+// scratch may be arena itself, working memory then stays behind in it.
+// Coefficients are summed in arena, where the product's end up.
+internal B32 
+PolyMulHeap(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *a, Poly const *b, Poly *out)
+{
+    if (a->count > b->count) { Poly const *swap = a; a = b; b = swap; }
+    if (a->count == 0) { *out = {}; return 1; }
+    if (a->count == 1) { return PolyMulTerm(arena, ring, a->terms[0], b, out); }
+    if (a->count > max_U32 || b->count > max_U32) { return 0; }
+
+    // Row i enters the heap once row i - 1 has used its first column, so the heap
+    // never holds more than one entry per term of a
+    U64 pos = scratch->ArenaGetPos();
+    PolyHeapEntry *heap = scratch->PushArrayNoZero<PolyHeapEntry>(a->count);
+    U64 heap_count = 0;
+    Poly product = {};
+    U64 cap = Min<U64>(a->count * b->count, 1 << 16);
+    B32 ok = heap && (product.terms = arena->PushArrayNoZero<PolyTerm>(cap)) != nullptr;
+    U64 exps = 0;
+    ok = ok && PolyMonomialMul(ring, a->terms[0].exps, b->terms[0].exps, &exps);
+    if (ok) { PolyHeapPush(heap, &heap_count, {exps, 0, 0}); }
+    while (ok && heap_count)
+    {
+        U64 current = heap[0].exps;
+        Integer coef = IntFromS64(0);
+        while (ok && heap_count && heap[0].exps == current)
+        {
+            PolyHeapEntry entry = PolyHeapPop(heap, &heap_count);
+            Integer term;
+            ok = IntMul(arena, a->terms[entry.i].coef, b->terms[entry.j].coef, &term) && IntAdd(arena, coef, term, &coef);
+            if (ok && entry.j == 0 && entry.i + 1 < a->count)
+            {
+                ok = PolyMonomialMul(ring, a->terms[entry.i + 1].exps, b->terms[0].exps, &exps);
+                if (ok) { PolyHeapPush(heap, &heap_count, {exps, entry.i + 1, 0}); }
+            }
+            if (ok && entry.j + 1 < b->count)
+            {
+                ok = PolyMonomialMul(ring, a->terms[entry.i].exps, b->terms[entry.j + 1].exps, &exps);
+                if (ok) { PolyHeapPush(heap, &heap_count, {exps, entry.i, entry.j + 1}); }
+            }
+        }
+        if (!ok || IntSign(coef) == 0) { continue; }
+        if (product.count == cap && !(product.terms = ArenaGrowArray(arena, product.terms, product.count, &cap))) { ok = 0; break; }
+        product.terms[product.count++] = {current, coef};
+    }
+
+    if (scratch != arena) { scratch->ArenaSetPosBack(pos); }
+    if (ok) { *out = product; }
+    return ok;
+}
+
+//////////////////
+// Karatsuba
+
+internal B32 
+PolySchoolbook(S64 const *a, S64 const *b, U64 n, S64 *out)
+{
+    MemoryZero(out, sizeof(S64) * 2 * n);
+    for (U64 i = 0; i < n; i += 1)
+    {
+        if (a[i] == 0) { continue; }
+        for (U64 j = 0; j < n; j += 1)
+        {
+            S64 term = 0, sum = 0;
+            if (!MulS64Checked(a[i], b[j], &term) || !AddS64Checked(out[i + j], term, &sum)) { return 0; }
+            out[i + j] = sum;
+        }
+    }
+    return 1;
+}
+
+// out gets 2n coefficients. tmp needs 4 * (n + 64), each level takes 4h of it
+// for the half sums and the middle product.
+internal B32 
+PolyKaratsubaDense(S64 const *a, S64 const *b, U64 n, S64 *out, S64 *tmp)
+{
+    if (n <= POLY_KARATSUBA_MIN) { return PolySchoolbook(a, b, n, out); }
+    U64 m = n / 2, h = n - m;
+    S64 *sa = tmp, *sb = tmp + h, *mid = tmp + 2 * h;
+    for (U64 i = 0; i < h; i += 1)
+    {
+        sa[i] = a[m + i];
+        sb[i] = b[m + i];
+        if (i < m && (!AddS64Checked(a[m + i], a[i], &sa[i]) || !AddS64Checked(b[m + i], b[i], &sb[i]))) { return 0; }
+    }
+
+    // low * low and high * high go straight to their places in out
+    if (!PolyKaratsubaDense(a, b, m, out, tmp + 4 * h)) { return 0; }
+    if (!PolyKaratsubaDense(a + m, b + m, h, out + 2 * m, tmp + 4 * h)) { return 0; }
+    if (!PolyKaratsubaDense(sa, sb, h, mid, tmp + 4 * h)) { return 0; }
+    for (U64 i = 0; i < 2 * m; i += 1)
+    {
+        if (!PolySubS64Checked(mid[i], out[i], &mid[i])) { return 0; }
+    }
+    for (U64 i = 0; i < 2 * h; i += 1)
+    {
+        if (!PolySubS64Checked(mid[i], out[2 * m + i], &mid[i])) { return 0; }
+    }
+    for (U64 i = 0; i < 2 * h; i += 1)
+    {
+        S64 sum = 0;
+        if (!AddS64Checked(out[m + i], mid[i], &sum)) { return 0; }
+        out[m + i] = sum;
+    }
+    return 1;
+}
+
+internal B32 
+PolyMulKaratsuba(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *a, Poly const *b, Poly *out)
+{
+    if (ring->var_count != 1) { return 0; }
+    if (a->count == 0 || b->count == 0) { *out = {}; return 1; }
+
+    // Univariate exponents sit at the bottom of the word, the first term has the top degree
+    U64 n = Max(a->terms[0].exps, b->terms[0].exps) + 1;
+    U64 pos = scratch->ArenaGetPos();
+    S64 *dense = scratch->PushArray<S64>(2 * n);
+    S64 *product = scratch->PushArrayNoZero<S64>(2 * n);
+    S64 *tmp = scratch->PushArrayNoZero<S64>(4 * (n + 64));
+    B32 ok = dense && product && tmp;
+    if (ok)
+    {
+        for (U64 i = 0; ok && i < a->count; i += 1) { dense[a->terms[i].exps] = a->terms[i].coef.small; ok = !a->terms[i].coef.big; }
+        for (U64 i = 0; ok && i < b->count; i += 1) { dense[n + b->terms[i].exps] = b->terms[i].coef.small; ok = !b->terms[i].coef.big; }
+        ok = ok && PolyKaratsubaDense(dense, dense + n, n, product, tmp);
+    }
+
+    U64 terms = 0;
+    for (U64 e = 0; ok && e < 2 * n; e += 1) { terms += product[e] != 0; }
+    Poly result = {};
+    result.count = terms;
+    ok = ok && 2 * n - 2 < ring->guards;
+    if (ok && terms && !(result.terms = arena->PushArrayNoZero<PolyTerm>(terms))) { ok = 0; }
+    for (U64 e = 2 * n, i = 0; ok && e > 0; e -= 1)
+    {
+        if (product[e - 1]) { result.terms[i++] = {e - 1, IntFromS64(product[e - 1])}; }
+    }
+
+    if (scratch != arena) { scratch->ArenaSetPosBack(pos); }
+    if (ok) { *out = result; }
+    return ok;
+}
+
+internal B32 
+PolyMul(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *a, Poly const *b, Poly *out, ExpandReport *report)
+{
+    ExpandReport counts = {};
+    ExpandReport *r = report ? report : &counts;
+
+    // Dense: at least a quarter of the coefficients up to the degree are nonzero
+    B32 dense = ring->var_count == 1 && Min(a->count, b->count) >= POLY_KARATSUBA_MIN &&
+                a->count * 4 > a->terms[0].exps && b->count * 4 > b->terms[0].exps;
+    if (dense && PolyMulKaratsuba(arena, scratch, ring, a, b, out))
+    {
+        r->dense_products += 1;
+        return 1;
+    }
+    r->heap_products += 1;
+    return PolyMulHeap(arena, scratch, ring, a, b, out);
+}
+
+//////////////////
+// Conversion
+
+// Sums operands pairwise, round after round, ping-ponging between two buffers
+// sized for all the terms: linear memory and log(count) passes over the terms.
+// The rounds are arranged to end in the buffer from arena, the other one and
+// the sums in between live in scratch, which may be arena itself.
+internal B32 
+PolySumAll(Arena *arena, Arena *scratch, Poly *ops, U32 count, Poly *out)
+{
+    U64 total = 0;
+    U32 kept = 0;
+    for (U32 i = 0; i < count; i += 1)
+    {
+        total += ops[i].count;
+        if (ops[i].count) { ops[kept++] = ops[i]; }
+    }
+    count = kept;
+    if (count <= 1)
+    {
+        *out = count ? ops[0] : Poly{};
+        return 1;
+    }
+
+    U32 rounds = 0;
+    for (U32 n = count; n > 1; n = (n + 1) / 2) { rounds += 1; }
+    PolyTerm *result = arena->PushArrayNoZero<PolyTerm>(total);
+    U64 pos = scratch->ArenaGetPos();
+    PolyTerm *buffers[2] = {result, scratch->PushArrayNoZero<PolyTerm>(total)};
+    if (!buffers[0] || !buffers[1]) { return 0; }
+    for (U32 round = 0; count > 1; round += 1)
+    {
+        PolyTerm *dst = buffers[(rounds - 1 - round) & 1];
+        U32 next = 0;
+        for (U32 i = 0; i < count; i += 2)
+        {
+            Poly merged = {dst, 0};
+            if (i + 1 == count)
+            {
+                MemoryCopy(dst, ops[i].terms, sizeof(PolyTerm) * ops[i].count);
+                merged.count = ops[i].count;
+            }
+            else if (!PolyMerge(scratch, ops[i].terms, ops[i].count, ops[i + 1].terms, ops[i + 1].count, dst, &merged.count)) { return 0; }
+            dst += merged.count;
+            ops[next++] = merged;
+        }
+        count = next;
+    }
+
+    // Big sums still point into scratch, and when that is arena they pin it
+    B32 big = 0;
+    for (U64 i = 0; i < ops[0].count; i += 1) { big |= ops[0].terms[i].coef.big != nullptr; }
+    if (scratch != arena)
+    {
+        for (U64 i = 0; big && i < ops[0].count; i += 1)
+        {
+            if (!IntCopy(arena, ops[0].terms[i].coef, &ops[0].terms[i].coef)) { return 0; }
+        }
+        scratch->ArenaSetPosBack(pos);
+    }
+    else if (!big) { scratch->ArenaSetPosBack(pos); }
+    *out = ops[0];
+    return 1;
+}
+
+internal B32 
+PolyFromExpr(Arena *arena, Arena *scratch, PolyRing const *ring, Expr *root, Poly *out, ExpandReport *report)
+{
+    // Postorder, children's polynomials wait on done. Everything in between lives
+    // in scratch, only the result is copied out.
+    struct Frame { Expr *expr; U32 next; };
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0, done_count = 0, done_cap = 0;
+    Frame *stack = nullptr;
+    Poly *done = nullptr;
+
+    Poly result = {};
+    B32 ok = (stack = ArenaGrowArray(scratch, stack, count, &cap)) != nullptr;
+    if (ok) { stack[count++] = {root, 0}; }
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        U32 children = ExprChildCount(expr);
+        if (top->next < children)
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0};
+            continue;
+        }
+
+        Poly *ops = done + done_count - children;
+        Poly poly = {};
+        switch (expr->kind)
+        {
+            case ExprKind::NUM:
+            case ExprKind::BIG_NUM:
+            {
+                Integer value = ExprInteger(expr);
+                if (IntSign(value) == 0) { break; }
+                ok = (poly.terms = scratch->PushArrayNoZero<PolyTerm>(1)) != nullptr;
+                if (ok) { poly.terms[0] = {0, value}; poly.count = 1; }
+            } break;
+            case ExprKind::VAR:
+            {
+                S32 var = PolyRingVar(ring, expr->var);
+                ok = var >= 0 && (poly.terms = scratch->PushArrayNoZero<PolyTerm>(1)) != nullptr;
+                if (ok) { poly.terms[0] = {(U64)1 << PolyShift(ring, (U32)var), IntFromS64(1)}; poly.count = 1; }
+            } break;
+            case ExprKind::PRE_UNARY_MINUS: { poly = ops[0]; ok = PolyNegate(scratch, &poly); } break;
+            case ExprKind::DIFFERENCE: { ok = PolyNegate(scratch, &ops[1]) && PolyAdd(scratch, &ops[0], &ops[1], &poly); } break;
+            case ExprKind::QUOTIENT:
+            {
+                // Exact division by a constant, coefficients stay integers
+                Poly divisor = ops[1];
+                ok = divisor.count == 1 && divisor.terms[0].exps == 0;
+                poly = ops[0];
+                for (U64 i = 0; ok && i < poly.count; i += 1)
+                {
+                    Integer remainder;
+                    ok = IntDivMod(scratch, scratch, poly.terms[i].coef, divisor.terms[0].coef, &poly.terms[i].coef, &remainder) &&
+                         IntSign(remainder) == 0;
+                }
+            } break;
+            case ExprKind::PLUS: { ok = PolySumAll(scratch, scratch, ops, children, &poly); } break;
+            case ExprKind::MULTIPLY:
+            {
+                poly = ops[0];
+                for (U32 i = 1; ok && i < children; i += 1)
+                {
+                    Poly product = {};
+                    ok = PolyMul(scratch, scratch, ring, &poly, &ops[i], &product, report);
+                    poly = product;
+                }
+            } break;
+            default: { ok = 0; } break;
+        }
+        if (!ok) { break; }
+        done_count -= children;
+        count -= 1;
+        if (count == 0) { result = poly; break; }
+        if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+        done[done_count++] = poly;
+    }
+
+    // Copied while scratch still holds it, arena may be scratch itself
+    PolyTerm *terms = nullptr;
+    if (ok && result.count && (terms = arena->PushArrayNoZero<PolyTerm>(result.count)))
+    {
+        MemoryCopy(terms, result.terms, sizeof(PolyTerm) * result.count);
+        for (U64 i = 0; ok && i < result.count; i += 1) { ok = IntCopy(arena, terms[i].coef, &terms[i].coef); }
+    }
+    ok = ok && (result.count == 0 || terms);
+    if (scratch != arena) { scratch->ArenaSetPosBack(pos); }
+    if (ok) { *out = {terms, result.count}; }
+    return ok;
+}
+
+internal Expr *
+PolyToExpr(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *poly)
+{
+    if (poly->count == 0) { return ExprPushNum(arena, 0); }
+    if (poly->count >= max_U32) { return nullptr; }
+
+    U64 pos = scratch->ArenaGetPos();
+    Expr **terms = scratch->PushArrayNoZero<Expr *>(poly->count);
+    Expr **factors = nullptr;
+    U64 factor_cap = 0;
+    B32 ok = terms != nullptr;
+    for (U64 t = 0; ok && t < poly->count; t += 1)
+    {
+        PolyTerm term = poly->terms[t];
+        U64 degree = PolyDegree(ring, term.exps);
+        B32 unit = IntIsSmall(term.coef) && (term.coef.small == 1 || term.coef.small == -1);
+        B32 lead = !unit;
+        U64 count = degree + (lead || degree == 0);
+        while (ok && count > factor_cap) { ok = (factors = ArenaGrowArray(scratch, factors, 0, &factor_cap)) != nullptr; }
+        if (!ok || count >= max_U32) { ok = 0; break; }
+
+        U64 n = 0;
+        if (lead || degree == 0) { ok = (factors[n++] = ExprPushInteger(arena, term.coef)) != nullptr; }
+        for (U32 v = 0; ok && v < ring->var_count; v += 1)
+        {
+            for (U32 e = PolyExponent(ring, term.exps, v); ok && e > 0; e -= 1)
+            {
+                ok = (factors[n++] = ExprPushVar(arena, ring->vars[v])) != nullptr;
+            }
+        }
+        if (!ok) { break; }
+        Expr *product = n == 1 ? factors[0] : ExprPushNary(arena, ExprKind::MULTIPLY, factors, (U32)n);
+        if (product && unit && degree && term.coef.small == -1) { product = ExprPushUnary(arena, product); }
+        ok = (terms[t] = product) != nullptr;
+    }
+
+    Expr *result = nullptr;
+    if (ok) { result = poly->count == 1 ? terms[0] : ExprPushNary(arena, ExprKind::PLUS, terms, (U32)poly->count); }
+    scratch->ArenaSetPosBack(pos);
+    return result;
+}
+
+internal Expr *
+ExprExpand(Arena *arena, Arena *scratch, Expr *root, ExpandReport *report)
+{
+    ExpandReport counts = {};
+    PolyRing ring = {};
+    Poly poly = {};
+    if (!PolyRingFromExpr(arena, scratch, root, &ring)) { return nullptr; }
+    if (!PolyFromExpr(arena, scratch, &ring, root, &poly, &counts)) { return nullptr; }
+    counts.terms = poly.count;
+    if (report) { *report = counts; }
+    return PolyToExpr(arena, scratch, &ring, &poly);
+}
@@ -0,0 +1,100 @@
+/*
+ast_poly.hpp
+
+Sparse multivariate polynomials with integer coefficients of any size, for
+expanding products without going through tree rewrites. Coefficients stay S64
+until one outgrows it, see base_number.hpp. A term is a coefficient and a packed
+exponent vector: every variable of the ring owns a fixed field of one U64, the
+first variable in the highest bits, so comparing two packed words is lex order
+on monomials and multiplying two monomials is one add. The top bit of each
+field is a guard that must stay clear, which catches exponent overflow without
+unpacking.
+
+Products go through a heap merge (Johnson): one heap entry per term of the
+smaller operand walks along the larger one, terms come out in descending order
+and equal monomials are summed as they leave, so nothing is sorted afterwards
+and the working set is the smaller operand. Dense univariate products switch to
+Karatsuba over S64 coefficient arrays, and back to the heap merge when a
+coefficient doesn't fit.
+
+There is no power operator, so (x+y+1)^20 is written out as 20 factors; the
+heap merge keeps each step proportional to the terms it produces.
+*/
+#ifndef AST_POLY_HPP
+#define AST_POLY_HPP
+
+#define POLY_MAX_VARS 21            // fields of 3 bits: exponents up to 3
+#define POLY_KARATSUBA_MIN 32       // below this many coefficients schoolbook wins
+
+struct PolyRing 
+{
+    String8 *vars;                  // sorted by name, a variable's index is its id
+    U32 var_count;
+    U32 bits;                       // per field, guard bit included
+    U64 guards;                     // the top bit of every field
+};
+
+struct PolyTerm 
+{
+    U64 exps;                       // packed, see PolyExponent
+    Integer coef;                   // never 0
+};
+
+// Terms in strictly descending exps. The zero polynomial has no terms.
+struct Poly 
+{
+    PolyTerm *terms;
+    U64 count;
+};
+
+struct ExpandReport 
+{
+    U64 terms;                      // in the expanded result
+    U64 heap_products;              // multiplications done by heap merge
+    U64 dense_products;             // multiplications done by Karatsuba
+};
+
+//////////////////
+// Ring
+
+// Ring over the variables root uses. 0 if there are more than POLY_MAX_VARS or
+// an arena runs out.
+internal B32 PolyRingFromExpr(Arena *arena, Arena *scratch, Expr *root, PolyRing *out);
+// Id of name, -1 if the ring doesn't have it
+internal S32 PolyRingVar(PolyRing const *ring, String8 name);
+internal U32 PolyExponent(PolyRing const *ring, U64 exps, U32 var);
+internal U32 PolyDegree(PolyRing const *ring, U64 exps);
+
+//////////////////
+// Arithmetic
+// Results go in arena, scratch holds working memory. All return 0 when an
+// exponent leaves its field or an arena runs out.
+
+internal B32 PolyAdd(Arena *arena, Poly const *a, Poly const *b, Poly *out);
+// In place, a coefficient that outgrows S64 goes in arena
+internal B32 PolyNegate(Arena *arena, Poly *poly);
+internal B32 PolyMulHeap(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *a, Poly const *b, Poly *out);
+// Univariate rings only, 0 also when a coefficient of the operands or the
+// product leaves S64
+internal B32 PolyMulKaratsuba(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *a, Poly const *b, Poly *out);
+// Karatsuba when the ring is univariate and both operands are dense and long
+// enough, the heap merge otherwise
+internal B32 PolyMul(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *a, Poly const *b, Poly *out, ExpandReport *report = nullptr);
+internal B32 PolyEqual(Poly const *a, Poly const *b);
+
+//////////////////
+// Conversion
+
+// 0 also when root is not a polynomial: a quotient by anything other than a
+// constant that divides every coefficient exactly
+internal B32 PolyFromExpr(Arena *arena, Arena *scratch, PolyRing const *ring, Expr *root, Poly *out, ExpandReport *report = nullptr);
+// A sum of terms in the poly's order, each a coefficient (left out when it is
+// 1, a negation when it is -1) times every variable repeated by its exponent
+internal Expr *PolyToExpr(Arena *arena, Arena *scratch, PolyRing const *ring, Poly const *poly);
+
+// Multiplies out every product of sums and collects like terms. nullptr when
+// root is not a polynomial (see PolyFromExpr), an exponent overflows, or an
+// arena runs out.
+internal Expr *ExprExpand(Arena *arena, Arena *scratch, Expr *root, ExpandReport *report = nullptr);
+
+#endif // AST_POLY_HPP
@@ -0,0 +1,237 @@
+//////////////////
+// Writer
+
+internal void 
+ExprWriterInitArena(ExprWriter *writer, Arena *arena)
+{
+    writer->arena = arena;
+    writer->fd = -1;
+    writer->ok = 1;
+    writer->used = 0;
+    writer->total = 0;
+}
+
+internal void 
+ExprWriterInitFd(ExprWriter *writer, int fd)
+{
+    ExprWriterInitArena(writer, nullptr);
+    writer->fd = fd;
+}
+
+internal B32 
+ExprWriterFlush(ExprWriter *writer)
+{
+    if (writer->ok && writer->used)
+    {
+        if (writer->arena)
+        {
+            // Alignment 1, so consecutive flushes land back to back
+            U8 *dst = writer->arena->PushArrayNoZero<U8>(writer->used, 1);
+            if (dst) { MemoryCopy(dst, writer->buffer, writer->used); }
+            writer->ok = dst != nullptr;
+        }
+        else { writer->ok = OSWriteFd(writer->fd, writer->buffer, writer->used); }
+    }
+    writer->used = 0;
+    return writer->ok;
+}
+
+internal void 
+ExprWrite(ExprWriter *writer, void const *data, U64 size)
+{
+    writer->total += size;
+    U8 const *at = (U8 const *)data;
+    while (writer->used + size > EXPR_WRITER_BUFFER_SIZE)
+    {
+        U64 chunk = EXPR_WRITER_BUFFER_SIZE - writer->used;
+        MemoryCopy(writer->buffer + writer->used, at, chunk);
+        writer->used += chunk;
+        ExprWriterFlush(writer);
+        at += chunk;
+        size -= chunk;
+    }
+    MemoryCopy(writer->buffer + writer->used, at, size);
+    writer->used += size;
+}
+
+internal void 
+ExprWriteS64(ExprWriter *writer, S64 value)
+{
+    char digits[24];
+    U64 magnitude = value < 0 ? 0 - (U64)value : (U64)value;
+    U32 at = sizeof(digits);
+    do
+    {
+        digits[--at] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) { digits[--at] = '-'; }
+    ExprWrite(writer, digits + at, sizeof(digits) - at);
+}
+
+internal void 
+ExprWriteInteger(ExprWriter *writer, Arena *scratch, Integer value)
+{
+    if (!value.big) { ExprWriteS64(writer, value.small); return; }
+    U64 pos = scratch->ArenaGetPos();
+    String8 digits = IntToStr8(scratch, scratch, value);
+    if (digits.str) { ExprWrite(writer, digits.str, digits.size); }
+    else            { writer->ok = 0; }
+    scratch->ArenaSetPosBack(pos);
+}
+
+//////////////////
+// Printer
+
+internal B32 
+ExprPrintParens(ExprPrintMode mode, ExprKind parent, ExprKind child, U32 index)
+{
+    switch (mode)
+    {
+        case ExprPrintMode::SEXPR: return 0;
+        // \frac groups its own arguments and is itself atomic
+        case ExprPrintMode::LATEX: return parent != ExprKind::QUOTIENT && child != ExprKind::QUOTIENT && ExprChildNeedsParens(parent, child, index);
+        default: return ExprChildNeedsParens(parent, child, index);
+    }
+}
+
+internal void 
+ExprPrintOpen(ExprWriter *writer, ExprPrintMode mode, ExprKind kind, B32 parens)
+{
+    switch (mode)
+    {
+        case ExprPrintMode::SEXPR:
+        {
+            char text[3] = {'(', ExprKindOperator(kind), ' '};
+            ExprWrite(writer, text, 3);
+        } break;
+        case ExprPrintMode::LATEX:
+        {
+            if (parens) { ExprWrite(writer, "\\left(", 6); }
+            if (kind == ExprKind::PRE_UNARY_MINUS) { ExprWrite(writer, "-", 1); }
+            if (kind == ExprKind::QUOTIENT) { ExprWrite(writer, "\\frac{", 6); }
+        } break;
+        default:
+        {
+            if (parens) { ExprWrite(writer, "(", 1); }
+            if (kind == ExprKind::PRE_UNARY_MINUS) { ExprWrite(writer, "-", 1); }
+        } break;
+    }
+}
+
+internal void 
+ExprPrintBetween(ExprWriter *writer, ExprPrintMode mode, ExprKind kind)
+{
+    if (mode == ExprPrintMode::SEXPR) { ExprWrite(writer, " ", 1); return; }
+    switch (kind)
+    {
+        case ExprKind::PLUS:       ExprWrite(writer, " + ", 3); break;
+        case ExprKind::DIFFERENCE: ExprWrite(writer, " - ", 3); break;
+        case ExprKind::MULTIPLY:
+        {
+            if (mode == ExprPrintMode::LATEX) { ExprWrite(writer, " \\cdot ", 7); }
+            else                              { ExprWrite(writer, "*", 1); }
+        } break;
+        default:
+        {
+            if (mode == ExprPrintMode::LATEX) { ExprWrite(writer, "}{", 2); }
+            else                              { ExprWrite(writer, "/", 1); }
+        } break;
+    }
+}
+
+internal void 
+ExprPrintClose(ExprWriter *writer, ExprPrintMode mode, ExprKind kind, B32 parens)
+{
+    switch (mode)
+    {
+        case ExprPrintMode::SEXPR: ExprWrite(writer, ")", 1); break;
+        case ExprPrintMode::LATEX:
+        {
+            if (kind == ExprKind::QUOTIENT) { ExprWrite(writer, "}", 1); }
+            if (parens) { ExprWrite(writer, "\\right)", 7); }
+        } break;
+        default:
+        {
+            if (parens) { ExprWrite(writer, ")", 1); }
+        } break;
+    }
+}
+
+internal B32 
+ExprPrintTo(ExprWriter *writer, Arena *scratch, Expr *root, ExprPrintMode mode)
+{
+    // Open operators, index is the operand being printed
+    struct Frame { Expr *expr; U32 index; B32 parens; };
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0;
+    Frame *stack = nullptr;
+
+    Expr *expr = root;
+    B32 parens = 0;
+    while (writer->ok)
+    {
+        if (ExprKindIsLeaf(expr->kind))
+        {
+            if (expr->kind == ExprKind::VAR) { ExprWrite(writer, expr->var.str, expr->var.size); }
+            else                             { ExprWriteInteger(writer, scratch, ExprInteger(expr)); }
+
+            // Climb until some operator still has operands to print
+            for (; count; count -= 1)
+            {
+                Frame *frame = &stack[count - 1];
+                frame->index += 1;
+                if (frame->index < ExprChildCount(frame->expr))
+                {
+                    ExprPrintBetween(writer, mode, frame->expr->kind);
+                    expr = ExprChild(frame->expr, frame->index);
+                    parens = ExprPrintParens(mode, frame->expr->kind, expr->kind, frame->index);
+                    break;
+                }
+                ExprPrintClose(writer, mode, frame->expr->kind, frame->parens);
+            }
+            if (count == 0) { break; }
+            continue;
+        }
+
+        if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { writer->ok = 0; break; }
+        ExprPrintOpen(writer, mode, expr->kind, parens);
+        stack[count++] = {expr, 0, parens};
+        Expr *child = ExprChild(expr, 0);
+        parens = ExprPrintParens(mode, expr->kind, child->kind, 0);
+        expr = child;
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    return writer->ok;
+}
+
+internal String8 
+ExprPrint(Arena *arena, Arena *scratch, Expr *root, ExprPrintMode mode)
+{
+    U64 pos = arena->ArenaGetPos();
+    ExprWriter writer;
+    ExprWriterInitArena(&writer, arena);
+    ExprPrintTo(&writer, scratch, root, mode);
+    ExprWrite(&writer, "", 1);
+    if (!ExprWriterFlush(&writer))
+    {
+        arena->ArenaSetPosBack(pos);
+        return Str8(nullptr, 0);
+    }
+    return Str8(arena->memory + pos, writer.total - 1);
+}
+
+internal B32 
+ExprPrintFd(int fd, Arena *scratch, Expr **roots, U64 count, ExprPrintMode mode)
+{
+    ExprWriter writer;
+    ExprWriterInitFd(&writer, fd);
+    for (U64 i = 0; i < count && writer.ok; i += 1)
+    {
+        if (roots[i]) { ExprPrintTo(&writer, scratch, roots[i], mode); }
+        ExprWrite(&writer, "\n", 1);
+    }
+    return ExprWriterFlush(&writer);
+}
@@ -0,0 +1,48 @@
+/*
+ast_print.hpp
+
+Single pass printer. Output goes through a small staging buffer that is flushed
+either onto the end of an arena, so the whole text ends up as one contiguous
+String8, or straight to a file descriptor for batch output.
+*/
+#ifndef AST_PRINT_HPP
+#define AST_PRINT_HPP
+
+enum class ExprPrintMode : U8 
+{
+    INFIX,      // 3*x*(x + 1) - y/2, only the parentheses needed to parse back the same tree
+    LATEX,      // 3 \cdot x \cdot \left(x + 1\right) - \frac{y}{2}
+    SEXPR,      // (- (* 3 x (+ x 1)) (/ y 2)), unary minus is (- x)
+};
+
+#define EXPR_WRITER_BUFFER_SIZE KB(4)
+
+struct ExprWriter 
+{
+    Arena *arena;       // output is appended here, or
+    int fd;             // written here when arena is null
+    B32 ok;
+    U64 used;
+    U64 total;          // bytes accepted so far
+    U8 buffer[EXPR_WRITER_BUFFER_SIZE];
+};
+
+internal void ExprWriterInitArena(ExprWriter *writer, Arena *arena);
+internal void ExprWriterInitFd(ExprWriter *writer, int fd);
+internal void ExprWrite(ExprWriter *writer, void const *data, U64 size);
+internal void ExprWriteS64(ExprWriter *writer, S64 value);
+// Big values are converted to decimal in scratch first
+internal void ExprWriteInteger(ExprWriter *writer, Arena *scratch, Integer value);
+internal B32 ExprWriterFlush(ExprWriter *writer);
+
+// Prints root onto the writer, the stack lives in scratch
+internal B32 ExprPrintTo(ExprWriter *writer, Arena *scratch, Expr *root, ExprPrintMode mode);
+
+// Whole text as one null terminated range of arena, which must not be scratch.
+// Returns an empty string and gives the memory back when either runs out.
+internal String8 ExprPrint(Arena *arena, Arena *scratch, Expr *root, ExprPrintMode mode = ExprPrintMode::INFIX);
+
+// One expression per line, a failed (nullptr) root prints an empty line
+internal B32 ExprPrintFd(int fd, Arena *scratch, Expr **roots, U64 count, ExprPrintMode mode = ExprPrintMode::INFIX);
+
+#endif // AST_PRINT_HPP
@@ -0,0 +1,674 @@
+//////////////////
+// Compiling rules
+
+#define RULE_TREE_DEFAULT_SLOTS 64
+
+internal B32 
+RuleSetInit(RuleSet *set, Arena *arena)
+{
+    MemoryZeroStruct(*set);
+    set->arena = arena;
+    set->tree = ArenaGrowArray(arena, set->tree, set->tree_count, &set->tree_cap);
+    set->slot_cap = RULE_TREE_DEFAULT_SLOTS;
+    set->slots = arena->PushArray<U32>(set->slot_cap);
+    if (!set->tree || !set->slots) { return 0; }
+    set->tree[set->tree_count++] = {ExprKind::COUNT, 0, 0, 0, 0, 0};
+    return 1;
+}
+
+internal U64 
+RuleTreeHash(U32 parent, ExprKind kind, U32 arity, S64 value)
+{
+    U64 hash = HashU64(((U64)parent << 8 | (U64)kind) + 1);
+    hash = HashCombine(hash, arity);
+    return HashCombine(hash, (U64)value);
+}
+
+// Slot of the keyed child of parent, or the empty slot where it would go
+internal U64 
+RuleTreeSlot(RuleSet const *set, U32 parent, ExprKind kind, U32 arity, S64 value)
+{
+    U64 mask = set->slot_cap - 1;
+    U64 slot = RuleTreeHash(parent, kind, arity, value) & mask;
+    for (; set->slots[slot]; slot = (slot + 1) & mask)
+    {
+        RuleTreeNode const *node = &set->tree[set->slots[slot] - 1];
+        if (node->parent == parent && node->kind == kind && node->arity == arity && node->value == value) { break; }
+    }
+    return slot;
+}
+
+// Preorder of root into out, variables numbered by names. New names are added
+// while allow_new is set, otherwise an unknown name fails.
+internal B32 
+RuleCompileSide(Expr *root, RulePat *out, U32 *out_count, String8 *names, U32 *name_count, B32 allow_new)
+{
+    Expr *stack[RULE_MAX_NODES];
+    U32 count = 0, emitted = 0;
+    stack[count++] = root;
+    while (count)
+    {
+        Expr *expr = stack[--count];
+        if (emitted == RULE_MAX_NODES) { return 0; }
+        RulePat pat = {expr->kind, ExprChildCount(expr), 0};
+        if (expr->kind == ExprKind::BIG_NUM) { return 0; }     // patterns key literals by S64
+        if (expr->kind == ExprKind::NUM) { pat.value = expr->num; }
+        if (expr->kind == ExprKind::VAR)
+        {
+            U32 var = 0;
+            while (var < *name_count && !Str8Match(names[var], expr->var)) { var += 1; }
+            if (var == *name_count)
+            {
+                if (!allow_new || var == RULE_MAX_VARS) { return 0; }
+                names[(*name_count)++] = expr->var;
+            }
+            pat.value = var;
+        }
+        out[emitted++] = pat;
+        if (count + pat.arity > RULE_MAX_NODES) { return 0; }
+        for (U32 i = pat.arity; i-- > 0;) { stack[count++] = ExprChild(expr, i); }
+    }
+    *out_count = emitted;
+    return 1;
+}
+
+// Child of node with the given key, appended when missing. 0 when the arena runs out.
+internal U32 
+RuleTreeChild(RuleSet *set, U32 node, RulePat pat)
+{
+    B32 wildcard = pat.kind == ExprKind::VAR;
+    ExprKind kind = wildcard ? ExprKind::COUNT : pat.kind;
+    S64 value = pat.kind == ExprKind::NUM ? pat.value : 0;
+    if (wildcard && set->tree[node].any) { return set->tree[node].any - 1; }
+    U64 slot = wildcard ? 0 : RuleTreeSlot(set, node, kind, pat.arity, value);
+    if (!wildcard && set->slots[slot]) { return set->slots[slot] - 1; }
+
+    if (set->tree_count == set->tree_cap && !(set->tree = ArenaGrowArray(set->arena, set->tree, set->tree_count, &set->tree_cap))) { return 0; }
+    U32 child = (U32)set->tree_count++;
+    set->tree[child] = {kind, pat.arity, value, node, 0, 0};
+    if (wildcard)
+    {
+        set->tree[node].any = child + 1;
+        return child;
+    }
+    set->slots[slot] = child + 1;
+
+    // Keyed children stay under half the slots
+    if (set->tree_count * 2 > set->slot_cap)
+    {
+        U64 cap = set->slot_cap * 2;
+        U32 *slots = set->arena->PushArray<U32>(cap);
+        if (!slots) { return 0; }
+        for (U64 i = 0; i < set->slot_cap; i += 1)
+        {
+            if (!set->slots[i]) { continue; }
+            RuleTreeNode const *n = &set->tree[set->slots[i] - 1];
+            U64 s = RuleTreeHash(n->parent, n->kind, n->arity, n->value) & (cap - 1);
+            while (slots[s]) { s = (s + 1) & (cap - 1); }
+            slots[s] = set->slots[i];
+        }
+        set->slots = slots;
+        set->slot_cap = cap;
+    }
+    return child;
+}
+
+internal B32 
+RuleSetAdd(RuleSet *set, Expr *lhs, Expr *rhs, String8 text)
+{
+    if (!lhs || !rhs || lhs->kind == ExprKind::VAR) { return 0; }
+    RulePat lhs_pats[RULE_MAX_NODES], rhs_pats[RULE_MAX_NODES];
+    String8 names[RULE_MAX_VARS];
+    U32 name_count = 0;
+    Rule rule = {};
+    if (!RuleCompileSide(lhs, lhs_pats, &rule.lhs_count, names, &name_count, 1) ||
+        !RuleCompileSide(rhs, rhs_pats, &rule.rhs_count, names, &name_count, 0))
+    {
+        return 0;
+    }
+
+    Arena *arena = set->arena;
+    rule.var_count = name_count;
+    rule.id = (U32)set->rule_count;
+    rule.rank = rule.id;
+    rule.text = text;
+    rule.lhs = arena->PushArrayNoZero<RulePat>(rule.lhs_count);
+    rule.rhs = arena->PushArrayNoZero<RulePat>(rule.rhs_count);
+    if (!rule.lhs || !rule.rhs) { return 0; }
+    MemoryCopy(rule.lhs, lhs_pats, sizeof(RulePat) * rule.lhs_count);
+    MemoryCopy(rule.rhs, rhs_pats, sizeof(RulePat) * rule.rhs_count);
+
+    U32 node = 0;
+    for (U32 i = 0; i < rule.lhs_count; i += 1)
+    {
+        node = RuleTreeChild(set, node, rule.lhs[i]);
+        if (!node) { return 0; }
+    }
+    if (set->rule_count == set->rule_cap && !(set->rules = ArenaGrowArray(arena, set->rules, set->rule_count, &set->rule_cap))) { return 0; }
+
+    // Kept in rank order along the list, ranks never exceed the count so far
+    U32 *link = &set->tree[node].rules;
+    while (*link) { link = &set->rules[*link - 1].next; }
+    set->rules[set->rule_count] = rule;
+    *link = (U32)++set->rule_count;
+    return 1;
+}
+
+//////////////////
+// Matching
+
+internal B32 
+RuleBind(Rule const *rule, Expr *expr, Expr **binds)
+{
+    Expr *pending[RULE_MAX_NODES];
+    U32 count = 0;
+    pending[count++] = expr;
+    for (U32 i = 0; i < rule->var_count; i += 1) { binds[i] = nullptr; }
+    for (U32 p = 0; p < rule->lhs_count; p += 1)
+    {
+        RulePat pat = rule->lhs[p];
+        Expr *subject = pending[--count];
+        if (pat.kind == ExprKind::VAR)
+        {
+            if (binds[pat.value] && binds[pat.value] != subject) { return 0; }
+            binds[pat.value] = subject;
+            continue;
+        }
+        if (subject->kind != pat.kind || ExprChildCount(subject) != pat.arity) { return 0; }
+        if (pat.kind == ExprKind::NUM && subject->num != pat.value) { return 0; }
+        for (U32 i = pat.arity; i-- > 0;) { pending[count++] = ExprChild(subject, i); }
+    }
+    return 1;
+}
+
+struct RuleQuery 
+{
+    RuleSet const *set;
+    Expr *pending[RULE_MAX_NODES];  // subterms still to be walked, the next on top
+    U32 count;
+    Expr *root;
+    Expr *trial[RULE_MAX_VARS];
+    Expr **binds;
+    Rule const *best;
+    U64 candidates;
+};
+
+// Every rule reachable from node with the pending subterms, keeping the lowest
+// ranked one that binds
+internal void 
+RuleQueryNode(RuleQuery *q, U32 node)
+{
+    RuleSet const *set = q->set;
+    RuleTreeNode const *tree = set->tree;
+    if (q->count == 0)
+    {
+        for (U32 r = tree[node].rules; r; r = set->rules[r - 1].next)
+        {
+            Rule const *rule = &set->rules[r - 1];
+            if (q->best && rule->rank >= q->best->rank) { break; }
+            q->candidates += 1;
+            B32 bound = 0;
+            if (set->stats && rule->id < set->stat_count)
+            {
+                RuleStats *stats = &set->stats[rule->id];
+                U64 start = ReadCycleCounter();
+                bound = RuleBind(rule, q->root, q->trial);
+                stats->cycles += ReadCycleCounter() - start;
+                stats->attempts += 1;
+                stats->matches += bound;
+            }
+            else { bound = RuleBind(rule, q->root, q->trial); }
+            if (bound)
+            {
+                q->best = rule;
+                MemoryCopy(q->binds, q->trial, sizeof(Expr *) * rule->var_count);
+                break;
+            }
+        }
+        return;
+    }
+
+    // The keyed child first: the more specific rules tend to be the ones wanted,
+    // and a match there bounds the ranks worth binding under the wildcard
+    Expr *subject = q->pending[--q->count];
+    if (subject->kind != ExprKind::VAR)
+    {
+        U32 arity = ExprChildCount(subject);
+        S64 value = subject->kind == ExprKind::NUM ? subject->num : 0;
+        U32 child = set->slots[RuleTreeSlot(set, node, subject->kind, arity, value)];
+        if (child)
+        {
+            U32 saved = q->count;
+            for (U32 i = arity; i-- > 0;) { q->pending[q->count++] = ExprChild(subject, i); }
+            RuleQueryNode(q, child - 1);
+            q->count = saved;
+        }
+    }
+    if (tree[node].any) { RuleQueryNode(q, tree[node].any - 1); }
+    q->pending[q->count++] = subject;
+}
+
+internal Rule const * 
+RuleSetMatch(RuleSet const *set, Expr *expr, Expr **binds, RewriteReport *report)
+{
+    RuleQuery q;
+    q.set = set;
+    q.count = 0;
+    q.pending[q.count++] = expr;
+    q.root = expr;
+    q.binds = binds;
+    q.best = nullptr;
+    q.candidates = 0;
+    RuleQueryNode(&q, 0);
+    if (report)
+    {
+        report->lookups += 1;
+        report->candidates += q.candidates;
+    }
+    return q.best;
+}
+
+internal Expr * 
+RuleInstantiate(ExprInterner *interner, Rule const *rule, Expr *const *binds)
+{
+    // Reversed preorder leaves every node's operands on the stack, first operand on top
+    Expr *stack[RULE_MAX_NODES];
+    U32 count = 0;
+    for (U32 p = rule->rhs_count; p-- > 0;)
+    {
+        RulePat pat = rule->rhs[p];
+        Expr *expr = nullptr;
+        Expr *ops[RULE_MAX_NODES];
+        for (U32 i = 0; i < pat.arity; i += 1) { ops[i] = stack[--count]; }
+        switch (pat.kind)
+        {
+            case ExprKind::NUM: expr = ExprInternNum(interner, pat.value); break;
+            case ExprKind::VAR: expr = binds[pat.value]; break;
+            case ExprKind::PRE_UNARY_MINUS: expr = ExprInternUnary(interner, ops[0]); break;
+            case ExprKind::DIFFERENCE:
+            case ExprKind::QUOTIENT: expr = ExprInternBinary(interner, pat.kind, ops[0], ops[1]); break;
+            default: expr = ExprInternNary(interner, pat.kind, ops, pat.arity); break;
+        }
+        if (!expr) { return nullptr; }
+        stack[count++] = expr;
+    }
+    return stack[0];
+}
+
+//////////////////
+// Driver
+
+struct Rewriter 
+{
+    ExprInterner *interner;
+    Arena *scratch;
+    RuleSet const *set;
+    Expr **keys;                    // node -> rewritten, open addressing
+    Expr **values;
+    U64 cap;
+    U64 count;
+    RewriteReport *report;
+};
+
+internal Expr * 
+RewriteDone(Rewriter *w, Expr *expr)
+{
+    U64 slot = HashU64((U64)(uintptr_t)expr) & (w->cap - 1);
+    while (w->keys[slot])
+    {
+        if (w->keys[slot] == expr) { return w->values[slot]; }
+        slot = (slot + 1) & (w->cap - 1);
+    }
+    return nullptr;
+}
+
+internal B32 
+RewriteSetDone(Rewriter *w, Expr *expr, Expr *rewritten)
+{
+    if ((w->count + 1) * 2 > w->cap)
+    {
+        U64 cap = w->cap * 2;
+        Expr **keys = w->scratch->PushArray<Expr *>(cap);
+        Expr **values = w->scratch->PushArrayNoZero<Expr *>(cap);
+        if (!keys || !values) { return 0; }
+        for (U64 i = 0; i < w->cap; i += 1)
+        {
+            if (!w->keys[i]) { continue; }
+            U64 slot = HashU64((U64)(uintptr_t)w->keys[i]) & (cap - 1);
+            while (keys[slot]) { slot = (slot + 1) & (cap - 1); }
+            keys[slot] = w->keys[i];
+            values[slot] = w->values[i];
+        }
+        w->keys = keys;
+        w->values = values;
+        w->cap = cap;
+    }
+    U64 slot = HashU64((U64)(uintptr_t)expr) & (w->cap - 1);
+    while (w->keys[slot]) { slot = (slot + 1) & (w->cap - 1); }
+    w->keys[slot] = expr;
+    w->values[slot] = rewritten;
+    w->count += 1;
+    return 1;
+}
+
+// expr with its children replaced by their rewritten versions, itself when none changed
+internal Expr * 
+RewriteRebuild(Rewriter *w, Expr *expr)
+{
+    U32 children = ExprChildCount(expr);
+    B32 changed = 0;
+    for (U32 i = 0; i < children; i += 1) { changed |= RewriteDone(w, ExprChild(expr, i)) != ExprChild(expr, i); }
+    if (!changed) { return expr; }
+
+    U64 pos = w->scratch->ArenaGetPos();
+    Expr **ops = w->scratch->PushArrayNoZero<Expr *>(children);
+    if (!ops) { return nullptr; }
+    for (U32 i = 0; i < children; i += 1) { ops[i] = RewriteDone(w, ExprChild(expr, i)); }
+    Expr *rebuilt = nullptr;
+    switch (expr->kind)
+    {
+        case ExprKind::PRE_UNARY_MINUS: rebuilt = ExprInternUnary(w->interner, ops[0]); break;
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT: rebuilt = ExprInternBinary(w->interner, expr->kind, ops[0], ops[1]); break;
+        default: rebuilt = ExprInternNary(w->interner, expr->kind, ops, children); break;
+    }
+    w->scratch->ArenaSetPosBack(pos);
+    return rebuilt;
+}
+
+// One pass over the distinct nodes of root, children first
+internal Expr * 
+RewritePass(Rewriter *w, Expr *root)
+{
+    struct Frame { Expr *expr; U32 next; };
+
+    U64 pos = w->scratch->ArenaGetPos();
+    w->cap = 64;
+    w->count = 0;
+    w->keys = w->scratch->PushArray<Expr *>(w->cap);
+    w->values = w->scratch->PushArrayNoZero<Expr *>(w->cap);
+    U64 count = 0, cap = 0;
+    Frame *stack = nullptr;
+    B32 ok = w->keys && w->values && (stack = ArenaGrowArray(w->scratch, stack, count, &cap));
+    if (ok) { stack[count++] = {root, 0}; }
+
+    Expr *binds[RULE_MAX_VARS];
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        if (top->next < ExprChildCount(expr))
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (RewriteDone(w, child)) { continue; }
+            if (count == cap && !(stack = ArenaGrowArray(w->scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0};
+            continue;
+        }
+
+        count -= 1;
+        if (RewriteDone(w, expr)) { continue; }
+        Expr *rewritten = RewriteRebuild(w, expr);
+        Rule const *rule = rewritten ? RuleSetMatch(w->set, rewritten, binds, w->report) : nullptr;
+        if (rule)
+        {
+            rewritten = RuleInstantiate(w->interner, rule, binds);
+            w->report->rewrites += 1;
+        }
+        ok = rewritten && RewriteSetDone(w, expr, rewritten);
+    }
+
+    Expr *result = ok ? RewriteDone(w, root) : nullptr;
+    w->scratch->ArenaSetPosBack(pos);
+    return result;
+}
+
+internal Expr * 
+ExprRewrite(ExprInterner *interner, Arena *scratch, RuleSet const *set, Expr *root, U32 max_passes, RewriteReport *report)
+{
+    RewriteReport local = {};
+    Rewriter w = {};
+    w.interner = interner;
+    w.scratch = scratch;
+    w.set = set;
+    w.report = report ? report : &local;
+    *w.report = {};
+
+    // Every root so far, a repeat means the rules go round in a cycle
+    U64 pos = scratch->ArenaGetPos();
+    Expr **seen = nullptr;
+    U64 seen_cap = 0, seen_count = 0;
+    B32 ok = 1;
+    ExprPtrSetInsert(scratch, &seen, &seen_cap, &seen_count, root, &ok);
+    while (ok && root && w.report->passes < max_passes)
+    {
+        Expr *next = RewritePass(&w, root);
+        w.report->passes += 1;
+        if (!next) { root = nullptr; break; }
+        if (next == root)
+        {
+            w.report->fixpoint = 1;
+            break;
+        }
+        root = next;
+        if (!ExprPtrSetInsert(scratch, &seen, &seen_cap, &seen_count, root, &ok))
+        {
+            w.report->cycle = ok;
+            break;
+        }
+    }
+    scratch->ArenaSetPosBack(pos);
+    return ok ? root : nullptr;
+}
+
+//////////////////
+// Profiling
+
+internal B32 
+RuleSetProfile(RuleSet *set)
+{
+    if (set->stats && set->stat_count == set->rule_count) { return 1; }
+    RuleStats *stats = set->arena->PushArray<RuleStats>(Max<U64>(set->rule_count, 1));
+    if (!stats) { return 0; }
+    if (set->stat_count) { MemoryCopy(stats, set->stats, sizeof(RuleStats) * set->stat_count); }
+    set->stats = stats;
+    set->stat_count = set->rule_count;
+    return 1;
+}
+
+internal B32 
+RuleSetReorder(RuleSet *set, Arena *scratch)
+{
+    U64 count = set->rule_count;
+    U64 pos = scratch->ArenaGetPos();
+    CanonSortItem *items = scratch->PushArrayNoZero<CanonSortItem>(Max<U64>(count, 1));
+    CanonSortItem *tmp = scratch->PushArrayNoZero<CanonSortItem>(Max<U64>(count, 1));
+    U32 *bucket = scratch->PushArrayNoZero<U32>(Max<U64>(count, 1));
+    if (!items || !tmp || !bucket)
+    {
+        scratch->ArenaSetPosBack(pos);
+        return 0;
+    }
+
+    // Ranks are always 0 to count - 1, and the sort is stable, so placing items
+    // by current rank keeps that order between equal counts
+    for (U64 i = 0; i < count; i += 1)
+    {
+        Rule const *rule = &set->rules[i];
+        U64 matches = rule->id < set->stat_count ? set->stats[rule->id].matches : 0;
+        items[rule->rank] = {~matches, 0, (U32)i};
+    }
+    CanonSortItem *sorted = CanonSort(items, tmp, count);
+    for (U64 i = 0; i < count; i += 1) { set->rules[sorted[i].index].rank = (U32)i; }
+
+    for (U64 node = 0; node < set->tree_count; node += 1)
+    {
+        U32 n = 0;
+        for (U32 r = set->tree[node].rules; r; r = set->rules[r - 1].next) { bucket[n++] = r; }
+        for (U32 i = 1; i < n; i += 1)
+        {
+            U32 r = bucket[i], j = i;
+            for (; j > 0 && set->rules[bucket[j - 1] - 1].rank > set->rules[r - 1].rank; j -= 1) { bucket[j] = bucket[j - 1]; }
+            bucket[j] = r;
+        }
+        U32 *link = &set->tree[node].rules;
+        for (U32 i = 0; i < n; i += 1)
+        {
+            *link = bucket[i];
+            link = &set->rules[bucket[i] - 1].next;
+        }
+        *link = 0;
+    }
+    scratch->ArenaSetPosBack(pos);
+    return 1;
+}
+
+internal B32 
+RuleProfileSave(RuleSet const *set, Arena *scratch, char const *path)
+{
+    U64 pos = scratch->ArenaGetPos();
+    ExprWriter writer;
+    ExprWriterInitArena(&writer, scratch);
+    String8 header = Str8Lit("# attempts matches cycles\trule\n");
+    ExprWrite(&writer, header.str, header.size);
+    for (U64 i = 0; i < set->rule_count; i += 1)
+    {
+        Rule const *rule = &set->rules[i];
+        if (!rule->text.size) { continue; }
+        RuleStats stats = i < set->stat_count ? set->stats[i] : RuleStats{};
+        ExprWriteS64(&writer, (S64)stats.attempts);
+        ExprWrite(&writer, " ", 1);
+        ExprWriteS64(&writer, (S64)stats.matches);
+        ExprWrite(&writer, " ", 1);
+        ExprWriteS64(&writer, (S64)stats.cycles);
+        ExprWrite(&writer, "\t", 1);
+        ExprWrite(&writer, rule->text.str, rule->text.size);
+        ExprWrite(&writer, "\n", 1);
+    }
+
+    OSMapping map;
+    B32 ok = ExprWriterFlush(&writer) && OSMapFileCreate(path, writer.total, &map);
+    if (ok)
+    {
+        MemoryCopy(map.data, scratch->memory + pos, writer.total);
+        OSUnmapFile(&map);
+    }
+    scratch->ArenaSetPosBack(pos);
+    return ok;
+}
+
+internal B32 
+RuleProfileLoad(RuleSet *set, Arena *scratch, char const *path)
+{
+    OSMapping map;
+    if (!RuleSetProfile(set) || !OSMapFileRead(path, &map)) { return 0; }
+
+    // Rules by text, 1 + index, open addressing. Counts gather in scratch and
+    // only reach the set once every line has parsed
+    U64 pos = scratch->ArenaGetPos();
+    U64 cap = 16;
+    while (cap < set->rule_count * 2) { cap *= 2; }
+    U32 *slots = scratch->PushArray<U32>(cap);
+    RuleStats *counted = scratch->PushArray<RuleStats>(Max<U64>(set->rule_count, 1));
+    U8 *claimed = scratch->PushArray<U8>(Max<U64>(set->rule_count, 1));
+    B32 ok = slots && counted && claimed;
+    for (U64 i = 0; ok && i < set->rule_count; i += 1)
+    {
+        String8 text = set->rules[i].text;
+        if (!text.size) { continue; }
+        U64 slot = HashBytes(text.str, text.size, 0) & (cap - 1);
+        while (slots[slot]) { slot = (slot + 1) & (cap - 1); }
+        slots[slot] = (U32)i + 1;
+    }
+
+    String8 file = Str8(map.data, map.size);
+    for (U64 start = 0; ok && start < file.size;)
+    {
+        U64 end = start;
+        while (end < file.size && file.str[end] != '\n') { end += 1; }
+        String8 line = Str8Substr(file, start, end);
+        start = end + 1;
+        if (line.size && line.str[line.size - 1] == '\r') { line.size -= 1; }
+        if (line.size == 0 || line.str[0] == '#') { continue; }
+
+        U64 counts[3] = {};
+        U64 at = 0;
+        for (U32 c = 0; ok && c < 3; c += 1)
+        {
+            U64 first = at;
+            for (; ok && at < line.size && line.str[at] >= '0' && line.str[at] <= '9'; at += 1)
+            {
+                ok = counts[c] <= (max_U64 - 9) / 10;
+                counts[c] = counts[c] * 10 + (line.str[at] - '0');
+            }
+            ok = ok && at > first && at < line.size && line.str[at] == (c < 2 ? ' ' : '\t');
+            at += 1;
+        }
+        if (!ok) { break; }
+
+        // Rules sharing a text take their lines in order, as they were saved
+        String8 text = Str8Substr(line, at, line.size);
+        for (U64 slot = HashBytes(text.str, text.size, 0) & (cap - 1); slots[slot]; slot = (slot + 1) & (cap - 1))
+        {
+            U32 index = slots[slot] - 1;
+            if (claimed[index] || !Str8Match(set->rules[index].text, text)) { continue; }
+            claimed[index] = 1;
+            counted[index] = {counts[0], counts[1], counts[2]};
+            break;
+        }
+    }
+    for (U64 i = 0; ok && i < set->rule_count; i += 1)
+    {
+        RuleStats *stats = &set->stats[i];
+        stats->attempts += counted[i].attempts;
+        stats->matches += counted[i].matches;
+        stats->cycles += counted[i].cycles;
+    }
+    scratch->ArenaSetPosBack(pos);
+    OSUnmapFile(&map);
+    return ok;
+}
+
+internal String8 
+RuleProfileReport(Arena *arena, Arena *scratch, RuleSet const *set, U64 min_attempts)
+{
+    U64 scratch_pos = scratch->ArenaGetPos();
+    U64 pos = arena->ArenaGetPos();
+    CanonSortItem *items = scratch->PushArrayNoZero<CanonSortItem>(Max<U64>(set->stat_count, 1));
+    CanonSortItem *tmp = scratch->PushArrayNoZero<CanonSortItem>(Max<U64>(set->stat_count, 1));
+    String8 result = Str8(nullptr, 0);
+    if (items && tmp)
+    {
+        U64 count = 0;
+        for (U64 i = 0; i < set->stat_count; i += 1)
+        {
+            RuleStats const *stats = &set->stats[i];
+            if (stats->matches == 0 && stats->attempts && stats->attempts >= min_attempts) { items[count++] = {~stats->cycles, 0, (U32)i}; }
+        }
+        CanonSortItem *sorted = CanonSort(items, tmp, count);
+
+        ExprWriter writer;
+        ExprWriterInitArena(&writer, arena);
+        for (U64 i = 0; i < count; i += 1)
+        {
+            Rule const *rule = &set->rules[sorted[i].index];
+            ExprWriteS64(&writer, (S64)set->stats[rule->id].cycles);
+            ExprWrite(&writer, " ", 1);
+            ExprWriteS64(&writer, (S64)set->stats[rule->id].attempts);
+            ExprWrite(&writer, " ", 1);
+            if (rule->text.size) { ExprWrite(&writer, rule->text.str, rule->text.size); }
+            else
+            {
+                ExprWrite(&writer, "rule ", 5);
+                ExprWriteS64(&writer, rule->id);
+            }
+            ExprWrite(&writer, "\n", 1);
+        }
+        ExprWrite(&writer, "", 1);
+        if (ExprWriterFlush(&writer)) { result = Str8(arena->memory + pos, writer.total - 1); }
+        else { arena->ArenaSetPosBack(pos); }
+    }
+    scratch->ArenaSetPosBack(scratch_pos);
+    return result;
+}
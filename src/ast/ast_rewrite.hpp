@@ -0,0 +1,146 @@
+/*
+ast_rewrite.hpp
+
+User defined rewrite rules, lhs -> rhs, applied to interned expressions. Every
+variable in a rule is a pattern variable that matches any subterm, a variable
+used twice on the left matches only equal subterms, and numbers match
+themselves: a*(b + c) -> a*b + a*c, a - a -> 0, a*1 -> a. Operators match by
+kind and operand count in order, so a + b matches sums of exactly two terms and
+does not commute.
+
+Left hand sides are compiled into a discrimination tree: each pattern read in
+preorder is a path of keys (kind and arity for operators, the value for
+numbers, a wildcard for variables) and rules hang off the node their path ends
+at. Looking up a subterm walks the tree along its own preorder, following the
+child keyed like the subterm's next node, found by hashing, and the wildcard
+child, which skips a whole subterm, so only rules whose shape fits are ever
+tried, however many rules there are. Binding then walks pattern and subterm with a
+fixed array on the stack. Interned subterms make repeated variables a pointer
+compare, so matching never allocates.
+
+ExprRewrite is the driver: a pass rewrites every distinct node once, children
+first, with the lowest ranked rule that matches, and passes repeat until the
+expression stops changing. Results are interned, so an expression seen after an
+earlier pass means the rules cycle, and the driver stops there.
+
+Ranks start as the order rules were added. A profiled set counts, per rule,
+how often it was bound, how often that succeeded and the ticks it took; the
+counts can be saved and loaded back by rule text, and RuleSetReorder ranks the
+rules that matched most first. Each bucket is kept in rank order and a lookup
+stops binding at the rank of the best match so far, so once the common rules
+come first most lookups bind one rule. Reordering changes which rule wins
+where several match the same subterm, so it suits rule sets whose result does
+not depend on that.
+*/
+#ifndef AST_REWRITE_HPP
+#define AST_REWRITE_HPP
+
+#define RULE_MAX_NODES 64           // per side of a rule
+#define RULE_MAX_VARS 16
+
+// One node of a side in preorder. VAR nodes hold the pattern variable's number,
+// NUM nodes the value.
+struct RulePat 
+{
+    ExprKind kind;
+    U32 arity;
+    S64 value;
+};
+
+struct Rule 
+{
+    RulePat *lhs;
+    RulePat *rhs;
+    U32 lhs_count;
+    U32 rhs_count;
+    U32 var_count;
+    U32 id;                         // order of addition
+    U32 rank;                       // the lower wins when several match, id until reordered
+    U32 next;                       // 1 + next rule ending at the same tree node, 0 at the end
+    String8 text;                   // as given to RuleSetAdd, for reports
+};
+
+// A node's wildcard child is linked from it directly, the keyed ones are found
+// through RuleSet::slots
+struct RuleTreeNode 
+{
+    ExprKind kind;                  // COUNT for the wildcard
+    U32 arity;
+    S64 value;
+    U32 parent;
+    U32 any;                        // 1 + wildcard child, 0 for none
+    U32 rules;                      // 1 + first rule whose pattern ends here
+};
+
+struct RuleStats 
+{
+    U64 attempts;                   // times bound against a subterm
+    U64 matches;
+    U64 cycles;                     // ReadCycleCounter ticks spent binding
+};
+
+struct RuleSet 
+{
+    Arena *arena;                   // rules, patterns and the tree
+    Rule *rules;
+    U64 rule_count;
+    U64 rule_cap;
+    RuleTreeNode *tree;             // tree[0] is the root
+    U64 tree_count;
+    U64 tree_cap;
+    U32 *slots;                     // (parent, key) -> 1 + child, open addressing
+    U64 slot_cap;                   // power of two
+    RuleStats *stats;               // by id, nullptr unless profiling
+    U64 stat_count;                 // rules added after profiling began aren't counted
+};
+
+struct RewriteReport 
+{
+    U64 passes;
+    U64 rewrites;                   // rule applications
+    U64 lookups;                    // subterms looked up in the tree
+    U64 candidates;                 // rules whose shape fit and were bound
+    B32 fixpoint;                   // the last pass changed nothing
+    B32 cycle;                      // a pass produced an expression seen before
+};
+
+internal B32 RuleSetInit(RuleSet *set, Arena *arena);
+// 0 when lhs is a bare variable, a side has more than RULE_MAX_NODES nodes or
+// lhs more than RULE_MAX_VARS variables, rhs uses a variable lhs doesn't, or
+// the arena runs out. text is kept as given.
+internal B32 RuleSetAdd(RuleSet *set, Expr *lhs, Expr *rhs, String8 text = {});
+
+// Lowest ranked rule matching expr, binds gets its variables (RULE_MAX_VARS
+// entries). expr must be interned. nullptr when none matches.
+internal Rule const *RuleSetMatch(RuleSet const *set, Expr *expr, Expr **binds, RewriteReport *report = nullptr);
+// rule's right hand side with binds substituted, nullptr when the arena runs out
+internal Expr *RuleInstantiate(ExprInterner *interner, Rule const *rule, Expr *const *binds);
+
+// Rewrites to a fixpoint, a cycle, or max_passes passes, whichever comes first.
+// root must come from interner, and so does the result. nullptr when an arena runs out.
+internal Expr *ExprRewrite(ExprInterner *interner, Arena *scratch, RuleSet const *set, Expr *root, U32 max_passes,
+                           RewriteReport *report = nullptr);
+
+// Starts counting for every rule added so far, again after adding more keeps the
+// counts so far. The counters aren't synchronized, so a profiled set rewrites
+// on one thread at a time. 0 when the arena runs out.
+internal B32 RuleSetProfile(RuleSet *set);
+// Ranks rules by matches counted so far, most first, keeping the current order
+// between equal counts, and resorts every bucket to match. 0 when scratch runs out.
+internal B32 RuleSetReorder(RuleSet *set, Arena *scratch);
+
+// Profile files hold one "attempts matches cycles<tab>rule text" line per rule
+// that has text, in rule order. Saving writes the set's counts, loading adds the
+// file's counts to them, starting profiling if needed, and skips lines for rules
+// the set no longer has. Rules with the same text take their lines in order.
+// 0 when the file can't be written or read or a line is malformed, and then no
+// counts are added.
+internal B32 RuleProfileSave(RuleSet const *set, Arena *scratch, char const *path);
+internal B32 RuleProfileLoad(RuleSet *set, Arena *scratch, char const *path);
+
+// Rules bound at least min_attempts times that never matched, the most ticks
+// first, one "cycles attempts rule text" line each. Null terminated, in arena,
+// which must not be scratch. Empty when no rule qualifies or an arena runs out.
+internal String8 RuleProfileReport(Arena *arena, Arena *scratch, RuleSet const *set, U64 min_attempts = 1);
+
+#endif // AST_REWRITE_HPP
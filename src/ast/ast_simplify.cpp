@@ -0,0 +1,642 @@
+//////////////////
+// Rules
+// Each gets a node whose children are simplified already, and returns what
+// replaces it: the node itself rewritten, or one of its children. Constants are
+// integer leaves and the fractions folding writes as num/den; their exact values
+// are worked out in scratch, and only what a rule keeps goes to arena.
+
+internal void 
+SimplifySetNum(Expr *expr, S64 value)
+{
+    expr->kind = ExprKind::NUM;
+    expr->count = 0;
+    expr->num = value;
+    expr->hash = ExprHashNum(value);
+}
+
+// expr becomes value: an integer leaf, or num/den with den > 1 in lowest terms
+internal B32 
+SimplifySetValue(Arena *arena, Expr *expr, Rational value)
+{
+    if (RatIsInteger(value) && IntIsSmall(value.num))
+    {
+        SimplifySetNum(expr, value.num.small);
+        return 1;
+    }
+    if (RatIsInteger(value))
+    {
+        if (!IntCopy(arena, value.num, &value.num)) { return 0; }
+        expr->kind = ExprKind::BIG_NUM;
+        expr->count = 0;
+        expr->big = value.num.big;
+        expr->hash = ExprHashInteger(value.num);
+        return 1;
+    }
+    Expr *num = ExprPushInteger(arena, value.num);
+    Expr *den = ExprPushInteger(arena, value.den);
+    if (!num || !den) { return 0; }
+    expr->kind = ExprKind::QUOTIENT;
+    expr->count = 0;
+    expr->bin.left = num;
+    expr->bin.right = den;
+    expr->hash = ExprHashBinary(ExprKind::QUOTIENT, num->hash, den->hash);
+    return 1;
+}
+
+internal Expr *
+SimplifyPushValue(Arena *arena, Rational value)
+{
+    Expr *expr = arena->PushArray<Expr>(1);
+    return expr && SimplifySetValue(arena, expr, value) ? expr : nullptr;
+}
+
+internal B32 
+SimplifyIsNum(Expr *expr, S64 value)
+{
+    return expr->kind == ExprKind::NUM && expr->num == value;
+}
+
+internal B32 
+SimplifyIsConstant(Expr *expr)
+{
+    if (ExprKindIsInteger(expr->kind)) { return 1; }
+    return expr->kind == ExprKind::QUOTIENT && ExprKindIsInteger(expr->bin.left->kind) &&
+           ExprKindIsInteger(expr->bin.right->kind) && !SimplifyIsNum(expr->bin.right, 0);
+}
+
+// Value of a constant, 0 when scratch runs out
+internal B32 
+SimplifyValue(Arena *scratch, Expr *expr, Rational *out)
+{
+    if (ExprKindIsInteger(expr->kind))
+    {
+        *out = RatFromInt(ExprInteger(expr));
+        return 1;
+    }
+    return RatFromFraction(scratch, scratch, ExprInteger(expr->bin.left), ExprInteger(expr->bin.right), out);
+}
+
+internal B32 
+SimplifyRatIs(Rational value, S64 small)
+{
+    return RatIsInteger(value) && IntIsSmall(value.num) && value.num.small == small;
+}
+
+internal Expr *
+SimplifyNegate(Arena *arena, Arena *scratch, Expr *expr, Expr *operand, SimplifyReport *report)
+{
+    if (operand->kind == ExprKind::PRE_UNARY_MINUS)
+    {
+        report->identities += 1;
+        return operand->operand;
+    }
+    if (SimplifyIsConstant(operand))
+    {
+        Rational value;
+        if (!SimplifyValue(scratch, operand, &value) || !IntNegate(scratch, value.num, &value.num) ||
+            !SimplifySetValue(arena, expr, value))
+        {
+            return nullptr;
+        }
+        report->folded += 1;
+        return expr;
+    }
+    expr->kind = ExprKind::PRE_UNARY_MINUS;
+    expr->operand = operand;
+    expr->hash = ExprHashUnary(operand->hash);
+    return expr;
+}
+
+internal Expr *
+SimplifyBinary(Arena *arena, Arena *scratch, Expr *expr, Expr *left, Expr *right, SimplifyReport *report)
+{
+    // Division by zero stays as written
+    B32 fold = SimplifyIsConstant(left) && SimplifyIsConstant(right) &&
+               (expr->kind == ExprKind::DIFFERENCE || !SimplifyIsNum(right, 0));
+    if (fold)
+    {
+        Rational a, b;
+        if (!SimplifyValue(scratch, left, &a) || !SimplifyValue(scratch, right, &b)) { return nullptr; }
+        B32 ok = expr->kind == ExprKind::DIFFERENCE ? RatSub(scratch, scratch, a, b, &a) : RatDiv(scratch, scratch, a, b, &a);
+        if (!ok) { return nullptr; }
+
+        // A fraction in lowest terms is already how folding writes it
+        B32 written = !RatIsInteger(a) && ExprKindIsInteger(left->kind) && ExprKindIsInteger(right->kind) &&
+                      IntCompare(a.num, ExprInteger(left)) == 0 && IntCompare(a.den, ExprInteger(right)) == 0;
+        if (!written)
+        {
+            if (!SimplifySetValue(arena, expr, a)) { return nullptr; }
+            report->folded += 1;
+            return expr;
+        }
+    }
+    if (expr->kind == ExprKind::DIFFERENCE)
+    {
+        if (SimplifyIsNum(right, 0)) { report->identities += 1; return left; }
+        if (SimplifyIsNum(left, 0))
+        {
+            report->identities += 1;
+            return SimplifyNegate(arena, scratch, expr, right, report);
+        }
+    }
+    else if (SimplifyIsNum(right, 1)) { report->identities += 1; return left; }
+    expr->bin.left = left;
+    expr->bin.right = right;
+    expr->hash = ExprHashBinary(expr->kind, left->hash, right->hash);
+    return expr;
+}
+
+// Operands of a sum or product once same-kind children are spliced in. Constants
+// are counted, and folded into *acc when it is given, the others go to dst when
+// that is given and are counted in *kept. 0 when scratch runs out.
+internal B32 
+SimplifyGather(Arena *scratch, ExprKind kind, Expr **children, U32 count, Rational *acc, Expr **dst, U64 *kept,
+               Expr **constant, U32 *constants)
+{
+    for (U32 i = 0; i < count; i += 1)
+    {
+        Expr *child = children[i];
+        B32 splice = child->kind == kind;
+        U32 inner = splice ? child->count : 1;
+        Expr **ops = splice ? child->operands : &children[i];
+        for (U32 j = 0; j < inner; j += 1)
+        {
+            if (!SimplifyIsConstant(ops[j]))
+            {
+                if (dst) { dst[*kept] = ops[j]; }
+                *kept += 1;
+                continue;
+            }
+            if (acc)
+            {
+                Rational value;
+                if (!SimplifyValue(scratch, ops[j], &value)) { return 0; }
+                B32 ok = kind == ExprKind::PLUS ? RatAdd(scratch, scratch, *acc, value, acc) : RatMul(scratch, scratch, *acc, value, acc);
+                if (!ok) { return 0; }
+            }
+            *constant = ops[j];
+            *constants += 1;
+        }
+    }
+    return 1;
+}
+
+// Spliced children hold at most one constant and no node of their own kind, being
+// simplified already. Constants fold into one, first in a product, last in a sum.
+internal Expr *
+SimplifyNary(Arena *arena, Arena *scratch, Expr *expr, Expr **children, U32 count, SimplifyReport *report)
+{
+    ExprKind kind = expr->kind;
+    S64 identity = kind == ExprKind::PLUS ? 0 : 1;
+    for (U32 i = 0; i < count; i += 1) { report->flattened += children[i]->kind == kind; }
+
+    // Counting pass first, the writing pass repeats its decisions without folding
+    Rational acc = RatFromInt(IntFromS64(identity));
+    Expr *constant = nullptr;
+    U32 constants = 0;
+    U64 kept = 0;
+    if (!SimplifyGather(scratch, kind, children, count, &acc, nullptr, &kept, &constant, &constants)) { return nullptr; }
+    B32 neutral = SimplifyRatIs(acc, identity);
+    report->folded += constants > 1;
+    report->identities += constants > 0 && neutral;
+    if (kind == ExprKind::MULTIPLY && SimplifyRatIs(acc, 0))
+    {
+        report->identities += kept > 0;
+        SimplifySetNum(expr, 0);
+        return expr;
+    }
+    if (kept == 0) { return SimplifySetValue(arena, expr, acc) ? expr : nullptr; }
+
+    // The one operand left replaces the node, which stays as it was for anything
+    // else that shares it
+    U64 total = kept + !neutral;
+    if (total >= max_U32) { return nullptr; }
+    U64 replay_kept = 0;
+    U32 replay_constants = 0;
+    Expr *only = nullptr;
+    if (total == 1)
+    {
+        SimplifyGather(scratch, kind, children, count, nullptr, &only, &replay_kept, &constant, &replay_constants);
+        return only;
+    }
+
+    if (constants > 1 && !neutral && !(constant = SimplifyPushValue(arena, acc))) { return nullptr; }
+    Expr **dst = total <= expr->count ? expr->operands : arena->PushArrayNoZero<Expr *>(total);
+    if (!dst) { return nullptr; }
+    B32 lead = kind == ExprKind::MULTIPLY && !neutral;
+    Expr *folded = constant;
+    SimplifyGather(scratch, kind, children, count, nullptr, dst + lead, &replay_kept, &constant, &replay_constants);
+    if (lead)          { dst[0] = folded; }
+    else if (!neutral) { dst[total - 1] = folded; }
+
+    U64 hash = 0;
+    for (U64 i = 0; i < total; i += 1) { hash = ExprHashNaryAdd(hash, dst[i]->hash); }
+    expr->operands = dst;
+    expr->count = (U32)total;
+    expr->hash = ExprHashNary(kind, hash, (U32)total);
+    return expr;
+}
+
+//////////////////
+// Pass
+
+internal Expr *
+ExprSimplify(Arena *arena, Arena *scratch, Expr *root, SimplifyReport *report)
+{
+    // Postorder, simplified children wait on done until their parent's turn
+    struct Frame { Expr *expr; U32 next; };
+
+    SimplifyReport counts = {};
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0, done_count = 0, done_cap = 0;
+    Frame *stack = nullptr;
+    Expr **done = nullptr;
+
+    Expr *result = nullptr;
+    B32 ok = (stack = ArenaGrowArray(scratch, stack, count, &cap)) != nullptr;
+    if (ok) { stack[count++] = {root, 0}; }
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        U32 children = ExprChildCount(expr);
+        if (top->next < children)
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0};
+            continue;
+        }
+
+        // Exact values a rule worked out are done with once it returns
+        Expr **ops = done + done_count - children;
+        Expr *simplified = expr;
+        U64 rule_pos = scratch->ArenaGetPos();
+        switch (expr->kind)
+        {
+            case ExprKind::NUM:
+            case ExprKind::BIG_NUM:
+            case ExprKind::VAR: break;
+            case ExprKind::PRE_UNARY_MINUS: simplified = SimplifyNegate(arena, scratch, expr, ops[0], &counts); break;
+            case ExprKind::DIFFERENCE:
+            case ExprKind::QUOTIENT: simplified = SimplifyBinary(arena, scratch, expr, ops[0], ops[1], &counts); break;
+            default: simplified = SimplifyNary(arena, scratch, expr, ops, children, &counts); break;
+        }
+        if (scratch != arena) { scratch->ArenaSetPosBack(rule_pos); }
+        if (!simplified) { ok = 0; break; }
+        done_count -= children;
+        count -= 1;
+        if (count == 0) { result = simplified; break; }
+        if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+        done[done_count++] = simplified;
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (report) { *report = counts; }
+    return ok ? result : nullptr;
+}
+
+//////////////////
+// Cache
+
+// Empty table and interner at the bottom of arena
+internal B32 
+SimplifyCacheReset(SimplifyCache *cache, Arena *arena)
+{
+    cache->entries = arena->PushArrayNoZero<SimplifyCacheEntry>(cache->entry_cap);
+    cache->index = arena->PushArray<U32>(cache->index_cap);
+    cache->entry_count = 0;
+    cache->hand = 0;
+    return ExprInternerInit(&cache->interner, arena, 0) && cache->entries && cache->index;
+}
+
+internal B32 
+SimplifyCacheInit(SimplifyCache *cache, Arena *a, Arena *b, U64 max_entries)
+{
+    MemoryZeroStruct(*cache);
+    cache->arenas[0] = a;
+    cache->arenas[1] = b;
+    cache->entry_cap = Max<U64>(max_entries, 1);
+    if (cache->entry_cap >= max_U32) { return 0; }
+    cache->index_cap = 16;
+    while (cache->index_cap < cache->entry_cap * 2) { cache->index_cap *= 2; }
+    return SimplifyCacheReset(cache, a);
+}
+
+internal SimplifyCacheEntry *
+SimplifyCacheFind(SimplifyCache *cache, Arena *scratch, Expr *expr)
+{
+    U64 mask = cache->index_cap - 1;
+    for (U64 slot = expr->hash & mask; cache->index[slot]; slot = (slot + 1) & mask)
+    {
+        SimplifyCacheEntry *entry = &cache->entries[cache->index[slot] - 1];
+        if (entry->hash == expr->hash && ExprMatch(scratch, entry->key, expr)) { return entry; }
+    }
+    return nullptr;
+}
+
+internal void 
+SimplifyCacheLink(SimplifyCache *cache, U64 entry)
+{
+    U64 mask = cache->index_cap - 1;
+    U64 slot = cache->entries[entry].hash & mask;
+    while (cache->index[slot]) { slot = (slot + 1) & mask; }
+    cache->index[slot] = (U32)entry + 1;
+}
+
+// Backward shift deletion: later entries of the probe run move into the gap
+// unless that would put them before their home slot
+internal void 
+SimplifyCacheUnlink(SimplifyCache *cache, U64 entry)
+{
+    U64 mask = cache->index_cap - 1;
+    U64 slot = cache->entries[entry].hash & mask;
+    while (cache->index[slot] != entry + 1) { slot = (slot + 1) & mask; }
+    for (U64 next = (slot + 1) & mask; cache->index[next]; next = (next + 1) & mask)
+    {
+        U64 home = cache->entries[cache->index[next] - 1].hash & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            cache->index[slot] = cache->index[next];
+            slot = next;
+        }
+    }
+    cache->index[slot] = 0;
+}
+
+internal void 
+SimplifyCacheInsert(SimplifyCache *cache, Expr *key, Expr *value, U64 nodes)
+{
+    U64 entry = cache->entry_count;
+    if (entry < cache->entry_cap) { cache->entry_count += 1; }
+    else
+    {
+        while (cache->entries[cache->hand].referenced)
+        {
+            cache->entries[cache->hand].referenced = 0;
+            cache->hand = (cache->hand + 1) % cache->entry_cap;
+        }
+        entry = cache->hand;
+        cache->hand = (cache->hand + 1) % cache->entry_cap;
+        SimplifyCacheUnlink(cache, entry);
+        cache->stats.evictions += 1;
+    }
+    cache->entries[entry] = {key->hash, key, value, nodes, 0};
+    SimplifyCacheLink(cache, entry);
+    cache->stats.inserts += 1;
+}
+
+// A constant a rule built outside the interner, anything else as it is
+internal Expr *
+SimplifyCacheInternConstant(ExprInterner *interner, Expr *expr)
+{
+    if (ExprKindIsInteger(expr->kind)) { return ExprInternLeaf(interner, expr); }
+    if (!SimplifyIsConstant(expr)) { return expr; }
+    Expr *num = ExprInternLeaf(interner, expr->bin.left);
+    Expr *den = ExprInternLeaf(interner, expr->bin.right);
+    return num && den ? ExprInternBinary(interner, ExprKind::QUOTIENT, num, den) : nullptr;
+}
+
+// Interned form of what a rule returned for shell: an operand is interned
+// already, and so is everything in a rewritten shell except constants it folded
+internal Expr *
+SimplifyCacheInternResult(ExprInterner *interner, Expr *shell, Expr *result)
+{
+    if (result != shell) { return result; }
+    switch (shell->kind)
+    {
+        case ExprKind::PRE_UNARY_MINUS: return ExprInternUnary(interner, shell->operand);
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT:
+        {
+            Expr *left = SimplifyCacheInternConstant(interner, shell->bin.left);
+            Expr *right = SimplifyCacheInternConstant(interner, shell->bin.right);
+            return left && right ? ExprInternBinary(interner, shell->kind, left, right) : nullptr;
+        }
+        case ExprKind::PLUS:
+        case ExprKind::MULTIPLY:
+        {
+            for (U32 i = 0; i < shell->count; i += 1)
+            {
+                if (!(shell->operands[i] = SimplifyCacheInternConstant(interner, shell->operands[i]))) { return nullptr; }
+            }
+            return ExprInternNary(interner, shell->kind, shell->operands, shell->count);
+        }
+        default: return ExprInternLeaf(interner, shell);
+    }
+}
+
+struct SimplifyCacheDone 
+{
+    Expr *key;
+    Expr *value;
+    U64 nodes;
+};
+
+// expr interned as it is and simplified, from its children's, stored when big enough
+internal SimplifyCacheDone 
+SimplifyCacheNode(SimplifyCache *cache, Arena *scratch, Expr *expr, SimplifyCacheDone const *done, U32 children,
+                  SimplifyReport *counts)
+{
+    ExprInterner *interner = &cache->interner;
+    SimplifyCacheDone item = {nullptr, nullptr, 1};
+    if (children == 0)
+    {
+        item.key = ExprInternLeaf(interner, expr);
+        item.value = item.key;
+        return item;
+    }
+
+    U64 pos = scratch->ArenaGetPos();
+    Expr **keys = scratch->PushArrayNoZero<Expr *>(children);
+    Expr **values = scratch->PushArrayNoZero<Expr *>(children);
+    Expr shell = {};
+    shell.kind = expr->kind;
+    if (ExprKindIsNary(expr->kind))
+    {
+        shell.count = children;
+        shell.operands = scratch->PushArrayNoZero<Expr *>(children);
+    }
+    if (!keys || !values || (ExprKindIsNary(expr->kind) && !shell.operands))
+    {
+        scratch->ArenaSetPosBack(pos);
+        return {};
+    }
+    for (U32 i = 0; i < children; i += 1)
+    {
+        keys[i] = done[i].key;
+        values[i] = done[i].value;
+        item.nodes += done[i].nodes;
+    }
+
+    Expr *simplified = nullptr;
+    switch (expr->kind)
+    {
+        case ExprKind::PRE_UNARY_MINUS:
+        {
+            item.key = ExprInternUnary(interner, keys[0]);
+            simplified = SimplifyNegate(scratch, scratch, &shell, values[0], counts);
+        } break;
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT:
+        {
+            item.key = ExprInternBinary(interner, expr->kind, keys[0], keys[1]);
+            simplified = SimplifyBinary(scratch, scratch, &shell, values[0], values[1], counts);
+        } break;
+        default:
+        {
+            item.key = ExprInternNary(interner, expr->kind, keys, children);
+            simplified = SimplifyNary(scratch, scratch, &shell, values, children, counts);
+        } break;
+    }
+    item.value = simplified ? SimplifyCacheInternResult(interner, &shell, simplified) : nullptr;
+    scratch->ArenaSetPosBack(pos);
+    if (!item.key || !item.value) { return {}; }
+    if (item.nodes >= SIMPLIFY_CACHE_MIN_NODES) { SimplifyCacheInsert(cache, item.key, item.value, item.nodes); }
+    return item;
+}
+
+internal Expr *
+ExprSimplifyCached(SimplifyCache *cache, Arena *scratch, Expr *root, SimplifyReport *report)
+{
+    // Postorder like ExprSimplify, with a lookup before descending into an operator
+    struct Frame { Expr *expr; U32 next; };
+
+    SimplifyReport counts = {};
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0, done_count = 0, done_cap = 0;
+    Frame *stack = nullptr;
+    SimplifyCacheDone *done = nullptr;
+
+    Expr *result = nullptr;
+    B32 ok = (stack = ArenaGrowArray(scratch, stack, count, &cap)) != nullptr;
+    if (ok) { stack[count++] = {root, 0}; }
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        U32 children = ExprChildCount(expr);
+        SimplifyCacheDone item = {};
+        if (top->next == 0 && children)
+        {
+            cache->stats.lookups += 1;
+            SimplifyCacheEntry *entry = SimplifyCacheFind(cache, scratch, expr);
+            if (entry)
+            {
+                entry->referenced = 1;
+                cache->stats.hits += 1;
+                cache->stats.nodes_saved += entry->nodes;
+                item = {entry->key, entry->value, entry->nodes};
+            }
+        }
+        if (!item.key)
+        {
+            if (top->next < children)
+            {
+                Expr *child = ExprChild(expr, top->next);
+                top->next += 1;
+                if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+                stack[count++] = {child, 0};
+                continue;
+            }
+            item = SimplifyCacheNode(cache, scratch, expr, done + done_count - children, children, &counts);
+            if (!item.key) { ok = 0; break; }
+            done_count -= children;
+        }
+        count -= 1;
+        if (count == 0) { result = item.value; break; }
+        if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+        done[done_count++] = item;
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (report) { *report = counts; }
+    return ok ? result : nullptr;
+}
+
+// root interned into interner. Moved nodes are overwritten to point at their
+// copy, kind COUNT and the copy in operand, so shared subtrees move once; the
+// old arena is thrown away afterwards anyway.
+internal Expr *
+SimplifyCacheMove(ExprInterner *interner, Arena *scratch, Expr *root)
+{
+    struct Frame { Expr *expr; U32 next; };
+
+    if (root->kind == ExprKind::COUNT) { return root->operand; }
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0, done_count = 0, done_cap = 0;
+    Frame *stack = nullptr;
+    Expr **done = nullptr;
+
+    Expr *result = nullptr;
+    B32 ok = (stack = ArenaGrowArray(scratch, stack, count, &cap)) != nullptr;
+    if (ok) { stack[count++] = {root, 0}; }
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        U32 children = ExprChildCount(expr);
+        if (top->next < children)
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (child->kind == ExprKind::COUNT)
+            {
+                if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+                done[done_count++] = child->operand;
+                continue;
+            }
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0};
+            continue;
+        }
+
+        Expr **ops = done + done_count - children;
+        Expr *moved = ExprInternFind(interner, expr->kind, expr, ops, children);
+        if (!moved) { ok = 0; break; }
+        expr->kind = ExprKind::COUNT;
+        expr->operand = moved;
+        done_count -= children;
+        count -= 1;
+        if (count == 0) { result = moved; break; }
+        if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+        done[done_count++] = moved;
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    return ok ? result : nullptr;
+}
+
+internal B32 
+SimplifyCacheTrim(SimplifyCache *cache, Arena *scratch)
+{
+    Arena *live = cache->interner.arena;
+    if (live->ArenaGetPos() <= live->size / 2) { return 1; }
+
+    // Entries keep their places in the ring, so the hand carries over
+    Arena *spare = live == cache->arenas[0] ? cache->arenas[1] : cache->arenas[0];
+    spare->ArenaClear();
+    SimplifyCache moved = *cache;
+    B32 ok = SimplifyCacheReset(&moved, spare);
+    for (U64 i = 0; ok && i < cache->entry_count; i += 1)
+    {
+        SimplifyCacheEntry entry = cache->entries[i];
+        entry.key = SimplifyCacheMove(&moved.interner, scratch, entry.key);
+        entry.value = entry.key ? SimplifyCacheMove(&moved.interner, scratch, entry.value) : nullptr;
+        ok = entry.key && entry.value;
+        moved.entries[i] = entry;
+        moved.entry_count = i + 1;
+        if (ok) { SimplifyCacheLink(&moved, i); }
+    }
+    moved.hand = cache->hand;
+    moved.stats.trims += 1;
+    live->ArenaClear();
+    if (!ok)
+    {
+        spare->ArenaClear();
+        SimplifyCacheReset(&moved, spare);
+    }
+    *cache = moved;
+    return ok;
+}
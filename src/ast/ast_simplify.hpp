@@ -0,0 +1,98 @@
+/*
+ast_simplify.hpp
+
+Cleanup in one postorder pass, each node once its children are done: constants
+fold exactly, integers to any size and quotients to a fraction in lowest terms
+(6/4 becomes 3/2, which later folding reads back as a constant, 1/0 stays as
+written), x + 0, x*1, x - 0, x/1 and 0 - x lose the identity, a product
+with a 0 factor becomes 0, --x becomes x, and sums and products directly inside
+one of the same kind are spliced into it.
+
+Nodes are rewritten where they are, so root is consumed. A node that shrinks
+keeps its operand array, only a splice that needs more operands than the array
+holds takes a new one from arena. Work is linear in the size of the tree.
+
+Values are treated as reals, like ExprHorner: x*0 is 0 even though inf*0 is NaN
+in double evaluation.
+
+ExprSimplifyCached gives the same result through a cache that outlives the call,
+for batches and long running processes where the same subexpressions come back
+again and again, like a factor every row of a generated system shares. Entries
+map a subtree, found by its structural hash and confirmed with ExprMatch, to its
+simplified form. Both sides are interned in the cache's own arena, so entries
+share common subtrees. A hit hands out the cached node without simplifying the
+subtree again, though ExprMatch still walks it once to confirm the entry.
+
+The table holds at most a fixed number of entries and evicts with CLOCK: a hit
+marks an entry, and the hand looking for a victim clears marks as it passes and
+takes the first unmarked entry. Evicted nodes stay in the arena until
+SimplifyCacheTrim copies the entries still held into a second arena and empties
+the first, the way a copying collector would.
+*/
+#ifndef AST_SIMPLIFY_HPP
+#define AST_SIMPLIFY_HPP
+
+struct SimplifyReport 
+{
+    U64 folded;             // operations on constants replaced by their value
+    U64 identities;         // identity operands dropped, annihilated products, double negations
+    U64 flattened;          // nested sums and products spliced into their parent
+};
+
+// The simplified root, which may be a descendant of root. nullptr when an arena runs out.
+internal Expr *ExprSimplify(Arena *arena, Arena *scratch, Expr *root, SimplifyReport *report = nullptr);
+
+//////////////////
+// Cache
+
+#define SIMPLIFY_CACHE_MIN_NODES 4  // smaller subtrees are looked up but never stored
+
+struct SimplifyCacheEntry 
+{
+    U64 hash;                       // structural, of the key
+    Expr *key;                      // subtree as it was given
+    Expr *value;                    // simplified
+    U64 nodes;                      // in key, counted as a tree
+    B32 referenced;                 // hit since the hand last passed
+};
+
+struct SimplifyCacheStats 
+{
+    U64 lookups;                    // operator nodes looked up
+    U64 hits;
+    U64 nodes_saved;                // nodes under hits, matched but not simplified
+    U64 inserts;
+    U64 evictions;
+    U64 trims;                      // times the entries moved arena
+};
+
+struct SimplifyCache 
+{
+    Arena *arenas[2];               // everything lives in interner.arena, the other one is empty
+    ExprInterner interner;
+    SimplifyCacheEntry *entries;    // the CLOCK ring
+    U64 entry_count;
+    U64 entry_cap;
+    U64 hand;
+    U32 *index;                     // hash -> 1 + entry, open addressing
+    U64 index_cap;                  // power of two, at least twice entry_cap
+    SimplifyCacheStats stats;       // since init
+};
+
+// a and b are the cache's from now on and should each hold what max_entries
+// entries reference a few times over
+internal B32 SimplifyCacheInit(SimplifyCache *cache, Arena *a, Arena *b, U64 max_entries);
+
+// ExprSimplify's result, interned in the cache, which root is left as it was.
+// The result stays valid until the next SimplifyCacheTrim. report counts the
+// rules applied outside hits. Not thread safe. nullptr when an arena runs out,
+// trimming first makes room.
+internal Expr *ExprSimplifyCached(SimplifyCache *cache, Arena *scratch, Expr *root, SimplifyReport *report = nullptr);
+
+// Meant for between requests: once the cache's arena is over half full, moves
+// the entries into the other arena and empties it, which invalidates every node
+// the cache handed out. 0 when the other arena can't hold them, the cache is left
+// empty then.
+internal B32 SimplifyCacheTrim(SimplifyCache *cache, Arena *scratch);
+
+#endif // AST_SIMPLIFY_HPP
@@ -0,0 +1,248 @@
+//////////////////
+// Node count
+
+internal U64 
+ExprNodeCount(Arena *scratch, Expr *root)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0;
+    Expr **stack = nullptr;
+
+    U64 nodes = 0;
+    B32 ok = 1;
+    Expr *expr = root;
+    while (ok)
+    {
+        nodes += 1;
+        U32 children = ExprChildCount(expr);
+        if (children == 0)
+        {
+            if (count == 0) { break; }
+            expr = stack[--count];
+            continue;
+        }
+        for (U32 i = children - 1; i > 0; i -= 1)
+        {
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = ExprChild(expr, i);
+        }
+        expr = ExprChild(expr, 0);
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    return ok ? nodes : 0;
+}
+
+//////////////////
+// Flop count
+
+// Inserts expr into an open addressing set of node addresses, growing it at half
+// full. Returns 1 if it was new, 0 if present or out of memory (*ok cleared).
+internal B32 
+ExprPtrSetInsert(Arena *scratch, Expr ***slots, U64 *cap, U64 *count, Expr *expr, B32 *ok)
+{
+    if ((*count + 1) * 2 > *cap)
+    {
+        U64 new_cap = Max<U64>(*cap * 2, 64);
+        Expr **grown = scratch->PushArray<Expr *>(new_cap);
+        if (!grown) { *ok = 0; return 0; }
+        for (U64 i = 0; i < *cap; i += 1)
+        {
+            if (!(*slots)[i]) { continue; }
+            U64 slot = HashU64((U64)(uintptr_t)(*slots)[i]) & (new_cap - 1);
+            while (grown[slot]) { slot = (slot + 1) & (new_cap - 1); }
+            grown[slot] = (*slots)[i];
+        }
+        *slots = grown;
+        *cap = new_cap;
+    }
+    U64 slot = HashU64((U64)(uintptr_t)expr) & (*cap - 1);
+    while ((*slots)[slot])
+    {
+        if ((*slots)[slot] == expr) { return 0; }
+        slot = (slot + 1) & (*cap - 1);
+    }
+    (*slots)[slot] = expr;
+    *count += 1;
+    return 1;
+}
+
+internal B32 
+ExprFlopCount(Arena *scratch, Expr *root, ExprFlops *out)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0;
+    Expr **stack = ArenaGrowArray(scratch, (Expr **)nullptr, count, &cap);
+    Expr **seen = nullptr;
+    U64 seen_cap = 0, seen_count = 0;
+
+    ExprFlops flops = {};
+    B32 ok = stack != nullptr;
+    if (ok) { stack[count++] = root; }
+    while (ok && count)
+    {
+        Expr *expr = stack[--count];
+        if (!ExprPtrSetInsert(scratch, &seen, &seen_cap, &seen_count, expr, &ok)) { continue; }
+        U32 children = ExprChildCount(expr);
+        switch (expr->kind)
+        {
+            case ExprKind::PLUS:
+            case ExprKind::DIFFERENCE:      flops.adds += children - 1; break;
+            case ExprKind::MULTIPLY:        flops.muls += children - 1; break;
+            case ExprKind::QUOTIENT:        flops.divs += 1; break;
+            case ExprKind::PRE_UNARY_MINUS: flops.negs += 1; break;
+            default: break;
+        }
+        for (U32 i = 0; i < children; i += 1)
+        {
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = ExprChild(expr, i);
+        }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (ok) { *out = flops; }
+    return ok;
+}
+
+internal U64 
+ExprFlopsTotal(ExprFlops flops)
+{
+    return flops.adds + flops.muls + flops.divs + flops.negs;
+}
+
+//////////////////
+// Evaluation
+
+internal B32 
+ExprEvalLeaf(Expr *expr, ExprEnv const *env, F64 *out)
+{
+    if (ExprKindIsInteger(expr->kind))
+    {
+        *out = IntToF64(ExprInteger(expr));
+        return 1;
+    }
+    for (U32 i = 0; env && i < env->count; i += 1)
+    {
+        if (Str8Match(env->names[i], expr->var))
+        {
+            *out = env->values[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+internal B32 
+ExprEval(Arena *scratch, Expr *root, ExprEnv const *env, F64 *out)
+{
+    // Interior nodes wait on the stack while their children are folded into acc
+    struct Frame { Expr *expr; U32 next; F64 acc; };
+
+    if (ExprKindIsLeaf(root->kind)) { return ExprEvalLeaf(root, env, out); }
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0;
+    Frame *stack = ArenaGrowArray(scratch, (Frame *)nullptr, count, &cap);
+    B32 ok = stack != nullptr;
+    if (ok) { stack[count++] = {root, 0, 0.0}; }
+
+    F64 value = 0.0;
+    while (ok)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+
+        // Fold in the child that just finished
+        if (top->next)
+        {
+            B32 first = top->next == 1;
+            switch (expr->kind)
+            {
+                case ExprKind::PRE_UNARY_MINUS: top->acc = -value; break;
+                case ExprKind::PLUS:            top->acc = first ? value : top->acc + value; break;
+                case ExprKind::MULTIPLY:        top->acc = first ? value : top->acc * value; break;
+                case ExprKind::DIFFERENCE:      top->acc = first ? value : top->acc - value; break;
+                case ExprKind::QUOTIENT:        top->acc = first ? value : top->acc / value; break;
+                default: break;
+            }
+        }
+
+        if (top->next < ExprChildCount(expr))
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (ExprKindIsLeaf(child->kind))
+            {
+                ok = ExprEvalLeaf(child, env, &value);
+                continue;
+            }
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0, 0.0};
+            continue;
+        }
+
+        value = top->acc;
+        count -= 1;
+        if (count == 0) { break; }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (ok) { *out = value; }
+    return ok;
+}
+
+internal B32 
+ExprEvalExact(Arena *arena, Arena *scratch, Expr *root, Rational *out)
+{
+    // Same shape as ExprEval, values live in arena and number temporaries go
+    // above the stack in scratch
+    struct Frame { Expr *expr; U32 next; Rational acc; };
+
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = 0, cap = 0;
+    Frame *stack = ArenaGrowArray(scratch, (Frame *)nullptr, count, &cap);
+    B32 ok = stack != nullptr;
+    if (ok) { stack[count++] = {root, 0, {}}; }
+
+    Rational value = {};
+    while (ok)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+
+        // Fold in the child that just finished
+        if (top->next == 1 && expr->kind != ExprKind::PRE_UNARY_MINUS) { top->acc = value; }
+        else if (top->next)
+        {
+            switch (expr->kind)
+            {
+                case ExprKind::PRE_UNARY_MINUS: { top->acc = value; ok = IntNegate(arena, value.num, &top->acc.num); } break;
+                case ExprKind::PLUS:            ok = RatAdd(arena, scratch, top->acc, value, &top->acc); break;
+                case ExprKind::MULTIPLY:        ok = RatMul(arena, scratch, top->acc, value, &top->acc); break;
+                case ExprKind::DIFFERENCE:      ok = RatSub(arena, scratch, top->acc, value, &top->acc); break;
+                case ExprKind::QUOTIENT:        ok = RatDiv(arena, scratch, top->acc, value, &top->acc); break;
+                default: break;
+            }
+            if (!ok) { break; }
+        }
+
+        if (top->next < ExprChildCount(expr))
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0, {}};
+            continue;
+        }
+
+        if (expr->kind == ExprKind::VAR) { ok = 0; break; }
+        value = ExprKindIsInteger(expr->kind) ? RatFromInt(ExprInteger(expr)) : top->acc;
+        count -= 1;
+        if (count == 0) { break; }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (ok) { *out = value; }
+    return ok;
+}
@@ -0,0 +1,44 @@
+/*
+ast_walk.hpp
+
+Whole tree passes, dispatched with a switch on kind. Walks keep their own stack
+in scratch so deep trees from the iterative parser are fine.
+*/
+#ifndef AST_WALK_HPP
+#define AST_WALK_HPP
+
+// Variable values for ExprEval, looked up by name
+struct ExprEnv 
+{
+    String8 *names;
+    F64 *values;
+    U32 count;
+};
+
+// Number of nodes reachable from root, 0 if scratch runs out
+internal U64 ExprNodeCount(Arena *scratch, Expr *root);
+
+// Arithmetic a node costs to evaluate, n-ary nodes cost count - 1
+struct ExprFlops 
+{
+    U64 adds;       // PLUS and DIFFERENCE
+    U64 muls;
+    U64 divs;
+    U64 negs;
+};
+
+// Sums over distinct nodes, so a subtree shared by pointer is counted once: the
+// cost for an evaluator that reuses it. 0 when scratch runs out.
+internal B32 ExprFlopCount(Arena *scratch, Expr *root, ExprFlops *out);
+internal U64 ExprFlopsTotal(ExprFlops flops);
+
+// Evaluates in double precision. Returns 0 on an unbound variable or when
+// scratch runs out, *out is left untouched then.
+internal B32 ExprEval(Arena *scratch, Expr *root, ExprEnv const *env, F64 *out);
+
+// Evaluates a tree without variables exactly: sums, products and quotients of
+// integers as rationals that grow as far as arena lets them. Returns 0 on a
+// variable, a division by zero or when an arena runs out.
+internal B32 ExprEvalExact(Arena *arena, Arena *scratch, Expr *root, Rational *out);
+
+#endif // AST_WALK_HPP
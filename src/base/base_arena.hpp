@@ -6,24 +6,25 @@ Refactored 12/09/2025
 
 
 
-template <size_t SIZE>  
-struct BumpAllocator 
+// Arena is the runtime-sized bump allocator everything else takes a pointer to,
+// BumpAllocator<SIZE> (bottom of file) is the fixed-size convenience wrapper.
+struct Arena 
 {
     unsigned char *memory;
-    U64 size{SIZE};
+    U64 size;
     U64 current_offset{};
     int alloc_counter{};
 
     // Constructor
     // Initialise the memory pointer to the memory of the heap array
-    BumpAllocator()
-        : memory{static_cast<unsigned char *>(malloc(SIZE))}
+    explicit Arena(U64 capacity)
+        : memory{static_cast<unsigned char *>(malloc(capacity))}, size{capacity}
     {}
 
-    BumpAllocator(const BumpAllocator&) = delete;
-    BumpAllocator& operator=(const BumpAllocator&) = delete;
-    BumpAllocator(BumpAllocator&&) = delete;
-    BumpAllocator& operator=(BumpAllocator&&) = delete;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = delete;
+    Arena& operator=(Arena&&) = delete;
 
     template <typename T>
     T* ArenaPush(U64 count, U64 align, B32 zero) 
@@ -103,7 +104,7 @@ struct BumpAllocator
         alloc_counter = 0;
     }
 
-    ~BumpAllocator() 
+    ~Arena() 
     {
         ArenaRelease();
     }
@@ -121,4 +122,22 @@ struct BumpAllocator
     }
 };
 
+template <size_t SIZE>  
+struct BumpAllocator : Arena
+{
+    BumpAllocator() : Arena(SIZE) {}
+};
 
+// Arena backed growable array. The old block is left behind in the arena,
+// at most doubling the memory actually used. Returns nullptr when out of space.
+template <typename T>
+internal T *
+ArenaGrowArray(Arena *arena, T *items, U64 count, U64 *cap)
+{
+    U64 new_cap = Max<U64>(16, *cap * 2);
+    T *grown = arena->PushArrayNoZero<T>(new_cap);
+    if (!grown) { return nullptr; }
+    if (count) { MemoryCopy(grown, items, sizeof(T) * count); }
+    *cap = new_cap;
+    return grown;
+}
@@ -24,3 +24,290 @@ MemoryZeroArray(T (&arr)[N])
 
 internal U64 
 DefaultAlign(U64 align) { return Max<U64>(8, align); }
+
+internal U32 
+CountTrailingZeros32(U32 x)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return (U32)index;
+#else
+	return (U32)__builtin_ctz(x);
+#endif
+}
+
+internal U32 
+CountTrailingZeros64(U64 x)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (U32)index;
+#else
+	return (U32)__builtin_ctzll(x);
+#endif
+}
+
+internal U32 
+CountLeadingZeros64(U64 x)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return 63 - (U32)index;
+#else
+	return (U32)__builtin_clzll(x);
+#endif
+}
+
+internal B32 
+AddS64Checked(S64 a, S64 b, S64 *out)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return !__builtin_add_overflow(a, b, out);
+#else
+	*out = (S64)((U64)a + (U64)b);
+	return !((a < 0) == (b < 0) && (*out < 0) != (a < 0));
+#endif
+}
+
+internal B32 
+SubS64Checked(S64 a, S64 b, S64 *out)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return !__builtin_sub_overflow(a, b, out);
+#else
+	*out = (S64)((U64)a - (U64)b);
+	return !((a < 0) != (b < 0) && (*out < 0) != (a < 0));
+#endif
+}
+
+internal B32 
+MulS64Checked(S64 a, S64 b, S64 *out)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return !__builtin_mul_overflow(a, b, out);
+#elif ARCH_X64
+	S64 high;
+	*out = _mul128(a, b, &high);
+	return high == (*out >> 63);
+#else
+	*out = (S64)((U64)a * (U64)b);
+	if (a == 0 || b == 0) { return 1; }
+	if ((a == -1 && b == std::numeric_limits<S64>::min()) || (b == -1 && a == std::numeric_limits<S64>::min())) { return 0; }
+	return *out / b == a;
+#endif
+}
+
+internal U64 
+HashU64(U64 x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
+
+internal U64 
+HashCombine(U64 seed, U64 value)
+{
+	return HashU64(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
+
+internal U64 
+HashBytes(void const *data, U64 size, U64 seed)
+{
+	U8 const *bytes = (U8 const *)data;
+	U64 hash = 0xcbf29ce484222325ull ^ seed;
+	for (U64 i = 0; i < size; i += 1)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return HashU64(hash);
+}
+
+internal B32 
+CpuHasAVX2(void)
+{
+#if !ARCH_X64
+	return 0;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	B32 os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+	__cpuidex(info, 7, 0);
+	return os_avx && (info[1] & (1 << 5));
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+internal B32 
+CpuHasAVX512(void)
+{
+#if !ARCH_X64
+	return 0;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	B32 os_avx512 = (info[2] & (1 << 27)) && (_xgetbv(0) & 0xe6) == 0xe6;
+	__cpuidex(info, 7, 0);
+	return os_avx512 && (info[1] & (1 << 16));
+#else
+	return __builtin_cpu_supports("avx512f");
+#endif
+}
+
+internal U64 
+ReadCycleCounter(void)
+{
+#if ARCH_X64
+	return __rdtsc();
+#elif defined(_MSC_VER)
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (U64)counter.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (U64)now.tv_sec*Billion(1) + (U64)now.tv_nsec;
+#endif
+}
+
+internal B32 
+OSWriteFd(int fd, void const *data, U64 size)
+{
+	U8 const *at = (U8 const *)data;
+	while (size)
+	{
+		U32 chunk = (U32)ClampTop<U64>(size, 1u << 30);
+#if defined(_MSC_VER)
+		int written = _write(fd, at, chunk);
+#else
+		ssize_t written = write(fd, at, chunk);
+#endif
+		if (written <= 0) { return 0; }
+		at += written;
+		size -= (U64)written;
+	}
+	return 1;
+}
+
+internal B32 
+OSMapFileRead(char const *path, OSMapping *out)
+{
+	*out = {};
+#if defined(_MSC_VER)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { return 0; }
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	CloseHandle(file);
+	if (!mapping) { return 0; }
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) { CloseHandle(mapping); return 0; }
+	out->handle = mapping;
+	out->size = (U64)size.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) { return 0; }
+	struct stat st;
+	void *data = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (data == MAP_FAILED) { return 0; }
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+	out->size = (U64)st.st_size;
+#endif
+	out->data = (U8 *)data;
+	return 1;
+}
+
+internal B32 
+OSMapFileCreate(char const *path, U64 size, OSMapping *out)
+{
+	*out = {};
+	if (size == 0) { return 0; }
+#if defined(_MSC_VER)
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { return 0; }
+	// Sizing the mapping grows the file
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, nullptr);
+	CloseHandle(file);
+	if (!mapping) { return 0; }
+	void *data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+	if (!data) { CloseHandle(mapping); return 0; }
+	out->handle = mapping;
+#else
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) { return 0; }
+	void *data = MAP_FAILED;
+	if (ftruncate(fd, (off_t)size) == 0)
+	{
+		data = mmap(nullptr, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (data == MAP_FAILED) { return 0; }
+#endif
+	out->data = (U8 *)data;
+	out->size = size;
+	return 1;
+}
+
+internal void 
+OSUnmapFile(OSMapping *map)
+{
+	if (!map->data) { return; }
+#if defined(_MSC_VER)
+	UnmapViewOfFile(map->data);
+	CloseHandle(map->handle);
+#else
+	munmap(map->data, (size_t)map->size);
+#endif
+	*map = {};
+}
+
+internal void *
+OSAllocExecutable(U64 size)
+{
+#if defined(_MSC_VER)
+	return VirtualAlloc(nullptr, (SIZE_T)size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	void *memory = mmap(nullptr, (size_t)size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return memory == MAP_FAILED ? nullptr : memory;
+#endif
+}
+
+internal B32 
+OSProtectExecutable(void *memory, U64 size)
+{
+#if defined(_MSC_VER)
+	DWORD old;
+	return VirtualProtect(memory, (SIZE_T)size, PAGE_EXECUTE_READ, &old) && FlushInstructionCache(GetCurrentProcess(), memory, (SIZE_T)size);
+#else
+	return mprotect(memory, (size_t)size, PROT_READ | PROT_EXEC) == 0;
+#endif
+}
+
+internal void 
+OSFreeExecutable(void *memory, U64 size)
+{
+	if (!memory) { return; }
+#if defined(_MSC_VER)
+	(void)size;
+	VirtualFree(memory, 0, MEM_RELEASE);
+#else
+	munmap(memory, (size_t)size);
+#endif
+}
@@ -7,9 +7,44 @@
 #include <cstdint>
 #include <cstring>
 #include <cstddef>
+#include <cstdio>
 #include <iostream>
 #include <limits>
 
+//////////////////
+// Architecture
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ARCH_X64 1
+#include <immintrin.h>
+#else
+#define ARCH_X64 0
+#endif
+
+// Lets one function use instructions the rest of the build does not assume,
+// callers check the CPU first. MSVC needs no opt-in for intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define FUNCTION_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FUNCTION_TARGET(isa)
+#endif
+
+#if defined(_MSC_VER)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+#undef CONST        // clashes with BcOp::CONST
+#include <intrin.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 //////////////////
 // Codebase Keywords
 
@@ -29,6 +64,8 @@ using S16 = int16_t;
 using S32 = int32_t;
 using S64 = int64_t;
 using B32 = S32; // bool32
+using F32 = float;
+using F64 = double;
 
 
 //////////////////
@@ -42,6 +79,11 @@ constexpr U64 Thousand(U64 n) { return n*1000; }
 constexpr U64 Million(U64 n) { return n*1000000; }
 constexpr U64 Billion(U64 n) { return n*1000000000; }
 
+constexpr U32 max_U32 = 0xffffffffu;
+constexpr U64 max_U64 = 0xffffffffffffffffull;
+
+#define ArrayCount(a) (sizeof(a) / sizeof((a)[0]))
+
 /////////////////
 // Clamps, Mins, Maxes
 
@@ -67,5 +109,69 @@ inline void MemoryZeroStruct(T& obj);
 template <typename T, std::size_t N>
 inline void MemoryZeroArray(T (&arr)[N]);
 
-U64 DefaultAlign(U64 align);
+internal U64 DefaultAlign(U64 align);
+
+/////////////////
+// Bit Operations
+
+internal U32 CountTrailingZeros32(U32 x);   // x must be non-zero
+internal U32 CountTrailingZeros64(U64 x);   // x must be non-zero
+internal U32 CountLeadingZeros64(U64 x);    // x must be non-zero
+
+/////////////////
+// Checked Arithmetic
+// 1 and the result in *out, or 0 on overflow with *out unspecified
+
+internal B32 AddS64Checked(S64 a, S64 b, S64 *out);
+internal B32 SubS64Checked(S64 a, S64 b, S64 *out);
+internal B32 MulS64Checked(S64 a, S64 b, S64 *out);
+
+/////////////////
+// CPU features, including OS support for the wider registers
+
+internal B32 CpuHasAVX2(void);
+internal B32 CpuHasAVX512(void);            // AVX-512F
+
+/////////////////
+// Timing
+
+// Ticks of the cheapest steady counter there is: the time stamp counter on x64,
+// nanoseconds or performance counter ticks elsewhere. Only good for comparing
+// costs within one run.
+internal U64 ReadCycleCounter(void);
+
+/////////////////
+// Files
+
+// Writes all of data to fd, retrying short writes. 0 on error.
+internal B32 OSWriteFd(int fd, void const *data, U64 size);
+
+// A whole file mapped into memory, shared with the page cache
+struct OSMapping 
+{
+    U8 *data;
+    U64 size;
+    void *handle;       // Windows file mapping object
+};
+
+// Read only, hinted for sequential access. 0 on error or an empty file.
+internal B32 OSMapFileRead(char const *path, OSMapping *out);
+// Creates or truncates path to size bytes and maps it writable. 0 on error.
+internal B32 OSMapFileCreate(char const *path, U64 size, OSMapping *out);
+internal void OSUnmapFile(OSMapping *map);
+
+/////////////////
+// Executable memory
+// Pages start writable, OSProtectExecutable flips them to read + execute once code is in
+
+internal void *OSAllocExecutable(U64 size);
+internal B32 OSProtectExecutable(void *memory, U64 size);
+internal void OSFreeExecutable(void *memory, U64 size);
+
+/////////////////
+// Hashing
+
+internal U64 HashU64(U64 x);                                    // splitmix64 finalizer
+internal U64 HashCombine(U64 seed, U64 value);                  // order dependent
+internal U64 HashBytes(void const *data, U64 size, U64 seed);   // FNV-1a, then mixed
 #endif // BASE_CORE_H
@@ -1,3 +1,4 @@
 #include "base_core.cpp"
 #include "base_arena.cpp"
-
+#include "base_string.cpp"
+#include "base_number.cpp"
@@ -3,5 +3,7 @@
 
 #include "base_core.hpp"
 #include "base_arena.hpp"
+#include "base_string.hpp"
+#include "base_number.hpp"
 
 #endif // BASE_INC_HPP
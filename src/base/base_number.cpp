@@ -0,0 +1,803 @@
+//////////////////
+// Limbs
+// 128-bit products and quotients go through __int128 where the compiler has it
+
+internal U64 
+BigMulWide(U64 a, U64 b, U64 *hi)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *hi = (U64)(product >> 64);
+    return (U64)product;
+#else
+    return _umul128(a, b, hi);
+#endif
+}
+
+// (hi:lo) / d, hi must be below d so the quotient fits
+internal U64 
+BigDivWide(U64 hi, U64 lo, U64 d, U64 *rem)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 n = ((unsigned __int128)hi << 64) | lo;
+    *rem = (U64)(n % d);
+    return (U64)(n / d);
+#else
+    return _udiv128(hi, lo, d, rem);
+#endif
+}
+
+//////////////////
+// Magnitudes
+// Limb arrays with explicit counts, leading zero limbs allowed unless noted
+
+internal U64 
+BigTrim(U64 const *a, U64 count)
+{
+    while (count && a[count - 1] == 0) { count -= 1; }
+    return count;
+}
+
+// Both trimmed
+internal S32 
+BigMagCompare(U64 const *a, U64 a_count, U64 const *b, U64 b_count)
+{
+    if (a_count != b_count) { return a_count < b_count ? -1 : 1; }
+    for (U64 i = a_count; i > 0; i -= 1)
+    {
+        if (a[i - 1] != b[i - 1]) { return a[i - 1] < b[i - 1] ? -1 : 1; }
+    }
+    return 0;
+}
+
+// dst += b over dst_count limbs, dst_count >= b_count. Returns the carry out.
+internal U64 
+BigMagAddInPlace(U64 *dst, U64 dst_count, U64 const *b, U64 b_count)
+{
+    U64 carry = 0;
+    for (U64 i = 0; i < b_count; i += 1)
+    {
+        U64 sum = dst[i] + b[i];
+        U64 c = sum < b[i];
+        dst[i] = sum + carry;
+        carry = c + (dst[i] < carry);
+    }
+    for (U64 i = b_count; carry && i < dst_count; i += 1) { carry = ++dst[i] == 0; }
+    return carry;
+}
+
+// dst -= b over dst_count limbs. Returns the borrow out.
+internal U64 
+BigMagSubInPlace(U64 *dst, U64 dst_count, U64 const *b, U64 b_count)
+{
+    U64 borrow = 0;
+    for (U64 i = 0; i < b_count; i += 1)
+    {
+        U64 diff = dst[i] - b[i];
+        U64 c = dst[i] < b[i];
+        dst[i] = diff - borrow;
+        borrow = c + (diff < borrow);
+    }
+    for (U64 i = b_count; borrow && i < dst_count; i += 1) { borrow = dst[i]-- == 0; }
+    return borrow;
+}
+
+// dst gets a_count + 1 limbs, a_count >= b_count
+internal void 
+BigMagAdd(U64 *dst, U64 const *a, U64 a_count, U64 const *b, U64 b_count)
+{
+    MemoryCopy(dst, a, sizeof(U64) * a_count);
+    dst[a_count] = BigMagAddInPlace(dst, a_count, b, b_count);
+}
+
+// dst = a * m + add over a_count limbs, returns the limb carried out
+internal U64 
+BigMagMulLimb(U64 *dst, U64 const *a, U64 a_count, U64 m, U64 add)
+{
+    U64 carry = add;
+    for (U64 i = 0; i < a_count; i += 1)
+    {
+        U64 hi;
+        U64 lo = BigMulWide(a[i], m, &hi);
+        lo += carry;
+        dst[i] = lo;
+        carry = hi + (lo < carry);
+    }
+    return carry;
+}
+
+// quotient = a / d over a_count limbs, may be a itself. Returns the remainder.
+internal U64 
+BigMagDivLimb(U64 *quotient, U64 const *a, U64 a_count, U64 d)
+{
+    U64 rem = 0;
+    for (U64 i = a_count; i > 0; i -= 1) { quotient[i - 1] = BigDivWide(rem, a[i - 1], d, &rem); }
+    return rem;
+}
+
+// dst gets a_count + b_count limbs
+internal void 
+BigMagMulSchoolbook(U64 *dst, U64 const *a, U64 a_count, U64 const *b, U64 b_count)
+{
+    MemoryZero(dst, sizeof(U64) * (a_count + b_count));
+    for (U64 i = 0; i < a_count; i += 1)
+    {
+        U64 carry = 0;
+        for (U64 j = 0; j < b_count; j += 1)
+        {
+            U64 hi;
+            U64 lo = BigMulWide(a[i], b[j], &hi);
+            U64 d = dst[i + j];
+            lo += d;
+            hi += lo < d;
+            lo += carry;
+            hi += lo < carry;
+            dst[i + j] = lo;
+            carry = hi;
+        }
+        dst[i + b_count] = carry;
+    }
+}
+
+// dst gets a_count + b_count limbs and must not overlap either operand. Halves
+// in scratch, which is back where it was on return.
+internal B32 
+BigMagMul(Arena *scratch, U64 *dst, U64 const *a, U64 a_count, U64 const *b, U64 b_count)
+{
+    if (a_count < b_count)
+    {
+        U64 const *swap = a; a = b; b = swap;
+        U64 n = a_count; a_count = b_count; b_count = n;
+    }
+    if (b_count < BIG_KARATSUBA_MIN)
+    {
+        BigMagMulSchoolbook(dst, a, a_count, b, b_count);
+        return 1;
+    }
+
+    U64 pos = scratch->ArenaGetPos();
+    B32 ok = 1;
+    U64 total = a_count + b_count;
+    if (2 * b_count <= a_count)
+    {
+        // Lopsided: b against a's b_count-limb slices, each balanced
+        MemoryZero(dst, sizeof(U64) * total);
+        U64 *part = scratch->PushArrayNoZero<U64>(2 * b_count);
+        ok = part != nullptr;
+        for (U64 at = 0; ok && at < a_count; at += b_count)
+        {
+            U64 n = Min(b_count, a_count - at);
+            ok = BigMagMul(scratch, part, a + at, n, b, b_count);
+            if (ok) { BigMagAddInPlace(dst + at, total - at, part, n + b_count); }
+        }
+    }
+    else
+    {
+        // a = a1 B^m + a0, b likewise: a0 b0 and a1 b1 land in their own halves
+        // of dst, (a0 + a1)(b0 + b1) minus both is the middle
+        U64 m = a_count / 2;
+        U64 a_high = a_count - m, b_high = b_count - m;
+        U64 sa_count = a_high + 1, sb_count = Max(m, b_high) + 1;
+        U64 *sa = scratch->PushArrayNoZero<U64>(sa_count);
+        U64 *sb = scratch->PushArrayNoZero<U64>(sb_count);
+        U64 *mid = scratch->PushArrayNoZero<U64>(sa_count + sb_count);
+        ok = sa && sb && mid;
+        ok = ok && BigMagMul(scratch, dst, a, m, b, m);
+        ok = ok && BigMagMul(scratch, dst + 2 * m, a + m, a_high, b + m, b_high);
+        if (ok)
+        {
+            BigMagAdd(sa, a + m, a_high, a, m);
+            if (b_high >= m) { BigMagAdd(sb, b + m, b_high, b, m); }
+            else             { BigMagAdd(sb, b, m, b + m, b_high); }
+            ok = BigMagMul(scratch, mid, sa, sa_count, sb, sb_count);
+        }
+        if (ok)
+        {
+            BigMagSubInPlace(mid, sa_count + sb_count, dst, 2 * m);
+            BigMagSubInPlace(mid, sa_count + sb_count, dst + 2 * m, a_high + b_high);
+            BigMagAddInPlace(dst + m, total - m, mid, BigTrim(mid, sa_count + sb_count));
+        }
+    }
+    scratch->ArenaSetPosBack(pos);
+    return ok;
+}
+
+// Knuth's algorithm D. quotient gets a_count - b_count + 1 limbs, remainder
+// b_count. b_count >= 2 with b trimmed, a_count >= b_count.
+internal B32 
+BigMagDivMod(Arena *scratch, U64 *quotient, U64 *remainder, U64 const *a, U64 a_count, U64 const *b, U64 b_count)
+{
+    U64 pos = scratch->ArenaGetPos();
+    U64 *v = scratch->PushArrayNoZero<U64>(b_count);
+    U64 *u = scratch->PushArrayNoZero<U64>(a_count + 1);
+    if (!v || !u) { scratch->ArenaSetPosBack(pos); return 0; }
+
+    // Shift so the divisor's top bit is set, the quotient estimates are then
+    // at most two too large
+    U32 shift = CountLeadingZeros64(b[b_count - 1]);
+    for (U64 i = b_count; i > 0; i -= 1) { v[i - 1] = (b[i - 1] << shift) | (shift && i > 1 ? b[i - 2] >> (64 - shift) : 0); }
+    u[a_count] = shift ? a[a_count - 1] >> (64 - shift) : 0;
+    for (U64 i = a_count; i > 0; i -= 1) { u[i - 1] = (a[i - 1] << shift) | (shift && i > 1 ? a[i - 2] >> (64 - shift) : 0); }
+
+    U64 v1 = v[b_count - 1], v2 = v[b_count - 2];
+    for (U64 j = a_count - b_count + 1; j > 0; j -= 1)
+    {
+        U64 *uj = u + j - 1;
+        U64 top = uj[b_count], next = uj[b_count - 1];
+        U64 qhat, rhat;
+        B32 rhat_overflow = 0;
+        if (top >= v1)
+        {
+            qhat = max_U64;
+            rhat = next + v1;
+            rhat_overflow = rhat < next;
+        }
+        else { qhat = BigDivWide(top, next, v1, &rhat); }
+        while (!rhat_overflow)
+        {
+            U64 hi;
+            U64 lo = BigMulWide(qhat, v2, &hi);
+            if (hi < rhat || (hi == rhat && lo <= uj[b_count - 2])) { break; }
+            qhat -= 1;
+            U64 r = rhat + v1;
+            rhat_overflow = r < rhat;
+            rhat = r;
+        }
+
+        // uj -= qhat * v, adding v back once if that went negative
+        U64 carry = 0, borrow = 0;
+        for (U64 i = 0; i < b_count; i += 1)
+        {
+            U64 hi;
+            U64 lo = BigMulWide(qhat, v[i], &hi);
+            lo += carry;
+            carry = hi + (lo < carry);
+            U64 diff = uj[i] - lo;
+            U64 c = uj[i] < lo;
+            uj[i] = diff - borrow;
+            borrow = c + (diff < borrow);
+        }
+        U64 diff = uj[b_count] - carry;
+        U64 c = uj[b_count] < carry;
+        uj[b_count] = diff - borrow;
+        borrow = c + (diff < borrow);
+        if (borrow)
+        {
+            qhat -= 1;
+            uj[b_count] += BigMagAddInPlace(uj, b_count, v, b_count);
+        }
+        quotient[j - 1] = qhat;
+    }
+    for (U64 i = 0; i < b_count; i += 1) { remainder[i] = (u[i] >> shift) | (shift ? u[i + 1] << (64 - shift) : 0); }
+    scratch->ArenaSetPosBack(pos);
+    return 1;
+}
+
+//////////////////
+// Integer
+
+internal Integer 
+IntFromS64(S64 value)
+{
+    Integer result = {value, nullptr};
+    return result;
+}
+
+internal B32 
+IntIsSmall(Integer a)
+{
+    return a.big == nullptr;
+}
+
+internal S32 
+IntSign(Integer a)
+{
+    if (a.big) { return a.big->neg ? -1 : 1; }
+    return (a.small > 0) - (a.small < 0);
+}
+
+// Magnitude and sign of any Integer, small ones through storage
+internal U64 const *
+IntMag(Integer const *a, U64 *storage, U64 *count, B32 *neg)
+{
+    if (a->big)
+    {
+        *count = a->big->count;
+        *neg = a->big->neg;
+        return a->big->limbs;
+    }
+    *neg = a->small < 0;
+    *storage = *neg ? (U64)0 - (U64)a->small : (U64)a->small;
+    *count = *storage != 0;
+    return storage;
+}
+
+// Takes limbs as the value's own when it doesn't fit S64, gives the arena back
+// down to pos when it does
+internal B32 
+IntFromMag(Arena *arena, U64 pos, U64 *limbs, U64 count, B32 neg, Integer *out)
+{
+    count = BigTrim(limbs, count);
+    U64 top = (U64)1 << 63;
+    if (count <= 1 && (count == 0 || limbs[0] < top || (neg && limbs[0] == top)))
+    {
+        U64 mag = count ? limbs[0] : 0;
+        arena->ArenaSetPosBack(pos);
+        *out = IntFromS64(neg ? (S64)((U64)0 - mag) : (S64)mag);
+        return 1;
+    }
+    BigInt *big = arena->PushArrayNoZero<BigInt>(1);
+    if (!big) { return 0; }
+    big->limbs = limbs;
+    big->count = (U32)count;
+    big->neg = neg != 0;
+    *out = {0, big};
+    return 1;
+}
+
+internal B32 
+IntCopy(Arena *arena, Integer a, Integer *out)
+{
+    if (!a.big) { *out = a; return 1; }
+    BigInt *big = arena->PushArrayNoZero<BigInt>(1);
+    U64 *limbs = arena->PushArrayNoZero<U64>(a.big->count);
+    if (!big || !limbs) { return 0; }
+    MemoryCopy(limbs, a.big->limbs, sizeof(U64) * a.big->count);
+    *big = {limbs, a.big->count, a.big->neg};
+    *out = {0, big};
+    return 1;
+}
+
+internal F64 
+IntToF64(Integer a)
+{
+    if (!a.big) { return (F64)a.small; }
+    F64 value = 0;
+    for (U64 i = a.big->count; i > 0; i -= 1) { value = value * 18446744073709551616.0 + (F64)a.big->limbs[i - 1]; }
+    return a.big->neg ? -value : value;
+}
+
+internal S32 
+IntCompare(Integer a, Integer b)
+{
+    if (!a.big && !b.big) { return (a.small > b.small) - (a.small < b.small); }
+    S32 sa = IntSign(a), sb = IntSign(b);
+    if (sa != sb) { return sa < sb ? -1 : 1; }
+    U64 a_storage, b_storage, a_count, b_count;
+    B32 a_neg, b_neg;
+    U64 const *am = IntMag(&a, &a_storage, &a_count, &a_neg);
+    U64 const *bm = IntMag(&b, &b_storage, &b_count, &b_neg);
+    S32 order = BigMagCompare(am, a_count, bm, b_count);
+    return sa < 0 ? -order : order;
+}
+
+// a + b with b's sign flipped when negate_b is set
+internal B32 
+IntAddSlow(Arena *arena, Integer a, Integer b, B32 negate_b, Integer *out)
+{
+    U64 a_storage, b_storage, a_count, b_count;
+    B32 a_neg, b_neg;
+    U64 const *am = IntMag(&a, &a_storage, &a_count, &a_neg);
+    U64 const *bm = IntMag(&b, &b_storage, &b_count, &b_neg);
+    b_neg ^= negate_b && b_count;
+
+    U64 pos = arena->ArenaGetPos();
+    U64 count = Max(a_count, b_count) + 1;
+    U64 *limbs = arena->PushArrayNoZero<U64>(count);
+    if (!limbs) { return 0; }
+    if (a_neg == b_neg)
+    {
+        if (a_count >= b_count) { BigMagAdd(limbs, am, a_count, bm, b_count); }
+        else                    { BigMagAdd(limbs, bm, b_count, am, a_count); }
+        return IntFromMag(arena, pos, limbs, count, a_neg, out);
+    }
+    if (BigMagCompare(am, a_count, bm, b_count) < 0)
+    {
+        U64 const *swap = am; am = bm; bm = swap;
+        U64 n = a_count; a_count = b_count; b_count = n;
+        a_neg = b_neg;
+    }
+    MemoryCopy(limbs, am, sizeof(U64) * a_count);
+    BigMagSubInPlace(limbs, a_count, bm, b_count);
+    return IntFromMag(arena, pos, limbs, a_count, a_neg, out);
+}
+
+internal B32 
+IntAdd(Arena *arena, Integer a, Integer b, Integer *out)
+{
+    S64 sum;
+    if (!a.big && !b.big && AddS64Checked(a.small, b.small, &sum)) { *out = IntFromS64(sum); return 1; }
+    return IntAddSlow(arena, a, b, 0, out);
+}
+
+internal B32 
+IntSub(Arena *arena, Integer a, Integer b, Integer *out)
+{
+    S64 diff;
+    if (!a.big && !b.big && SubS64Checked(a.small, b.small, &diff)) { *out = IntFromS64(diff); return 1; }
+    return IntAddSlow(arena, a, b, 1, out);
+}
+
+internal B32 
+IntNegate(Arena *arena, Integer a, Integer *out)
+{
+    return IntSub(arena, IntFromS64(0), a, out);
+}
+
+internal B32 
+IntMulSlow(Arena *arena, Integer a, Integer b, Integer *out)
+{
+    U64 a_storage, b_storage, a_count, b_count;
+    B32 a_neg, b_neg;
+    U64 const *am = IntMag(&a, &a_storage, &a_count, &a_neg);
+    U64 const *bm = IntMag(&b, &b_storage, &b_count, &b_neg);
+    if (!a_count || !b_count) { *out = IntFromS64(0); return 1; }
+
+    // Karatsuba's halves go above the product and are popped again
+    U64 pos = arena->ArenaGetPos();
+    U64 *limbs = arena->PushArrayNoZero<U64>(a_count + b_count);
+    if (!limbs || !BigMagMul(arena, limbs, am, a_count, bm, b_count)) { return 0; }
+    return IntFromMag(arena, pos, limbs, a_count + b_count, a_neg != b_neg, out);
+}
+
+internal B32 
+IntMul(Arena *arena, Integer a, Integer b, Integer *out)
+{
+    S64 product;
+    if (!a.big && !b.big && MulS64Checked(a.small, b.small, &product)) { *out = IntFromS64(product); return 1; }
+    return IntMulSlow(arena, a, b, out);
+}
+
+internal B32 
+IntDivMod(Arena *arena, Arena *scratch, Integer a, Integer b, Integer *quotient, Integer *remainder)
+{
+    if (IntSign(b) == 0) { return 0; }
+    if (!a.big && !b.big && !(b.small == -1 && a.small == std::numeric_limits<S64>::min()))
+    {
+        if (quotient)  { *quotient = IntFromS64(a.small / b.small); }
+        if (remainder) { *remainder = IntFromS64(a.small % b.small); }
+        return 1;
+    }
+
+    U64 a_storage, b_storage, a_count, b_count;
+    B32 a_neg, b_neg;
+    U64 const *am = IntMag(&a, &a_storage, &a_count, &a_neg);
+    U64 const *bm = IntMag(&b, &b_storage, &b_count, &b_neg);
+    Integer q = IntFromS64(0), r = a;
+    if (BigMagCompare(am, a_count, bm, b_count) >= 0)
+    {
+        U64 q_count = a_count - b_count + 1;
+        U64 *q_limbs = arena->PushArrayNoZero<U64>(q_count);
+        U64 *r_limbs = arena->PushArrayNoZero<U64>(b_count);
+        if (!q_limbs || !r_limbs) { return 0; }
+        if (b_count == 1)
+        {
+            r_limbs[0] = BigMagDivLimb(q_limbs, am, a_count, bm[0]);
+        }
+        else if (!BigMagDivMod(scratch, q_limbs, r_limbs, am, a_count, bm, b_count)) { return 0; }
+
+        // Both stay allocated even when they fit S64, neither is the last block
+        if (!IntFromMag(arena, arena->ArenaGetPos(), r_limbs, b_count, a_neg, &r)) { return 0; }
+        if (!IntFromMag(arena, arena->ArenaGetPos(), q_limbs, q_count, a_neg != b_neg, &q)) { return 0; }
+    }
+    if (quotient)  { *quotient = q; }
+    if (remainder) { *remainder = r; }
+    return 1;
+}
+
+internal U64 
+IntGcdU64(U64 a, U64 b)
+{
+    if (a == 0) { return b; }
+    if (b == 0) { return a; }
+    U32 shift = CountTrailingZeros64(a | b);
+    a >>= CountTrailingZeros64(a);
+    while (b)
+    {
+        b >>= CountTrailingZeros64(b);
+        if (a > b) { U64 t = a; a = b; b = t; }
+        b -= a;
+    }
+    return a << shift;
+}
+
+// The bits of x from shift up, as many as fit a U64
+internal U64 
+BigTopBits(U64 const *x, U64 count, U64 shift)
+{
+    U64 index = shift / 64, offset = shift % 64;
+    if (index >= count) { return 0; }
+    U64 bits = x[index] >> offset;
+    if (offset && index + 1 < count) { bits |= x[index + 1] << (64 - offset); }
+    return bits;
+}
+
+// dst = u x + v y with u and v of opposite signs (or zero) and a result known to
+// be non-negative. dst and tmp have room for count + 1 limbs, y is zero padded to count.
+internal U64 
+BigLinear(U64 *dst, U64 *tmp, U64 const *x, U64 const *y, U64 count, S64 u, S64 v)
+{
+    U64 const *plus = x, *minus = y;
+    U64 mul_plus = (U64)u, mul_minus = (U64)0 - (U64)v;
+    if (u < 0 || (u == 0 && v > 0))
+    {
+        plus = y;
+        minus = x;
+        mul_plus = (U64)v;
+        mul_minus = (U64)0 - (U64)u;
+    }
+    dst[count] = BigMagMulLimb(dst, plus, count, mul_plus, 0);
+    tmp[count] = BigMagMulLimb(tmp, minus, count, mul_minus, 0);
+    BigMagSubInPlace(dst, count + 1, tmp, count + 1);
+    return BigTrim(dst, count + 1);
+}
+
+internal B32 
+IntGcd(Arena *arena, Arena *scratch, Integer a, Integer b, Integer *out)
+{
+    U64 a_storage, b_storage, a_count, b_count;
+    B32 a_neg, b_neg;
+    U64 const *am = IntMag(&a, &a_storage, &a_count, &a_neg);
+    U64 const *bm = IntMag(&b, &b_storage, &b_count, &b_neg);
+    if (BigMagCompare(am, a_count, bm, b_count) < 0)
+    {
+        U64 const *swap = am; am = bm; bm = swap;
+        U64 n = a_count; a_count = b_count; b_count = n;
+    }
+    if (a_count <= 1)
+    {
+        U64 g = IntGcdU64(a_count ? am[0] : 0, b_count ? bm[0] : 0);
+        U64 pos = arena->ArenaGetPos();
+        U64 *limbs = arena->PushArrayNoZero<U64>(1);
+        if (!limbs) { return 0; }
+        limbs[0] = g;
+        return IntFromMag(arena, pos, limbs, 1, 0, out);
+    }
+
+    // Five buffers sized for the larger operand, rotated as the pair shrinks:
+    // x >= y always, the rest hold the next pair and products
+    U64 pos = scratch->ArenaGetPos();
+    U64 cap = a_count + 2;
+    U64 *buffers = scratch->PushArray<U64>(cap * 5);
+    if (!buffers) { return 0; }
+    U64 *x = buffers, *y = buffers + cap, *t0 = buffers + 2 * cap, *t1 = buffers + 3 * cap, *t2 = buffers + 4 * cap;
+    MemoryCopy(x, am, sizeof(U64) * a_count);
+    MemoryCopy(y, bm, sizeof(U64) * b_count);
+    U64 x_count = a_count, y_count = b_count;
+    B32 ok = 1;
+    while (ok && y_count > 1)
+    {
+        // Lehmer: run Euclid on the leading 62 bits with cofactors A B C D
+        // while the quotients provably match the full numbers', then apply the
+        // cofactors to the full numbers in one pass
+        U64 shift = x_count * 64 - CountLeadingZeros64(x[x_count - 1]) - 62;
+        S64 xh = (S64)BigTopBits(x, x_count, shift), yh = (S64)BigTopBits(y, y_count, shift);
+        S64 A = 1, B = 0, C = 0, D = 1;
+        while (yh + C > 0 && yh + D > 0)
+        {
+            S64 q = (xh + A) / (yh + C);
+            if (q != (xh + B) / (yh + D)) { break; }
+            S64 t = A - q * C; A = C; C = t;
+            t = B - q * D; B = D; D = t;
+            t = xh - q * yh; xh = yh; yh = t;
+        }
+
+        if (B == 0)
+        {
+            // No progress on the leading bits, one full division step
+            ok = BigMagDivMod(scratch, t2, t0, x, x_count, y, y_count);
+            U64 r_count = BigTrim(t0, y_count);
+            U64 *old = x;
+            x = y; x_count = y_count;
+            y = t0; y_count = r_count;
+            t0 = old;
+        }
+        else
+        {
+            MemoryZero(y + y_count, sizeof(U64) * (x_count - y_count));
+            U64 nx = BigLinear(t0, t2, x, y, x_count, A, B);
+            U64 ny = BigLinear(t1, t2, x, y, x_count, C, D);
+            U64 *old_x = x, *old_y = y;
+            x = t0; x_count = nx;
+            y = t1; y_count = ny;
+            t0 = old_x;
+            t1 = old_y;
+            if (BigMagCompare(x, x_count, y, y_count) < 0)
+            {
+                U64 *swap = x; x = y; y = swap;
+                U64 n = x_count; x_count = y_count; y_count = n;
+            }
+        }
+    }
+
+    U64 g = 0;
+    if (ok && y_count == 1)
+    {
+        U64 rem = BigMagDivLimb(t2, x, x_count, y[0]);
+        g = IntGcdU64(y[0], rem);
+    }
+    U64 out_pos = arena->ArenaGetPos();
+    U64 result_count = y_count == 1 ? 1 : x_count;
+    U64 *limbs = ok ? arena->PushArrayNoZero<U64>(result_count) : nullptr;
+    if (limbs)
+    {
+        if (y_count == 1) { limbs[0] = g; }
+        else              { MemoryCopy(limbs, x, sizeof(U64) * x_count); }
+        ok = IntFromMag(arena, out_pos, limbs, result_count, 0, out);
+    }
+    // arena may be scratch itself, the result then sits above the buffers
+    if (scratch != arena) { scratch->ArenaSetPosBack(pos); }
+    return ok && limbs;
+}
+
+//////////////////
+// Decimal text
+
+#define BIG_TEN19 10000000000000000000ull
+
+internal B32 
+IntFromStr8(Arena *arena, String8 text, Integer *out)
+{
+    B32 neg = text.size && text.str[0] == '-';
+    U64 first = neg;
+    if (first == text.size) { return 0; }
+    for (U64 i = first; i < text.size; i += 1)
+    {
+        if (text.str[i] < '0' || text.str[i] > '9') { return 0; }
+    }
+
+    // 19 digits at a time: limbs = limbs * 10^n + chunk
+    U64 digits = text.size - first;
+    U64 pos = arena->ArenaGetPos();
+    U64 cap = digits / 19 + 2;
+    U64 *limbs = arena->PushArray<U64>(cap);
+    if (!limbs) { return 0; }
+    U64 count = 0;
+    for (U64 at = first; at < text.size;)
+    {
+        U64 n = at == first && digits % 19 ? digits % 19 : 19;
+        U64 chunk = 0, scale = 1;
+        for (U64 i = 0; i < n; i += 1)
+        {
+            chunk = chunk * 10 + (U64)(text.str[at + i] - '0');
+            scale *= 10;
+        }
+        U64 carry = BigMagMulLimb(limbs, limbs, count, scale, chunk);
+        if (carry) { limbs[count++] = carry; }
+        at += n;
+    }
+    return IntFromMag(arena, pos, limbs, count, neg, out);
+}
+
+internal String8 
+IntToStr8(Arena *arena, Arena *scratch, Integer a)
+{
+    if (!a.big)
+    {
+        char text[24];
+        int size = snprintf(text, sizeof(text), "%lld", (long long)a.small);
+        return PushStr8Copy(arena, Str8((U8 *)text, (U64)size));
+    }
+
+    // Peel off 19 digits at a time from the bottom
+    U64 pos = scratch->ArenaGetPos();
+    U64 count = a.big->count;
+    U64 *work = scratch->PushArrayNoZero<U64>(count);
+    U64 *chunks = scratch->PushArrayNoZero<U64>(count * 2 + 1);
+    U8 *text = arena->PushArrayNoZero<U8>(count * 40 + 2);
+    if (!work || !chunks || !text)
+    {
+        scratch->ArenaSetPosBack(pos);
+        return Str8(nullptr, 0);
+    }
+    MemoryCopy(work, a.big->limbs, sizeof(U64) * count);
+    U64 chunk_count = 0;
+    while (count)
+    {
+        chunks[chunk_count++] = BigMagDivLimb(work, work, count, BIG_TEN19);
+        count = BigTrim(work, count);
+    }
+    U64 size = 0;
+    if (a.big->neg) { text[size++] = '-'; }
+    size += (U64)snprintf((char *)text + size, 21, "%llu", (unsigned long long)chunks[chunk_count - 1]);
+    for (U64 i = chunk_count - 1; i > 0; i -= 1) { size += (U64)snprintf((char *)text + size, 21, "%019llu", (unsigned long long)chunks[i - 1]); }
+    if (scratch != arena) { scratch->ArenaSetPosBack(pos); }
+    return Str8(text, size);
+}
+
+//////////////////
+// Rational
+
+internal Rational 
+RatFromInt(Integer a)
+{
+    Rational result = {a, IntFromS64(1)};
+    return result;
+}
+
+internal B32 
+RatIsInteger(Rational a)
+{
+    return !a.den.big && a.den.small == 1;
+}
+
+internal B32 
+RatFromFraction(Arena *arena, Arena *scratch, Integer num, Integer den, Rational *out)
+{
+    if (IntSign(den) == 0) { return 0; }
+
+    // The gcd takes the denominator's sign so the result's is positive
+    U64 pos = scratch->ArenaGetPos();
+    Integer g;
+    B32 ok = IntGcd(scratch, scratch, num, den, &g);
+    if (ok && IntSign(den) < 0) { ok = IntNegate(scratch, g, &g); }
+    Rational result = {num, den};
+    if (ok && IntCompare(g, IntFromS64(1)) != 0)
+    {
+        ok = IntDivMod(arena, scratch, num, g, &result.num, nullptr) && IntDivMod(arena, scratch, den, g, &result.den, nullptr);
+    }
+    if (scratch != arena) { scratch->ArenaSetPosBack(pos); }
+    if (ok) { *out = result; }
+    return ok;
+}
+
+internal B32 
+RatAdd(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out)
+{
+    if (RatIsInteger(a) && RatIsInteger(b))
+    {
+        Integer sum;
+        if (!IntAdd(arena, a.num, b.num, &sum)) { return 0; }
+        *out = RatFromInt(sum);
+        return 1;
+    }
+    Integer ad, bc, num, den;
+    return IntMul(arena, a.num, b.den, &ad) && IntMul(arena, b.num, a.den, &bc) &&
+           IntAdd(arena, ad, bc, &num) && IntMul(arena, a.den, b.den, &den) &&
+           RatFromFraction(arena, scratch, num, den, out);
+}
+
+internal B32 
+RatSub(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out)
+{
+    Rational negated = b;
+    return IntNegate(arena, b.num, &negated.num) && RatAdd(arena, scratch, a, negated, out);
+}
+
+internal B32 
+RatMul(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out)
+{
+    if (RatIsInteger(a) && RatIsInteger(b))
+    {
+        Integer product;
+        if (!IntMul(arena, a.num, b.num, &product)) { return 0; }
+        *out = RatFromInt(product);
+        return 1;
+    }
+    Integer num, den;
+    return IntMul(arena, a.num, b.num, &num) && IntMul(arena, a.den, b.den, &den) &&
+           RatFromFraction(arena, scratch, num, den, out);
+}
+
+internal B32 
+RatDiv(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out)
+{
+    Integer num, den;
+    return IntSign(b.num) != 0 &&
+           IntMul(arena, a.num, b.den, &num) && IntMul(arena, a.den, b.num, &den) &&
+           RatFromFraction(arena, scratch, num, den, out);
+}
+
+internal String8 
+RatToStr8(Arena *arena, Arena *scratch, Rational a)
+{
+    String8 num = IntToStr8(arena, scratch, a.num);
+    if (RatIsInteger(a) || !num.str) { return num; }
+    String8 den = IntToStr8(arena, scratch, a.den);
+    U8 *text = den.str ? arena->PushArrayNoZero<U8>(num.size + den.size + 1) : nullptr;
+    if (!text) { return Str8(nullptr, 0); }
+    MemoryCopy(text, num.str, num.size);
+    text[num.size] = '/';
+    MemoryCopy(text + num.size + 1, den.str, den.size);
+    return Str8(text, num.size + den.size + 1);
+}
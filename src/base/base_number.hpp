@@ -0,0 +1,72 @@
+#ifndef BASE_NUMBER_HPP
+#define BASE_NUMBER_HPP
+
+//////////////////
+// Exact integers and rationals
+// An Integer is a plain S64 until an operation overflows, then it is promoted
+// to an arena allocated magnitude and sign, and it drops back to S64 whenever a
+// result fits again. The small path is one checked instruction and a branch.
+// Big magnitudes are 64-bit limbs, least significant first; products switch to
+// Karatsuba above BIG_KARATSUBA_MIN limbs and gcds use Lehmer's algorithm.
+//
+// Every operation that can promote takes an arena and returns 0 when it runs
+// out, or on division by zero. Results never alias their inputs' limbs, and
+// inputs are passed by value, so out may be one of them. A scratch arena may be
+// the arena itself, its temporaries are then left behind with the result.
+
+#define BIG_KARATSUBA_MIN 32
+
+struct BigInt 
+{
+    U64 *limbs;                 // no leading zero limb
+    U32 count;                  // at least 1, smaller values stay S64
+    B32 neg;
+};
+
+struct Integer 
+{
+    S64 small;                  // the value while big is nullptr
+    BigInt *big;
+};
+
+// num / den with den > 0 and gcd(num, den) = 1
+struct Rational 
+{
+    Integer num;
+    Integer den;
+};
+
+internal Integer IntFromS64(S64 value);
+internal B32 IntIsSmall(Integer a);
+internal S32 IntSign(Integer a);
+internal S32 IntCompare(Integer a, Integer b);
+// Deep, so the copy outlives the arena a came from
+internal B32 IntCopy(Arena *arena, Integer a, Integer *out);
+// Rounded once per limb, so big values can be an ulp off the nearest double
+internal F64 IntToF64(Integer a);
+
+internal B32 IntAdd(Arena *arena, Integer a, Integer b, Integer *out);
+internal B32 IntSub(Arena *arena, Integer a, Integer b, Integer *out);
+internal B32 IntMul(Arena *arena, Integer a, Integer b, Integer *out);
+internal B32 IntNegate(Arena *arena, Integer a, Integer *out);
+// Truncating, like C: the remainder takes the sign of a. scratch holds the
+// normalized operands.
+internal B32 IntDivMod(Arena *arena, Arena *scratch, Integer a, Integer b, Integer *quotient, Integer *remainder);
+// Non-negative, gcd(0, 0) = 0
+internal B32 IntGcd(Arena *arena, Arena *scratch, Integer a, Integer b, Integer *out);
+
+// Decimal with an optional leading '-', 0 on anything else
+internal B32 IntFromStr8(Arena *arena, String8 text, Integer *out);
+internal String8 IntToStr8(Arena *arena, Arena *scratch, Integer a);
+
+internal Rational RatFromInt(Integer a);
+internal B32 RatFromFraction(Arena *arena, Arena *scratch, Integer num, Integer den, Rational *out);
+internal B32 RatAdd(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out);
+internal B32 RatSub(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out);
+internal B32 RatMul(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out);
+internal B32 RatDiv(Arena *arena, Arena *scratch, Rational a, Rational b, Rational *out);
+internal B32 RatIsInteger(Rational a);
+// "num" or "num/den"
+internal String8 RatToStr8(Arena *arena, Arena *scratch, Rational a);
+
+#endif // BASE_NUMBER_HPP
@@ -0,0 +1,37 @@
+internal String8 
+Str8(U8 *str, U64 size)
+{
+    String8 result = {str, size};
+    return result;
+}
+
+internal String8 
+Str8C(char const *cstr)
+{
+    return Str8((U8 *)cstr, cstr ? std::strlen(cstr) : 0);
+}
+
+internal String8 
+Str8Substr(String8 string, U64 first, U64 one_past_last)
+{
+    one_past_last = ClampTop(one_past_last, string.size);
+    first = ClampTop(first, one_past_last);
+    return Str8(string.str + first, one_past_last - first);
+}
+
+internal B32 
+Str8Match(String8 a, String8 b)
+{
+    return a.size == b.size && (a.size == 0 || std::memcmp(a.str, b.str, a.size) == 0);
+}
+
+// Copies and null terminates so the result can also be handed to C APIs
+internal String8 
+PushStr8Copy(Arena *arena, String8 string)
+{
+    U8 *str = arena->PushArrayNoZero<U8>(string.size + 1);
+    if (!str) { return Str8(nullptr, 0); }
+    MemoryCopy(str, string.str, string.size);
+    str[string.size] = 0;
+    return Str8(str, string.size);
+}
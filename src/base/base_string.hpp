@@ -0,0 +1,22 @@
+#ifndef BASE_STRING_HPP
+#define BASE_STRING_HPP
+
+//////////////////
+// Sized strings
+// Not null terminated, usually point into a source buffer or an arena
+
+struct String8
+{
+    U8 *str;
+    U64 size;
+};
+
+#define Str8Lit(s) Str8((U8 *)(s), sizeof(s) - 1)
+
+internal String8 Str8(U8 *str, U64 size);
+internal String8 Str8C(char const *cstr);
+internal String8 Str8Substr(String8 string, U64 first, U64 one_past_last);
+internal B32 Str8Match(String8 a, String8 b);
+internal String8 PushStr8Copy(Arena *arena, String8 string);
+
+#endif // BASE_STRING_HPP
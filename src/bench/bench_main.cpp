@@ -0,0 +1,1508 @@
+//////////////////////
+// Headers
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "base_inc.hpp"
+#include "ast/ast_inc.hpp"
+#include "job/job_inc.hpp"
+#include "parse/parse_inc.hpp"
+#include "eval/eval_inc.hpp"
+
+//////////////////////
+// Implementations
+#include "base_inc.cpp"
+#include "ast/ast_inc.cpp"
+#include "job/job_inc.cpp"
+#include "parse/parse_inc.cpp"
+#include "eval/eval_inc.cpp"
+
+//////////////////////
+// Timing
+
+internal double 
+BenchSeconds(void)
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Runs body once to warm caches and page in arenas, then until at least
+// min_seconds have passed, returns seconds per run
+#define BENCH_TIME(result, min_seconds, body) do { \
+    body; \
+    U64 bench_runs_ = 0; double bench_start_ = BenchSeconds(), bench_now_; \
+    do { body; bench_runs_ += 1; bench_now_ = BenchSeconds(); } while (bench_now_ - bench_start_ < (min_seconds)); \
+    (result) = (bench_now_ - bench_start_) / (double)bench_runs_; } while (0)
+
+internal void 
+BenchReport(char const *group, char const *name, U64 n, double seconds, U64 bytes)
+{
+    if (bytes) { printf("%-10s %-28s n=%-9llu %10.3f ms %10.1f MB/s\n", group, name, (unsigned long long)n, seconds * 1e3, (double)bytes / seconds / 1e6); }
+    else       { printf("%-10s %-28s n=%-9llu %10.3f ms\n", group, name, (unsigned long long)n, seconds * 1e3); }
+}
+
+internal void 
+BenchReportPerItem(char const *group, char const *name, U64 n, double seconds)
+{
+    printf("%-10s %-28s n=%-9llu %10.3f us %10.2f ns/item\n", group, name, (unsigned long long)n, seconds * 1e6, seconds * 1e9 / (double)n);
+}
+
+internal void 
+BenchReportRate(char const *group, char const *name, U64 n, double seconds, char const *unit)
+{
+    printf("%-10s %-28s n=%-9llu %10.3f ms %10.1f M%s/s\n", group, name, (unsigned long long)n, seconds * 1e3, (double)n / seconds / 1e6, unit);
+}
+
+//////////////////////
+// Input generators
+
+internal String8 
+BenchDeepParens(Arena *arena, U64 depth)
+{
+    U8 *str = arena->PushArrayNoZero<U8>(depth * 2 + 1);
+    for (U64 i = 0; i < depth; i += 1) { str[i] = '('; str[depth + 1 + i] = ')'; }
+    str[depth] = 'x';
+    return Str8(str, depth * 2 + 1);
+}
+
+internal String8 
+BenchDeepUnary(Arena *arena, U64 depth)
+{
+    U8 *str = arena->PushArrayNoZero<U8>(depth + 1);
+    for (U64 i = 0; i < depth; i += 1) { str[i] = '-'; }
+    str[depth] = 'x';
+    return Str8(str, depth + 1);
+}
+
+// Generated polynomial style input: 3x(x+1) - 12y/2z + ... with n terms
+internal String8 
+BenchPolynomial(Arena *arena, U64 terms, B32 sum_only = 0)
+{
+    char const *pieces[] = {"3x(x+1)", "12y/2z", "-7x*y*z", "(a+b)*c", "42", "xy"};
+    char const *ops[] = {" + ", " - ", " + ", " * "};
+    U64 cap = terms * 12 + 1;
+    U8 *str = arena->PushArrayNoZero<U8>(cap);
+    U64 size = 0;
+    for (U64 i = 0; i < terms; i += 1)
+    {
+        if (i) { char const *op = sum_only ? " + " : ops[i % ArrayCount(ops)]; U64 n = std::strlen(op); MemoryCopy(str + size, op, n); size += n; }
+        char const *piece = pieces[(i * 7) % ArrayCount(pieces)];
+        U64 n = std::strlen(piece);
+        MemoryCopy(str + size, piece, n);
+        size += n;
+    }
+    return Str8(str, size);
+}
+
+// Every x^i y^j with i + j <= degree, written out as repeated products
+internal String8 
+BenchDensePolynomial(Arena *arena, U32 degree)
+{
+    U64 cap = (U64)(degree + 1) * (degree + 1) * (degree * 2 + 16) + 1;
+    U8 *str = arena->PushArrayNoZero<U8>(cap);
+    U64 size = 0;
+    for (U32 i = 0; i <= degree; i += 1)
+    {
+        for (U32 j = 0; i + j <= degree; j += 1)
+        {
+            size += (U64)snprintf((char *)str + size, cap - size, "%s%u", size ? ((i + j) % 3 ? " + " : " - ") : "", (i * 7 + j * 3) % 9 + 1);
+            for (U32 k = 0; k < i; k += 1) { size += (U64)snprintf((char *)str + size, cap - size, "*x"); }
+            for (U32 k = 0; k < j; k += 1) { size += (U64)snprintf((char *)str + size, cap - size, "*y"); }
+        }
+    }
+    return Str8(str, size);
+}
+
+//////////////////////
+// Recursive reference
+// The old recursive Pratt structure, over the same lexer and nodes, to keep the
+// iterative parser honest about throughput. Only fed inputs the C++ stack survives.
+
+struct BenchRecParser 
+{
+    Arena *arena;
+    Arena *scratch;
+    Lexer lexer;
+    Token cur;
+    Token peek;
+};
+
+internal void 
+BenchRecNext(BenchRecParser *p)
+{
+    p->cur = p->peek;
+    p->peek = LexerNext(&p->lexer);
+}
+
+internal Expr *
+BenchRecExpression(BenchRecParser *p, int precedence)
+{
+    Expr *left = nullptr;
+    switch (p->cur.kind)
+    {
+        case TokenKind::INT:
+        {
+            S64 value = 0;
+            for (U32 i = 0; i < p->cur.size; i += 1) { value = value * 10 + (p->lexer.input.str[p->cur.offset + i] - '0'); }
+            left = ExprPushNum(p->arena, value);
+        } break;
+        case TokenKind::SYMBOL: left = ExprPushVar(p->arena, TokenString(p->lexer.input, p->cur)); break;
+        case TokenKind::MINUS:
+        {
+            BenchRecNext(p);
+            left = ExprPushUnary(p->arena, BenchRecExpression(p, UNARY));
+        } break;
+        case TokenKind::LPAREN:
+        {
+            BenchRecNext(p);
+            left = BenchRecExpression(p, LOWEST);
+            if (p->peek.kind != TokenKind::RPAREN) { return nullptr; }
+            BenchRecNext(p);
+        } break;
+        default: return nullptr;
+    }
+
+    // Open n-ary operands of left, flattened like parseNaryExpression
+    Expr **ops = nullptr;
+    U64 count = 0, cap = 0;
+    ExprKind open_kind = ExprKind::COUNT;
+    while (p->peek.kind != TokenKind::EOL && precedence < GrammarInfixPower(p->peek.kind))
+    {
+        BenchRecNext(p);
+        TokenKind op = p->cur.kind;
+        int power = GrammarInfixPower(op);
+        BenchRecNext(p);
+        Expr *right = BenchRecExpression(p, power);
+        ExprKind kind = GrammarInfixExprKind(op);
+        if (ExprKindIsNary(kind))
+        {
+            if (open_kind != kind)
+            {
+                if (ops) { left = ExprPushNary(p->arena, open_kind, ops, (U32)count); }
+                count = 0;
+                cap = 0;
+                ops = ArenaGrowArray<Expr *>(p->scratch, nullptr, 0, &cap);
+                ops[count++] = left;
+                open_kind = kind;
+            }
+            if (count == cap) { ops = ArenaGrowArray(p->scratch, ops, count, &cap); }
+            ops[count++] = right;
+        }
+        else
+        {
+            if (ops) { left = ExprPushNary(p->arena, open_kind, ops, (U32)count); ops = nullptr; open_kind = ExprKind::COUNT; }
+            left = ExprPushBinary(p->arena, kind, left, right);
+        }
+    }
+    if (ops) { left = ExprPushNary(p->arena, open_kind, ops, (U32)count); }
+    return left;
+}
+
+internal Expr *
+BenchRecParse(Arena *arena, Arena *scratch, String8 source)
+{
+    U64 pos = scratch->ArenaGetPos();
+    BenchRecParser p = {};
+    p.arena = arena;
+    p.scratch = scratch;
+    p.lexer = LexerInit(source);
+    BenchRecNext(&p);
+    BenchRecNext(&p);
+    Expr *root = BenchRecExpression(&p, LOWEST);
+    scratch->ArenaSetPosBack(pos);
+    return root;
+}
+
+//////////////////////
+// Parse benchmarks
+
+internal void 
+BenchParseInput(Arena *arena, Arena *scratch, char const *name, String8 source, U64 n, B32 recursive)
+{
+    U64 pos = arena->ArenaGetPos();
+    double seconds;
+    B32 ok = 1;
+
+    BENCH_TIME(seconds, 0.2, { ok &= Parse(arena, scratch, source).root != nullptr; arena->ArenaSetPosBack(pos); });
+    BenchReport("parse", name, n, seconds, source.size);
+
+    if (recursive)
+    {
+        char rec_name[64];
+        snprintf(rec_name, sizeof(rec_name), "%s (recursive)", name);
+        BENCH_TIME(seconds, 0.2, { ok &= BenchRecParse(arena, scratch, source) != nullptr; arena->ArenaSetPosBack(pos); });
+        BenchReport("parse", rec_name, n, seconds, source.size);
+    }
+    if (!ok) { printf("parse %s: FAILED\n", name); }
+}
+
+internal void 
+BenchParse(void)
+{
+    Arena *inputs = new Arena(MB(64));
+    Arena *arena = new Arena(GB(1));
+    Arena *scratch = new Arena(MB(256));
+
+    BenchParseInput(arena, scratch, "polynomial", BenchPolynomial(inputs, Thousand(100)), Thousand(100), 1);
+    BenchParseInput(arena, scratch, "polynomial", BenchPolynomial(inputs, Million(1)), Million(1), 1);
+    BenchParseInput(arena, scratch, "deep_parens", BenchDeepParens(inputs, Thousand(5)), Thousand(5), 1);
+    BenchParseInput(arena, scratch, "deep_parens", BenchDeepParens(inputs, Million(1)), Million(1), 0);
+    BenchParseInput(arena, scratch, "deep_unary", BenchDeepUnary(inputs, Thousand(5)), Thousand(5), 1);
+    BenchParseInput(arena, scratch, "deep_unary", BenchDeepUnary(inputs, Million(1)), Million(1), 0);
+
+    delete scratch;
+    delete arena;
+    delete inputs;
+}
+
+internal void 
+BenchParseParallel(void)
+{
+    JobSystem *jobs = JobSystemCreate(0, MB(256));
+    Arena *inputs = new Arena(MB(64));
+    Arena *arena = new Arena(GB(1));
+    Arena **worker_arenas = new Arena *[jobs->worker_count];
+    for (U32 i = 0; i < jobs->worker_count; i += 1) { worker_arenas[i] = new Arena(GB(1)); }
+
+    U64 terms = Million(2);
+    String8 source = BenchPolynomial(inputs, terms);
+    U64 pos = arena->ArenaGetPos();
+    double seconds;
+
+    U64 *splits;
+    U64 split_count;
+    BENCH_TIME(seconds, 0.2, { ParseSplitTopLevel(arena, source, &splits, &split_count); arena->ArenaSetPosBack(pos); });
+    BenchReport("parse", "split_scan", terms, seconds, source.size);
+
+    BENCH_TIME(seconds, 0.5, { Parse(arena, JobScratch(jobs, 0), source); arena->ArenaSetPosBack(pos); });
+    BenchReport("parse", "serial", terms, seconds, source.size);
+
+    char name[64];
+    snprintf(name, sizeof(name), "parallel (%u workers)", jobs->worker_count);
+    BENCH_TIME(seconds, 0.5, {
+        ParseParallel(jobs, arena, worker_arenas, source);
+        arena->ArenaSetPosBack(pos);
+        for (U32 i = 0; i < jobs->worker_count; i += 1) { worker_arenas[i]->ArenaClear(); }
+    });
+    BenchReport("parse", name, terms, seconds, source.size);
+
+    for (U32 i = 0; i < jobs->worker_count; i += 1) { delete worker_arenas[i]; }
+    delete[] worker_arenas;
+    delete arena;
+    delete inputs;
+    JobSystemDestroy(jobs);
+}
+
+internal void 
+BenchParseBatch(void)
+{
+    JobSystem *jobs = JobSystemCreate(0, MB(64));
+    Arena *inputs = new Arena(MB(256));
+    Arena *arena = new Arena(MB(256));
+    Arena **worker_arenas = new Arena *[jobs->worker_count];
+    for (U32 i = 0; i < jobs->worker_count; i += 1) { worker_arenas[i] = new Arena(MB(512)); }
+
+    // Many short independent inputs, one in eight broken
+    U64 count = Thousand(250);
+    U64 bytes = 0;
+    String8 *sources = inputs->PushArray<String8>(count);
+    for (U64 i = 0; i < count; i += 1)
+    {
+        sources[i] = (i % 8 == 7) ? Str8Lit("3x(x+1) - (y + 2") : BenchPolynomial(inputs, 4 + i % 13);
+        bytes += sources[i].size;
+    }
+    U64 pos = arena->ArenaGetPos();
+    double seconds;
+
+    BENCH_TIME(seconds, 0.5, {
+        Arena *scratch = JobScratch(jobs, 0);
+        Expr **roots = arena->PushArrayNoZero<Expr *>(count);
+        ParseError *errors = arena->PushArrayNoZero<ParseError>(count);
+        for (U64 i = 0; i < count; i += 1)
+        {
+            ParseResult res = Parse(worker_arenas[0], scratch, sources[i]);
+            roots[i] = res.root;
+            errors[i] = res.error;
+        }
+        arena->ArenaSetPosBack(pos);
+        worker_arenas[0]->ArenaClear();
+    });
+    BenchReport("parse", "batch serial loop", count, seconds, bytes);
+
+    char name[64];
+    snprintf(name, sizeof(name), "batch (%u workers)", jobs->worker_count);
+    BENCH_TIME(seconds, 0.5, {
+        ParseBatch(jobs, arena, worker_arenas, sources, count);
+        arena->ArenaSetPosBack(pos);
+        for (U32 i = 0; i < jobs->worker_count; i += 1) { worker_arenas[i]->ArenaClear(); }
+    });
+    BenchReport("parse", name, count, seconds, bytes);
+
+    for (U32 i = 0; i < jobs->worker_count; i += 1) { delete worker_arenas[i]; }
+    delete[] worker_arenas;
+    delete arena;
+    delete inputs;
+    JobSystemDestroy(jobs);
+}
+
+//////////////////////
+// Virtual dispatch reference
+// Same shape as old/ast.hpp: a vptr, token text and kind duplicated in every node,
+// unique_ptr children and double dispatch through a visitor.
+
+struct VNum;
+struct VVar;
+struct VPrefix;
+struct VBinary;
+struct VNary;
+
+struct VVisitor 
+{
+    virtual ~VVisitor() = default;
+    virtual void visit(const VNum &) = 0;
+    virtual void visit(const VVar &) = 0;
+    virtual void visit(const VPrefix &) = 0;
+    virtual void visit(const VBinary &) = 0;
+    virtual void visit(const VNary &) = 0;
+};
+
+struct VNode 
+{
+    virtual ~VNode() = default;
+    virtual ExprKind getKind() const = 0;
+    virtual void accept(VVisitor &visitor) const = 0;
+};
+
+struct VNum : VNode 
+{
+    std::string Tok;
+    ExprKind Kind;
+    S64 Value;
+    ExprKind getKind() const override { return Kind; }
+    void accept(VVisitor &visitor) const override { visitor.visit(*this); }
+};
+
+struct VVar : VNode 
+{
+    std::string Tok;
+    ExprKind Kind;
+    std::string Value;
+    ExprKind getKind() const override { return Kind; }
+    void accept(VVisitor &visitor) const override { visitor.visit(*this); }
+};
+
+struct VPrefix : VNode 
+{
+    std::string Tok;
+    ExprKind Kind;
+    std::unique_ptr<VNode> Right;
+    ExprKind getKind() const override { return Kind; }
+    void accept(VVisitor &visitor) const override { visitor.visit(*this); }
+};
+
+struct VBinary : VNode 
+{
+    std::string Tok;
+    ExprKind Kind;
+    std::unique_ptr<VNode> Left, Right;
+    ExprKind getKind() const override { return Kind; }
+    void accept(VVisitor &visitor) const override { visitor.visit(*this); }
+};
+
+struct VNary : VNode 
+{
+    std::string Tok;
+    ExprKind Kind;
+    std::vector<std::unique_ptr<VNode>> Operands;
+    ExprKind getKind() const override { return Kind; }
+    void accept(VVisitor &visitor) const override { visitor.visit(*this); }
+};
+
+struct VCountVisitor : VVisitor 
+{
+    U64 nodes = 0;
+    void visit(const VNum &) override { nodes += 1; }
+    void visit(const VVar &) override { nodes += 1; }
+    void visit(const VPrefix &n) override { nodes += 1; n.Right->accept(*this); }
+    void visit(const VBinary &n) override { nodes += 1; n.Left->accept(*this); n.Right->accept(*this); }
+    void visit(const VNary &n) override { nodes += 1; for (auto &op : n.Operands) { op->accept(*this); } }
+};
+
+struct VEvalVisitor : VVisitor 
+{
+    ExprEnv const *env;
+    F64 value = 0.0;
+    void visit(const VNum &n) override { value = (F64)n.Value; }
+    void visit(const VVar &n) override 
+    {
+        value = 0.0;
+        for (U32 i = 0; i < env->count; i += 1)
+        {
+            if (Str8Match(env->names[i], Str8((U8 *)n.Value.data(), n.Value.size()))) { value = env->values[i]; break; }
+        }
+    }
+    void visit(const VPrefix &n) override { n.Right->accept(*this); value = -value; }
+    void visit(const VBinary &n) override 
+    {
+        n.Left->accept(*this);
+        F64 left = value;
+        n.Right->accept(*this);
+        value = n.Kind == ExprKind::DIFFERENCE ? left - value : left / value;
+    }
+    void visit(const VNary &n) override 
+    {
+        n.Operands[0]->accept(*this);
+        F64 acc = value;
+        for (size_t i = 1; i < n.Operands.size(); i += 1)
+        {
+            n.Operands[i]->accept(*this);
+            acc = n.Kind == ExprKind::PLUS ? acc + value : acc * value;
+        }
+        value = acc;
+    }
+};
+
+internal std::unique_ptr<VNode> 
+BenchVirtualFromExpr(Expr *expr)
+{
+    std::string tok(1, ExprKindOperator(expr->kind));
+    switch (expr->kind)
+    {
+        case ExprKind::NUM:
+        {
+            auto node = std::make_unique<VNum>();
+            node->Tok = std::to_string(expr->num);
+            node->Kind = expr->kind;
+            node->Value = expr->num;
+            return node;
+        }
+        case ExprKind::VAR:
+        {
+            auto node = std::make_unique<VVar>();
+            node->Tok = std::string((char *)expr->var.str, expr->var.size);
+            node->Kind = expr->kind;
+            node->Value = node->Tok;
+            return node;
+        }
+        case ExprKind::PRE_UNARY_MINUS:
+        {
+            auto node = std::make_unique<VPrefix>();
+            node->Tok = tok;
+            node->Kind = expr->kind;
+            node->Right = BenchVirtualFromExpr(expr->operand);
+            return node;
+        }
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT:
+        {
+            auto node = std::make_unique<VBinary>();
+            node->Tok = tok;
+            node->Kind = expr->kind;
+            node->Left = BenchVirtualFromExpr(expr->bin.left);
+            node->Right = BenchVirtualFromExpr(expr->bin.right);
+            return node;
+        }
+        default:
+        {
+            auto node = std::make_unique<VNary>();
+            node->Tok = tok;
+            node->Kind = expr->kind;
+            for (U32 i = 0; i < expr->count; i += 1) { node->Operands.push_back(BenchVirtualFromExpr(expr->operands[i])); }
+            return node;
+        }
+    }
+}
+
+// old/ast.cpp String(): a fresh ostringstream per node, children returned by value
+internal std::string 
+BenchOldString(Expr *expr)
+{
+    std::ostringstream oss;
+    switch (expr->kind)
+    {
+        case ExprKind::NUM: oss << expr->num; break;
+        case ExprKind::VAR: oss << std::string((char *)expr->var.str, expr->var.size); break;
+        case ExprKind::PRE_UNARY_MINUS: oss << "(-" << BenchOldString(expr->operand) << ")"; break;
+        case ExprKind::DIFFERENCE:
+        case ExprKind::QUOTIENT:
+        {
+            oss << "(" << BenchOldString(expr->bin.left) << " " << ExprKindOperator(expr->kind) << " " << BenchOldString(expr->bin.right) << ")";
+        } break;
+        default:
+        {
+            oss << "(";
+            for (U32 i = 0; i < expr->count; i += 1)
+            {
+                if (i) { oss << " " << ExprKindOperator(expr->kind) << " "; }
+                oss << BenchOldString(expr->operands[i]);
+            }
+            oss << ")";
+        } break;
+    }
+    return oss.str();
+}
+
+internal void 
+BenchWalk(void)
+{
+    Arena *arena = new Arena(MB(512));
+    Arena *scratch = new Arena(MB(512));
+
+    // Only top level '+', the '-' chains of the plain polynomial nest deeper than
+    // the recursive visitors survive
+    U64 terms = Million(1);
+    String8 source = BenchPolynomial(arena, terms, 1);
+    Expr *root = Parse(arena, scratch, source).root;
+    std::unique_ptr<VNode> vroot = BenchVirtualFromExpr(root);
+
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z"), Str8Lit("a"), Str8Lit("b"), Str8Lit("c"), Str8Lit("xy")};
+    F64 values[] = {1.5, -2.0, 0.25, 3.0, 4.0, -1.0, 0.5};
+    ExprEnv env = {names, values, (U32)ArrayCount(names)};
+
+    printf("walk       node bytes: switch %llu, virtual num/var/prefix/binary/nary %llu/%llu/%llu/%llu/%llu + heap\n",
+           (unsigned long long)sizeof(Expr), (unsigned long long)sizeof(VNum), (unsigned long long)sizeof(VVar),
+           (unsigned long long)sizeof(VPrefix), (unsigned long long)sizeof(VBinary), (unsigned long long)sizeof(VNary));
+
+    U64 nodes = 0;
+    double seconds;
+    BENCH_TIME(seconds, 0.3, { nodes = ExprNodeCount(scratch, root); });
+    BenchReport("walk", "count (switch)", nodes, seconds, 0);
+    BENCH_TIME(seconds, 0.3, { VCountVisitor v; vroot->accept(v); nodes = v.nodes; });
+    BenchReport("walk", "count (virtual)", nodes, seconds, 0);
+
+    F64 a = 0.0, b = 0.0;
+    BENCH_TIME(seconds, 0.3, { ExprEval(scratch, root, &env, &a); });
+    BenchReport("walk", "eval (switch)", nodes, seconds, 0);
+    BENCH_TIME(seconds, 0.3, { VEvalVisitor v; v.env = &env; vroot->accept(v); b = v.value; });
+    BenchReport("walk", "eval (virtual)", nodes, seconds, 0);
+    if (a != b) { printf("walk eval: MISMATCH %f vs %f\n", a, b); }
+
+    // Same tree as parallel arrays in preorder
+    U64 pos = arena->ArenaGetPos();
+    ExprFlat flat = {};
+    BENCH_TIME(seconds, 0.3, { arena->ArenaSetPosBack(pos); ExprFlatFromExpr(arena, scratch, root, &flat); });
+    BenchReport("walk", "flatten", nodes, seconds, 0);
+    printf("walk       flat bytes/node: %.1f (pointer tree %.1f)\n", (double)flat.size / nodes, (double)(pos - source.size) / nodes);
+
+    F64 flat_values[ArrayCount(names)] = {};
+    for (U32 v = 0; v < flat.var_count; v += 1)
+    {
+        for (U32 i = 0; i < env.count; i += 1)
+        {
+            if (Str8Match(ExprFlatVarName(&flat, v), names[i])) { flat_values[v] = values[i]; }
+        }
+    }
+    BENCH_TIME(seconds, 0.3, { ExprFlatEval(scratch, &flat, 0, flat_values, &b); });
+    BenchReport("walk", "eval (flat)", nodes, seconds, 0);
+    if (a != b) { printf("walk flat eval: MISMATCH %f vs %f\n", a, b); }
+
+    U64 hash = 0;
+    BENCH_TIME(seconds, 0.3, { hash = ExprFlatHash(scratch, &flat, 0); });
+    BenchReport("walk", "hash (flat)", nodes, seconds, 0);
+
+    U64 print_pos = arena->ArenaGetPos();
+    String8 text = {};
+    BENCH_TIME(seconds, 0.3, { arena->ArenaSetPosBack(print_pos); text = ExprFlatPrint(arena, scratch, &flat, 0); });
+    BenchReport("walk", "print (flat)", nodes, seconds, text.size);
+
+    BENCH_TIME(seconds, 0.3, { arena->ArenaSetPosBack(print_pos); text = ExprPrint(arena, scratch, root); });
+    BenchReport("walk", "print (arena)", nodes, seconds, text.size);
+    U64 infix_size = text.size;
+    BENCH_TIME(seconds, 0.3, { arena->ArenaSetPosBack(print_pos); text = ExprPrint(arena, scratch, root, ExprPrintMode::LATEX); });
+    BenchReport("walk", "print (latex)", nodes, seconds, text.size);
+#if defined(_MSC_VER)
+    FILE *null_file = fopen("NUL", "wb");
+    int null_fd = null_file ? _fileno(null_file) : -1;
+#else
+    FILE *null_file = fopen("/dev/null", "wb");
+    int null_fd = null_file ? fileno(null_file) : -1;
+#endif
+    if (null_file)
+    {
+        BENCH_TIME(seconds, 0.3, { ExprPrintFd(null_fd, scratch, &root, 1); });
+        BenchReport("walk", "print (fd)", nodes, seconds, infix_size);
+        fclose(null_file);
+    }
+    U64 old_size = 0;
+    BENCH_TIME(seconds, 0.3, { old_size = BenchOldString(root).size(); });
+    BenchReport("walk", "print (ostringstream)", nodes, seconds, old_size);
+
+    ExprFlat copy;
+    BENCH_TIME(seconds, 0.3, { arena->ArenaSetPosBack(print_pos); ExprFlatCopy(arena, &flat, &copy); });
+    BenchReport("walk", "copy (flat)", nodes, seconds, flat.size);
+    if (ExprFlatHash(scratch, &copy, 0) != hash) { printf("walk flat copy: MISMATCH\n"); }
+
+    // Batch dedup over the top level terms, probing on the cached hashes
+    U32 *ids = scratch->PushArrayNoZero<U32>(root->count);
+    U64 unique = 0;
+    BENCH_TIME(seconds, 0.3, { unique = ExprDedup(scratch, root->operands, root->count, ids); });
+    BenchReport("walk", "dedup terms", root->count, seconds, 0);
+    printf("walk       distinct terms: %llu\n", (unsigned long long)unique);
+
+    // Hash consing, the generator only has a handful of distinct terms
+    Arena *intern_arena = new Arena(MB(256));
+    Expr *other = Parse(arena, scratch, source).root;
+    B32 same = 0;
+    BENCH_TIME(seconds, 0.3, { same = ExprMatch(scratch, root, other); });
+    BenchReport("walk", "equal (ExprMatch)", nodes, seconds, 0);
+
+    ExprInterner interner = {};
+    Expr *interned = nullptr;
+    BENCH_TIME(seconds, 0.3, {
+        intern_arena->ArenaClear();
+        ExprInternerInit(&interner, intern_arena, 0);
+        interned = ExprIntern(&interner, scratch, root);
+    });
+    BenchReport("walk", "intern", nodes, seconds, 0);
+    printf("walk       interned nodes: %llu of %llu, %.1f MB vs %.1f MB\n", (unsigned long long)interner.count, (unsigned long long)nodes,
+           (double)intern_arena->ArenaGetPos() / 1e6, (double)(pos - source.size) / 1e6);
+    Expr *interned_other = ExprIntern(&interner, scratch, other);
+    BENCH_TIME(seconds, 0.1, { same &= interned == interned_other; });
+    BenchReport("walk", "equal (interned)", nodes, seconds, 0);
+    if (!same) { printf("walk intern: MISMATCH\n"); }
+    delete intern_arena;
+
+    vroot.reset();
+    delete scratch;
+    delete arena;
+}
+
+// Values for a slot table, looked up by name in env
+internal void 
+BenchBindSlots(ExprEnv const *env, String8 *slots, U32 count, F64 *out)
+{
+    for (U32 slot = 0; slot < count; slot += 1)
+    {
+        out[slot] = 0.0;
+        for (U32 i = 0; i < env->count; i += 1)
+        {
+            if (Str8Match(env->names[i], slots[slot])) { out[slot] = env->values[i]; }
+        }
+    }
+}
+
+internal void 
+BenchEval(void)
+{
+    Arena *arena = new Arena(MB(512));
+    Arena *scratch = new Arena(MB(256));
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z"), Str8Lit("a"), Str8Lit("b"), Str8Lit("c"), Str8Lit("xy")};
+    F64 values[] = {1.5, -2.0, 0.25, 3.0, 4.0, -1.0, 0.5};
+    ExprEnv env = {names, values, (U32)ArrayCount(names)};
+
+    // Roughly 10 to 1M nodes
+    U64 terms[] = {2, 25, 250, 2500, 25000, 250000};
+    for (U64 term_count : terms)
+    {
+        U64 pos = arena->ArenaGetPos();
+        Expr *root = Parse(arena, scratch, BenchPolynomial(arena, term_count)).root;
+        U64 nodes = ExprNodeCount(scratch, root);
+        char name[64];
+        double seconds;
+
+        F64 walk = 0.0;
+        snprintf(name, sizeof(name), "tree walk %llu", (unsigned long long)nodes);
+        BENCH_TIME(seconds, 0.1, { ExprEval(scratch, root, &env, &walk); });
+        BenchReportPerItem("eval", name, nodes, seconds);
+
+        ExprFlat flat;
+        ExprFlatFromExpr(arena, scratch, root, &flat);
+        String8 *flat_names = arena->PushArray<String8>(flat.var_count + 1);
+        for (U32 v = 0; v < flat.var_count; v += 1) { flat_names[v] = ExprFlatVarName(&flat, v); }
+        F64 *flat_values = arena->PushArray<F64>(flat.var_count + 1);
+        BenchBindSlots(&env, flat_names, flat.var_count, flat_values);
+        F64 flat_result = 0.0;
+        snprintf(name, sizeof(name), "flat %llu", (unsigned long long)nodes);
+        BENCH_TIME(seconds, 0.1, { ExprFlatEval(scratch, &flat, 0, flat_values, &flat_result); });
+        BenchReportPerItem("eval", name, nodes, seconds);
+
+        Bytecode code;
+        snprintf(name, sizeof(name), "compile %llu", (unsigned long long)nodes);
+        U64 code_pos = arena->ArenaGetPos();
+        BENCH_TIME(seconds, 0.1, { arena->ArenaSetPosBack(code_pos); BytecodeCompile(arena, scratch, root, &code); });
+        BenchReportPerItem("eval", name, nodes, seconds);
+
+        F64 *slots = arena->PushArray<F64>(code.var_count + 1);
+        BenchBindSlots(&env, code.vars, code.var_count, slots);
+        F64 *stack = arena->PushArray<F64>(code.stack_size);
+        F64 result = 0.0;
+        snprintf(name, sizeof(name), "bytecode %llu", (unsigned long long)nodes);
+        BENCH_TIME(seconds, 0.1, { result = BytecodeEval(&code, slots, stack); });
+        BenchReportPerItem("eval", name, nodes, seconds);
+
+        JitCode jit;
+        snprintf(name, sizeof(name), "jit compile %llu", (unsigned long long)nodes);
+        BENCH_TIME(seconds, 0.1, { JitCompile(scratch, &code, &jit); JitRelease(&jit); });
+        BenchReportPerItem("eval", name, nodes, seconds);
+
+        JitCompile(scratch, &code, &jit);
+        F64 jit_result = 0.0;
+        snprintf(name, sizeof(name), "jit %llu (%u spilled)", (unsigned long long)nodes, jit.spill_count);
+        BENCH_TIME(seconds, 0.1, { jit_result = JitEval(&jit, &code, slots, stack); });
+        BenchReportPerItem("eval", name, nodes, seconds);
+        JitRelease(&jit);
+
+        if (result != walk || flat_result != walk || jit_result != walk)
+        {
+            printf("eval %llu: MISMATCH %f %f %f %f\n", (unsigned long long)nodes, walk, flat_result, result, jit_result);
+        }
+        arena->ArenaSetPosBack(pos);
+    }
+
+    delete scratch;
+    delete arena;
+}
+
+internal void 
+BenchBatch(void)
+{
+    Arena *arena = new Arena(MB(256));
+    Arena *scratch = new Arena(MB(64));
+
+    // Rows of a small and a mid sized expression, scalar interpreter per row against each batch kernel
+    U64 rows = Million(1);
+    U64 terms[] = {2, 25};
+    for (U64 term_count : terms)
+    {
+        U64 pos = arena->ArenaGetPos();
+        Expr *root = Parse(arena, scratch, BenchPolynomial(arena, term_count)).root;
+        U64 nodes = ExprNodeCount(scratch, root);
+        Bytecode code;
+        BytecodeCompile(arena, scratch, root, &code);
+
+        F64 **columns = arena->PushArray<F64 *>(code.var_count + 1);
+        for (U32 slot = 0; slot < code.var_count; slot += 1)
+        {
+            columns[slot] = arena->PushArrayNoZero<F64>(rows, 64);
+            for (U64 row = 0; row < rows; row += 1) { columns[slot][row] = 0.5 + (F64)((row * 7 + slot) % 13); }
+        }
+        F64 *out = arena->PushArrayNoZero<F64>(rows, 64);
+        F64 *expected = arena->PushArrayNoZero<F64>(rows, 64);
+        char name[64];
+        double seconds;
+
+        F64 *vars = arena->PushArray<F64>(code.var_count + 1);
+        F64 *stack = arena->PushArray<F64>(code.stack_size);
+        snprintf(name, sizeof(name), "bytecode rows %llu", (unsigned long long)nodes);
+        BENCH_TIME(seconds, 0.1, {
+            for (U64 row = 0; row < rows; row += 1)
+            {
+                for (U32 slot = 0; slot < code.var_count; slot += 1) { vars[slot] = columns[slot][row]; }
+                expected[row] = BytecodeEval(&code, vars, stack);
+            }
+        });
+        BenchReportRate("batch", name, rows, seconds, "rows");
+
+        void *workspace = arena->PushArrayNoZero<U8>(BytecodeBatchWorkspaceSize(&code), 64);
+        for (U8 isa = (U8)EvalIsa::SCALAR; isa < (U8)EvalIsa::COUNT; isa += 1)
+        {
+            if ((EvalIsa)isa > EvalBestIsa()) { continue; }
+            snprintf(name, sizeof(name), "%s %llu", EvalIsaString((EvalIsa)isa), (unsigned long long)nodes);
+            BENCH_TIME(seconds, 0.1, { BytecodeEvalBatch(&code, columns, rows, out, workspace, (EvalIsa)isa); });
+            BenchReportRate("batch", name, rows, seconds, "rows");
+            if (memcmp(out, expected, sizeof(F64) * rows) != 0) { printf("batch %s: MISMATCH\n", name); }
+        }
+        arena->ArenaSetPosBack(pos);
+    }
+
+    delete scratch;
+    delete arena;
+}
+
+internal void 
+BenchColumns(void)
+{
+    Arena *arena = new Arena(MB(16));
+    Arena *scratch = new Arena(MB(16));
+    JobSystem *jobs = JobSystemCreate(0, MB(1));
+    char const *input_path = "bench_columns_in.bin";
+    char const *output_path = "bench_columns_out.bin";
+
+    // 8M rows of x, y and z, 192MB of input
+    U64 rows = Million(8);
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z")};
+    ColumnFile file;
+    if (!ColumnFileCreate(arena, input_path, names, 3, rows, &file)) { printf("columns: can't create %s\n", input_path); return; }
+    for (U32 c = 0; c < 3; c += 1)
+    {
+        for (U64 row = 0; row < rows; row += 1) { file.columns[c][row] = 0.5 + (F64)((row * 7 + c) % 13); }
+    }
+    ColumnFileClose(&file);
+
+    Bytecode code;
+    BytecodeCompile(arena, scratch, Parse(arena, scratch, Str8Lit("(x + y)*(y - z)/(z + x) - 3x(x+1)")).root, &code);
+    U64 bytes = rows * sizeof(F64) * 4;
+    char name[64];
+    double seconds;
+    snprintf(name, sizeof(name), "file (%u workers)", jobs->worker_count);
+    BENCH_TIME(seconds, 0.2, { EvalColumnFile(jobs, arena, &code, input_path, output_path, Str8Lit("r")); });
+    BenchReport("columns", name, rows, seconds, bytes);
+    BenchReportRate("columns", name, rows, seconds, "rows");
+
+    // Same again without the open, create and unmap per call
+    ColumnFile input, output;
+    ColumnFileOpen(arena, input_path, &input);
+    ColumnFileCreate(arena, output_path, names, 1, rows, &output);
+    F64 const *columns[] = {input.columns[0], input.columns[1], input.columns[2]};
+    snprintf(name, sizeof(name), "mapped (%u workers)", jobs->worker_count);
+    BENCH_TIME(seconds, 0.2, { EvalColumnsParallel(jobs, &code, columns, rows, output.columns[0]); });
+    BenchReportRate("columns", name, rows, seconds, "rows");
+    ColumnFileClose(&output);
+    ColumnFileClose(&input);
+
+    remove(input_path);
+    remove(output_path);
+    JobSystemDestroy(jobs);
+    delete scratch;
+    delete arena;
+}
+
+internal void 
+BenchHorner(void)
+{
+    Arena *arena = new Arena(MB(256));
+    Arena *scratch = new Arena(MB(256));
+    String8 names[] = {Str8Lit("x"), Str8Lit("y")};
+    F64 values[] = {0.75, -0.5};
+    ExprEnv env = {names, values, 2};
+
+    U32 degrees[] = {4, 16, 64};
+    for (U32 degree : degrees)
+    {
+        U64 pos = arena->ArenaGetPos();
+        Expr *root = Parse(arena, scratch, BenchDensePolynomial(arena, degree)).root;
+        char name[64];
+        double seconds;
+
+        HornerReport report = {};
+        Expr *horner = nullptr;
+        U64 horner_pos = arena->ArenaGetPos();
+        snprintf(name, sizeof(name), "rewrite degree %u", degree);
+        BENCH_TIME(seconds, 0.1, { arena->ArenaSetPosBack(horner_pos); horner = ExprHorner(arena, scratch, root, &report); });
+        BenchReport("horner", name, ExprNodeCount(scratch, root), seconds, 0);
+        printf("%-10s degree %-3u flops %llu -> %llu (muls %llu -> %llu, adds %llu -> %llu)\n", "horner", degree,
+               (unsigned long long)ExprFlopsTotal(report.before), (unsigned long long)ExprFlopsTotal(report.after),
+               (unsigned long long)report.before.muls, (unsigned long long)report.after.muls,
+               (unsigned long long)report.before.adds, (unsigned long long)report.after.adds);
+
+        Expr *forms[] = {root, horner};
+        char const *form_names[] = {"expanded", "horner"};
+        F64 results[2] = {};
+        for (U32 f = 0; f < 2; f += 1)
+        {
+            Bytecode code;
+            BytecodeCompile(arena, scratch, forms[f], &code);
+            F64 *slots = arena->PushArray<F64>(code.var_count + 1);
+            BenchBindSlots(&env, code.vars, code.var_count, slots);
+            F64 *stack = arena->PushArray<F64>(code.stack_size);
+            snprintf(name, sizeof(name), "bytecode %s %u", form_names[f], degree);
+            BENCH_TIME(seconds, 0.1, { results[f] = BytecodeEval(&code, slots, stack); });
+            BenchReportPerItem("horner", name, code.count, seconds);
+        }
+        printf("%-10s degree %-3u value %.17g vs %.17g\n", "horner", degree, results[0], results[1]);
+        arena->ArenaSetPosBack(pos);
+    }
+
+    delete scratch;
+    delete arena;
+}
+
+// Simplifying consumes the tree, so each round parses again and the parse alone is timed beside it
+internal void 
+BenchSimplify(void)
+{
+    Arena *arena = new Arena(GB(1));
+    Arena *scratch = new Arena(MB(256));
+    Arena *inputs = new Arena(MB(64));
+    struct { char const *name; String8 source; } cases[] = {
+        {"polynomial", BenchPolynomial(inputs, Million(1))},
+        {"deep_unary", BenchDeepUnary(inputs, Million(1))},
+    };
+    for (auto const &c : cases)
+    {
+        U64 pos = arena->ArenaGetPos();
+        U64 nodes = ExprNodeCount(scratch, Parse(arena, scratch, c.source).root);
+        arena->ArenaSetPosBack(pos);
+        char name[64];
+        double seconds;
+        B32 ok = 1;
+        snprintf(name, sizeof(name), "parse %s", c.name);
+        BENCH_TIME(seconds, 0.3, { ok &= Parse(arena, scratch, c.source).root != nullptr; arena->ArenaSetPosBack(pos); });
+        BenchReportPerItem("simplify", name, nodes, seconds);
+        snprintf(name, sizeof(name), "parse+simplify %s", c.name);
+        BENCH_TIME(seconds, 0.3, { ok &= ExprSimplify(arena, scratch, Parse(arena, scratch, c.source).root) != nullptr; arena->ArenaSetPosBack(pos); });
+        BenchReportPerItem("simplify", name, nodes, seconds);
+        if (!ok) { printf("simplify   %s failed\n", c.name); }
+    }
+
+    // A generated system: every row repeats one factor that needs cleaning up.
+    // The cache is trimmed between rounds, the way a server would between requests.
+    U64 rows = 20000;
+    String8 factor = Str8Lit("(a*1 + 0)*(b - 0)*(c/1 + 2*3)*(d*(e + 0)*1 - (0 - f))*(g + h*1 + (i - 0)/1)");
+    U64 cap = rows * (factor.size + 32);
+    char *text = inputs->PushArrayNoZero<char>(cap);
+    U64 size = 0;
+    for (U64 i = 0; i < rows; i += 1)
+    {
+        size += (U64)snprintf(text + size, cap - size, "%s%.*s*(x*%llu + 0)", i ? " + " : "", (int)factor.size, (char const *)factor.str,
+                              (unsigned long long)i + 1);
+    }
+    String8 system = Str8((U8 *)text, size);
+    Arena *cache_arenas[2] = {new Arena(MB(64)), new Arena(MB(64))};
+    SimplifyCache cache;
+    B32 ok = SimplifyCacheInit(&cache, cache_arenas[0], cache_arenas[1], KB(16));
+    U64 pos = arena->ArenaGetPos();
+    U64 nodes = ExprNodeCount(scratch, Parse(arena, scratch, system).root);
+    arena->ArenaSetPosBack(pos);
+    double seconds;
+    BENCH_TIME(seconds, 0.3, { ok &= Parse(arena, scratch, system).root != nullptr; arena->ArenaSetPosBack(pos); });
+    BenchReportPerItem("simplify", "parse shared rows", nodes, seconds);
+    BENCH_TIME(seconds, 0.3, { ok &= ExprSimplify(arena, scratch, Parse(arena, scratch, system).root) != nullptr; arena->ArenaSetPosBack(pos); });
+    BenchReportPerItem("simplify", "parse+simplify shared rows", nodes, seconds);
+    BENCH_TIME(seconds, 0.3, {
+        ok &= ExprSimplifyCached(&cache, scratch, Parse(arena, scratch, system).root) != nullptr;
+        ok &= SimplifyCacheTrim(&cache, scratch);
+        arena->ArenaSetPosBack(pos);
+    });
+    BenchReportPerItem("simplify", "parse+cached shared rows", nodes, seconds);
+    SimplifyCacheStats stats = cache.stats;
+    printf("%-10s cache hit rate %.1f%%, %.1f nodes not resimplified per hit, %llu entries, %llu evictions, %llu trims\n", "simplify",
+           100.0 * (double)stats.hits / (double)Max<U64>(stats.lookups, 1), (double)stats.nodes_saved / (double)Max<U64>(stats.hits, 1),
+           (unsigned long long)cache.entry_count, (unsigned long long)stats.evictions, (unsigned long long)stats.trims);
+    if (!ok) { printf("simplify   shared rows failed\n"); }
+    delete cache_arenas[1];
+    delete cache_arenas[0];
+    delete inputs;
+    delete scratch;
+    delete arena;
+}
+
+// terms coefficients times a name, every name twice, so half the terms collect
+internal String8 
+BenchNamedTerms(Arena *arena, U64 terms)
+{
+    U64 cap = terms * 16 + 1;
+    U8 *str = arena->PushArrayNoZero<U8>(cap);
+    U64 size = 0;
+    for (U64 i = 0; i < terms; i += 1)
+    {
+        char name[8] = {};
+        U64 n = i / 2;
+        for (U32 k = 0; k < 5; k += 1, n /= 26) { name[k] = (char)('a' + n % 26); }
+        size += (U64)snprintf((char *)str + size, cap - size, "%s%u*%s", i ? (i % 3 ? " + " : " - ") : "", (U32)(i % 7) + 1, name);
+    }
+    return Str8(str, size);
+}
+
+internal void 
+BenchCanon(void)
+{
+    Arena *arena = new Arena(GB(1));
+    Arena *scratch = new Arena(MB(512));
+    Arena *inputs = new Arena(MB(64));
+    struct { char const *name; String8 source; } cases[] = {
+        {"polynomial", BenchPolynomial(inputs, Million(1), 1)},
+        {"named", BenchNamedTerms(inputs, Million(1))},
+    };
+    for (auto const &c : cases)
+    {
+        U64 pos = arena->ArenaGetPos();
+        CanonReport report = {};
+        char name[64];
+        double seconds;
+        B32 ok = 1;
+        snprintf(name, sizeof(name), "parse %s", c.name);
+        BENCH_TIME(seconds, 0.3, { ok &= Parse(arena, scratch, c.source).root != nullptr; arena->ArenaSetPosBack(pos); });
+        BenchReportPerItem("canon", name, Million(1), seconds);
+        snprintf(name, sizeof(name), "parse+canon %s", c.name);
+        BENCH_TIME(seconds, 0.3, { ok &= ExprCanonicalize(arena, scratch, Parse(arena, scratch, c.source).root, &report) != nullptr; arena->ArenaSetPosBack(pos); });
+        BenchReportPerItem("canon", name, Million(1), seconds);
+        printf("%-10s %-10s terms %llu -> %llu\n", "canon", c.name, (unsigned long long)report.terms_in, (unsigned long long)report.terms_out);
+        if (!ok) { printf("canon      %s failed\n", c.name); }
+    }
+    delete inputs;
+    delete scratch;
+    delete arena;
+}
+
+// count copies of factor multiplied together, there is no power operator
+internal String8 
+BenchPower(Arena *arena, char const *factor, U32 count)
+{
+    U64 cap = (strlen(factor) + 1) * count + 1;
+    U8 *str = arena->PushArrayNoZero<U8>(cap);
+    U64 size = 0;
+    for (U32 i = 0; i < count; i += 1) { size += (U64)snprintf((char *)str + size, cap - size, "%s%s", i ? "*" : "", factor); }
+    return Str8(str, size);
+}
+
+internal void 
+BenchExpand(void)
+{
+    Arena *arena = new Arena(MB(256));
+    Arena *scratch = new Arena(MB(256));
+    Arena *inputs = new Arena(MB(1));
+    struct { char const *name; String8 source; } cases[] = {
+        {"(x+y+1)^20", BenchPower(inputs, "(x + y + 1)", 20)},
+        {"(x+y+z+1)^16", BenchPower(inputs, "(x + y + z + 1)", 16)},
+        {"(a+b+c+d+e+1)^8", BenchPower(inputs, "(a + b + c + d + e + 1)", 8)},
+    };
+    for (auto const &c : cases)
+    {
+        U64 pos = arena->ArenaGetPos();
+        ExpandReport report = {};
+        char name[64];
+        double seconds;
+        B32 ok = 1;
+        snprintf(name, sizeof(name), "expand %s", c.name);
+        BENCH_TIME(seconds, 0.3, { ok &= ExprExpand(arena, scratch, Parse(arena, scratch, c.source).root, &report) != nullptr; arena->ArenaSetPosBack(pos); });
+        BenchReportPerItem("expand", name, report.terms, seconds);
+        if (!ok) { printf("expand     %s failed\n", c.name); }
+    }
+
+    // Dense univariate square, Karatsuba against the heap merge, which is too slow
+    // to time at the largest size
+    PolyRing ring = {};
+    PolyRingFromExpr(inputs, scratch, Parse(inputs, scratch, Str8Lit("x")).root, &ring);
+    for (U64 n : {64, 1024, 8192})
+    {
+        Poly a = {};
+        a.terms = arena->PushArrayNoZero<PolyTerm>(n);
+        for (U64 i = 0; i < n; i += 1) { a.terms[i] = {n - 1 - i, IntFromS64((S64)(i % 7) + 1)}; }
+        a.count = n;
+        U64 pos = arena->ArenaGetPos();
+        Poly product = {};
+        char name[64];
+        double seconds;
+        B32 ok = 1;
+        snprintf(name, sizeof(name), "karatsuba n=%llu", (unsigned long long)n);
+        BENCH_TIME(seconds, 0.3, { ok &= PolyMulKaratsuba(arena, scratch, &ring, &a, &a, &product); arena->ArenaSetPosBack(pos); });
+        BenchReportPerItem("expand", name, 2 * n - 1, seconds);
+        if (n <= 1024)
+        {
+            snprintf(name, sizeof(name), "heap n=%llu", (unsigned long long)n);
+            BENCH_TIME(seconds, 0.3, { ok &= PolyMulHeap(arena, scratch, &ring, &a, &a, &product); arena->ArenaSetPosBack(pos); });
+            BenchReportPerItem("expand", name, 2 * n - 1, seconds);
+        }
+        if (!ok) { printf("expand     n=%llu failed\n", (unsigned long long)n); }
+        arena->ArenaClear();
+    }
+    delete inputs;
+    delete scratch;
+    delete arena;
+}
+
+internal void 
+BenchNumber(void)
+{
+    Arena *arena = new Arena(MB(256));
+    Arena *scratch = new Arena(MB(64));
+
+    // Small path against plain S64: a dot product that never leaves the word
+    U64 n = Million(1);
+    S64 *xs = arena->PushArrayNoZero<S64>(n);
+    for (U64 i = 0; i < n; i += 1) { xs[i] = (S64)(HashU64(i) % 2001) - 1000; }
+    U64 pos = arena->ArenaGetPos();
+    double seconds;
+    S64 plain = 0;
+    BENCH_TIME(seconds, 0.3, { plain = 0; for (U64 i = 0; i + 1 < n; i += 1) { plain += xs[i] * xs[i + 1]; } });
+    BenchReportPerItem("number", "dot S64", n, seconds);
+    Integer exact = {};
+    B32 ok = 1;
+    BENCH_TIME(seconds, 0.3, {
+        exact = IntFromS64(0);
+        for (U64 i = 0; i + 1 < n; i += 1)
+        {
+            Integer term;
+            ok &= IntMul(arena, IntFromS64(xs[i]), IntFromS64(xs[i + 1]), &term) && IntAdd(arena, exact, term, &exact);
+        }
+    });
+    BenchReportPerItem("number", "dot Integer", n, seconds);
+    if (!ok || !IntIsSmall(exact) || exact.small != plain) { printf("number     dot mismatch\n"); }
+
+    // Big products and gcds
+    for (U64 limbs : {16, 256, 2048})
+    {
+        U64 *a = arena->PushArrayNoZero<U64>(limbs);
+        U64 *b = arena->PushArrayNoZero<U64>(limbs);
+        U64 *product = arena->PushArrayNoZero<U64>(2 * limbs);
+        for (U64 i = 0; i < limbs; i += 1) { a[i] = HashU64(i); b[i] = HashU64(i + limbs); }
+        char name[64];
+        snprintf(name, sizeof(name), "mul karatsuba %llu limbs", (unsigned long long)limbs);
+        BENCH_TIME(seconds, 0.3, { ok &= BigMagMul(scratch, product, a, limbs, b, limbs); });
+        BenchReportPerItem("number", name, limbs, seconds);
+        snprintf(name, sizeof(name), "mul schoolbook %llu limbs", (unsigned long long)limbs);
+        BENCH_TIME(seconds, 0.3, { BigMagMulSchoolbook(product, a, limbs, b, limbs); });
+        BenchReportPerItem("number", name, limbs, seconds);
+
+        if (limbs > 256) { continue; }
+        Integer x, y, g;
+        IntFromMag(arena, arena->ArenaGetPos(), a, limbs, 0, &x);
+        IntFromMag(arena, arena->ArenaGetPos(), b, limbs, 0, &y);
+        U64 gcd_pos = arena->ArenaGetPos();
+        snprintf(name, sizeof(name), "gcd lehmer %llu limbs", (unsigned long long)limbs);
+        BENCH_TIME(seconds, 0.3, { ok &= IntGcd(arena, scratch, x, y, &g); arena->ArenaSetPosBack(gcd_pos); });
+        BenchReportPerItem("number", name, limbs, seconds);
+        snprintf(name, sizeof(name), "gcd euclid %llu limbs", (unsigned long long)limbs);
+        BENCH_TIME(seconds, 0.3, {
+            Integer u = x;
+            Integer v = y;
+            while (ok && IntSign(v) != 0)
+            {
+                Integer r;
+                ok &= IntDivMod(arena, scratch, u, v, nullptr, &r);
+                u = v;
+                v = r;
+            }
+            arena->ArenaSetPosBack(gcd_pos);
+        });
+        BenchReportPerItem("number", name, limbs, seconds);
+    }
+    if (!ok) { printf("number     failed\n"); }
+    arena->ArenaSetPosBack(pos);
+    delete scratch;
+    delete arena;
+}
+
+// Derivatives of prod (x/i + 1): the DAG stays linear in n where writing each
+// product rule term out in full would be quadratic
+internal void 
+BenchDiff(void)
+{
+    Arena *arena = new Arena(MB(256));
+    Arena *scratch = new Arena(MB(256));
+    for (U32 n : {16, 256, 4096})
+    {
+        U64 cap = (U64)n * 24;
+        U8 *text = arena->PushArrayNoZero<U8>(cap);
+        U64 size = 0;
+        for (U32 i = 1; i <= n; i += 1) { size += (U64)snprintf((char *)text + size, cap - size, "%s(x/%u + 1)", i > 1 ? "*" : "", i); }
+        Expr *parsed = Parse(arena, scratch, Str8(text, size)).root;
+        U64 pos = arena->ArenaGetPos();
+
+        ExprInterner interner;
+        Expr *root = nullptr, *d1 = nullptr, *d2 = nullptr;
+        char name[64];
+        double seconds;
+        snprintf(name, sizeof(name), "d/dx n=%u", n);
+        BENCH_TIME(seconds, 0.3, {
+            arena->ArenaSetPosBack(pos);
+            ExprInternerInit(&interner, arena, 0);
+            root = ExprIntern(&interner, scratch, parsed);
+            d1 = root ? ExprDifferentiate(&interner, scratch, root, Str8Lit("x")) : nullptr;
+        });
+        BenchReportPerItem("diff", name, n, seconds);
+        snprintf(name, sizeof(name), "d2/dx2 n=%u", n);
+        BENCH_TIME(seconds, 0.3, { d2 = d1 ? ExprDifferentiate(&interner, scratch, d1, Str8Lit("x")) : nullptr; });
+        BenchReportPerItem("diff", name, n, seconds);
+
+        ExprFlops f = {}, f1 = {}, f2 = {};
+        if (!d2 || !ExprFlopCount(scratch, root, &f) || !ExprFlopCount(scratch, d1, &f1) || !ExprFlopCount(scratch, d2, &f2))
+        {
+            printf("diff       n=%u failed\n", n);
+        }
+        else
+        {
+            printf("%-10s n=%-5u flops f %llu, f' %llu, f'' %llu (full product rule terms: %llu muls in f')\n", "diff", n,
+                   (unsigned long long)ExprFlopsTotal(f), (unsigned long long)ExprFlopsTotal(f1), (unsigned long long)ExprFlopsTotal(f2),
+                   (unsigned long long)n * (n - 1));
+        }
+        arena->ArenaClear();
+    }
+    delete scratch;
+    delete arena;
+}
+
+// Gradient of sum (v_i - v_(i+1))^2 / (v_i*v_i + 1) over n variables: the tape
+// against one evaluation and against compiling every symbolic partial
+internal void 
+BenchGradient(void)
+{
+    Arena *arena = new Arena(MB(512));
+    Arena *scratch = new Arena(MB(256));
+    for (U32 n : {8, 64, 512})
+    {
+        U64 cap = (U64)n * 64;
+        U8 *text = arena->PushArrayNoZero<U8>(cap);
+        U64 size = 0;
+        for (U32 i = 0; i < n; i += 1)
+        {
+            // Names are letters only: v then the index in base 26
+            char a[8], b[8];
+            for (U32 k = 0, u = i, w = (i + 1) % n; k < 3; k += 1, u /= 26, w /= 26)
+            {
+                a[k + 1] = (char)('a' + u % 26);
+                b[k + 1] = (char)('a' + w % 26);
+            }
+            a[0] = b[0] = 'v';
+            a[4] = b[4] = 0;
+            size += (U64)snprintf((char *)text + size, cap - size, "%s(%s - %s)*(%s - %s)/(%s*%s + 1)", i ? " + " : "", a, b, a, b, a, a);
+        }
+        Expr *root = Parse(arena, scratch, Str8(text, size)).root;
+        Bytecode code = {};
+        GradTape tape = {};
+        if (!root || !BytecodeCompile(arena, scratch, root, &code) || !GradTapeFromBytecode(arena, scratch, &code, &tape))
+        {
+            printf("gradient   n=%u failed\n", n);
+            continue;
+        }
+        F64 *vars = arena->PushArray<F64>(code.var_count);
+        for (U32 slot = 0; slot < code.var_count; slot += 1) { vars[slot] = 0.5 + 0.01 * slot; }
+        F64 *stack = arena->PushArray<F64>(code.stack_size);
+        F64 *workspace = arena->PushArray<F64>(GradWorkspaceCount(&tape));
+        F64 *grad = arena->PushArray<F64>(code.var_count);
+        volatile F64 sink = 0.0;
+        double eval_seconds, tape_seconds, symbolic_seconds = 0.0;
+        char name[64];
+        snprintf(name, sizeof(name), "eval n=%u", n);
+        BENCH_TIME(eval_seconds, 0.2, { sink = BytecodeEval(&code, vars, stack); });
+        BenchReportPerItem("gradient", name, 1, eval_seconds);
+        snprintf(name, sizeof(name), "tape n=%u", n);
+        BENCH_TIME(tape_seconds, 0.2, { sink = GradEval(&tape, vars, grad, workspace); });
+        BenchReportPerItem("gradient", name, 1, tape_seconds);
+
+        // Every partial compiled into one program, subexpressions shared between them
+        ExprInterner interner;
+        Expr **partials = arena->PushArray<Expr *>(code.var_count);
+        Bytecode symbolic = {};
+        B32 ok = ExprInternerInit(&interner, arena, 0);
+        Expr *interned = ok ? ExprIntern(&interner, scratch, root) : nullptr;
+        ok = interned && ExprGradient(&interner, scratch, interned, code.vars, code.var_count, partials) &&
+             BytecodeCompileBatch(arena, scratch, partials, code.var_count, &symbolic);
+        if (ok)
+        {
+            F64 *symbolic_vars = arena->PushArray<F64>(symbolic.var_count);
+            for (U32 slot = 0; slot < symbolic.var_count; slot += 1) { symbolic_vars[slot] = vars[BytecodeVarSlot(&code, symbolic.vars[slot])]; }
+            F64 *symbolic_stack = arena->PushArray<F64>(symbolic.stack_size);
+            snprintf(name, sizeof(name), "symbolic n=%u", n);
+            BENCH_TIME(symbolic_seconds, 0.2, { sink = BytecodeEval(&symbolic, symbolic_vars, symbolic_stack); });
+            BenchReportPerItem("gradient", name, 1, symbolic_seconds);
+        }
+        printf("%-10s n=%-4u tape %u nodes, gradient %.2fx one evaluation, symbolic partials %.2fx\n", "gradient", n, tape.count,
+               tape_seconds / eval_seconds, symbolic_seconds / eval_seconds);
+
+        // Columns, per row
+        U64 rows = 4096;
+        F64 **columns = arena->PushArray<F64 *>(code.var_count);
+        F64 **grads = arena->PushArray<F64 *>(code.var_count);
+        for (U32 slot = 0; slot < code.var_count; slot += 1)
+        {
+            columns[slot] = arena->PushArrayNoZero<F64>(rows);
+            grads[slot] = arena->PushArrayNoZero<F64>(rows);
+            for (U64 row = 0; row < rows; row += 1) { columns[slot][row] = vars[slot] + 0.001 * (F64)row; }
+        }
+        F64 *out = arena->PushArrayNoZero<F64>(rows);
+        F64 *batch_workspace = arena->PushArrayNoZero<F64>(GradBatchWorkspaceCount(&tape));
+        double seconds;
+        snprintf(name, sizeof(name), "tape batch n=%u", n);
+        BENCH_TIME(seconds, 0.2, { GradEvalBatch(&tape, columns, rows, out, grads, batch_workspace); });
+        BenchReportPerItem("gradient", name, rows, seconds);
+        (void)sink;
+        arena->ArenaClear();
+    }
+    delete scratch;
+    delete arena;
+}
+
+// Rule lookup through the discrimination tree against trying every rule in
+// order, over the distinct subterms of a large sum, then the whole driver
+internal void 
+BenchRewrite(void)
+{
+    Arena *arena = new Arena(MB(256));
+    Arena *scratch = new Arena(MB(256));
+    ExprInterner interner;
+    RuleSet set;
+    ExprInternerInit(&interner, arena, 0);
+    RuleSetInit(&set, arena);
+
+    // Cleanup rules plus a long tail of constant specific ones, which is what
+    // user rule files tend to grow into
+    U64 cap = KB(64);
+    char *rules = arena->PushArrayNoZero<char>(cap);
+    U64 size = (U64)snprintf(rules, cap, "a*(b + c) -> a*b + a*c\na*1 -> a\na*0 -> 0\na + 0 -> a\na - a -> 0\n--a -> a\n");
+    for (U32 i = 2; i < 200; i += 1) { size += (U64)snprintf(rules + size, cap - size, "a*%u + a -> %u*a\na/%u/%u -> a/%u\n", i, i + 1, i, i, i * i); }
+    String8 rule_text = Str8((U8 *)rules, size);
+    if (!ParseRules(scratch, rule_text, &set)) { printf("rewrite    rules failed\n"); }
+
+    U64 terms = 20000;
+    cap = terms * 48;
+    char *text = arena->PushArrayNoZero<char>(cap);
+    size = 0;
+    for (U64 i = 0; i < terms; i += 1)
+    {
+        char v = (char)('a' + i % 26), w = (char)('a' + i / 26 % 26);
+        U32 k = (U32)(i % 50) + 2;
+        size += (U64)snprintf(text + size, cap - size, "%s(%c*(%c + %llu) + 0)/%u/%u", i ? " + " : "", v, w, (unsigned long long)i, k, k);
+    }
+    Expr *root = ExprIntern(&interner, scratch, Parse(arena, scratch, Str8((U8 *)text, size)).root);
+
+    // Distinct subterms, children before parents
+    Expr **nodes = nullptr;
+    U64 node_count = 0, node_cap = 0, seen_cap = 0, seen_count = 0;
+    Expr **seen = nullptr;
+    Expr **stack = nullptr;
+    U64 stack_count = 0, stack_cap = 0;
+    B32 ok = root != nullptr;
+    if (ok && (stack = ArenaGrowArray(scratch, stack, stack_count, &stack_cap))) { stack[stack_count++] = root; }
+    while (ok && stack_count)
+    {
+        Expr *expr = stack[--stack_count];
+        if (!ExprPtrSetInsert(scratch, &seen, &seen_cap, &seen_count, expr, &ok)) { continue; }
+        if (node_count == node_cap && !(nodes = ArenaGrowArray(scratch, nodes, node_count, &node_cap))) { ok = 0; break; }
+        nodes[node_count++] = expr;
+        for (U32 i = 0; i < ExprChildCount(expr); i += 1)
+        {
+            if (stack_count == stack_cap && !(stack = ArenaGrowArray(scratch, stack, stack_count, &stack_cap))) { ok = 0; break; }
+            stack[stack_count++] = ExprChild(expr, i);
+        }
+    }
+    if (!ok) { printf("rewrite    setup failed\n"); }
+
+    Expr *binds[RULE_MAX_VARS];
+    U64 tree_hits = 0, scan_hits = 0;
+    double seconds;
+    RewriteReport report = {};
+    BENCH_TIME(seconds, 0.3, {
+        tree_hits = 0;
+        report = {};
+        for (U64 i = 0; i < node_count; i += 1) { tree_hits += RuleSetMatch(&set, nodes[i], binds, &report) != nullptr; }
+    });
+    BenchReportPerItem("rewrite", "lookup tree", node_count, seconds);
+    printf("%-10s %llu rules, %.2f candidates bound per lookup\n", "rewrite", (unsigned long long)set.rule_count,
+           (double)report.candidates / (double)Max<U64>(report.lookups, 1));
+    BENCH_TIME(seconds, 0.3, {
+        scan_hits = 0;
+        for (U64 i = 0; i < node_count; i += 1)
+        {
+            for (U64 r = 0; r < set.rule_count; r += 1)
+            {
+                if (RuleBind(&set.rules[r], nodes[i], binds)) { scan_hits += 1; break; }
+            }
+        }
+    });
+    BenchReportPerItem("rewrite", "lookup every rule", node_count, seconds);
+    if (tree_hits != scan_hits) { printf("rewrite    lookups disagree: %llu vs %llu\n", (unsigned long long)tree_hits, (unsigned long long)scan_hits); }
+
+    Expr *rewritten = nullptr;
+    BENCH_TIME(seconds, 0.3, { rewritten = ExprRewrite(&interner, scratch, &set, root, 64, &report); });
+    BenchReportPerItem("rewrite", "fixpoint", terms, seconds);
+    printf("%-10s %llu passes, %llu rewrites, fixpoint %d\n", "rewrite", (unsigned long long)report.passes,
+           (unsigned long long)report.rewrites, report.fixpoint);
+    if (!rewritten) { printf("rewrite    failed\n"); }
+
+    // Rules that only differ in which variables repeat share a bucket and get
+    // bound one after another; the general one, added last, is the one that fires
+    RuleSet tuned;
+    RuleSetInit(&tuned, arena);
+    String8 shapes = Str8Lit("a*(a + c) + d -> 0\na*(b + a) + d -> 0\na*(b + c) + a -> 0\na*(b + b) + d -> 0\n"
+                             "a*(b + c) + b -> 0\na*(b + c) + c -> 0\na*(a + a) + d -> 0\na*(a + c) + a -> 0\n"
+                             "a*(b + a) + a -> 0\na*(b + b) + b -> 0\na*(a + c) + c -> 0\na*(b + a) + b -> 0\n"
+                             "a*(b + b) + a -> 0\na*(a + a) + a -> 0\na*(b + c) + d -> a*b + a*c + d\n");
+    if (!ParseRules(scratch, shapes, &tuned) || !ParseRules(scratch, rule_text, &tuned) || !RuleSetProfile(&tuned))
+    {
+        printf("rewrite    profiled rules failed\n");
+    }
+    BENCH_TIME(seconds, 0.3, {
+        report = {};
+        for (U64 i = 0; i < node_count; i += 1) { RuleSetMatch(&tuned, nodes[i], binds, &report); }
+    });
+    BenchReportPerItem("rewrite", "lookup profiled", node_count, seconds);
+    double before = (double)report.candidates / (double)Max<U64>(report.lookups, 1);
+    String8 never = RuleProfileReport(arena, scratch, &tuned, 1000);
+    U64 never_count = 0;
+    for (U64 i = 0; i < never.size; i += 1) { never_count += never.str[i] == '\n'; }
+    RuleSetReorder(&tuned, scratch);
+    BENCH_TIME(seconds, 0.3, {
+        report = {};
+        for (U64 i = 0; i < node_count; i += 1) { RuleSetMatch(&tuned, nodes[i], binds, &report); }
+    });
+    BenchReportPerItem("rewrite", "lookup reordered", node_count, seconds);
+    printf("%-10s %.2f candidates bound per lookup before reordering, %.2f after, %llu rules never fired\n", "rewrite", before,
+           (double)report.candidates / (double)Max<U64>(report.lookups, 1), (unsigned long long)never_count);
+    delete scratch;
+    delete arena;
+}
+
+// Shared quotients, the way derivatives repeat their subterms: root j sums
+// t[i]*t[i + j] over the terms t[i] = (x*y + i)/(x - i*y)
+internal String8 
+BenchSharedTerms(Arena *arena, U32 terms, U32 root)
+{
+    U64 cap = (U64)terms * 64 + 1;
+    U8 *str = arena->PushArrayNoZero<U8>(cap);
+    U64 size = 0;
+    for (U32 i = 0; i < terms; i += 1)
+    {
+        U32 k = (i + root) % terms;
+        size += (U64)snprintf((char *)str + size, cap - size, "%s(x*y + %u)/(x - %u*y)*((x*y + %u)/(x - %u*y))",
+                              i ? " + " : "", i + 1, i + 2, k + 1, k + 2);
+    }
+    return Str8(str, size);
+}
+
+internal void 
+BenchCse(void)
+{
+    Arena *arena = new Arena(MB(64));
+    Arena *scratch = new Arena(MB(64));
+    F64 vars_by_name[] = {0.75, -0.5};
+    U32 const terms = 32;
+    U32 const root_count = 16;
+    Expr *roots[root_count];
+    for (U32 j = 0; j < root_count; j += 1) { roots[j] = Parse(arena, scratch, BenchSharedTerms(arena, terms, j + 1)).root; }
+
+    // One expression, then all roots as one program
+    for (U32 batch = 0; batch <= 1; batch += 1)
+    {
+        F64 seconds[2] = {};
+        U32 counts[2] = {};
+        Bytecode code;
+        for (B32 cse = 0; cse <= 1; cse += 1)
+        {
+            B32 ok = batch ? BytecodeCompileBatch(arena, scratch, roots, root_count, &code, cse)
+                           : BytecodeCompile(arena, scratch, roots[0], &code, cse);
+            if (!ok) { printf("cse        compile failed\n"); break; }
+            F64 vars[2];
+            for (U32 slot = 0; slot < code.var_count; slot += 1) { vars[slot] = vars_by_name[code.vars[slot].str[0] == 'y']; }
+            F64 *stack = arena->PushArray<F64>(code.stack_size);
+            F64 volatile sink = 0.0;
+            char name[64];
+            snprintf(name, sizeof(name), "%s %s", batch ? "batch" : "single", cse ? "shared" : "plain");
+            BENCH_TIME(seconds[cse], 0.1, { sink = sink + BytecodeEval(&code, vars, stack); });
+            BenchReportPerItem("cse", name, code.count, seconds[cse]);
+            counts[cse] = code.count;
+        }
+        printf("%-10s %-6s eliminated %llu nodes, %u shared, %u -> %u instructions, %.2fx faster\n", "cse",
+               batch ? "batch" : "single", (unsigned long long)code.eliminated, code.shared, counts[0], counts[1],
+               seconds[1] > 0.0 ? seconds[0] / seconds[1] : 0.0);
+    }
+
+    delete scratch;
+    delete arena;
+}
+
+int main(void)
+{
+    BenchParse();
+    BenchParseParallel();
+    BenchParseBatch();
+    BenchWalk();
+    BenchEval();
+    BenchBatch();
+    BenchColumns();
+    BenchHorner();
+    BenchCse();
+    BenchSimplify();
+    BenchCanon();
+    BenchExpand();
+    BenchNumber();
+    BenchDiff();
+    BenchGradient();
+    BenchRewrite();
+    return 0;
+}
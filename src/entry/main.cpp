@@ -1,7 +1,7 @@
 ///////////////////////////////
 // Headers
 
-#include "base/base_inc.h"
+#include "base/base_inc.hpp"
 
 ///////////////////////////////
 // Implementations
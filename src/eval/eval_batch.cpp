@@ -0,0 +1,97 @@
+//////////////////
+// Kernels
+
+#define EVAL_KERNEL_NAME EvalBatchTileScalar
+#define EVAL_KERNEL_TARGET
+#define EVAL_LANES 1
+#define EVAL_V F64
+#define EVAL_LOAD(p) (*(p))
+#define EVAL_STORE(p, v) (*(p) = (v))
+#define EVAL_SET1(x) (x)
+#define EVAL_ADD(a, b) ((a) + (b))
+#define EVAL_SUB(a, b) ((a) - (b))
+#define EVAL_MUL(a, b) ((a) * (b))
+#define EVAL_DIV(a, b) ((a) / (b))
+#include "eval_batch_kernel.cpp"
+
+#if ARCH_X64
+
+#define EVAL_KERNEL_NAME EvalBatchTileAVX2
+#define EVAL_KERNEL_TARGET FUNCTION_TARGET("avx2")
+#define EVAL_LANES 4
+#define EVAL_V __m256d
+#define EVAL_LOAD(p) _mm256_loadu_pd(p)
+#define EVAL_STORE(p, v) _mm256_storeu_pd((p), (v))
+#define EVAL_SET1(x) _mm256_set1_pd(x)
+#define EVAL_ADD(a, b) _mm256_add_pd((a), (b))
+#define EVAL_SUB(a, b) _mm256_sub_pd((a), (b))
+#define EVAL_MUL(a, b) _mm256_mul_pd((a), (b))
+#define EVAL_DIV(a, b) _mm256_div_pd((a), (b))
+#include "eval_batch_kernel.cpp"
+
+#define EVAL_KERNEL_NAME EvalBatchTileAVX512
+#define EVAL_KERNEL_TARGET FUNCTION_TARGET("avx512f")
+#define EVAL_LANES 8
+#define EVAL_V __m512d
+#define EVAL_LOAD(p) _mm512_loadu_pd(p)
+#define EVAL_STORE(p, v) _mm512_storeu_pd((p), (v))
+#define EVAL_SET1(x) _mm512_set1_pd(x)
+#define EVAL_ADD(a, b) _mm512_add_pd((a), (b))
+#define EVAL_SUB(a, b) _mm512_sub_pd((a), (b))
+#define EVAL_MUL(a, b) _mm512_mul_pd((a), (b))
+#define EVAL_DIV(a, b) _mm512_div_pd((a), (b))
+#include "eval_batch_kernel.cpp"
+
+#endif // ARCH_X64
+
+//////////////////
+// Dispatch
+
+internal EvalIsa 
+EvalBestIsa(void)
+{
+    local_persist EvalIsa best = CpuHasAVX512() ? EvalIsa::AVX512 : CpuHasAVX2() ? EvalIsa::AVX2 : EvalIsa::SCALAR;
+    return best;
+}
+
+internal char const *
+EvalIsaString(EvalIsa isa)
+{
+    switch (isa)
+    {
+        case EvalIsa::SCALAR: return "scalar";
+        case EvalIsa::AVX2:   return "avx2";
+        case EvalIsa::AVX512: return "avx512";
+        default:              return "auto";
+    }
+}
+
+internal U64 
+BytecodeBatchWorkspaceSize(Bytecode const *code)
+{
+    return sizeof(F64) * EVAL_BATCH_TILE * code->stack_size + sizeof(F64 const *) * (code->stack_size + 1);
+}
+
+internal EvalIsa 
+BytecodeEvalBatch(Bytecode const *code, F64 const *const *columns, U64 rows, F64 *out, void *workspace, EvalIsa isa)
+{
+    typedef void Kernel(Bytecode const *, F64 const *const *, U64, U32, F64 *, F64 *, F64 const **);
+
+    // Never more than the CPU has, whatever was asked for
+    EvalIsa best = EvalBestIsa();
+    if (isa == EvalIsa::AUTO || isa > best) { isa = best; }
+    Kernel *kernel = EvalBatchTileScalar;
+#if ARCH_X64
+    if (isa == EvalIsa::AVX2)   { kernel = EvalBatchTileAVX2; }
+    if (isa == EvalIsa::AVX512) { kernel = EvalBatchTileAVX512; }
+#endif
+
+    F64 *tiles = (F64 *)workspace;
+    F64 const **values = (F64 const **)(tiles + (U64)EVAL_BATCH_TILE * code->stack_size);
+    for (U64 row = 0; row < rows; row += EVAL_BATCH_TILE)
+    {
+        U32 n = (U32)Min<U64>(EVAL_BATCH_TILE, rows - row);
+        kernel(code, columns, row, n, out + row, tiles, values);
+    }
+    return isa;
+}
@@ -0,0 +1,36 @@
+/*
+eval_batch.hpp
+
+Bytecode evaluated over columns of variable values, one output per row. Rows are
+processed a tile at a time: every instruction runs over the whole tile before the
+next one, so dispatch is paid once per tile and the inner loops are plain SIMD.
+Intermediates live in per stack level tiles small enough to stay in cache, and
+temporaries of shared subexpressions in tiles of their own.
+*/
+#ifndef EVAL_BATCH_HPP
+#define EVAL_BATCH_HPP
+
+#define EVAL_BATCH_TILE 256         // rows, one tile is 2KB of doubles
+
+enum class EvalIsa : U8 
+{
+    AUTO,       // best the CPU supports
+    SCALAR,
+    AVX2,       // 4 rows per instruction
+    AVX512,     // 8 rows per instruction
+    COUNT
+};
+
+internal EvalIsa EvalBestIsa(void);
+internal char const *EvalIsaString(EvalIsa isa);
+
+// Bytes of workspace BytecodeEvalBatch needs for code
+internal U64 BytecodeBatchWorkspaceSize(Bytecode const *code);
+
+// columns[slot] holds rows values of variable slot, out gets rows results.
+// workspace is BytecodeBatchWorkspaceSize(code) bytes, 64 byte aligned is best.
+// Batch compiled code writes its last root. Returns the instruction set actually used.
+internal EvalIsa BytecodeEvalBatch(Bytecode const *code, F64 const *const *columns, U64 rows, F64 *out, void *workspace,
+                                   EvalIsa isa = EvalIsa::AUTO);
+
+#endif // EVAL_BATCH_HPP
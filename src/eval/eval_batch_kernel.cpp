@@ -0,0 +1,129 @@
+/*
+eval_batch_kernel.cpp
+
+One tile of BytecodeEvalBatch. Included by eval_batch.cpp once per instruction
+set, after it defines:
+    EVAL_KERNEL_NAME, EVAL_KERNEL_TARGET    function name and FUNCTION_TARGET(...) or nothing
+    EVAL_LANES, EVAL_V                      rows per vector and the vector type
+    EVAL_LOAD(p), EVAL_STORE(p, v), EVAL_SET1(x)
+    EVAL_ADD(a, b), EVAL_SUB(a, b), EVAL_MUL(a, b), EVAL_DIV(a, b)
+*/
+
+// dst[i] = vector_expr for whole vectors, scalar_expr for the rows left over
+#define EVAL_MAP(dst, vector_expr, scalar_expr) do { \
+    U32 i = 0; \
+    for (; i + EVAL_LANES <= n; i += EVAL_LANES) { EVAL_STORE((dst) + i, vector_expr); } \
+    for (; i < n; i += 1) { (dst)[i] = (scalar_expr); } } while (0)
+
+EVAL_KERNEL_TARGET internal void 
+EVAL_KERNEL_NAME(Bytecode const *code, F64 const *const *columns, U64 row, U32 n, F64 *out, F64 *tiles, F64 const **values)
+{
+    F64 const *consts = code->consts;
+    U32 sp = 0;     // values[sp] is the top, tile sp - 1 backs it once it is computed
+    for (BcInst const *ip = code->code; ; ip += 1)
+    {
+        switch (ip->op)
+        {
+            case BcOp::CONST:
+            {
+                sp += 1;
+                F64 *t = tiles + (U64)(sp - 1) * EVAL_BATCH_TILE;
+                F64 c = consts[ip->arg];
+                EVAL_V cv = EVAL_SET1(c);
+                EVAL_MAP(t, cv, c);
+                values[sp] = t;
+            } break;
+            case BcOp::VAR:
+            {
+                // Read straight from the column, no copy
+                sp += 1;
+                values[sp] = columns[ip->arg] + row;
+            } break;
+            case BcOp::NEG:
+            {
+                F64 *t = tiles + (U64)(sp - 1) * EVAL_BATCH_TILE;
+                F64 const *a = values[sp];
+                EVAL_V zero = EVAL_SET1(0.0);
+                EVAL_MAP(t, EVAL_SUB(zero, EVAL_LOAD(a + i)), -a[i]);
+                values[sp] = t;
+            } break;
+
+#define EVAL_BINARY(op_name, OP, op) case BcOp::op_name: \
+            { \
+                sp -= 1; \
+                F64 *t = tiles + (U64)(sp - 1) * EVAL_BATCH_TILE; \
+                F64 const *a = values[sp]; \
+                F64 const *b = values[sp + 1]; \
+                EVAL_MAP(t, OP(EVAL_LOAD(a + i), EVAL_LOAD(b + i)), a[i] op b[i]); \
+                values[sp] = t; \
+            } break;
+#define EVAL_FUSED_CONST(op_name, OP, op) case BcOp::op_name: \
+            { \
+                F64 *t = tiles + (U64)(sp - 1) * EVAL_BATCH_TILE; \
+                F64 const *a = values[sp]; \
+                F64 c = consts[ip->arg]; \
+                EVAL_V cv = EVAL_SET1(c); \
+                EVAL_MAP(t, OP(EVAL_LOAD(a + i), cv), a[i] op c); \
+                values[sp] = t; \
+            } break;
+#define EVAL_FUSED_VAR(op_name, OP, op) case BcOp::op_name: \
+            { \
+                F64 *t = tiles + (U64)(sp - 1) * EVAL_BATCH_TILE; \
+                F64 const *a = values[sp]; \
+                F64 const *b = columns[ip->arg] + row; \
+                EVAL_MAP(t, OP(EVAL_LOAD(a + i), EVAL_LOAD(b + i)), a[i] op b[i]); \
+                values[sp] = t; \
+            } break;
+
+            EVAL_BINARY(ADD, EVAL_ADD, +)
+            EVAL_BINARY(SUB, EVAL_SUB, -)
+            EVAL_BINARY(MUL, EVAL_MUL, *)
+            EVAL_BINARY(DIV, EVAL_DIV, /)
+            EVAL_FUSED_CONST(ADD_CONST, EVAL_ADD, +)
+            EVAL_FUSED_CONST(SUB_CONST, EVAL_SUB, -)
+            EVAL_FUSED_CONST(MUL_CONST, EVAL_MUL, *)
+            EVAL_FUSED_CONST(DIV_CONST, EVAL_DIV, /)
+            EVAL_FUSED_VAR(ADD_VAR, EVAL_ADD, +)
+            EVAL_FUSED_VAR(SUB_VAR, EVAL_SUB, -)
+            EVAL_FUSED_VAR(MUL_VAR, EVAL_MUL, *)
+            EVAL_FUSED_VAR(DIV_VAR, EVAL_DIV, /)
+
+#undef EVAL_BINARY
+#undef EVAL_FUSED_CONST
+#undef EVAL_FUSED_VAR
+
+            case BcOp::STORE:
+            {
+                // Temporaries get the tiles above the stack's
+                F64 *t = tiles + (U64)(code->temp_base + ip->arg) * EVAL_BATCH_TILE;
+                MemoryCopy(t, values[sp], sizeof(F64) * n);
+                values[sp] = t;
+            } break;
+            case BcOp::LOAD:
+            {
+                sp += 1;
+                values[sp] = tiles + (U64)(code->temp_base + ip->arg) * EVAL_BATCH_TILE;
+            } break;
+            case BcOp::POP: { sp -= 1; } break;
+
+            default:
+            {
+                MemoryCopy(out, values[sp], sizeof(F64) * n);
+                return;
+            }
+        }
+    }
+}
+
+#undef EVAL_MAP
+#undef EVAL_KERNEL_NAME
+#undef EVAL_KERNEL_TARGET
+#undef EVAL_LANES
+#undef EVAL_V
+#undef EVAL_LOAD
+#undef EVAL_STORE
+#undef EVAL_SET1
+#undef EVAL_ADD
+#undef EVAL_SUB
+#undef EVAL_MUL
+#undef EVAL_DIV
@@ -0,0 +1,521 @@
+//////////////////
+// Value numbering
+// One node per distinct subexpression, found by kind, literal and the numbers of
+// its children. Addresses already seen are looked up first, so a DAG such as
+// ExprHorner's output costs its distinct nodes rather than its tree size.
+
+struct BcNode 
+{
+    Expr *expr;             // first occurrence, kind and literal come from it
+    U32 first;              // children's numbers start at edges[first]
+    U32 uses;               // references from distinct parents and from roots
+    U32 temp;               // 1 + temporary holding the value once computed
+    U64 hash;
+    U64 size;               // nodes of the tree it stands for, saturating
+};
+
+struct BcNumbering 
+{
+    BcNode *nodes;
+    U64 node_count, node_cap;
+    U32 *edges;
+    U64 edge_count, edge_cap;
+    U32 *table;             // open addressing over node index + 1
+    U64 table_cap;
+    Expr **seen;            // address -> node
+    U32 *seen_node;
+    U64 seen_count, seen_cap;
+};
+
+internal B32 
+BcNumberingInit(Arena *scratch, BcNumbering *n)
+{
+    *n = {};
+    n->table_cap = n->seen_cap = 64;
+    n->table = scratch->PushArray<U32>(n->table_cap);
+    n->seen = scratch->PushArray<Expr *>(n->seen_cap);
+    n->seen_node = scratch->PushArrayNoZero<U32>(n->seen_cap);
+    return n->table && n->seen && n->seen_node;
+}
+
+// Slot holding expr, or the empty one where it would go
+internal U64 
+BcSeenSlot(BcNumbering *n, Expr *expr)
+{
+    U64 mask = n->seen_cap - 1;
+    U64 slot = HashU64((U64)(uintptr_t)expr) & mask;
+    while (n->seen[slot] && n->seen[slot] != expr) { slot = (slot + 1) & mask; }
+    return slot;
+}
+
+internal B32 
+BcSeenInsert(Arena *scratch, BcNumbering *n, Expr *expr, U32 node)
+{
+    if ((n->seen_count + 1) * 2 > n->seen_cap)
+    {
+        Expr **old = n->seen;
+        U32 *old_node = n->seen_node;
+        U64 old_cap = n->seen_cap;
+        n->seen_cap *= 2;
+        n->seen = scratch->PushArray<Expr *>(n->seen_cap);
+        n->seen_node = scratch->PushArrayNoZero<U32>(n->seen_cap);
+        if (!n->seen || !n->seen_node) { return 0; }
+        for (U64 i = 0; i < old_cap; i += 1)
+        {
+            if (!old[i]) { continue; }
+            U64 slot = BcSeenSlot(n, old[i]);
+            n->seen[slot] = old[i];
+            n->seen_node[slot] = old_node[i];
+        }
+    }
+    U64 slot = BcSeenSlot(n, expr);
+    n->seen[slot] = expr;
+    n->seen_node[slot] = node;
+    n->seen_count += 1;
+    return 1;
+}
+
+internal B32 
+BcNodeSame(BcNumbering *n, BcNode *node, Expr *expr, U32 const *children, U32 count)
+{
+    Expr *other = node->expr;
+    if (other->kind != expr->kind) { return 0; }
+    switch (expr->kind)
+    {
+        case ExprKind::NUM: return other->num == expr->num;
+        case ExprKind::BIG_NUM: return IntCompare(ExprInteger(other), ExprInteger(expr)) == 0;
+        case ExprKind::VAR: return Str8Match(other->var, expr->var);
+        default: return ExprChildCount(other) == count && memcmp(n->edges + node->first, children, sizeof(U32) * count) == 0;
+    }
+}
+
+// Number of the subexpression expr stands for, given its children's numbers
+internal B32 
+BcNumberNode(Arena *scratch, BcNumbering *n, Expr *expr, U32 const *children, U32 count, U32 *out)
+{
+    U64 hash = HashU64((U64)expr->kind + 1);
+    if (count == 0) { hash = HashCombine(hash, expr->hash); }
+    for (U32 i = 0; i < count; i += 1) { hash = HashCombine(hash, children[i]); }
+
+    U64 mask = n->table_cap - 1;
+    U64 slot = hash & mask;
+    for (; n->table[slot]; slot = (slot + 1) & mask)
+    {
+        BcNode *node = &n->nodes[n->table[slot] - 1];
+        if (node->hash == hash && BcNodeSame(n, node, expr, children, count))
+        {
+            *out = n->table[slot] - 1;
+            return 1;
+        }
+    }
+
+    if (n->node_count + 1 >= max_U32) { return 0; }
+    if (n->node_count == n->node_cap && !(n->nodes = ArenaGrowArray(scratch, n->nodes, n->node_count, &n->node_cap))) { return 0; }
+    while (n->edge_count + count > n->edge_cap)
+    {
+        if (!(n->edges = ArenaGrowArray(scratch, n->edges, n->edge_count, &n->edge_cap))) { return 0; }
+    }
+    U64 size = 1;
+    for (U32 i = 0; i < count; i += 1)
+    {
+        BcNode *child = &n->nodes[children[i]];
+        child->uses += 1;
+        size = ClampTop(size + child->size, max_U64 >> 1);
+    }
+    if (count) { MemoryCopy(n->edges + n->edge_count, children, sizeof(U32) * count); }
+    n->nodes[n->node_count] = {expr, (U32)n->edge_count, 0, 0, hash, size};
+    n->edge_count += count;
+    n->table[slot] = (U32)++n->node_count;
+    *out = (U32)n->node_count - 1;
+
+    if (n->node_count * 2 > n->table_cap)
+    {
+        U64 cap = n->table_cap * 2;
+        U32 *table = scratch->PushArray<U32>(cap);
+        if (!table) { return 0; }
+        for (U64 i = 0; i < n->node_count; i += 1)
+        {
+            U64 s = n->nodes[i].hash & (cap - 1);
+            while (table[s]) { s = (s + 1) & (cap - 1); }
+            table[s] = (U32)i + 1;
+        }
+        n->table = table;
+        n->table_cap = cap;
+    }
+    return 1;
+}
+
+// Postorder over root, children's numbers wait on done until their parent's turn
+internal B32 
+BcNumberRoot(Arena *scratch, BcNumbering *n, Expr *root, U32 *out)
+{
+    struct Frame { Expr *expr; U32 next; };
+
+    U64 slot = BcSeenSlot(n, root);
+    if (n->seen[slot]) { *out = n->seen_node[slot]; return 1; }
+
+    U64 count = 0, cap = 0, done_count = 0, done_cap = 0;
+    Frame *stack = ArenaGrowArray(scratch, (Frame *)nullptr, count, &cap);
+    U32 *done = ArenaGrowArray(scratch, (U32 *)nullptr, done_count, &done_cap);
+    B32 ok = stack && done;
+    if (ok) { stack[count++] = {root, 0}; }
+    while (ok && count)
+    {
+        Frame *top = &stack[count - 1];
+        Expr *expr = top->expr;
+        U32 children = ExprChildCount(expr);
+        if (top->next < children)
+        {
+            Expr *child = ExprChild(expr, top->next);
+            top->next += 1;
+            slot = BcSeenSlot(n, child);
+            if (n->seen[slot])
+            {
+                if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+                done[done_count++] = n->seen_node[slot];
+                continue;
+            }
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {child, 0};
+            continue;
+        }
+
+        U32 number = 0;
+        done_count -= children;
+        ok = BcNumberNode(scratch, n, expr, done + done_count, children, &number) && BcSeenInsert(scratch, n, expr, number);
+        count -= 1;
+        if (count == 0) { *out = number; break; }
+        if (done_count == done_cap && !(done = ArenaGrowArray(scratch, done, done_count, &done_cap))) { ok = 0; break; }
+        done[done_count++] = number;
+    }
+    return ok;
+}
+
+//////////////////
+// Compiler
+
+struct BcCompiler 
+{
+    BcInst *code;
+    U32 count;
+    U32 depth;
+    U32 max_depth;
+    U32 temp_count;
+    U32 shared;
+
+    // Pools, open addressing over index + 1
+    F64 *consts;            // big literals are rounded here already
+    U32 const_count;
+    U32 *const_table;
+    String8 *vars;
+    U32 var_count;
+    U32 *var_table;
+    U64 table_mask;
+};
+
+internal void 
+BcEmit(BcCompiler *c, BcOp op, U32 arg)
+{
+    c->code[c->count++] = {op, arg};
+    if (op == BcOp::CONST || op == BcOp::VAR || op == BcOp::LOAD)
+    {
+        c->depth += 1;
+        c->max_depth = Max(c->max_depth, c->depth);
+    }
+    else if ((op >= BcOp::ADD && op <= BcOp::DIV) || op == BcOp::POP) { c->depth -= 1; }
+}
+
+internal U32 
+BcConstIndex(BcCompiler *c, F64 value)
+{
+    U64 bits;
+    MemoryCopy(&bits, &value, sizeof(bits));
+    U64 slot = HashU64(bits) & c->table_mask;
+    while (c->const_table[slot] && c->consts[c->const_table[slot] - 1] != value) { slot = (slot + 1) & c->table_mask; }
+    if (!c->const_table[slot])
+    {
+        c->consts[c->const_count] = value;
+        c->const_table[slot] = ++c->const_count;
+    }
+    return c->const_table[slot] - 1;
+}
+
+internal U32 
+BcVarIndex(BcCompiler *c, String8 name)
+{
+    U64 slot = HashBytes(name.str, name.size, 0) & c->table_mask;
+    while (c->var_table[slot] && !Str8Match(c->vars[c->var_table[slot] - 1], name)) { slot = (slot + 1) & c->table_mask; }
+    if (!c->var_table[slot])
+    {
+        c->vars[c->var_count] = name;
+        c->var_table[slot] = ++c->var_count;
+    }
+    return c->var_table[slot] - 1;
+}
+
+internal void 
+BcEmitLeaf(BcCompiler *c, Expr *leaf, BcOp const_op, BcOp var_op)
+{
+    if (leaf->kind == ExprKind::VAR) { BcEmit(c, var_op, BcVarIndex(c, leaf->var)); }
+    else                             { BcEmit(c, const_op, BcConstIndex(c, IntToF64(ExprInteger(leaf)))); }
+}
+
+// Plain and fused forms of the operator applied between operands
+internal BcOp 
+BcCombineOp(ExprKind kind, U32 form)
+{
+    static BcOp const ops[][3] = {
+        {BcOp::ADD, BcOp::ADD_CONST, BcOp::ADD_VAR},
+        {BcOp::SUB, BcOp::SUB_CONST, BcOp::SUB_VAR},
+        {BcOp::MUL, BcOp::MUL_CONST, BcOp::MUL_VAR},
+        {BcOp::DIV, BcOp::DIV_CONST, BcOp::DIV_VAR},
+    };
+    U32 row = kind == ExprKind::PLUS ? 0 : kind == ExprKind::DIFFERENCE ? 1 : kind == ExprKind::MULTIPLY ? 2 : 3;
+    return ops[row][form];
+}
+
+// Shared by BytecodeCompile and BytecodeCompileBatch, batch gives every root an output
+internal B32 
+BcCompileRoots(Arena *arena, Arena *scratch, Expr **roots, U32 root_count, B32 batch, B32 cse, Bytecode *out)
+{
+    // pending: the child just finished was a whole subtree that still has to be combined
+    struct Frame { U32 node; U32 next; B32 pending; };
+
+    U64 pos = scratch->ArenaGetPos();
+    BcNumbering n;
+    U32 *root_nodes = scratch->PushArrayNoZero<U32>(Max<U32>(root_count, 1));
+    B32 ok = root_count > 0 && root_nodes && BcNumberingInit(scratch, &n);
+    U64 tree_size = 0;
+    for (U32 r = 0; ok && r < root_count; r += 1)
+    {
+        ok = roots[r] && BcNumberRoot(scratch, &n, roots[r], &root_nodes[r]);
+        if (ok)
+        {
+            n.nodes[root_nodes[r]].uses += 1;
+            tree_size = ClampTop(tree_size + n.nodes[root_nodes[r]].size, max_U64 >> 1);
+        }
+    }
+
+    // One instruction per node emitted, with CSE also a store per shared node and a
+    // load plus its combining op per repeated reference, and up to three per root
+    // for batch outputs
+    U64 code_cap = (cse ? (n.node_count + n.edge_count) * 2 : tree_size) + (U64)root_count * 3 + 1;
+    ok = ok && code_cap < max_U32;
+    U64 table_cap = 16;
+    while (ok && table_cap < n.node_count * 2) { table_cap <<= 1; }
+
+    BcCompiler c = {};
+    U64 count = 0, cap = 0;
+    Frame *stack = nullptr;
+    if (ok)
+    {
+        c.code = scratch->PushArrayNoZero<BcInst>(code_cap);
+        c.consts = scratch->PushArrayNoZero<F64>(n.node_count);
+        c.vars = scratch->PushArrayNoZero<String8>(n.node_count);
+        c.const_table = scratch->PushArray<U32>(table_cap);
+        c.var_table = scratch->PushArray<U32>(table_cap);
+        c.table_mask = table_cap - 1;
+        stack = ArenaGrowArray(scratch, stack, count, &cap);
+        ok = c.code && c.consts && c.vars && c.const_table && c.var_table && stack;
+    }
+    U32 *outputs = batch && ok ? scratch->PushArrayNoZero<U32>(root_count) : nullptr;
+    ok = ok && (!batch || outputs);
+
+    for (U32 r = 0; ok && r < root_count; r += 1)
+    {
+        BcNode *root = &n.nodes[root_nodes[r]];
+        B32 last = r + 1 == root_count;
+        B32 reuse = cse && root->temp;
+        if (reuse && !last)
+        {
+            outputs[r] = root->temp - 1;
+            continue;
+        }
+        if (reuse) { BcEmit(&c, BcOp::LOAD, root->temp - 1); }
+        else       { stack[count++] = {root_nodes[r], 0, 0}; }
+
+        while (count)
+        {
+            Frame *top = &stack[count - 1];
+            BcNode *node = &n.nodes[top->node];
+            Expr *expr = node->expr;
+            U32 children = ExprChildCount(expr);
+            if (children == 0)
+            {
+                BcEmitLeaf(&c, expr, BcOp::CONST, BcOp::VAR);
+                count -= 1;
+                continue;
+            }
+            if (top->pending)
+            {
+                BcEmit(&c, expr->kind == ExprKind::PRE_UNARY_MINUS ? BcOp::NEG : BcCombineOp(expr->kind, 0), 0);
+                top->pending = 0;
+            }
+            if (top->next == children)
+            {
+                if (cse && node->uses > 1)
+                {
+                    node->temp = ++c.temp_count;
+                    c.shared += 1;
+                    BcEmit(&c, BcOp::STORE, node->temp - 1);
+                }
+                count -= 1;
+                continue;
+            }
+
+            U32 index = top->next++;
+            BcNode *child = &n.nodes[n.edges[node->first + index]];
+            if (index > 0 && ExprChildCount(child->expr) == 0)
+            {
+                BcEmitLeaf(&c, child->expr, BcCombineOp(expr->kind, 1), BcCombineOp(expr->kind, 2));
+                continue;
+            }
+            top->pending = index > 0 || expr->kind == ExprKind::PRE_UNARY_MINUS;
+            if (cse && child->temp)
+            {
+                BcEmit(&c, BcOp::LOAD, child->temp - 1);
+                continue;
+            }
+            if (count == cap && !(stack = ArenaGrowArray(scratch, stack, count, &cap))) { ok = 0; break; }
+            stack[count++] = {n.edges[node->first + index], 0, 0};
+        }
+
+        if (ok && batch)
+        {
+            if (!cse || !root->temp)
+            {
+                root->temp = ++c.temp_count;
+                BcEmit(&c, BcOp::STORE, root->temp - 1);
+            }
+            outputs[r] = root->temp - 1;
+        }
+        if (ok) { BcEmit(&c, last ? BcOp::RET : BcOp::POP, 0); }
+    }
+
+    // Exact sized copies out of scratch
+    Bytecode code = {};
+    code.count = c.count;
+    code.temp_base = Max<U32>(c.max_depth, 1);
+    code.temp_count = c.temp_count;
+    code.stack_size = code.temp_base + c.temp_count;
+    code.const_count = c.const_count;
+    code.var_count = c.var_count;
+    code.output_count = batch ? root_count : 0;
+    code.shared = c.shared;
+    code.eliminated = cse && ok ? tree_size - n.node_count : 0;
+    code.code = ok ? arena->PushArrayNoZero<BcInst>(c.count) : nullptr;
+    code.consts = ok ? arena->PushArrayNoZero<F64>(Max<U32>(c.const_count, 1)) : nullptr;
+    code.vars = ok ? arena->PushArrayNoZero<String8>(Max<U32>(c.var_count, 1)) : nullptr;
+    code.outputs = ok && batch ? arena->PushArrayNoZero<U32>(root_count) : nullptr;
+    ok = code.code && code.consts && code.vars && (!batch || code.outputs);
+    if (ok)
+    {
+        MemoryCopy(code.code, c.code, sizeof(BcInst) * c.count);
+        if (batch) { MemoryCopy(code.outputs, outputs, sizeof(U32) * root_count); }
+        MemoryCopy(code.consts, c.consts, sizeof(F64) * c.const_count);
+        for (U32 i = 0; i < c.var_count && ok; i += 1)
+        {
+            code.vars[i] = PushStr8Copy(arena, c.vars[i]);
+            ok = code.vars[i].str != nullptr;
+        }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (ok) { *out = code; }
+    return ok;
+}
+
+internal B32 
+BytecodeCompile(Arena *arena, Arena *scratch, Expr *root, Bytecode *out, B32 cse)
+{
+    return BcCompileRoots(arena, scratch, &root, 1, 0, cse, out);
+}
+
+internal B32 
+BytecodeCompileBatch(Arena *arena, Arena *scratch, Expr **roots, U32 count, Bytecode *out, B32 cse)
+{
+    return BcCompileRoots(arena, scratch, roots, count, 1, cse, out);
+}
+
+internal void 
+BytecodeReadOutputs(Bytecode const *code, F64 const *stack, F64 *out)
+{
+    for (U32 i = 0; i < code->output_count; i += 1) { out[i] = stack[code->temp_base + code->outputs[i]]; }
+}
+
+internal S32 
+BytecodeVarSlot(Bytecode const *code, String8 name)
+{
+    for (U32 i = 0; i < code->var_count; i += 1)
+    {
+        if (Str8Match(code->vars[i], name)) { return (S32)i; }
+    }
+    return -1;
+}
+
+//////////////////
+// Interpreter
+// Computed goto where the compiler has it, a switch in a loop otherwise
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BC_COMPUTED_GOTO 1
+#define BC_CASE(name) bc_##name:
+#define BC_NEXT() goto *dispatch[(U8)ip->op]
+#else
+#define BC_COMPUTED_GOTO 0
+#define BC_CASE(name) case BcOp::name:
+#define BC_NEXT() continue
+#endif
+
+internal F64 
+BytecodeEval(Bytecode const *code, F64 const *vars, F64 *stack)
+{
+    BcInst const *ip = code->code;
+    F64 const *consts = code->consts;
+    F64 *sp = stack;
+    F64 *temps = stack + code->temp_base;
+    F64 acc = 0.0;      // top of the stack, the slot under sp is the one below it
+
+#if BC_COMPUTED_GOTO
+    static void *const dispatch[] = {
+        &&bc_CONST, &&bc_VAR, &&bc_NEG,
+        &&bc_ADD, &&bc_SUB, &&bc_MUL, &&bc_DIV,
+        &&bc_ADD_CONST, &&bc_SUB_CONST, &&bc_MUL_CONST, &&bc_DIV_CONST,
+        &&bc_ADD_VAR, &&bc_SUB_VAR, &&bc_MUL_VAR, &&bc_DIV_VAR,
+        &&bc_STORE, &&bc_LOAD, &&bc_POP,
+        &&bc_RET,
+    };
+    static_assert(ArrayCount(dispatch) == (U64)BcOp::COUNT, "dispatch table out of date");
+    BC_NEXT();
+#else
+    for (;;) switch (ip->op) {
+#endif
+
+    BC_CASE(CONST)     { *sp++ = acc; acc = consts[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(VAR)       { *sp++ = acc; acc = vars[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(NEG)       { acc = -acc; ip += 1; } BC_NEXT();
+    BC_CASE(ADD)       { acc = *--sp + acc; ip += 1; } BC_NEXT();
+    BC_CASE(SUB)       { acc = *--sp - acc; ip += 1; } BC_NEXT();
+    BC_CASE(MUL)       { acc = *--sp * acc; ip += 1; } BC_NEXT();
+    BC_CASE(DIV)       { acc = *--sp / acc; ip += 1; } BC_NEXT();
+    BC_CASE(ADD_CONST) { acc += consts[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(SUB_CONST) { acc -= consts[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(MUL_CONST) { acc *= consts[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(DIV_CONST) { acc /= consts[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(ADD_VAR)   { acc += vars[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(SUB_VAR)   { acc -= vars[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(MUL_VAR)   { acc *= vars[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(DIV_VAR)   { acc /= vars[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(STORE)     { temps[ip->arg] = acc; ip += 1; } BC_NEXT();
+    BC_CASE(LOAD)      { *sp++ = acc; acc = temps[ip->arg]; ip += 1; } BC_NEXT();
+    BC_CASE(POP)       { acc = *--sp; ip += 1; } BC_NEXT();
+    BC_CASE(RET)       { return acc; }
+
+#if !BC_COMPUTED_GOTO
+    default: return acc;
+    }
+#endif
+}
+
+#undef BC_CASE
+#undef BC_NEXT
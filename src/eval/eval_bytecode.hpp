@@ -0,0 +1,70 @@
+/*
+eval_bytecode.hpp
+
+Expressions compiled to a linear stack bytecode for repeated evaluation. Literals
+are pooled, variables are resolved to slots at compile time, and operators whose
+right operand is a leaf are fused with it (x*y + 2 is VAR MUL_VAR ADD_CONST).
+The interpreter keeps the top of the stack in a local and never allocates.
+
+Repeated subexpressions are computed once: the compiler value-numbers the tree,
+stores a node used more than once in a temporary the first time and loads it
+after that. BytecodeCompileBatch does the same across several roots, such as
+the components of a gradient, and leaves each root's value in a temporary.
+*/
+#ifndef EVAL_BYTECODE_HPP
+#define EVAL_BYTECODE_HPP
+
+enum class BcOp : U8 
+{
+    CONST,      // push consts[arg]
+    VAR,        // push vars[arg]
+    NEG,
+    ADD, SUB, MUL, DIV,                             // pop b, pop a, push a op b
+    ADD_CONST, SUB_CONST, MUL_CONST, DIV_CONST,     // top = top op consts[arg]
+    ADD_VAR, SUB_VAR, MUL_VAR, DIV_VAR,             // top = top op vars[arg]
+    STORE,      // temps[arg] = top, top stays
+    LOAD,       // push temps[arg]
+    POP,        // between batch roots
+    RET,        // last instruction, returns the top
+    COUNT
+};
+
+struct BcInst 
+{
+    BcOp op;
+    U32 arg;
+};
+
+struct Bytecode 
+{
+    BcInst *code;
+    U32 count;              // including the final RET
+    U32 stack_size;         // F64 slots the interpreter needs, temporaries included
+    U32 temp_base;          // temporaries live in the stack buffer from this slot on
+    U32 temp_count;
+    F64 *consts;
+    U32 const_count;
+    U32 var_count;
+    String8 *vars;          // slot -> name, in order of first appearance
+    U32 *outputs;           // BytecodeCompileBatch: temporary holding each root
+    U32 output_count;
+    U32 shared;             // subexpressions stored once and loaded after
+    U64 eliminated;         // tree nodes not evaluated because of that
+};
+
+// 0 when an arena runs out. Everything in out lives in arena. cse = 0 evaluates
+// every occurrence of a repeated subexpression, for comparison.
+internal B32 BytecodeCompile(Arena *arena, Arena *scratch, Expr *root, Bytecode *out, B32 cse = 1);
+// One program for all roots, sharing subexpressions between them. It returns the
+// last root's value, BytecodeReadOutputs gets all of them afterwards.
+internal B32 BytecodeCompileBatch(Arena *arena, Arena *scratch, Expr **roots, U32 count, Bytecode *out, B32 cse = 1);
+
+// Slot of a variable, -1 if the expression does not use it
+internal S32 BytecodeVarSlot(Bytecode const *code, String8 name);
+
+// vars is indexed by slot, stack needs code->stack_size entries
+internal F64 BytecodeEval(Bytecode const *code, F64 const *vars, F64 *stack);
+// out[i] = root i of a batch, from the stack buffer of the evaluation that just ran
+internal void BytecodeReadOutputs(Bytecode const *code, F64 const *stack, F64 *out);
+
+#endif // EVAL_BYTECODE_HPP
@@ -0,0 +1,185 @@
+//////////////////
+// Files
+
+internal U64 
+ColumnFileStride(U64 rows)
+{
+    return (rows * sizeof(F64) + 63) & ~(U64)63;
+}
+
+internal U64 
+ColumnFileDataOffset(U64 names_size)
+{
+    return (sizeof(ColumnFileHeader) + names_size + KB(4) - 1) & ~(U64)(KB(4) - 1);
+}
+
+// Fills names and columns from a mapping whose header is already validated
+internal B32 
+ColumnFileBindMapping(Arena *arena, ColumnFile *file)
+{
+    ColumnFileHeader const *header = (ColumnFileHeader const *)file->map.data;
+    file->rows = header->rows;
+    file->column_count = header->column_count;
+    file->names = arena->PushArrayNoZero<String8>(header->column_count + 1);
+    file->columns = arena->PushArrayNoZero<F64 *>(header->column_count + 1);
+    if (!file->names || !file->columns) { return 0; }
+
+    U8 *name = file->map.data + sizeof(ColumnFileHeader);
+    U8 *names_opl = name + header->names_size;
+    for (U32 i = 0; i < header->column_count; i += 1)
+    {
+        U8 *end = name;
+        while (end < names_opl && *end) { end += 1; }
+        if (end == names_opl) { return 0; }
+        file->names[i] = Str8(name, (U64)(end - name));
+        file->columns[i] = (F64 *)(file->map.data + header->data_offset + header->column_stride * i);
+        name = end + 1;
+    }
+    return 1;
+}
+
+internal B32 
+ColumnFileCreate(Arena *arena, char const *path, String8 const *names, U32 column_count, U64 rows, ColumnFile *out)
+{
+    *out = {};
+    U64 names_size = 0;
+    for (U32 i = 0; i < column_count; i += 1) { names_size += names[i].size + 1; }
+    if (names_size > max_U32) { return 0; }
+
+    ColumnFileHeader header = {};
+    header.magic = COLUMN_FILE_MAGIC;
+    header.rows = rows;
+    header.column_stride = ColumnFileStride(rows);
+    header.data_offset = ColumnFileDataOffset(names_size);
+    header.column_count = column_count;
+    header.names_size = (U32)names_size;
+    if (!OSMapFileCreate(path, header.data_offset + header.column_stride * column_count, &out->map)) { return 0; }
+
+    MemoryCopy(out->map.data, &header, sizeof(header));
+    U8 *at = out->map.data + sizeof(header);
+    for (U32 i = 0; i < column_count; i += 1)
+    {
+        MemoryCopy(at, names[i].str, names[i].size);
+        at += names[i].size;
+        *at++ = 0;
+    }
+    if (!ColumnFileBindMapping(arena, out)) { ColumnFileClose(out); return 0; }
+    return 1;
+}
+
+internal B32 
+ColumnFileOpen(Arena *arena, char const *path, ColumnFile *out)
+{
+    *out = {};
+    if (!OSMapFileRead(path, &out->map)) { return 0; }
+
+    ColumnFileHeader header;
+    B32 ok = out->map.size >= sizeof(header);
+    if (ok)
+    {
+        MemoryCopy(&header, out->map.data, sizeof(header));
+        U64 data_size = header.column_stride * header.column_count;
+        ok = header.magic == COLUMN_FILE_MAGIC &&
+             header.rows <= max_U64 / sizeof(F64) &&
+             header.column_stride >= header.rows * sizeof(F64) && header.column_stride % 64 == 0 &&
+             header.data_offset % KB(4) == 0 && header.data_offset >= sizeof(header) + header.names_size &&
+             (header.column_count == 0 || data_size / header.column_count == header.column_stride) &&
+             header.data_offset <= out->map.size && data_size <= out->map.size - header.data_offset;
+    }
+    if (!ok || !ColumnFileBindMapping(arena, out)) { ColumnFileClose(out); return 0; }
+    return 1;
+}
+
+internal void 
+ColumnFileClose(ColumnFile *file)
+{
+    OSUnmapFile(&file->map);
+    *file = {};
+}
+
+internal S32 
+ColumnFileFind(ColumnFile const *file, String8 name)
+{
+    for (U32 i = 0; i < file->column_count; i += 1)
+    {
+        if (Str8Match(file->names[i], name)) { return (S32)i; }
+    }
+    return -1;
+}
+
+//////////////////
+// Evaluation
+
+struct EvalColumnsJob 
+{
+    JobSystem *jobs;
+    Bytecode const *code;
+    F64 const *const *columns;
+    U64 rows;
+    F64 *out;
+    EvalIsa isa;
+    std::atomic<B32> failed;        // a chunk's scratch couldn't hold its workspace
+};
+
+internal void 
+EvalColumnsChunk(void *data, U64 index, U32 worker)
+{
+    EvalColumnsJob *job = (EvalColumnsJob *)data;
+    Arena *scratch = JobScratch(job->jobs, worker);
+    U64 pos = scratch->ArenaGetPos();
+    void *workspace = scratch->PushArrayNoZero<U8>(BytecodeBatchWorkspaceSize(job->code), 64);
+
+    // Offset column pointers for this chunk, the kernels index from row 0
+    U32 var_count = job->code->var_count;
+    F64 const **columns = scratch->PushArrayNoZero<F64 const *>(var_count + 1);
+    U64 first = index * EVAL_COLUMNS_CHUNK_ROWS;
+    U64 rows = Min<U64>(EVAL_COLUMNS_CHUNK_ROWS, job->rows - first);
+    if (workspace && columns)
+    {
+        for (U32 slot = 0; slot < var_count; slot += 1) { columns[slot] = job->columns[slot] + first; }
+        BytecodeEvalBatch(job->code, columns, rows, job->out + first, workspace, job->isa);
+    }
+    else { job->failed.store(1, std::memory_order_relaxed); }
+    scratch->ArenaSetPosBack(pos);
+}
+
+internal B32 
+EvalColumnsParallel(JobSystem *jobs, Bytecode const *code, F64 const *const *columns, U64 rows, F64 *out, EvalIsa isa)
+{
+    EvalColumnsJob job;
+    job.jobs = jobs;
+    job.code = code;
+    job.columns = columns;
+    job.rows = rows;
+    job.out = out;
+    job.isa = isa;
+    job.failed.store(0);
+    JobParallelFor(jobs, (rows + EVAL_COLUMNS_CHUNK_ROWS - 1) / EVAL_COLUMNS_CHUNK_ROWS, EvalColumnsChunk, &job);
+    return !job.failed.load();
+}
+
+internal B32 
+EvalColumnFile(JobSystem *jobs, Arena *arena, Bytecode const *code, char const *input_path, char const *output_path,
+               String8 output_name)
+{
+    U64 pos = arena->ArenaGetPos();
+    ColumnFile input, output = {};
+    if (!ColumnFileOpen(arena, input_path, &input)) { return 0; }
+
+    // Slots to mapped input columns, no copies
+    F64 const **columns = arena->PushArrayNoZero<F64 const *>(code->var_count + 1);
+    B32 ok = columns != nullptr;
+    for (U32 slot = 0; ok && slot < code->var_count; slot += 1)
+    {
+        S32 column = ColumnFileFind(&input, code->vars[slot]);
+        ok = column >= 0;
+        if (ok) { columns[slot] = input.columns[column]; }
+    }
+    ok = ok && ColumnFileCreate(arena, output_path, &output_name, 1, input.rows, &output);
+    ok = ok && EvalColumnsParallel(jobs, code, columns, input.rows, output.columns[0]);
+
+    ColumnFileClose(&output);
+    ColumnFileClose(&input);
+    arena->ArenaSetPosBack(pos);
+    return ok;
+}
@@ -0,0 +1,54 @@
+/*
+eval_columns.hpp
+
+Columnar datasets on disk: a header, the null terminated column names, then one
+contiguous run of doubles per column. Files are memory mapped rather than read,
+so evaluation reads the page cache directly and writes results straight into a
+mapped output file. Rows are split into chunks handed out to the job system in
+file order, which keeps every worker streaming forwards through the columns.
+*/
+#ifndef EVAL_COLUMNS_HPP
+#define EVAL_COLUMNS_HPP
+
+#define COLUMN_FILE_MAGIC 0x314c4f4352505845ull     // "EXPRCOL1"
+#define EVAL_COLUMNS_CHUNK_ROWS (64 * EVAL_BATCH_TILE)
+
+struct ColumnFileHeader 
+{
+    U64 magic;
+    U64 rows;
+    U64 column_stride;      // bytes from one column to the next, multiple of 64
+    U64 data_offset;        // first column, page aligned
+    U32 column_count;
+    U32 names_size;         // bytes of names right after the header
+};
+
+struct ColumnFile 
+{
+    OSMapping map;
+    U64 rows;
+    U32 column_count;
+    String8 *names;         // point into the mapping
+    F64 **columns;          // point into the mapping, read only unless created
+};
+
+// Creates path sized for rows values of each named column, contents left for the caller
+internal B32 ColumnFileCreate(Arena *arena, char const *path, String8 const *names, U32 column_count, U64 rows, ColumnFile *out);
+// Maps an existing file read only, 0 if missing or malformed
+internal B32 ColumnFileOpen(Arena *arena, char const *path, ColumnFile *out);
+internal void ColumnFileClose(ColumnFile *file);
+// Column index of name, -1 if absent
+internal S32 ColumnFileFind(ColumnFile const *file, String8 name);
+
+// BytecodeEvalBatch over rows split across every worker. 0 when a worker's scratch
+// can't hold the batch workspace, out is incomplete then.
+internal B32 EvalColumnsParallel(JobSystem *jobs, Bytecode const *code, F64 const *const *columns, U64 rows, F64 *out,
+                                  EvalIsa isa = EvalIsa::AUTO);
+
+// Evaluates code over input_path, writing a one column file named output_name.
+// 0 if a file can't be mapped, input lacks one of the code's variables or the
+// evaluation fails, the output file's contents are undefined then.
+internal B32 EvalColumnFile(JobSystem *jobs, Arena *arena, Bytecode const *code, char const *input_path, char const *output_path,
+                            String8 output_name);
+
+#endif // EVAL_COLUMNS_HPP
@@ -0,0 +1,282 @@
+//////////////////
+// Tape
+
+internal U32 
+GradLeaf(GradNode *nodes, U32 *count, U32 *leaves, GradOp op, U32 arg)
+{
+    if (leaves[arg] == max_U32)
+    {
+        nodes[*count] = {op, arg, 0};
+        leaves[arg] = (*count)++;
+    }
+    return leaves[arg];
+}
+
+internal B32 
+GradTapeFromBytecode(Arena *arena, Arena *scratch, Bytecode const *code, GradTape *out)
+{
+    U64 pos = scratch->ArenaGetPos();
+
+    // Every instruction adds at most its leaf and its operation
+    U64 cap = (U64)code->count * 2 + 1;
+    GradNode *nodes = scratch->PushArrayNoZero<GradNode>(cap);
+    U32 *stack = scratch->PushArrayNoZero<U32>((U64)code->stack_size + 1);
+    U32 *temps = scratch->PushArrayNoZero<U32>(Max<U64>(code->temp_count, 1));
+    U32 *const_leaves = scratch->PushArrayNoZero<U32>(Max<U64>(code->const_count, 1));
+    U32 *var_leaves = scratch->PushArrayNoZero<U32>(Max<U64>(code->var_count, 1));
+    B32 ok = cap < max_U32 && nodes && stack && temps && const_leaves && var_leaves;
+    for (U32 i = 0; ok && i < code->const_count; i += 1) { const_leaves[i] = max_U32; }
+    for (U32 i = 0; ok && i < code->var_count; i += 1) { var_leaves[i] = max_U32; }
+
+    U32 count = 0, sp = 0, output = 0;
+    for (U32 i = 0; ok && i < code->count; i += 1)
+    {
+        BcInst inst = code->code[i];
+        switch (inst.op)
+        {
+            case BcOp::CONST: stack[sp++] = GradLeaf(nodes, &count, const_leaves, GradOp::CONST, inst.arg); break;
+            case BcOp::VAR:   stack[sp++] = GradLeaf(nodes, &count, var_leaves, GradOp::VAR, inst.arg); break;
+            case BcOp::NEG:
+            {
+                nodes[count] = {GradOp::NEG, stack[sp - 1], 0};
+                stack[sp - 1] = count++;
+            } break;
+            case BcOp::ADD: case BcOp::SUB: case BcOp::MUL: case BcOp::DIV:
+            {
+                GradOp op = (GradOp)((U32)GradOp::ADD + ((U32)inst.op - (U32)BcOp::ADD));
+                sp -= 1;
+                nodes[count] = {op, stack[sp - 1], stack[sp]};
+                stack[sp - 1] = count++;
+            } break;
+            case BcOp::ADD_CONST: case BcOp::SUB_CONST: case BcOp::MUL_CONST: case BcOp::DIV_CONST:
+            {
+                GradOp op = (GradOp)((U32)GradOp::ADD + ((U32)inst.op - (U32)BcOp::ADD_CONST));
+                U32 leaf = GradLeaf(nodes, &count, const_leaves, GradOp::CONST, inst.arg);
+                nodes[count] = {op, stack[sp - 1], leaf};
+                stack[sp - 1] = count++;
+            } break;
+            case BcOp::ADD_VAR: case BcOp::SUB_VAR: case BcOp::MUL_VAR: case BcOp::DIV_VAR:
+            {
+                GradOp op = (GradOp)((U32)GradOp::ADD + ((U32)inst.op - (U32)BcOp::ADD_VAR));
+                U32 leaf = GradLeaf(nodes, &count, var_leaves, GradOp::VAR, inst.arg);
+                nodes[count] = {op, stack[sp - 1], leaf};
+                stack[sp - 1] = count++;
+            } break;
+            case BcOp::STORE: temps[inst.arg] = stack[sp - 1]; break;
+            case BcOp::LOAD:  stack[sp++] = temps[inst.arg]; break;
+            case BcOp::POP:   sp -= 1; break;
+            case BcOp::RET:   output = stack[sp - 1]; break;
+            default: ok = 0; break;
+        }
+    }
+
+    // Keep what the result depends on. Operands come before their users, so one
+    // backward pass marks everything live.
+    U8 *live = ok ? scratch->PushArray<U8>(Max<U32>(count, 1)) : nullptr;
+    U32 *remap = ok ? scratch->PushArrayNoZero<U32>(Max<U32>(count, 1)) : nullptr;
+    ok = ok && live && remap && count > 0;
+    if (ok) { live[output] = 1; }
+    for (U32 i = output + 1; ok && i-- > 0;)
+    {
+        if (!live[i] || nodes[i].op == GradOp::CONST || nodes[i].op == GradOp::VAR) { continue; }
+        live[nodes[i].a] = 1;
+        if (nodes[i].op != GradOp::NEG) { live[nodes[i].b] = 1; }
+    }
+
+    GradTape tape = {};
+    if (ok)
+    {
+        U32 kept = 0;
+        for (U32 i = 0; i <= output; i += 1) { kept += live[i]; }
+        tape.nodes = arena->PushArrayNoZero<GradNode>(kept);
+        tape.consts = arena->PushArrayNoZero<F64>(Max<U32>(code->const_count, 1));
+        tape.var_nodes = arena->PushArrayNoZero<U32>(Max<U32>(code->var_count, 1));
+        ok = tape.nodes && tape.consts && tape.var_nodes;
+    }
+    if (ok)
+    {
+        for (U32 i = 0; i <= output; i += 1)
+        {
+            if (!live[i]) { continue; }
+            GradNode node = nodes[i];
+            if (node.op != GradOp::CONST && node.op != GradOp::VAR)
+            {
+                node.a = remap[node.a];
+                node.b = node.op == GradOp::NEG ? 0 : remap[node.b];
+            }
+            remap[i] = tape.count;
+            tape.nodes[tape.count++] = node;
+        }
+        if (code->const_count) { MemoryCopy(tape.consts, code->consts, sizeof(F64) * code->const_count); }
+        tape.const_count = code->const_count;
+        tape.var_count = code->var_count;
+        for (U32 slot = 0; slot < code->var_count; slot += 1)
+        {
+            U32 leaf = var_leaves[slot];
+            tape.var_nodes[slot] = leaf != max_U32 && live[leaf] ? remap[leaf] : max_U32;
+        }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+    if (ok) { *out = tape; }
+    return ok;
+}
+
+//////////////////
+// One point
+
+internal U64 
+GradWorkspaceCount(GradTape const *tape)
+{
+    return (U64)tape->count * 2;
+}
+
+internal F64 
+GradEval(GradTape const *tape, F64 const *vars, F64 *grad, F64 *workspace)
+{
+    GradNode const *nodes = tape->nodes;
+    U32 count = tape->count;
+    F64 *value = workspace;
+    F64 *adjoint = workspace + count;
+
+    for (U32 i = 0; i < count; i += 1)
+    {
+        GradNode node = nodes[i];
+        switch (node.op)
+        {
+            case GradOp::CONST: value[i] = tape->consts[node.a]; break;
+            case GradOp::VAR:   value[i] = vars[node.a]; break;
+            case GradOp::NEG:   value[i] = -value[node.a]; break;
+            case GradOp::ADD:   value[i] = value[node.a] + value[node.b]; break;
+            case GradOp::SUB:   value[i] = value[node.a] - value[node.b]; break;
+            case GradOp::MUL:   value[i] = value[node.a] * value[node.b]; break;
+            case GradOp::DIV:   value[i] = value[node.a] / value[node.b]; break;
+        }
+        adjoint[i] = 0.0;
+    }
+
+    adjoint[count - 1] = 1.0;
+    for (U32 i = count; i-- > 0;)
+    {
+        GradNode node = nodes[i];
+        F64 g = adjoint[i];
+        switch (node.op)
+        {
+            case GradOp::NEG: adjoint[node.a] -= g; break;
+            case GradOp::ADD: adjoint[node.a] += g; adjoint[node.b] += g; break;
+            case GradOp::SUB: adjoint[node.a] += g; adjoint[node.b] -= g; break;
+            case GradOp::MUL: adjoint[node.a] += g * value[node.b]; adjoint[node.b] += g * value[node.a]; break;
+            case GradOp::DIV:
+            {
+                F64 q = g / value[node.b];
+                adjoint[node.a] += q;
+                adjoint[node.b] -= q * value[i];
+            } break;
+            default: break;
+        }
+    }
+
+    for (U32 slot = 0; slot < tape->var_count; slot += 1)
+    {
+        U32 leaf = tape->var_nodes[slot];
+        grad[slot] = leaf == max_U32 ? 0.0 : adjoint[leaf];
+    }
+    return value[count - 1];
+}
+
+//////////////////
+// Columns
+
+internal U64 
+GradBatchWorkspaceCount(GradTape const *tape)
+{
+    return (U64)tape->count * 2 * GRAD_TILE;
+}
+
+// Rows [row, row + n) with n at most GRAD_TILE
+internal void 
+GradEvalTile(GradTape const *tape, F64 const *const *columns, U64 row, U32 n, F64 *out, F64 *const *grads, F64 *workspace)
+{
+    GradNode const *nodes = tape->nodes;
+    U32 count = tape->count;
+    F64 *values = workspace;
+    F64 *adjoints = workspace + (U64)count * GRAD_TILE;
+
+    for (U32 i = 0; i < count; i += 1)
+    {
+        GradNode node = nodes[i];
+        F64 *v = values + (U64)i * GRAD_TILE;
+        if (node.op == GradOp::CONST)
+        {
+            F64 c = tape->consts[node.a];
+            for (U32 r = 0; r < n; r += 1) { v[r] = c; }
+            continue;
+        }
+        if (node.op == GradOp::VAR)
+        {
+            MemoryCopy(v, columns[node.a] + row, sizeof(F64) * n);
+            continue;
+        }
+        F64 const *a = values + (U64)node.a * GRAD_TILE;
+        F64 const *b = values + (U64)node.b * GRAD_TILE;
+        switch (node.op)
+        {
+            case GradOp::NEG:   for (U32 r = 0; r < n; r += 1) { v[r] = -a[r]; } break;
+            case GradOp::ADD:   for (U32 r = 0; r < n; r += 1) { v[r] = a[r] + b[r]; } break;
+            case GradOp::SUB:   for (U32 r = 0; r < n; r += 1) { v[r] = a[r] - b[r]; } break;
+            case GradOp::MUL:   for (U32 r = 0; r < n; r += 1) { v[r] = a[r] * b[r]; } break;
+            case GradOp::DIV:   for (U32 r = 0; r < n; r += 1) { v[r] = a[r] / b[r]; } break;
+            default: break;
+        }
+    }
+
+    MemoryZero(adjoints, sizeof(F64) * GRAD_TILE * count);
+    F64 *top = adjoints + (U64)(count - 1) * GRAD_TILE;
+    for (U32 r = 0; r < n; r += 1) { top[r] = 1.0; }
+    for (U32 i = count; i-- > 0;)
+    {
+        GradNode node = nodes[i];
+        if (node.op == GradOp::CONST || node.op == GradOp::VAR) { continue; }
+        F64 const *g = adjoints + (U64)i * GRAD_TILE;
+        F64 *ga = adjoints + (U64)node.a * GRAD_TILE;
+        F64 *gb = adjoints + (U64)node.b * GRAD_TILE;
+        F64 const *a = values + (U64)node.a * GRAD_TILE;
+        F64 const *b = values + (U64)node.b * GRAD_TILE;
+        F64 const *v = values + (U64)i * GRAD_TILE;
+        switch (node.op)
+        {
+            case GradOp::NEG: for (U32 r = 0; r < n; r += 1) { ga[r] -= g[r]; } break;
+            case GradOp::ADD: for (U32 r = 0; r < n; r += 1) { ga[r] += g[r]; gb[r] += g[r]; } break;
+            case GradOp::SUB: for (U32 r = 0; r < n; r += 1) { ga[r] += g[r]; gb[r] -= g[r]; } break;
+            case GradOp::MUL: for (U32 r = 0; r < n; r += 1) { ga[r] += g[r] * b[r]; gb[r] += g[r] * a[r]; } break;
+            case GradOp::DIV:
+            {
+                for (U32 r = 0; r < n; r += 1)
+                {
+                    F64 q = g[r] / b[r];
+                    ga[r] += q;
+                    gb[r] -= q * v[r];
+                }
+            } break;
+            default: break;
+        }
+    }
+
+    MemoryCopy(out, values + (U64)(count - 1) * GRAD_TILE, sizeof(F64) * n);
+    for (U32 slot = 0; slot < tape->var_count; slot += 1)
+    {
+        U32 leaf = tape->var_nodes[slot];
+        if (leaf == max_U32) { MemoryZero(grads[slot] + row, sizeof(F64) * n); }
+        else                 { MemoryCopy(grads[slot] + row, adjoints + (U64)leaf * GRAD_TILE, sizeof(F64) * n); }
+    }
+}
+
+internal void 
+GradEvalBatch(GradTape const *tape, F64 const *const *columns, U64 rows, F64 *out, F64 *const *grads, F64 *workspace)
+{
+    for (U64 row = 0; row < rows; row += GRAD_TILE)
+    {
+        U32 n = (U32)Min<U64>(GRAD_TILE, rows - row);
+        GradEvalTile(tape, columns, row, n, out + row, grads, workspace);
+    }
+}
@@ -0,0 +1,65 @@
+/*
+eval_grad.hpp
+
+Reverse mode differentiation of compiled bytecode: the value and every partial
+derivative at a point for a few evaluations' work, however many variables
+there are, where one symbolic derivative per variable costs vars times that.
+
+GradTapeFromBytecode replays the stack code once into a tape of single
+assignment nodes, one per value the program computes: a fused instruction
+splits into its leaf and its operation, a LOAD refers back to the node that was
+stored, constants and variables get one leaf each, and nodes the result does
+not depend on (other roots of a batch) are dropped. Evaluating runs the tape
+forward recording every node's value, then backward accumulating adjoints from
+the result; a variable's partial derivative is the adjoint of its leaf.
+
+GradEvalBatch does both sweeps a tile of rows at a time, with every value and
+adjoint a tile of its own, so each node is dispatched once per tile and its
+loops run over rows.
+*/
+#ifndef EVAL_GRAD_HPP
+#define EVAL_GRAD_HPP
+
+#define GRAD_TILE 64                // rows, a tape of n nodes takes 2n tiles of workspace
+
+enum class GradOp : U8 
+{
+    CONST,      // consts[a]
+    VAR,        // vars[a]
+    NEG,        // operands are node indices, always below the node's own
+    ADD, SUB, MUL, DIV,
+};
+
+struct GradNode 
+{
+    GradOp op;
+    U32 a;
+    U32 b;
+};
+
+struct GradTape 
+{
+    GradNode *nodes;        // the result is the last one
+    U32 count;
+    F64 *consts;
+    U32 const_count;
+    U32 var_count;          // the bytecode's slots
+    U32 *var_nodes;         // slot -> leaf, max_U32 when the result doesn't use it
+};
+
+// Tape for the value code returns: its root, or the last root of batch compiled
+// code. Everything in out lives in arena. 0 when an arena runs out.
+internal B32 GradTapeFromBytecode(Arena *arena, Arena *scratch, Bytecode const *code, GradTape *out);
+
+// F64s of workspace GradEval needs
+internal U64 GradWorkspaceCount(GradTape const *tape);
+// vars is indexed by slot like BytecodeEval, grad gets var_count partial derivatives
+internal F64 GradEval(GradTape const *tape, F64 const *vars, F64 *grad, F64 *workspace);
+
+// F64s of workspace GradEvalBatch needs
+internal U64 GradBatchWorkspaceCount(GradTape const *tape);
+// columns[slot] holds rows values of variable slot. out gets rows results and
+// grads[slot] rows partial derivatives by that variable.
+internal void GradEvalBatch(GradTape const *tape, F64 const *const *columns, U64 rows, F64 *out, F64 *const *grads, F64 *workspace);
+
+#endif // EVAL_GRAD_HPP
@@ -0,0 +1,5 @@
+#include "eval_bytecode.cpp"
+#include "eval_batch.cpp"
+#include "eval_grad.cpp"
+#include "eval_columns.cpp"
+#include "eval_jit.cpp"
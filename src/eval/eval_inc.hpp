@@ -0,0 +1,10 @@
+#ifndef EVAL_INC_HPP
+#define EVAL_INC_HPP
+
+#include "eval_bytecode.hpp"
+#include "eval_batch.hpp"
+#include "eval_grad.hpp"
+#include "eval_columns.hpp"
+#include "eval_jit.hpp"
+
+#endif // EVAL_INC_HPP
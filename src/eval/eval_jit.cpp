@@ -0,0 +1,307 @@
+//////////////////
+// Target
+
+// Argument registers and how many xmm registers values may use. The register
+// after the last allocatable one is scratch for spilled values.
+#if defined(_WIN32)
+#define JIT_ARG_VARS   1    // rcx
+#define JIT_ARG_CONSTS 2    // rdx
+#define JIT_ARG_SPILL  8    // r8
+#define JIT_REGISTERS  5    // xmm0-4, xmm6 and up are callee saved
+#else
+#define JIT_ARG_VARS   7    // rdi
+#define JIT_ARG_CONSTS 6    // rsi
+#define JIT_ARG_SPILL  2    // rdx
+#define JIT_REGISTERS  15   // xmm0-14
+#endif
+#define JIT_SCRATCH JIT_REGISTERS
+#define JIT_NO_REG 16
+
+#define JIT_MAX_INST_BYTES 32       // spilled binary op: load, op, store
+#define JIT_HEADER_BYTES 16         // sign mask for NEG, 16 byte aligned for xorpd
+
+//////////////////
+// Encoder
+
+enum class JitRm : U8 
+{
+    REG,        // rm is an xmm register
+    MEM,        // [rm + disp32], rm a general register
+    RIP,        // [rip + disp32], disp is the target address
+};
+
+struct JitAsm 
+{
+    U8 *at;
+    B32 avx;
+};
+
+// One SSE2 instruction with a legacy prefix (0x66 or 0xF2) and an 0F opcode,
+// or its VEX form where src1 is the extra source (JIT_NO_REG for none)
+internal void 
+JitEmit(JitAsm *a, U8 prefix, U8 opcode, U32 reg, U32 src1, JitRm kind, U32 rm, U8 const *target = nullptr, S32 disp = 0)
+{
+    U8 *at = a->at;
+    U32 b = kind == JitRm::RIP ? 0 : (rm >> 3) & 1;
+    U32 r = (reg >> 3) & 1;
+    if (a->avx)
+    {
+        U32 pp = prefix == 0x66 ? 1 : 3;
+        U32 v = src1 == JIT_NO_REG ? 0 : src1;
+        *at++ = 0xC4;
+        *at++ = (U8)(((r ^ 1) << 7) | (1 << 6) | ((b ^ 1) << 5) | 0x01);
+        *at++ = (U8)((((~v) & 15) << 3) | pp);
+    }
+    else
+    {
+        *at++ = prefix;
+        if (r || b) { *at++ = (U8)(0x40 | (r << 2) | b); }
+        *at++ = 0x0F;
+    }
+    *at++ = opcode;
+    switch (kind)
+    {
+        case JitRm::REG: { *at++ = (U8)(0xC0 | ((reg & 7) << 3) | (rm & 7)); } break;
+        case JitRm::MEM: { *at++ = (U8)(0x80 | ((reg & 7) << 3) | (rm & 7)); MemoryCopy(at, &disp, 4); at += 4; } break;
+        case JitRm::RIP:
+        {
+            *at++ = (U8)(((reg & 7) << 3) | 5);
+            S32 rel = (S32)(target - (at + 4));
+            MemoryCopy(at, &rel, 4);
+            at += 4;
+        } break;
+    }
+    a->at = at;
+}
+
+#define JIT_MOVSD_LOAD  0x10
+#define JIT_MOVSD_STORE 0x11
+#define JIT_MOVAPD      0x28
+#define JIT_XORPD       0x57
+
+internal U8 
+JitArithOpcode(BcOp op)
+{
+    switch (op)
+    {
+        case BcOp::ADD: case BcOp::ADD_CONST: case BcOp::ADD_VAR: return 0x58;
+        case BcOp::MUL: case BcOp::MUL_CONST: case BcOp::MUL_VAR: return 0x59;
+        case BcOp::SUB: case BcOp::SUB_CONST: case BcOp::SUB_VAR: return 0x5C;
+        default:                                                  return 0x5E;
+    }
+}
+
+//////////////////
+// Compiler
+
+// A value lives from the instruction that pushes it to the one that pops it
+struct JitValue 
+{
+    U32 start;
+    U32 end;
+    U32 depth;      // stack slot, doubles as the spill slot
+    S32 reg;        // -1 when spilled
+};
+
+internal void 
+JitLoad(JitAsm *a, JitValue const *dst, U32 base, U32 index)
+{
+    S32 disp = (S32)(index * sizeof(F64));
+    if (dst->reg >= 0)
+    {
+        JitEmit(a, 0xF2, JIT_MOVSD_LOAD, (U32)dst->reg, JIT_NO_REG, JitRm::MEM, base, nullptr, disp);
+        return;
+    }
+    JitEmit(a, 0xF2, JIT_MOVSD_LOAD, JIT_SCRATCH, JIT_NO_REG, JitRm::MEM, base, nullptr, disp);
+    JitEmit(a, 0xF2, JIT_MOVSD_STORE, JIT_SCRATCH, JIT_NO_REG, JitRm::MEM, JIT_ARG_SPILL, nullptr, (S32)(dst->depth * sizeof(F64)));
+}
+
+// dst = dst op operand, where operand is a register or memory
+internal void 
+JitArith(JitAsm *a, U8 prefix, U8 opcode, JitValue const *dst, JitRm kind, U32 rm, U8 const *target, S32 disp)
+{
+    if (dst->reg >= 0)
+    {
+        JitEmit(a, prefix, opcode, (U32)dst->reg, (U32)dst->reg, kind, rm, target, disp);
+        return;
+    }
+    S32 home = (S32)(dst->depth * sizeof(F64));
+    JitEmit(a, 0xF2, JIT_MOVSD_LOAD, JIT_SCRATCH, JIT_NO_REG, JitRm::MEM, JIT_ARG_SPILL, nullptr, home);
+    JitEmit(a, prefix, opcode, JIT_SCRATCH, JIT_SCRATCH, kind, rm, target, disp);
+    JitEmit(a, 0xF2, JIT_MOVSD_STORE, JIT_SCRATCH, JIT_NO_REG, JitRm::MEM, JIT_ARG_SPILL, nullptr, home);
+}
+
+// Poletto and Sarkar: values arrive in start order, when every register is taken
+// the value that lives longest goes to memory. Returns the spill count.
+internal U32 
+JitAllocateRegisters(JitValue *values, U32 value_count)
+{
+    U32 active[JIT_REGISTERS];
+    U32 active_count = 0;
+    U32 free_regs[JIT_REGISTERS];
+    U32 free_count = JIT_REGISTERS;
+    for (U32 i = 0; i < JIT_REGISTERS; i += 1) { free_regs[i] = JIT_REGISTERS - 1 - i; }
+
+    U32 spills = 0;
+    for (U32 v = 0; v < value_count; v += 1)
+    {
+        JitValue *value = &values[v];
+        for (U32 i = 0; i < active_count; )
+        {
+            JitValue *old = &values[active[i]];
+            if (old->end < value->start)
+            {
+                free_regs[free_count++] = (U32)old->reg;
+                active[i] = active[--active_count];
+            }
+            else { i += 1; }
+        }
+
+        if (free_count)
+        {
+            value->reg = (S32)free_regs[--free_count];
+            active[active_count++] = v;
+            continue;
+        }
+        U32 longest = 0;
+        for (U32 i = 1; i < active_count; i += 1)
+        {
+            if (values[active[i]].end > values[active[longest]].end) { longest = i; }
+        }
+        JitValue *victim = &values[active[longest]];
+        spills += 1;
+        if (victim->end > value->end)
+        {
+            value->reg = victim->reg;
+            victim->reg = -1;
+            active[longest] = v;
+        }
+        else { value->reg = -1; }
+    }
+    return spills;
+}
+
+internal B32 
+JitCompile(Arena *scratch, Bytecode const *code, JitCode *out, B32 allow_avx)
+{
+    *out = {};
+    if (!ARCH_X64) { return 0; }
+
+    // Every displacement has to fit in a disp32
+    U64 widest = Max<U64>(Max<U64>(code->var_count, code->const_count), code->stack_size);
+    if (widest >= (1u << 28) || code->count >= (1u << 26)) { return 0; }
+
+    U64 pos = scratch->ArenaGetPos();
+    U32 *dst = scratch->PushArrayNoZero<U32>(code->count);
+    U32 *src = scratch->PushArrayNoZero<U32>(code->count);
+    JitValue *values = scratch->PushArrayNoZero<JitValue>(code->count);
+    U32 *stack = scratch->PushArrayNoZero<U32>(code->stack_size);
+    if (!dst || !src || !values || !stack) { scratch->ArenaSetPosBack(pos); return 0; }
+
+    // Which value each instruction writes and reads
+    U32 value_count = 0;
+    U32 sp = 0;
+    for (U32 i = 0; i < code->count; i += 1)
+    {
+        BcOp op = code->code[i].op;
+        if (op == BcOp::CONST || op == BcOp::VAR || op == BcOp::LOAD)
+        {
+            values[value_count] = {i, i, sp, -1};
+            stack[sp++] = value_count;
+            dst[i] = value_count++;
+        }
+        else if (op >= BcOp::ADD && op <= BcOp::DIV)
+        {
+            src[i] = stack[--sp];
+            values[src[i]].end = i;
+            dst[i] = stack[sp - 1];
+        }
+        else
+        {
+            dst[i] = stack[sp - 1];
+            if (op == BcOp::RET || op == BcOp::POP) { values[dst[i]].end = i; }
+            if (op == BcOp::POP) { sp -= 1; }
+        }
+    }
+    out->value_count = value_count;
+    out->spill_count = JitAllocateRegisters(values, value_count);
+
+    U64 size = (JIT_HEADER_BYTES + (U64)code->count * JIT_MAX_INST_BYTES + KB(4) - 1) & ~(U64)(KB(4) - 1);
+    U8 *memory = (U8 *)OSAllocExecutable(size);
+    if (!memory) { scratch->ArenaSetPosBack(pos); return 0; }
+
+    U64 sign = 0x8000000000000000ull;
+    MemoryZero(memory, JIT_HEADER_BYTES);
+    MemoryCopy(memory, &sign, sizeof(sign));
+    JitAsm a = {memory + JIT_HEADER_BYTES, allow_avx && CpuHasAVX2()};
+
+    for (U32 i = 0; i < code->count; i += 1)
+    {
+        BcInst inst = code->code[i];
+        JitValue const *value = &values[dst[i]];
+        S32 arg_disp = (S32)(inst.arg * sizeof(F64));
+        switch (inst.op)
+        {
+            case BcOp::CONST: { JitLoad(&a, value, JIT_ARG_CONSTS, inst.arg); } break;
+            case BcOp::VAR:   { JitLoad(&a, value, JIT_ARG_VARS, inst.arg); } break;
+            case BcOp::NEG:   { JitArith(&a, 0x66, JIT_XORPD, value, JitRm::RIP, 0, memory, 0); } break;
+            case BcOp::ADD: case BcOp::SUB: case BcOp::MUL: case BcOp::DIV:
+            {
+                JitValue const *operand = &values[src[i]];
+                if (operand->reg >= 0) { JitArith(&a, 0xF2, JitArithOpcode(inst.op), value, JitRm::REG, (U32)operand->reg, nullptr, 0); }
+                else                   { JitArith(&a, 0xF2, JitArithOpcode(inst.op), value, JitRm::MEM, JIT_ARG_SPILL, nullptr, (S32)(operand->depth * sizeof(F64))); }
+            } break;
+            case BcOp::ADD_CONST: case BcOp::SUB_CONST: case BcOp::MUL_CONST: case BcOp::DIV_CONST:
+            {
+                JitArith(&a, 0xF2, JitArithOpcode(inst.op), value, JitRm::MEM, JIT_ARG_CONSTS, nullptr, arg_disp);
+            } break;
+            case BcOp::ADD_VAR: case BcOp::SUB_VAR: case BcOp::MUL_VAR: case BcOp::DIV_VAR:
+            {
+                JitArith(&a, 0xF2, JitArithOpcode(inst.op), value, JitRm::MEM, JIT_ARG_VARS, nullptr, arg_disp);
+            } break;
+            case BcOp::LOAD: { JitLoad(&a, value, JIT_ARG_SPILL, code->temp_base + inst.arg); } break;
+            case BcOp::STORE:
+            {
+                // Temporaries sit above every spill slot in the same buffer
+                S32 disp = (S32)((code->temp_base + inst.arg) * sizeof(F64));
+                U32 reg = value->reg >= 0 ? (U32)value->reg : JIT_SCRATCH;
+                if (value->reg < 0) { JitEmit(&a, 0xF2, JIT_MOVSD_LOAD, JIT_SCRATCH, JIT_NO_REG, JitRm::MEM, JIT_ARG_SPILL, nullptr, (S32)(value->depth * sizeof(F64))); }
+                JitEmit(&a, 0xF2, JIT_MOVSD_STORE, reg, JIT_NO_REG, JitRm::MEM, JIT_ARG_SPILL, nullptr, disp);
+            } break;
+            case BcOp::POP: break;
+            default:
+            {
+                // Result in xmm0
+                if (value->reg < 0)      { JitEmit(&a, 0xF2, JIT_MOVSD_LOAD, 0, JIT_NO_REG, JitRm::MEM, JIT_ARG_SPILL, nullptr, (S32)(value->depth * sizeof(F64))); }
+                else if (value->reg > 0) { JitEmit(&a, 0x66, JIT_MOVAPD, 0, JIT_NO_REG, JitRm::REG, (U32)value->reg); }
+                *a.at++ = 0xC3;
+            } break;
+        }
+    }
+    scratch->ArenaSetPosBack(pos);
+
+    if (!OSProtectExecutable(memory, size))
+    {
+        OSFreeExecutable(memory, size);
+        return 0;
+    }
+    out->memory = memory;
+    out->size = size;
+    out->avx = a.avx;
+    out->func = (JitFunc *)(void *)(memory + JIT_HEADER_BYTES);
+    return 1;
+}
+
+internal void 
+JitRelease(JitCode *jit)
+{
+    OSFreeExecutable(jit->memory, jit->size);
+    *jit = {};
+}
+
+internal F64 
+JitEval(JitCode const *jit, Bytecode const *code, F64 const *vars, F64 *stack)
+{
+    if (jit->func) { return jit->func(vars, code->consts, stack); }
+    return BytecodeEval(code, vars, stack);
+}
@@ -0,0 +1,33 @@
+/*
+eval_jit.hpp
+
+Bytecode compiled to native x86-64 scalar double code. The stack values the
+bytecode implies get xmm registers by linear scan, and the ones that lose out
+live in the caller's stack buffer, as do the bytecode's temporaries. The code
+is SSE2, with VEX encoded forms when the CPU has AVX. On other targets, or when
+something doesn't fit, compilation fails and JitEval runs the interpreter instead.
+*/
+#ifndef EVAL_JIT_HPP
+#define EVAL_JIT_HPP
+
+typedef F64 JitFunc(F64 const *vars, F64 const *consts, F64 *spill);
+
+struct JitCode 
+{
+    JitFunc *func;          // null when falling back to the interpreter
+    U8 *memory;             // executable pages
+    U64 size;
+    U32 value_count;        // stack values in the bytecode
+    U32 spill_count;        // of those, how many live in memory
+    B32 avx;
+};
+
+// 0 when the code can't be compiled natively, out is then still usable with JitEval.
+// The code refers to nothing in scratch or code when done.
+internal B32 JitCompile(Arena *scratch, Bytecode const *code, JitCode *out, B32 allow_avx = 1);
+internal void JitRelease(JitCode *jit);
+
+// Same contract as BytecodeEval, code must be the one jit was compiled from
+internal F64 JitEval(JitCode const *jit, Bytecode const *code, F64 const *vars, F64 *stack);
+
+#endif // EVAL_JIT_HPP
@@ -0,0 +1,106 @@
+internal void 
+JobDrain(JobSystem *jobs, JobFunc *func, void *data, U64 count, U32 worker)
+{
+    for (;;)
+    {
+        U64 index = jobs->next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= count) { break; }
+        func(data, index, worker);
+    }
+}
+
+internal void 
+JobWorkerMain(JobSystem *jobs, U32 worker)
+{
+    U64 seen = 0;
+    for (;;)
+    {
+        JobFunc *func;
+        void *data;
+        U64 count;
+        {
+            std::unique_lock<std::mutex> lock(jobs->mutex);
+            jobs->wake.wait(lock, [&] { return jobs->quit || jobs->generation != seen; });
+            if (jobs->quit) { return; }
+            seen = jobs->generation;
+            func = jobs->func;
+            data = jobs->data;
+            count = jobs->count;
+        }
+
+        JobDrain(jobs, func, data, count, worker);
+
+        std::lock_guard<std::mutex> lock(jobs->mutex);
+        jobs->running -= 1;
+        if (jobs->running == 0) { jobs->finished.notify_one(); }
+    }
+}
+
+internal JobSystem *
+JobSystemCreate(U32 worker_count, U64 scratch_size)
+{
+    if (worker_count == 0) { worker_count = Max<U32>(1, std::thread::hardware_concurrency()); }
+
+    JobSystem *jobs = new JobSystem();
+    jobs->worker_count = worker_count;
+    jobs->scratch = new Arena *[worker_count];
+    for (U32 i = 0; i < worker_count; i += 1) { jobs->scratch[i] = new Arena(scratch_size); }
+
+    jobs->threads = new std::thread[worker_count - 1];
+    for (U32 i = 1; i < worker_count; i += 1)
+    {
+        jobs->threads[i - 1] = std::thread(JobWorkerMain, jobs, i);
+    }
+    return jobs;
+}
+
+internal void 
+JobSystemDestroy(JobSystem *jobs)
+{
+    {
+        std::lock_guard<std::mutex> lock(jobs->mutex);
+        jobs->quit = 1;
+    }
+    jobs->wake.notify_all();
+    for (U32 i = 1; i < jobs->worker_count; i += 1) { jobs->threads[i - 1].join(); }
+
+    for (U32 i = 0; i < jobs->worker_count; i += 1) { delete jobs->scratch[i]; }
+    delete[] jobs->scratch;
+    delete[] jobs->threads;
+    delete jobs;
+}
+
+internal void 
+JobParallelFor(JobSystem *jobs, U64 count, JobFunc *func, void *data)
+{
+    if (count == 0) { return; }
+
+    // Not worth waking anyone for a single index
+    if (jobs->worker_count == 1 || count == 1)
+    {
+        for (U64 i = 0; i < count; i += 1) { func(data, i, 0); }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobs->mutex);
+        jobs->func = func;
+        jobs->data = data;
+        jobs->count = count;
+        jobs->next.store(0, std::memory_order_relaxed);
+        jobs->running = jobs->worker_count - 1;
+        jobs->generation += 1;
+    }
+    jobs->wake.notify_all();
+
+    JobDrain(jobs, func, data, count, 0);
+
+    std::unique_lock<std::mutex> lock(jobs->mutex);
+    jobs->finished.wait(lock, [&] { return jobs->running == 0; });
+}
+
+internal Arena *
+JobScratch(JobSystem *jobs, U32 worker)
+{
+    return jobs->scratch[worker];
+}
@@ -0,0 +1,48 @@
+/*
+job_core.hpp
+
+Minimal job system: a fixed pool of worker threads running parallel-for batches.
+The calling thread joins in as worker 0, so a pool of one worker is just a loop.
+Each worker owns a scratch arena, indexed by the worker id handed to the job.
+*/
+#ifndef JOB_CORE_HPP
+#define JOB_CORE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Called once per index in [0, count), worker is in [0, worker_count)
+typedef void JobFunc(void *data, U64 index, U32 worker);
+
+struct JobSystem 
+{
+    U32 worker_count;
+    std::thread *threads;           // worker_count - 1, the caller is worker 0
+    Arena **scratch;                // one per worker
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    U64 generation;                 // bumped for every batch
+    U32 running;                    // threads still inside the current batch
+    B32 quit;
+
+    JobFunc *func;
+    void *data;
+    U64 count;
+    std::atomic<U64> next;
+};
+
+// worker_count 0 means one per hardware thread
+internal JobSystem *JobSystemCreate(U32 worker_count, U64 scratch_size);
+internal void JobSystemDestroy(JobSystem *jobs);
+
+// Blocks until func has run for every index. Indices are handed out one at a time,
+// so make each one a decent chunk of work.
+internal void JobParallelFor(JobSystem *jobs, U64 count, JobFunc *func, void *data);
+
+internal Arena *JobScratch(JobSystem *jobs, U32 worker);
+
+#endif // JOB_CORE_HPP
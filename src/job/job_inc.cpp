@@ -0,0 +1 @@
+#include "job_core.cpp"
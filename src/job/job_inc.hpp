@@ -0,0 +1,6 @@
+#ifndef JOB_INC_HPP
+#define JOB_INC_HPP
+
+#include "job_core.hpp"
+
+#endif // JOB_INC_HPP
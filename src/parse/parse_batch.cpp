@@ -0,0 +1,108 @@
+#define PARSE_BATCH_JOB_BYTES KB(64)
+
+struct ParseBatchJobs 
+{
+    String8 *sources;
+    U64 *job_first;         // first source of each job, one past the end at [job_count]
+    Expr **roots;
+    ParseError *errors;
+    Arena **arenas;
+    JobSystem *jobs;
+    ParseParams params;
+    std::atomic<U64> error_count;
+};
+
+internal void 
+ParseBatchJob(void *data, U64 index, U32 worker)
+{
+    ParseBatchJobs *batch = (ParseBatchJobs *)data;
+    Arena *arena = batch->arenas[worker];
+    Arena *scratch = JobScratch(batch->jobs, worker);
+
+    U64 errors = 0;
+    for (U64 i = batch->job_first[index]; i < batch->job_first[index + 1]; i += 1)
+    {
+        ParseResult res = Parse(arena, scratch, batch->sources[i], &batch->params);
+        batch->roots[i] = res.root;
+        batch->errors[i] = res.error;
+        errors += res.error.code != ParseErrorCode::NONE;
+    }
+    if (errors) { batch->error_count.fetch_add(errors, std::memory_order_relaxed); }
+}
+
+internal ParseBatchResult 
+ParseBatch(JobSystem *jobs, Arena *arena, Arena **worker_arenas, String8 *sources, U64 count, ParseParams const *params)
+{
+    ParseBatchResult result = {};
+    result.roots = arena->PushArrayNoZero<Expr *>(Max<U64>(count, 1));
+    result.errors = arena->PushArrayNoZero<ParseError>(Max<U64>(count, 1));
+    if (!result.roots || !result.errors || count == 0) { return result; }
+    result.count = count;
+
+    // Group neighbouring sources into jobs of roughly PARSE_BATCH_JOB_BYTES,
+    // one index per expression would spend more time on the atomic than parsing
+    Arena *scratch = JobScratch(jobs, 0);
+    U64 pos = scratch->ArenaGetPos();
+    U64 job_count = 0, job_cap = 0;
+    U64 *job_first = nullptr;
+    U64 bytes = 0;
+    for (U64 i = 0; i <= count; i += 1)
+    {
+        if (i == 0 || i == count || bytes >= PARSE_BATCH_JOB_BYTES)
+        {
+            if (job_count == job_cap)
+            {
+                job_first = ArenaGrowArray(scratch, job_first, job_count, &job_cap);
+                if (!job_first) { result.count = 0; return result; }
+            }
+            job_first[job_count++] = i;
+            bytes = 0;
+        }
+        if (i < count) { bytes += sources[i].size + 16; }
+    }
+
+    ParseBatchJobs batch = {};
+    batch.sources = sources;
+    batch.job_first = job_first;
+    batch.roots = result.roots;
+    batch.errors = result.errors;
+    batch.arenas = worker_arenas;
+    batch.jobs = jobs;
+    if (params) { batch.params = *params; }
+    batch.error_count.store(0);
+    JobParallelFor(jobs, job_count - 1, ParseBatchJob, &batch);
+
+    result.error_count = batch.error_count.load();
+    scratch->ArenaSetPosBack(pos);
+    return result;
+}
+
+internal String8 
+ParseErrorFormat(Arena *arena, String8 source, ParseError error)
+{
+    U64 offset = ClampTop(error.offset, source.size);
+
+    // The line holding the offset, sources are usually one line anyway
+    U64 line_first = offset;
+    while (line_first > 0 && source.str[line_first - 1] != '\n') { line_first -= 1; }
+    U64 line_opl = offset;
+    while (line_opl < source.size && source.str[line_opl] != '\n' && source.str[line_opl] != '\r') { line_opl += 1; }
+    String8 line = Str8Substr(source, line_first, line_opl);
+    U64 column = offset - line_first;
+
+    char const *message = ParseErrorCodeString(error.code);
+    int header = snprintf(nullptr, 0, "offset %llu: %s\n", (unsigned long long)error.offset, message);
+    U64 size = (U64)header + line.size + 1 + column + 1;
+
+    U8 *str = arena->PushArrayNoZero<U8>(size + 1);
+    if (!str) { return Str8(nullptr, 0); }
+    snprintf((char *)str, (size_t)header + 1, "offset %llu: %s\n", (unsigned long long)error.offset, message);
+    U8 *at = str + header;
+    MemoryCopy(at, line.str, line.size);
+    at += line.size;
+    *at++ = '\n';
+    for (U64 i = 0; i < column; i += 1) { *at++ = source.str[line_first + i] == '\t' ? '\t' : ' '; }
+    *at++ = '^';
+    *at = 0;
+    return Str8(str, size);
+}
@@ -0,0 +1,27 @@
+/*
+parse_batch.hpp
+
+Many independent expressions parsed across the job system. Each worker parses
+into its own arena, results come back as flat arrays indexed like the input.
+Failures are {code, offset} records, text is only produced by ParseErrorFormat.
+*/
+#ifndef PARSE_BATCH_HPP
+#define PARSE_BATCH_HPP
+
+struct ParseBatchResult 
+{
+    U64 count;
+    Expr **roots;           // [count], nullptr where parsing failed
+    ParseError *errors;     // [count], code NONE where parsing succeeded
+    U64 error_count;
+};
+
+// roots/errors are pushed into arena, nodes go into worker_arenas[worker]
+// (jobs->worker_count of them). All must outlive the results.
+internal ParseBatchResult ParseBatch(JobSystem *jobs, Arena *arena, Arena **worker_arenas, String8 *sources, U64 count,
+                                     ParseParams const *params = nullptr);
+
+// "offset 6: missing ')'" followed by the source line and a caret under the offset
+internal String8 ParseErrorFormat(Arena *arena, String8 source, ParseError error);
+
+#endif // PARSE_BATCH_HPP
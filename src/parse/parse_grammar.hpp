@@ -0,0 +1,380 @@
+/*
+parse_grammar.hpp
+
+The expression grammar as constexpr tables, plus the token stream and the shunting-yard
+driver over them, shared by every parser that accepts our syntax so they cannot drift
+apart. Nothing here allocates or touches globals: Parse and DSP_EXPR each instantiate
+GrammarParse with a builder that owns the nodes and the frame stack.
+
+Binding powers and the implicit multiplication rule are carried over from old/parser.hpp.
+*/
+#ifndef PARSE_GRAMMAR_HPP
+#define PARSE_GRAMMAR_HPP
+
+enum class TokenKind : U8 
+{
+    PLUS,           // '+'
+    MINUS,          // '-'
+    MULT,           // '*'
+    DIV,            // '/'
+    PRE_MINUS,      // '-{expression}', never lexed, the parser rewrites MINUS in operand position
+    IMPLICIT_MULT,  // inserted between 2x, 2(...) and x(...)
+    INT,            // '42'
+    SYMBOL,         // variables, e.g. the x in '2x'
+    LPAREN,         // '('
+    RPAREN,         // ')'
+    ILLEGAL,        // unrecognised input
+    EOL,            // end of input, or '$'
+};
+
+// Precedence levels (binding powers)
+constexpr int LOWEST = 0;
+constexpr int ADDITIVE = 10;
+constexpr int MULTIPLICATIVE = 20;
+constexpr int IMPLICIT_MULT = 21;   // > MULTIPLICATIVE, so a/2x is a/(2*x)
+constexpr int UNARY = 30;
+
+//////////////////
+// Character classes
+
+constexpr bool GrammarIsLetter(char ch) { return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z'); }
+constexpr bool GrammarIsDigit(char ch) { return '0' <= ch && ch <= '9'; }
+constexpr bool GrammarIsSpace(char ch) { return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r'; }
+
+// Single character tokens. Letters and digits start SYMBOL/INT runs.
+constexpr TokenKind 
+GrammarCharToken(char ch)
+{
+    switch (ch)
+    {
+        case '+': return TokenKind::PLUS;
+        case '-': return TokenKind::MINUS;
+        case '*': return TokenKind::MULT;
+        case '/': return TokenKind::DIV;
+        case '(': return TokenKind::LPAREN;
+        case ')': return TokenKind::RPAREN;
+        case '$': return TokenKind::EOL;
+        default:
+            if (GrammarIsLetter(ch)) { return TokenKind::SYMBOL; }
+            if (GrammarIsDigit(ch))  { return TokenKind::INT; }
+            return TokenKind::ILLEGAL;
+    }
+}
+
+//////////////////
+// Tokens
+
+struct GrammarToken 
+{
+    TokenKind kind;
+    U64 offset;
+    U64 end;        // one past the last byte, == offset for EOL
+};
+
+// Skips spaces from pos and reads one token, without implicit multiplication
+constexpr GrammarToken 
+GrammarReadToken(char const *str, U64 size, U64 pos)
+{
+    while (pos < size && GrammarIsSpace(str[pos])) { pos += 1; }
+    if (pos >= size) { return {TokenKind::EOL, pos, pos}; }
+
+    GrammarToken tok = {GrammarCharToken(str[pos]), pos, pos + 1};
+    switch (tok.kind)
+    {
+        case TokenKind::INT:
+            while (tok.end < size && GrammarIsDigit(str[tok.end])) { tok.end += 1; }
+            break;
+        case TokenKind::SYMBOL:
+            while (tok.end < size && GrammarIsLetter(str[tok.end])) { tok.end += 1; }
+            break;
+        case TokenKind::EOL:
+            tok.end = pos;  // '$' ends the input, keep returning it
+            break;
+        default:
+            break;
+    }
+    return tok;
+}
+
+//////////////////
+// Operators
+
+// Left binding power of an infix operator, LOWEST for anything that is not one
+constexpr int 
+GrammarInfixPower(TokenKind kind)
+{
+    switch (kind)
+    {
+        case TokenKind::PLUS:
+        case TokenKind::MINUS:         return ADDITIVE;
+        case TokenKind::MULT:
+        case TokenKind::DIV:           return MULTIPLICATIVE;
+        case TokenKind::IMPLICIT_MULT: return IMPLICIT_MULT;
+        default:                       return LOWEST;
+    }
+}
+
+constexpr bool 
+GrammarIsInfix(TokenKind kind)
+{
+    return GrammarInfixPower(kind) != LOWEST;
+}
+
+// 2x, 12x, 2(...) and x(...) multiply. Nothing else does, e.g. (a)(b) and x2 do not.
+constexpr bool 
+GrammarImplicitMult(TokenKind prev, TokenKind next)
+{
+    return (prev == TokenKind::INT && next == TokenKind::SYMBOL) ||
+           ((prev == TokenKind::INT || prev == TokenKind::SYMBOL) && next == TokenKind::LPAREN);
+}
+
+constexpr ExprKind 
+GrammarInfixExprKind(TokenKind kind)
+{
+    switch (kind)
+    {
+        case TokenKind::PLUS:          return ExprKind::PLUS;
+        case TokenKind::MINUS:         return ExprKind::DIFFERENCE;
+        case TokenKind::DIV:           return ExprKind::QUOTIENT;
+        default:                       return ExprKind::MULTIPLY;  // MULT, IMPLICIT_MULT
+    }
+}
+
+//////////////////
+// Token stream
+// IMPLICIT_MULT is inserted ahead of the token that calls for it, which is held back until the next call
+
+struct GrammarLexer 
+{
+    char const *str;
+    U64 size;
+    U64 position;
+    TokenKind prev;         // kind of the last token handed out
+    bool has_held;
+    GrammarToken held;      // real token queued behind an inserted IMPLICIT_MULT
+};
+
+constexpr GrammarLexer 
+GrammarLexerInit(char const *str, U64 size)
+{
+    return {str, size, 0, TokenKind::EOL, false, {}};
+}
+
+constexpr GrammarToken 
+GrammarNextToken(GrammarLexer *lexer)
+{
+    GrammarToken tok = lexer->held;
+    if (lexer->has_held)
+    {
+        lexer->has_held = false;
+    }
+    else
+    {
+        tok = GrammarReadToken(lexer->str, lexer->size, lexer->position);
+        lexer->position = tok.end;
+        if (GrammarImplicitMult(lexer->prev, tok.kind))
+        {
+            lexer->held = tok;
+            lexer->has_held = true;
+            tok.kind = TokenKind::IMPLICIT_MULT;
+            tok.end = tok.offset;
+        }
+    }
+
+    lexer->prev = tok.kind;
+    return tok;
+}
+
+//////////////////
+// Errors
+
+enum class ParseErrorCode : U8 
+{
+    NONE,
+    ILLEGAL_CHARACTER,
+    EXPECTED_OPERAND,       // e.g. "1+" or "*2"
+    UNEXPECTED_TOKEN,       // e.g. "(a)(b)" or "x2", no implicit multiplication there
+    MISSING_RPAREN,
+    UNMATCHED_RPAREN,
+    NUMBER_OVERFLOW,        // integer literal does not fit in S64, DSP_EXPR only
+    TOO_DEEP,               // nesting exceeded ParseParams::max_depth
+    OUT_OF_MEMORY,
+    COUNT,
+};
+
+constexpr char const *
+ParseErrorCodeString(ParseErrorCode code)
+{
+    switch (code)
+    {
+        case ParseErrorCode::NONE:              return "no error";
+        case ParseErrorCode::ILLEGAL_CHARACTER: return "illegal character";
+        case ParseErrorCode::EXPECTED_OPERAND:  return "expected a number, variable, '-' or '('";
+        case ParseErrorCode::UNEXPECTED_TOKEN:  return "unexpected token, expected an operator";
+        case ParseErrorCode::MISSING_RPAREN:    return "missing ')'";
+        case ParseErrorCode::UNMATCHED_RPAREN:  return "')' without matching '('";
+        case ParseErrorCode::NUMBER_OVERFLOW:   return "integer literal too large";
+        case ParseErrorCode::TOO_DEEP:          return "expression nested too deeply";
+        case ParseErrorCode::OUT_OF_MEMORY:     return "out of memory";
+        default:                                return "unknown error";
+    }
+}
+
+//////////////////
+// Shunting-yard driver
+/*
+GrammarParse is the Pratt loop of old/parser.cpp with explicit stacks:
+    expecting an operand: numbers/variables become the current value, '-' and '(' push a frame (the NUDs)
+    expecting an operator: reduce while the pending operator binds at least as tightly,
+                           then push it (the LEDs, left associative like the recursive version)
+
+PLUS/MULTIPLY chains are flattened on the way: the left operand of a '+' that is
+itself an open PLUS takes the right operand as one more child, so a+b+c is one node.
+A parenthesised sum stays open, (a+b)+c flattens the same way.
+
+What gets built is up to the builder, which provides:
+    using Value;                                        operand handle, value-initialised when unused
+    GrammarFrame<Value> *frames; U64 frame_count;       the pending operators
+    GrammarFrame<Value> *PushFrame(U64 offset);         nullptr on failure
+    bool Number(GrammarToken tok, Value *out);
+    bool Variable(GrammarToken tok, Value *out);
+    bool Close(Value *v, U64 offset);                   makes an open PLUS/MULTIPLY final
+    bool Negate(Value operand, U64 offset, Value *out);
+    bool Binary(ExprKind kind, Value left, Value right, U64 offset, Value *out);
+    bool IsOpen(Value v, ExprKind kind);                open PLUS/MULTIPLY of that kind
+    bool Open(ExprKind kind, Value first, U64 offset, Value *out);
+    bool Append(Value *list, Value operand, U64 offset);
+    bool Fail(ParseErrorCode code, U64 offset);         returns false
+Anything returning false has recorded why, the driver just stops.
+*/
+
+// Pending operator, '(' or prefix '-'. Binary operators carry their left operand,
+// the right one is the driver's current value when the frame is reduced.
+template <class Value>
+struct GrammarFrame 
+{
+    Value left;
+    U64 offset;
+    int power;
+    TokenKind kind;
+    ExprKind expr_kind;     // what reducing it builds, resolved once at push
+};
+
+template <class Builder>
+constexpr bool 
+GrammarPushFrame(Builder &b, TokenKind kind, int power, ExprKind expr_kind, typename Builder::Value left, U64 offset)
+{
+    GrammarFrame<typename Builder::Value> *frame = b.PushFrame(offset);
+    if (!frame) { return false; }
+    frame->left = left;
+    frame->offset = offset;
+    frame->power = power;
+    frame->kind = kind;
+    frame->expr_kind = expr_kind;
+    return true;
+}
+
+// Pops the top frame and applies it to the current value
+template <class Builder>
+constexpr bool 
+GrammarReduce(Builder &b, typename Builder::Value *cur)
+{
+    GrammarFrame<typename Builder::Value> frame = b.frames[--b.frame_count];
+
+    if (!b.Close(cur, frame.offset)) { return false; }
+    if (frame.kind == TokenKind::PRE_MINUS) { return b.Negate(*cur, frame.offset, cur); }
+
+    typename Builder::Value left = frame.left;
+    if (!ExprKindIsNary(frame.expr_kind))
+    {
+        return b.Close(&left, frame.offset) && b.Binary(frame.expr_kind, left, *cur, frame.offset, cur);
+    }
+
+    // Same kind on the left: keep appending, a+b+c stays one node
+    if (!b.IsOpen(left, frame.expr_kind))
+    {
+        if (!b.Close(&left, frame.offset) || !b.Open(frame.expr_kind, left, frame.offset, &left)) { return false; }
+    }
+    if (!b.Append(&left, *cur, frame.offset)) { return false; }
+    *cur = left;
+    return true;
+}
+
+template <class Builder>
+constexpr bool 
+GrammarParse(Builder &b, char const *str, U64 size, typename Builder::Value *out)
+{
+    using Value = typename Builder::Value;
+
+    GrammarLexer lexer = GrammarLexerInit(str, size);
+    Value cur = {};
+    bool expect_operand = true;
+    for (;;)
+    {
+        GrammarToken tok = GrammarNextToken(&lexer);
+        if (tok.kind == TokenKind::ILLEGAL) { return b.Fail(ParseErrorCode::ILLEGAL_CHARACTER, tok.offset); }
+
+        if (expect_operand)
+        {
+            bool ok = false;
+            switch (tok.kind)
+            {
+                case TokenKind::INT:    ok = b.Number(tok, &cur); expect_operand = false; break;
+                case TokenKind::SYMBOL: ok = b.Variable(tok, &cur); expect_operand = false; break;
+                case TokenKind::MINUS:
+                    ok = GrammarPushFrame(b, TokenKind::PRE_MINUS, UNARY, ExprKind::PRE_UNARY_MINUS, Value{}, tok.offset);
+                    break;
+                case TokenKind::LPAREN:
+                    ok = GrammarPushFrame(b, TokenKind::LPAREN, LOWEST, ExprKind::COUNT, Value{}, tok.offset);
+                    break;
+                default:
+                    ok = b.Fail(ParseErrorCode::EXPECTED_OPERAND, tok.offset);
+                    break;
+            }
+            if (!ok) { return false; }
+            continue;
+        }
+
+        // ')' and end of input close everything down to the nearest '(' (which sits at LOWEST)
+        int power = GrammarInfixPower(tok.kind);
+        bool infix = power != LOWEST;
+        if (!infix)
+        {
+            if (tok.kind != TokenKind::RPAREN && tok.kind != TokenKind::EOL)
+            {
+                return b.Fail(ParseErrorCode::UNEXPECTED_TOKEN, tok.offset);
+            }
+            power = LOWEST + 1;
+        }
+
+        while (b.frame_count && b.frames[b.frame_count - 1].power >= power)
+        {
+            if (!GrammarReduce(b, &cur)) { return false; }
+        }
+
+        if (infix)
+        {
+            if (!GrammarPushFrame(b, tok.kind, power, GrammarInfixExprKind(tok.kind), cur, tok.offset)) { return false; }
+            expect_operand = true;
+        }
+        else if (tok.kind == TokenKind::RPAREN)
+        {
+            if (!b.frame_count) { return b.Fail(ParseErrorCode::UNMATCHED_RPAREN, tok.offset); }
+            b.frame_count -= 1;
+        }
+        else if (b.frame_count)
+        {
+            return b.Fail(ParseErrorCode::MISSING_RPAREN, tok.offset);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (!b.Close(&cur, size)) { return false; }
+    *out = cur;
+    return true;
+}
+
+#endif // PARSE_GRAMMAR_HPP
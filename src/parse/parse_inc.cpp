@@ -0,0 +1,5 @@
+#include "parse_lexer.cpp"
+#include "parse_parser.cpp"
+#include "parse_parallel.cpp"
+#include "parse_batch.cpp"
+#include "parse_rules.cpp"
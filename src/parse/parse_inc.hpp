@@ -0,0 +1,12 @@
+#ifndef PARSE_INC_HPP
+#define PARSE_INC_HPP
+
+#include "parse_grammar.hpp"
+#include "parse_lexer.hpp"
+#include "parse_parser.hpp"
+#include "parse_parallel.hpp"
+#include "parse_batch.hpp"
+#include "parse_rules.hpp"
+#include "parse_static.hpp"
+
+#endif // PARSE_INC_HPP
@@ -0,0 +1,25 @@
+internal Lexer 
+LexerInit(String8 input)
+{
+    Lexer lexer = {};
+    lexer.input = input;
+    lexer.grammar = GrammarLexerInit((char const *)input.str, input.size);
+    return lexer;
+}
+
+internal Token 
+LexerNext(Lexer *lexer)
+{
+    GrammarToken next = GrammarNextToken(&lexer->grammar);
+    Token tok = {};
+    tok.offset = next.offset;
+    tok.size = (U32)(next.end - next.offset);
+    tok.kind = next.kind;
+    return tok;
+}
+
+internal String8 
+TokenString(String8 input, Token token)
+{
+    return Str8Substr(input, token.offset, token.offset + token.size);
+}
@@ -0,0 +1,29 @@
+/*
+parse_lexer.hpp
+
+Streaming lexer over a String8. Unlike old/lexer.cpp nothing is tokenised up front,
+tokens are produced on demand and IMPLICIT_MULT is inserted by GrammarNextToken rather
+than patched into the parser's peek token.
+*/
+#ifndef PARSE_LEXER_HPP
+#define PARSE_LEXER_HPP
+
+struct Token 
+{
+    U64 offset;     // byte offset into the source
+    U32 size;       // 0 for EOL and IMPLICIT_MULT
+    TokenKind kind;
+};
+
+// GrammarLexer with the Token shape the recursive parsers expect
+struct Lexer 
+{
+    String8 input;
+    GrammarLexer grammar;
+};
+
+internal Lexer LexerInit(String8 input);
+internal Token LexerNext(Lexer *lexer);
+internal String8 TokenString(String8 input, Token token);
+
+#endif // PARSE_LEXER_HPP
@@ -0,0 +1,236 @@
+//////////////////
+// Phase one: top level split points
+
+// '+'/'-' right after an operand is binary, anywhere else it is a prefix minus
+// (or an error the segment parse will report)
+internal B32 
+ParseIsBinaryAt(String8 source, U64 at)
+{
+    while (at > 0 && GrammarIsSpace((char)source.str[at - 1])) { at -= 1; }
+    if (at == 0) { return 0; }
+    char prev = (char)source.str[at - 1];
+    return GrammarIsLetter(prev) || GrammarIsDigit(prev) || prev == ')';
+}
+
+internal B32 
+ParsePushSplit(Arena *arena, U64 **splits, U64 *count, U64 *cap, U64 at)
+{
+    if (*count == *cap)
+    {
+        *splits = ArenaGrowArray(arena, *splits, *count, cap);
+        if (!*splits) { return 0; }
+    }
+    (*splits)[(*count)++] = at;
+    return 1;
+}
+
+internal B32 
+ParseSplitTopLevel(Arena *arena, String8 source, U64 **splits_out, U64 *count_out)
+{
+    U64 *splits = nullptr;
+    U64 count = 0, cap = 0;
+    S64 depth = 0;
+    U64 i = 0;
+
+#if ARCH_X64
+    // 16 bytes at a time: per byte depth change (+1 '(' -1 ')'), inclusive prefix
+    // sum across the lanes in four shifted adds, then ops where depth is zero.
+    // Lane sums stay within [-16, 16] so S8 lanes are enough, the running depth
+    // carries across blocks in a scalar.
+    __m128i open_ch  = _mm_set1_epi8('(');
+    __m128i close_ch = _mm_set1_epi8(')');
+    __m128i plus_ch  = _mm_set1_epi8('+');
+    __m128i minus_ch = _mm_set1_epi8('-');
+    for (; i + 16 <= source.size; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((__m128i const *)(source.str + i));
+        __m128i d = _mm_sub_epi8(_mm_cmpeq_epi8(bytes, close_ch), _mm_cmpeq_epi8(bytes, open_ch));
+        d = _mm_add_epi8(d, _mm_slli_si128(d, 1));
+        d = _mm_add_epi8(d, _mm_slli_si128(d, 2));
+        d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+        d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+
+        // Deeper than 16 nothing in this block can get back to the top level
+        if (depth <= 16)
+        {
+            __m128i top = _mm_set1_epi8((char)-depth);
+            if (_mm_movemask_epi8(_mm_cmplt_epi8(d, top))) { return 0; }
+
+            __m128i ops = _mm_or_si128(_mm_cmpeq_epi8(bytes, plus_ch), _mm_cmpeq_epi8(bytes, minus_ch));
+            U32 hits = (U32)_mm_movemask_epi8(_mm_and_si128(ops, _mm_cmpeq_epi8(d, top)));
+            while (hits)
+            {
+                U64 at = i + CountTrailingZeros32(hits);
+                hits &= hits - 1;
+                if (ParseIsBinaryAt(source, at) && !ParsePushSplit(arena, &splits, &count, &cap, at)) { return 0; }
+            }
+        }
+        depth += (S8)(_mm_extract_epi16(d, 7) >> 8);
+    }
+#endif
+
+    for (; i < source.size; i += 1)
+    {
+        char ch = (char)source.str[i];
+        if (ch == '(') { depth += 1; }
+        else if (ch == ')') { depth -= 1; if (depth < 0) { return 0; } }
+        else if ((ch == '+' || ch == '-') && depth == 0 && ParseIsBinaryAt(source, i))
+        {
+            if (!ParsePushSplit(arena, &splits, &count, &cap, i)) { return 0; }
+        }
+    }
+
+    *splits_out = splits;
+    *count_out = count;
+    return 1;
+}
+
+//////////////////
+// Phase two: segment parse jobs
+
+struct ParseSegmentJobs 
+{
+    String8 source;
+    U64 *splits;
+    U64 split_count;
+    U64 *job_first;         // first segment of each job, one past the end at [job_count]
+    Expr **roots;           // one per segment
+    Arena **arenas;
+    JobSystem *jobs;
+    ParseParams params;
+    std::atomic<B32> failed;
+};
+
+internal void 
+ParseSegmentJob(void *data, U64 index, U32 worker)
+{
+    ParseSegmentJobs *seg = (ParseSegmentJobs *)data;
+    Arena *arena = seg->arenas[worker];
+    Arena *scratch = JobScratch(seg->jobs, worker);
+
+    for (U64 k = seg->job_first[index]; k < seg->job_first[index + 1]; k += 1)
+    {
+        if (seg->failed.load(std::memory_order_relaxed)) { return; }
+
+        U64 first = k ? seg->splits[k - 1] + 1 : 0;
+        U64 opl = k < seg->split_count ? seg->splits[k] : seg->source.size;
+
+        // Serially every segment after the first sits on top of the pending '+'/'-' frame
+        ParseParams params = seg->params;
+        if (k) { params.max_depth -= 1; }
+
+        ParseResult res = Parse(arena, scratch, Str8Substr(seg->source, first, opl), &params);
+        if (!res.root) { seg->failed.store(1, std::memory_order_relaxed); return; }
+        seg->roots[k] = res.root;
+    }
+}
+
+//////////////////
+// Stitching
+
+// Left fold over the segments with the serial parser's rules: '-' nests, a run of
+// '+' becomes one PLUS, which also absorbs a parenthesised sum on its left.
+internal Expr *
+ParseStitch(Arena *arena, Arena *scratch, String8 source, U64 *splits, Expr **roots, U64 segment_count)
+{
+    Expr *v = roots[0];
+    U64 k = 1;
+    while (v && k < segment_count)
+    {
+        if (source.str[splits[k - 1]] == '-')
+        {
+            v = ExprPushBinary(arena, ExprKind::DIFFERENCE, v, roots[k]);
+            k += 1;
+            continue;
+        }
+
+        U64 end = k;
+        while (end < segment_count && source.str[splits[end - 1]] == '+') { end += 1; }
+
+        U64 head = v->kind == ExprKind::PLUS ? v->count : 1;
+        U64 total = head + (end - k);
+        U64 pos = scratch->ArenaGetPos();
+        Expr **ops = scratch->PushArrayNoZero<Expr *>(total);
+        if (!ops) { return nullptr; }
+        if (v->kind == ExprKind::PLUS) { MemoryCopy(ops, v->operands, sizeof(Expr *) * head); }
+        else { ops[0] = v; }
+        MemoryCopy(ops + head, roots + k, sizeof(Expr *) * (end - k));
+
+        v = ExprPushNary(arena, ExprKind::PLUS, ops, (U32)total);
+        scratch->ArenaSetPosBack(pos);
+        k = end;
+    }
+    return v;
+}
+
+internal ParseResult 
+ParseParallel(JobSystem *jobs, Arena *arena, Arena **worker_arenas, String8 source, ParseParallelParams const *params)
+{
+    ParseParallelParams p = {};
+    if (params) { p = *params; }
+    if (!p.min_bytes) { p.min_bytes = MB(1); }
+    if (!p.job_bytes) { p.job_bytes = KB(256); }
+    if (!p.parse.max_depth) { p.parse.max_depth = PARSE_DEFAULT_MAX_DEPTH; }
+
+    Arena *scratch = JobScratch(jobs, 0);
+
+    // '$' ends the input for the serial lexer, nothing after it matters
+    U8 *dollar = (U8 *)std::memchr(source.str, '$', source.size);
+    if (dollar) { source.size = (U64)(dollar - source.str); }
+
+    // Segments after the first get one level less, which a depth of 1 doesn't have
+    if (source.size < p.min_bytes || p.parse.max_depth <= 1) { return Parse(arena, scratch, source, &p.parse); }
+
+    U64 pos = scratch->ArenaGetPos();
+    ParseResult result = {};
+
+    U64 *splits = nullptr;
+    U64 split_count = 0;
+    if (ParseSplitTopLevel(scratch, source, &splits, &split_count) && split_count)
+    {
+        U64 segment_count = split_count + 1;
+
+        // Group consecutive segments into jobs of roughly job_bytes each
+        U64 max_jobs = source.size / p.job_bytes + 2;
+        U64 *job_first = scratch->PushArrayNoZero<U64>(max_jobs + 1);
+        Expr **roots = scratch->PushArray<Expr *>(segment_count);
+        U64 job_count = 0;
+        if (job_first && roots)
+        {
+            U64 job_start = 0;
+            job_first[job_count++] = 0;
+            for (U64 k = 0; k < split_count; k += 1)
+            {
+                if (splits[k] - job_start >= p.job_bytes && job_count < max_jobs)
+                {
+                    job_first[job_count++] = k + 1;
+                    job_start = splits[k];
+                }
+            }
+            job_first[job_count] = segment_count;
+
+            ParseSegmentJobs seg = {};
+            seg.source = source;
+            seg.splits = splits;
+            seg.split_count = split_count;
+            seg.job_first = job_first;
+            seg.roots = roots;
+            seg.arenas = worker_arenas;
+            seg.jobs = jobs;
+            seg.params = p.parse;
+            seg.failed.store(0);
+            JobParallelFor(jobs, job_count, ParseSegmentJob, &seg);
+
+            if (!seg.failed.load())
+            {
+                result.root = ParseStitch(arena, scratch, source, splits, roots, segment_count);
+            }
+        }
+    }
+
+    scratch->ArenaSetPosBack(pos);
+
+    // Errors, unbalanced parentheses, single segment: the serial parser has the answer
+    if (!result.root) { result = Parse(arena, scratch, source, &p.parse); }
+    return result;
+}
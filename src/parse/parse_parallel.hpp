@@ -0,0 +1,35 @@
+/*
+parse_parallel.hpp
+
+Two phase parse for single huge expressions.
+    1. A vectorised parenthesis depth prefix scan finds the binary '+'/'-' outside
+       all parentheses. Everything between two of them binds tighter, so each
+       segment is an independent expression.
+    2. Segments are parsed with the normal Parser on the job system, into one
+       arena per worker, and folded left to right into the top level the serial
+       parser would have built (one flattened PLUS per run of '+').
+
+The result matches Parse() node for node. Any error, including unbalanced
+parentheses, reruns the serial parser so errors match too.
+*/
+#ifndef PARSE_PARALLEL_HPP
+#define PARSE_PARALLEL_HPP
+
+struct ParseParallelParams 
+{
+    ParseParams parse;
+    U64 min_bytes;          // below this just call Parse(), 0 means MB(1)
+    U64 job_bytes;          // rough source bytes per job, 0 means KB(256)
+};
+
+// Segment nodes go into worker_arenas[worker] (jobs->worker_count of them), the
+// top level into arena. All of them must outlive the tree. Worker 0's job scratch
+// holds the split table while parsing.
+internal ParseResult ParseParallel(JobSystem *jobs, Arena *arena, Arena **worker_arenas, String8 source,
+                                   ParseParallelParams const *params = nullptr);
+
+// Phase one on its own: offsets of the top level binary '+' and '-'.
+// Returns 0 if a ')' closes more than was opened.
+internal B32 ParseSplitTopLevel(Arena *arena, String8 source, U64 **splits_out, U64 *count_out);
+
+#endif // PARSE_PARALLEL_HPP
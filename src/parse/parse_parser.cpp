@@ -0,0 +1,211 @@
+//////////////////
+// Parser stack
+
+// Operand list of a PLUS/MULTIPLY that can still grow, ops follows the header in scratch
+struct alignas(Expr *) ParseList 
+{
+    U32 count;
+    U32 cap;
+    ExprKind kind;
+};
+
+// Operand. While list is non-null it is an open n-ary node, it becomes an Expr
+// when something else consumes it.
+struct ParseValue 
+{
+    Expr *expr;
+    ParseList *list;
+};
+
+internal Expr **
+ParseListOps(ParseList *list)
+{
+    return (Expr **)(list + 1);
+}
+
+// New list with room for cap operands, copying the old one if given
+internal ParseList *
+ParsePushList(Arena *scratch, ParseList *old, ExprKind kind, U32 cap)
+{
+    U64 bytes = sizeof(ParseList) + sizeof(Expr *) * cap;
+    ParseList *list = (ParseList *)scratch->PushArrayNoZero<U8>(bytes, alignof(ParseList *));
+    if (!list) { return nullptr; }
+    list->count = 0;
+    list->cap = cap;
+    list->kind = kind;
+    if (old)
+    {
+        MemoryCopy(ParseListOps(list), ParseListOps(old), sizeof(Expr *) * old->count);
+        list->count = old->count;
+    }
+    return list;
+}
+
+// The builder GrammarParse runs for Parse: Expr nodes in arena, frames and open
+// operand lists in scratch. Only the first failure is kept.
+struct Parser 
+{
+    using Value = ParseValue;
+
+    Arena *arena;
+    Arena *scratch;
+    String8 source;
+    U64 max_depth;
+
+    GrammarFrame<ParseValue> *frames;
+    U64 frame_count;
+    U64 frame_cap;
+
+    ParseError error;
+
+    bool 
+    Fail(ParseErrorCode code, U64 offset)
+    {
+        if (error.code == ParseErrorCode::NONE)
+        {
+            error.code = code;
+            error.offset = offset;
+        }
+        return false;
+    }
+
+    bool 
+    Set(ParseValue *out, Expr *expr, U64 offset)
+    {
+        if (!expr) { return Fail(ParseErrorCode::OUT_OF_MEMORY, offset); }
+        out->expr = expr;
+        out->list = nullptr;
+        return true;
+    }
+
+    GrammarFrame<ParseValue> *
+    PushFrame(U64 offset)
+    {
+        if (frame_count >= max_depth) { Fail(ParseErrorCode::TOO_DEEP, offset); return nullptr; }
+        if (frame_count == frame_cap)
+        {
+            frames = ArenaGrowArray(scratch, frames, frame_count, &frame_cap);
+            if (!frames) { Fail(ParseErrorCode::OUT_OF_MEMORY, offset); return nullptr; }
+        }
+        return &frames[frame_count++];
+    }
+
+    bool 
+    Number(GrammarToken tok, ParseValue *out)
+    {
+        S64 value = 0;
+        U8 *str = source.str;
+        for (U64 i = tok.offset; i < tok.end; i += 1)
+        {
+            S64 digit = str[i] - '0';
+            // Up to 18 digits always fit, only check beyond that
+            if (i - tok.offset >= 18 && value > (std::numeric_limits<S64>::max() - digit) / 10)
+            {
+                return BigNumber(tok, out);
+            }
+            value = value * 10 + digit;
+        }
+        return Set(out, ExprPushNum(arena, value), tok.offset);
+    }
+
+    // Literals past S64 become BIG_NUM, the digits are converted in scratch
+    bool 
+    BigNumber(GrammarToken tok, ParseValue *out)
+    {
+        U64 pos = scratch->ArenaGetPos();
+        Integer value;
+        Expr *expr = nullptr;
+        if (IntFromStr8(scratch, Str8Substr(source, tok.offset, tok.end), &value)) { expr = ExprPushInteger(arena, value); }
+        if (scratch != arena) { scratch->ArenaSetPosBack(pos); }
+        return Set(out, expr, tok.offset);
+    }
+
+    bool 
+    Variable(GrammarToken tok, ParseValue *out)
+    {
+        return Set(out, ExprPushVar(arena, Str8Substr(source, tok.offset, tok.end)), tok.offset);
+    }
+
+    // Turns an open n-ary value into a node with an exactly sized operand array
+    bool 
+    Close(ParseValue *v, U64 offset)
+    {
+        ParseList *list = v->list;
+        if (!list) { return true; }
+
+        v->expr = ExprPushNary(arena, list->kind, ParseListOps(list), list->count);
+        v->list = nullptr;
+
+        // Operand lists mostly close in the order they opened, so the one closing
+        // is usually the last thing in scratch and its space can be reused straight away
+        U8 *end = (U8 *)(ParseListOps(list) + list->cap);
+        if (scratch != arena && end == scratch->memory + scratch->ArenaGetPos())
+        {
+            scratch->ArenaSetPosBack((U64)((U8 *)list - scratch->memory));
+        }
+        return v->expr ? true : Fail(ParseErrorCode::OUT_OF_MEMORY, offset);
+    }
+
+    bool 
+    Negate(ParseValue operand, U64 offset, ParseValue *out)
+    {
+        return Set(out, ExprPushUnary(arena, operand.expr), offset);
+    }
+
+    bool 
+    Binary(ExprKind kind, ParseValue left, ParseValue right, U64 offset, ParseValue *out)
+    {
+        return Set(out, ExprPushBinary(arena, kind, left.expr, right.expr), offset);
+    }
+
+    bool 
+    IsOpen(ParseValue v, ExprKind kind)
+    {
+        return v.list && v.list->kind == kind;
+    }
+
+    bool 
+    Open(ExprKind kind, ParseValue first, U64 offset, ParseValue *out)
+    {
+        ParseList *list = ParsePushList(scratch, nullptr, kind, 4);
+        if (!list) { return Fail(ParseErrorCode::OUT_OF_MEMORY, offset); }
+        ParseListOps(list)[list->count++] = first.expr;
+        out->expr = nullptr;
+        out->list = list;
+        return true;
+    }
+
+    bool 
+    Append(ParseValue *v, ParseValue operand, U64 offset)
+    {
+        ParseList *list = v->list;
+        if (list->count == list->cap)
+        {
+            list = ParsePushList(scratch, list, list->kind, list->cap * 2);
+            if (!list) { return Fail(ParseErrorCode::OUT_OF_MEMORY, offset); }
+            v->list = list;
+        }
+        ParseListOps(list)[list->count++] = operand.expr;
+        return true;
+    }
+};
+
+internal ParseResult 
+Parse(Arena *arena, Arena *scratch, String8 source, ParseParams const *params)
+{
+    U64 scratch_pos = scratch->ArenaGetPos();
+
+    Parser p = {};
+    p.arena = arena;
+    p.scratch = scratch;
+    p.source = source;
+    p.max_depth = (params && params->max_depth) ? params->max_depth : PARSE_DEFAULT_MAX_DEPTH;
+
+    ParseResult result = {};
+    ParseValue root = {};
+    if (GrammarParse(p, (char const *)source.str, source.size, &root)) { result.root = root.expr; }
+    result.error = p.error;
+
+    if (scratch != arena) { scratch->ArenaSetPosBack(scratch_pos); }
+    return result;
+}
@@ -0,0 +1,41 @@
+/*
+parse_parser.hpp
+
+Iterative Pratt parser. Same grammar as the recursive one in old/parser.cpp
+(binding powers, implicit multiplication and the driver loop live in parse_grammar.hpp),
+but the pending operators and operands sit on explicit stacks in a scratch arena, so
+((((x)))) or -----x nest as deep as max_depth allows instead of as deep as the
+C++ stack allows.
+
+PLUS/MULTIPLY chains are flattened while parsing: a+b+c+d is one node with four
+operands, the operand array is contiguous and sized exactly. Integer literals
+that don't fit S64 become BIG_NUM nodes rather than errors.
+*/
+#ifndef PARSE_PARSER_HPP
+#define PARSE_PARSER_HPP
+
+// Compact on purpose, turn it into text with ParseErrorCodeString only when reporting
+struct ParseError 
+{
+    ParseErrorCode code;
+    U64 offset;             // byte offset into the source
+};
+
+#define PARSE_DEFAULT_MAX_DEPTH Million(1)
+
+struct ParseParams 
+{
+    U64 max_depth;          // max pending operators, prefix minuses and open parens, 0 means PARSE_DEFAULT_MAX_DEPTH
+};
+
+struct ParseResult 
+{
+    Expr *root;             // nullptr on error
+    ParseError error;
+};
+
+// Nodes go into arena. scratch holds the parser stacks and is reset before returning,
+// it may be the same arena (the stacks are then simply left behind).
+internal ParseResult Parse(Arena *arena, Arena *scratch, String8 source, ParseParams const *params = nullptr);
+
+#endif // PARSE_PARSER_HPP
@@ -0,0 +1,48 @@
+internal String8 
+ParseRulesTrim(String8 text)
+{
+    U64 first = 0, last = text.size;
+    while (first < last && (text.str[first] == ' ' || text.str[first] == '\t' || text.str[first] == '\r')) { first += 1; }
+    while (last > first && (text.str[last - 1] == ' ' || text.str[last - 1] == '\t' || text.str[last - 1] == '\r')) { last -= 1; }
+    return Str8Substr(text, first, last);
+}
+
+internal B32 
+ParseRules(Arena *scratch, String8 text, RuleSet *set, U64 *error_line)
+{
+    U64 line = 0;
+    for (U64 start = 0; start < text.size;)
+    {
+        U64 end = start;
+        while (end < text.size && text.str[end] != '\n') { end += 1; }
+        String8 rule = Str8Substr(text, start, end);
+        start = end + 1;
+        line += 1;
+
+        for (U64 i = 0; i < rule.size; i += 1)
+        {
+            if (rule.str[i] == '#') { rule.size = i; break; }
+        }
+        rule = ParseRulesTrim(rule);
+        if (rule.size == 0) { continue; }
+
+        U64 arrow = 0;
+        while (arrow + 1 < rule.size && !(rule.str[arrow] == '-' && rule.str[arrow + 1] == '>')) { arrow += 1; }
+        U64 pos = scratch->ArenaGetPos();
+        B32 ok = arrow + 1 < rule.size;
+        if (ok)
+        {
+            Expr *lhs = Parse(scratch, scratch, Str8Substr(rule, 0, arrow)).root;
+            Expr *rhs = lhs ? Parse(scratch, scratch, Str8Substr(rule, arrow + 2, rule.size)).root : nullptr;
+            String8 copy = rhs ? PushStr8Copy(set->arena, rule) : String8{};
+            ok = copy.str && RuleSetAdd(set, lhs, rhs, copy);
+        }
+        scratch->ArenaSetPosBack(pos);
+        if (!ok)
+        {
+            if (error_line) { *error_line = line; }
+            return 0;
+        }
+    }
+    return 1;
+}
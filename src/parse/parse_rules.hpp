@@ -0,0 +1,16 @@
+/*
+parse_rules.hpp
+
+Rule text for ExprRewrite, typically read once at startup: one "lhs -> rhs" per
+line in the expression grammar, blank lines and anything after '#' ignored.
+*/
+#ifndef PARSE_RULES_HPP
+#define PARSE_RULES_HPP
+
+// Adds every rule of text to set, in order. On a line that doesn't parse or that
+// RuleSetAdd rejects, returns 0 with *error_line set to its number from 1; rules
+// before it stay added. scratch holds each side while it is compiled and must
+// not be the set's arena.
+internal B32 ParseRules(Arena *scratch, String8 text, RuleSet *set, U64 *error_line = nullptr);
+
+#endif // PARSE_RULES_HPP
@@ -0,0 +1,339 @@
+/*
+parse_static.hpp
+
+Formulas parsed at compile time. DSP_EXPR("3x(x+1)") instantiates the same GrammarParse
+driver as Parse (parse_grammar.hpp) with a builder of constexpr nodes, and
+turns the result into a tree of types. Evaluating it is a chain of inline static
+functions the optimiser flattens into straight-line arithmetic: no parsing at
+startup, no dispatch per node. Malformed input is a compile error.
+
+    auto f = DSP_EXPR("3x(x+1) - y");
+    F64 vars[f.var_count];
+    vars[f.VarSlot("x")] = 2.0;
+    F64 value = f(vars);
+
+Variable slots count up in order of first appearance, like Bytecode's.
+*/
+#ifndef PARSE_STATIC_HPP
+#define PARSE_STATIC_HPP
+
+#include <utility>
+
+//////////////////
+// Compile-time parse
+
+template <U64 N>
+struct StaticString
+{
+    char chars[N] = {};
+
+    constexpr StaticString(char const (&str)[N])
+    {
+        for (U64 i = 0; i < N; i += 1) { chars[i] = str[i]; }
+    }
+};
+
+struct StaticNode
+{
+    ExprKind kind = ExprKind::NUM;
+    S64 num = 0;
+    U32 slot = 0;                   // VAR
+    U32 first_child = 0;
+    U32 last_child = 0;
+    U32 next_sibling = 0;
+    U32 child_count = 0;
+    bool open = false;              // PLUS/MULTIPLY that can still take operands, see GrammarReduce
+};
+
+// Not constexpr, so reaching one while parsing stops compilation here
+inline void StaticParseError(char const *message) { (void)message; }
+
+template <U64 N>
+struct StaticTree;
+
+// The builder GrammarParse runs for DSP_EXPR, values are node indices. A PLUS/MULTIPLY
+// stays open (takes more operands) until something else consumes it.
+template <U64 N>
+struct StaticBuilder
+{
+    using Value = U32;
+
+    StaticTree<N> &tree;
+    GrammarFrame<U32> frames[2 * N] = {};
+    U64 frame_count = 0;
+
+    constexpr bool
+    Fail(ParseErrorCode code, U64)
+    {
+        StaticParseError(ParseErrorCodeString(code));
+        return false;
+    }
+
+    constexpr GrammarFrame<U32> *PushFrame(U64) { return &frames[frame_count++]; }
+
+    constexpr bool
+    Number(GrammarToken tok, U32 *out)
+    {
+        S64 value = 0;
+        for (U64 i = tok.offset; i < tok.end; i += 1)
+        {
+            S64 digit = tree.source[i] - '0';
+            if (value > (std::numeric_limits<S64>::max() - digit) / 10) { return Fail(ParseErrorCode::NUMBER_OVERFLOW, tok.offset); }
+            value = value * 10 + digit;
+        }
+        *out = tree.Push(ExprKind::NUM);
+        tree.nodes[*out].num = value;
+        return true;
+    }
+
+    constexpr bool
+    Variable(GrammarToken tok, U32 *out)
+    {
+        *out = tree.Push(ExprKind::VAR);
+        tree.nodes[*out].slot = tree.VarSlot(tok.offset, tok.end - tok.offset);
+        return true;
+    }
+
+    constexpr bool
+    Close(U32 *v, U64)
+    {
+        tree.nodes[*v].open = false;
+        return true;
+    }
+
+    constexpr bool
+    Negate(U32 operand, U64, U32 *out)
+    {
+        *out = tree.Push(ExprKind::PRE_UNARY_MINUS);
+        tree.AddChild(*out, operand);
+        return true;
+    }
+
+    constexpr bool
+    Binary(ExprKind kind, U32 left, U32 right, U64, U32 *out)
+    {
+        *out = tree.Push(kind);
+        tree.AddChild(*out, left);
+        tree.AddChild(*out, right);
+        return true;
+    }
+
+    constexpr bool IsOpen(U32 v, ExprKind kind) { return tree.nodes[v].open && tree.nodes[v].kind == kind; }
+
+    constexpr bool
+    Open(ExprKind kind, U32 first, U64, U32 *out)
+    {
+        *out = tree.Push(kind);
+        tree.AddChild(*out, first);
+        tree.nodes[*out].open = true;
+        return true;
+    }
+
+    constexpr bool
+    Append(U32 *list, U32 operand, U64)
+    {
+        tree.AddChild(*list, operand);
+        return true;
+    }
+};
+
+// N counts the terminating null. Every node and frame needs at least one source
+// byte, except implicit multiplications which need two, so 2N bounds both.
+template <U64 N>
+struct StaticTree
+{
+    StaticNode nodes[2 * N] = {};
+    U32 node_count = 0;
+    U32 root = 0;
+    U32 var_offset[N] = {};         // by slot, into source
+    U32 var_size[N] = {};
+    U32 var_count = 0;
+    char source[N] = {};
+
+    constexpr U32
+    Push(ExprKind kind)
+    {
+        nodes[node_count].kind = kind;
+        return node_count++;
+    }
+
+    constexpr void
+    AddChild(U32 parent, U32 child)
+    {
+        StaticNode &p = nodes[parent];
+        if (p.child_count == 0) { p.first_child = child; }
+        else                    { nodes[p.last_child].next_sibling = child; }
+        p.last_child = child;
+        p.child_count += 1;
+    }
+
+    constexpr U32
+    VarSlot(U64 offset, U64 size)
+    {
+        for (U32 slot = 0; slot < var_count; slot += 1)
+        {
+            bool same = var_size[slot] == size;
+            for (U64 i = 0; same && i < size; i += 1) { same = source[var_offset[slot] + i] == source[offset + i]; }
+            if (same) { return slot; }
+        }
+        var_offset[var_count] = (U32)offset;
+        var_size[var_count] = (U32)size;
+        return var_count++;
+    }
+
+    constexpr
+    StaticTree(char const (&str)[N])
+    {
+        for (U64 i = 0; i < N; i += 1) { source[i] = str[i]; }
+        StaticBuilder<N> builder = {*this};
+        GrammarParse(builder, source, N - 1, &root);
+    }
+
+    constexpr U32
+    Child(U32 node, U32 index) const
+    {
+        U32 child = nodes[node].first_child;
+        for (U32 i = 0; i < index; i += 1) { child = nodes[child].next_sibling; }
+        return child;
+    }
+};
+
+template <StaticString S>
+inline constexpr StaticTree<sizeof(S.chars)> static_tree{S.chars};
+
+//////////////////
+// Type-level tree
+// Each node is an empty type with Eval and Push, Push builds the Expr Parse would
+
+template <S64 Value>
+struct StaticNum
+{
+    static F64 Eval(F64 const *) { return (F64)Value; }
+    static Expr *Push(Arena *arena, String8 const *) { return ExprPushNum(arena, Value); }
+};
+
+template <U32 Slot>
+struct StaticVar
+{
+    static F64 Eval(F64 const *vars) { return vars[Slot]; }
+    static Expr *Push(Arena *arena, String8 const *names) { return ExprPushVar(arena, names[Slot]); }
+};
+
+template <class A>
+struct StaticNeg
+{
+    static F64 Eval(F64 const *vars) { return -A::Eval(vars); }
+    static Expr *Push(Arena *arena, String8 const *names)
+    {
+        Expr *a = A::Push(arena, names);
+        return a ? ExprPushUnary(arena, a) : nullptr;
+    }
+};
+
+template <ExprKind Kind, class A, class B>
+struct StaticBinary
+{
+    static F64
+    Eval(F64 const *vars)
+    {
+        if constexpr (Kind == ExprKind::DIFFERENCE) { return A::Eval(vars) - B::Eval(vars); }
+        else                                        { return A::Eval(vars) / B::Eval(vars); }
+    }
+    static Expr *
+    Push(Arena *arena, String8 const *names)
+    {
+        Expr *a = A::Push(arena, names);
+        Expr *b = B::Push(arena, names);
+        return a && b ? ExprPushBinary(arena, Kind, a, b) : nullptr;
+    }
+};
+
+// Left folds, the same order ExprEval accumulates in
+template <ExprKind Kind, class... Ops>
+struct StaticNary
+{
+    static F64
+    Eval(F64 const *vars)
+    {
+        if constexpr (Kind == ExprKind::PLUS) { return (... + Ops::Eval(vars)); }
+        else                                  { return (... * Ops::Eval(vars)); }
+    }
+    static Expr *
+    Push(Arena *arena, String8 const *names)
+    {
+        Expr *ops[] = {Ops::Push(arena, names)...};
+        for (Expr *op : ops) { if (!op) { return nullptr; } }
+        return ExprPushNary(arena, Kind, ops, (U32)sizeof...(Ops));
+    }
+};
+
+template <StaticString S, U32 Node, class Children = std::make_index_sequence<static_tree<S>.nodes[Node].child_count>>
+struct StaticBuild;
+
+template <StaticString S, U32 Node, U64... I>
+struct StaticBuild<S, Node, std::index_sequence<I...>>
+{
+    static constexpr StaticNode node = static_tree<S>.nodes[Node];
+
+    template <U64 Index>
+    using Child = typename StaticBuild<S, static_tree<S>.Child(Node, Index)>::Type;
+
+    static auto
+    Pick()
+    {
+        if constexpr (node.kind == ExprKind::NUM)                  { return StaticNum<node.num>{}; }
+        else if constexpr (node.kind == ExprKind::VAR)             { return StaticVar<node.slot>{}; }
+        else if constexpr (node.kind == ExprKind::PRE_UNARY_MINUS) { return StaticNeg<Child<0>>{}; }
+        else if constexpr (ExprKindIsNary(node.kind))              { return StaticNary<node.kind, Child<I>...>{}; }
+        else                                                       { return StaticBinary<node.kind, Child<0>, Child<1>>{}; }
+    }
+    using Type = decltype(Pick());
+};
+
+//////////////////
+// Front end
+
+template <StaticString S>
+struct StaticExpr
+{
+    using Root = typename StaticBuild<S, static_tree<S>.root>::Type;
+    static constexpr U32 var_count = static_tree<S>.var_count;
+
+    // -1 if the formula does not use name
+    static constexpr S32
+    VarSlot(char const *name)
+    {
+        constexpr auto const &tree = static_tree<S>;
+        for (U32 slot = 0; slot < tree.var_count; slot += 1)
+        {
+            U32 i = 0;
+            while (i < tree.var_size[slot] && name[i] == tree.source[tree.var_offset[slot] + i]) { i += 1; }
+            if (i == tree.var_size[slot] && name[i] == 0) { return (S32)slot; }
+        }
+        return -1;
+    }
+
+    static String8
+    VarName(U32 slot)
+    {
+        constexpr auto const &tree = static_tree<S>;
+        return Str8((U8 *)tree.source + tree.var_offset[slot], tree.var_size[slot]);
+    }
+
+    // vars is indexed by slot
+    static F64 Eval(F64 const *vars) { return Root::Eval(vars); }
+    F64 operator()(F64 const *vars) const { return Root::Eval(vars); }
+
+    // The tree Parse builds for the same source
+    static Expr *
+    ToExpr(Arena *arena)
+    {
+        String8 names[var_count + 1];
+        for (U32 slot = 0; slot < var_count; slot += 1) { names[slot] = VarName(slot); }
+        return Root::Push(arena, names);
+    }
+};
+
+#define DSP_EXPR(source) (StaticExpr<source>{})
+
+#endif // PARSE_STATIC_HPP
@@ -0,0 +1,1082 @@
+//////////////////////
+// AST tests
+
+internal B32 
+TestEval(Arena *arena, Arena *scratch, char const *source, ExprEnv const *env, F64 expected)
+{
+    ParseResult res = Parse(arena, scratch, Str8C(source));
+    F64 value = 0.0;
+    return res.root && ExprEval(scratch, res.root, env, &value) && value == expected;
+}
+
+DEFINE_TEST_G(ExprNodeLayout, Ast)
+{
+    TEST(sizeof(Expr) <= 32);
+    TEST(alignof(Expr) <= 8);
+
+    BumpAllocator<MB(1)> arena;
+    Expr *num = ExprPushNum(&arena, 7);
+    Expr *var = ExprPushVar(&arena, Str8Lit("x"));
+    Expr *ops[] = {num, var, num};
+    Expr *sum = ExprPushNary(&arena, ExprKind::PLUS, ops, 3);
+    TEST_EQ(ExprChildCount(sum), 3u);
+    TEST(ExprChild(sum, 1) == var);
+    TEST_EQ(ExprChildCount(num), 0u);
+}
+
+DEFINE_TEST_G(ExprNodeCounting, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    TEST_EQ(ExprNodeCount(&scratch, Parse(&arena, &scratch, Str8Lit("x")).root), 1u);
+    TEST_EQ(ExprNodeCount(&scratch, Parse(&arena, &scratch, Str8Lit("a + b + c")).root), 4u);
+    // (3 * x * (x + 1)) - (y / -2)
+    TEST_EQ(ExprNodeCount(&scratch, Parse(&arena, &scratch, Str8Lit("3x(x+1) - y/-2")).root), 11u);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(ExprEvaluation, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    String8 names[] = {Str8Lit("x"), Str8Lit("y")};
+    F64 values[] = {2.0, 8.0};
+    ExprEnv env = {names, values, 2};
+
+    TEST(TestEval(&arena, &scratch, "42", &env, 42.0));
+    TEST(TestEval(&arena, &scratch, "3x(x+1)", &env, 18.0));
+    TEST(TestEval(&arena, &scratch, "y - x - 1", &env, 5.0));
+    TEST(TestEval(&arena, &scratch, "y/x/2", &env, 2.0));
+    TEST(TestEval(&arena, &scratch, "-x*-(y+1)", &env, 18.0));
+    TEST(TestEval(&arena, &scratch, "1/(x-2)", &env, 1.0/0.0));
+
+    F64 value = 0.0;
+    TEST_FAIL(ExprEval(&scratch, Parse(&arena, &scratch, Str8Lit("x + z")).root, &env, &value));
+    TEST_FAIL(ExprEval(&scratch, Parse(&arena, &scratch, Str8Lit("z")).root, &env, &value));
+}
+
+DEFINE_TEST_G(ExprWalkDeep, Ast)
+{
+    BumpAllocator<MB(64)> arena;
+    BumpAllocator<MB(64)> scratch;
+
+    // 100k nested negations and parentheses, far past what recursion survives
+    U64 depth = 100000;
+    U8 *text = arena.PushArray<U8>(depth * 3 + 1);
+    for (U64 i = 0; i < depth; i += 1) { text[2 * i] = '-'; text[2 * i + 1] = '('; }
+    text[2 * depth] = '1';
+    for (U64 i = 0; i < depth; i += 1) { text[2 * depth + 1 + i] = ')'; }
+    Expr *root = Parse(&arena, &scratch, Str8(text, depth * 3 + 1)).root;
+    TEST(root != nullptr);
+    TEST_EQ(ExprNodeCount(&scratch, root), depth + 1);
+    F64 value = 0.0;
+    TEST(ExprEval(&scratch, root, nullptr, &value));
+    TEST_EQ(value, 1.0);
+}
+
+//////////////////////
+// Flat layout
+
+internal B32 
+TestFlatRoundTrip(Arena *arena, Arena *scratch, char const *source)
+{
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    ExprFlat flat;
+    if (!root || !ExprFlatFromExpr(arena, scratch, root, &flat)) { return 0; }
+    String8 text = ExprFlatPrint(arena, scratch, &flat, 0);
+    Expr *reparsed = Parse(arena, scratch, text).root;
+    return ExprMatch(scratch, root, ExprFromFlat(arena, scratch, &flat)) && reparsed && ExprMatch(scratch, root, reparsed);
+}
+
+DEFINE_TEST_G(ExprFlatLayout, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    // (3 * x * (x + 1)) - (y / -2)
+    ExprFlat flat;
+    TEST(ExprFlatFromExpr(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("3x(x+1) - y/-2")).root, &flat));
+    TEST_EQ(flat.count, 11u);
+    TEST(flat.kinds[0] == ExprKind::DIFFERENCE);
+    TEST(flat.kinds[1] == ExprKind::MULTIPLY);
+    TEST_EQ(flat.skip[0], 11u);
+    TEST_EQ(flat.skip[1], 7u);      // the product covers 3, x, x + 1
+    TEST(flat.kinds[flat.skip[1]] == ExprKind::QUOTIENT);
+    TEST_EQ(flat.var_count, 2u);
+    TEST(Str8Match(ExprFlatVarName(&flat, 0), Str8Lit("x")));
+    TEST_EQ(flat.payload[2], flat.payload[4]);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(ExprFlatPasses, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    String8 names[] = {Str8Lit("a"), Str8Lit("b"), Str8Lit("c"), Str8Lit("x"), Str8Lit("y")};
+    F64 values[] = {0.5, -3.0, 7.0, 2.0, 8.0};
+    ExprEnv env = {names, values, 5};
+
+    char const *sources[] = {"3x(x+1) - y/-2", "y - x - 1", "y/x/2", "-x*-(y+1)", "a - (b - c)", "x + (y + 2)*3 + -(x*y)", "7",
+                             "x*36893488147419103232 - 18446744073709551616*-y"};
+    for (char const *source : sources)
+    {
+        Expr *root = Parse(&arena, &scratch, Str8C(source)).root;
+        ExprFlat flat;
+        TEST(ExprFlatFromExpr(&arena, &scratch, root, &flat));
+
+        // The same values, renumbered the flat way
+        F64 flat_values[5] = {};
+        for (U32 v = 0; v < flat.var_count; v += 1)
+        {
+            for (U32 i = 0; i < env.count; i += 1)
+            {
+                if (Str8Match(ExprFlatVarName(&flat, v), names[i])) { flat_values[v] = values[i]; }
+            }
+        }
+        F64 a = 0.0, b = 1.0;
+        TEST(ExprEval(&scratch, root, &env, &a));
+        TEST(ExprFlatEval(&scratch, &flat, 0, flat_values, &b));
+        TEST_EQ(a, b);
+        TEST(TestFlatRoundTrip(&arena, &scratch, source));
+    }
+
+    // Hash follows structure, not variable numbering or where the block lives
+    ExprFlat a, b, c, copy;
+    Expr *tree = Parse(&arena, &scratch, Str8Lit("x*y + (y - x)")).root;
+    TEST(ExprFlatFromExpr(&arena, &scratch, tree, &a));
+    TEST(ExprFlatFromExpr(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("(x - y) + x*y")).root, &b));
+    TEST(ExprFlatFromExpr(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("x - y")).root, &c));
+    TEST(ExprFlatCopy(&arena, &a, &copy));
+    TEST_EQ(ExprFlatHash(&scratch, &a, 0), ExprFlatHash(&scratch, &copy, 0));
+    TEST_EQ(ExprFlatHash(&scratch, &a, 0), ExprHash(tree));
+    TEST(ExprFlatHash(&scratch, &a, 0) != ExprFlatHash(&scratch, &b, 0));
+    TEST_EQ(ExprFlatHash(&scratch, &b, 1), ExprFlatHash(&scratch, &c, 0));
+    TEST(ExprFlatHash(&scratch, &a, a.skip[1]) != ExprFlatHash(&scratch, &c, 0));
+
+    // Serialised form is just the block
+    TEST_FAIL(ExprFlatBind(copy.data, copy.size - 1, &copy));
+    TEST(ExprFlatBind(copy.data, copy.size, &copy));
+    TEST(ExprMatch(&scratch, ExprFromFlat(&arena, &scratch, &a), ExprFromFlat(&arena, &scratch, &copy)));
+}
+
+DEFINE_TEST_G(ExprFlatFreeVariables, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    ExprFlat flat;
+    TEST(ExprFlatFromExpr(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("a*b + c/(d - a) + 4")).root, &flat));
+    U32 count = 0;
+    U32 *vars = ExprFlatFreeVars(&arena, &scratch, &flat, 0, &count);
+    TEST_EQ(count, 4u);
+    TEST_EQ(vars[3], 3u);
+
+    // Second operand of the sum, c/(d - a)
+    U32 node = flat.skip[1];
+    vars = ExprFlatFreeVars(&arena, &scratch, &flat, node, &count);
+    TEST_EQ(count, 3u);
+    TEST(Str8Match(ExprFlatVarName(&flat, vars[0]), Str8Lit("a")));
+    TEST(Str8Match(ExprFlatVarName(&flat, vars[1]), Str8Lit("c")));
+    TEST(Str8Match(ExprFlatVarName(&flat, vars[2]), Str8Lit("d")));
+
+    vars = ExprFlatFreeVars(&arena, &scratch, &flat, flat.skip[node], &count);
+    TEST_EQ(count, 0u);
+}
+
+DEFINE_TEST_G(ExprFlatPrinting, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    char const *cases[][2] = {
+        {"3x(x+1)", "3*x*(x + 1)"},
+        {"a - (b - c) - d", "a - (b - c) - d"},
+        {"((a*b))/(c/d)", "a*b/(c/d)"},
+        {"-(a+b)*-c", "-(a + b)*-c"},
+        {"--x", "--x"},
+        {"1 - 340282366920938463463374607431768211456x", "1 - 340282366920938463463374607431768211456*x"},
+    };
+    for (auto &c : cases)
+    {
+        ExprFlat flat;
+        TEST(ExprFlatFromExpr(&arena, &scratch, Parse(&arena, &scratch, Str8C(c[0])).root, &flat));
+        TEST(Str8Match(ExprFlatPrint(&arena, &scratch, &flat, 0), Str8C(c[1])));
+    }
+}
+
+//////////////////////
+// Structural hashes
+
+DEFINE_TEST_G(ExprHashes, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    char const *same[][2] = {
+        {"3x(x+1) - y/2", "3x*(x+1) - y/2"},
+        {"a + b*c + d", "d + c*b + a"},         // operand order is free in sums and products
+        {"x + x + y", "x + y + x"},
+    };
+    for (auto &pair : same)
+    {
+        Expr *a = Parse(&arena, &scratch, Str8C(pair[0])).root;
+        Expr *b = Parse(&arena, &scratch, Str8C(pair[1])).root;
+        TEST_EQ(ExprHash(a), ExprHash(b));
+        TEST(ExprMaybeEqual(a, b));
+    }
+
+    char const *different[][2] = {
+        {"a - b", "b - a"},
+        {"a/b", "b/a"},
+        {"x + x + y", "x + y + y"},
+        {"x + y", "x*y"},
+        {"-x", "x"},
+        {"1", "2"},
+        {"x + y + z", "(x + y) + z + 0"},
+    };
+    for (auto &pair : different)
+    {
+        Expr *a = Parse(&arena, &scratch, Str8C(pair[0])).root;
+        Expr *b = Parse(&arena, &scratch, Str8C(pair[1])).root;
+        TEST(ExprHash(a) != ExprHash(b));
+        TEST_FAIL(ExprMatch(&scratch, a, b));
+    }
+}
+
+DEFINE_TEST_G(ExprDedupBatch, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    // b + a hashes like a + b but is not the same tree, so it gets its own id
+    char const *sources[] = {"a + b", "x*y", "a + b", "b + a", "x*y", "(a + b)"};
+    Expr *exprs[ArrayCount(sources)];
+    for (U32 i = 0; i < ArrayCount(sources); i += 1) { exprs[i] = Parse(&arena, &scratch, Str8C(sources[i])).root; }
+    U32 ids[ArrayCount(sources)];
+    TEST_EQ(ExprDedup(&scratch, exprs, ArrayCount(sources), ids), 3u);
+    TEST_EQ(ids[0], 0u);
+    TEST_EQ(ids[1], 1u);
+    TEST_EQ(ids[2], 0u);
+    TEST_EQ(ids[3], 2u);
+    TEST_EQ(ids[4], 1u);
+    TEST_EQ(ids[5], 0u);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+//////////////////////
+// Hash consing
+
+DEFINE_TEST_G(ExprInternShares, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    ExprInterner interner;
+    TEST(ExprInternerInit(&interner, &arena, 16));
+
+    Expr *x = ExprInternVar(&interner, Str8Lit("x"));
+    TEST(x == ExprInternVar(&interner, Str8Lit("x")));
+    TEST(x != ExprInternVar(&interner, Str8Lit("y")));
+    TEST(ExprInternNum(&interner, 3) == ExprInternNum(&interner, 3));
+
+    Expr *ops[] = {ExprInternNum(&interner, 3), x};
+    Expr *product = ExprInternNary(&interner, ExprKind::MULTIPLY, ops, 2);
+    TEST(product == ExprInternNary(&interner, ExprKind::MULTIPLY, ops, 2));
+    TEST(product != ExprInternNary(&interner, ExprKind::PLUS, ops, 2));
+    TEST(ExprInternBinary(&interner, ExprKind::QUOTIENT, x, product) != ExprInternBinary(&interner, ExprKind::QUOTIENT, product, x));
+    TEST(ExprInternUnary(&interner, x) == ExprInternUnary(&interner, x));
+
+    // Repeated subtrees of a parsed tree collapse into one node each
+    Expr *root = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("3x*(3x + 1) - (3x + 1)/3x")).root);
+    TEST(root != nullptr);
+    TEST(root->kind == ExprKind::DIFFERENCE);
+    Expr *sum = root->bin.left->operands[2];
+    TEST(sum == root->bin.right->bin.left);
+    TEST(sum->operands[0] == root->bin.right->bin.right);
+    TEST(sum->operands[0] == product);
+
+    Expr *again = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("3x*(3x + 1) - (3x + 1)/3x")).root);
+    TEST(again == root);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(ExprInternGrows, Ast)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(1)> scratch;
+    ExprInterner interner;
+    TEST(ExprInternerInit(&interner, &arena, 0));
+
+    // Enough distinct nodes to rehash several times, all still found afterwards
+    Expr *x = ExprInternVar(&interner, Str8Lit("x"));
+    for (S64 i = 0; i < 20000; i += 1)
+    {
+        Expr *ops[] = {ExprInternNum(&interner, i), x};
+        ExprInternNary(&interner, ExprKind::MULTIPLY, ops, 2);
+    }
+    TEST_EQ(interner.count, 40001u);
+    B32 found = 1;
+    for (S64 i = 0; i < 20000; i += 1)
+    {
+        Expr *ops[] = {ExprInternNum(&interner, i), x};
+        found &= ExprInternNary(&interner, ExprKind::MULTIPLY, ops, 2)->operands[0]->num == i;
+    }
+    TEST(found);
+    TEST_EQ(interner.count, 40001u);
+}
+
+//////////////////////
+// Printing
+
+internal B32 
+TestPrint(Arena *arena, Arena *scratch, char const *source, ExprPrintMode mode, char const *expected)
+{
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    return root && Str8Match(ExprPrint(arena, scratch, root, mode), Str8C(expected));
+}
+
+DEFINE_TEST_G(ExprPrintModes, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    TEST(TestPrint(&arena, &scratch, "3x(x+1) - y/2", ExprPrintMode::INFIX, "3*x*(x + 1) - y/2"));
+    TEST(TestPrint(&arena, &scratch, "a - (b - c) - d", ExprPrintMode::INFIX, "a - (b - c) - d"));
+    TEST(TestPrint(&arena, &scratch, "-(a+b)*-c", ExprPrintMode::INFIX, "-(a + b)*-c"));
+    TEST(TestPrint(&arena, &scratch, "x", ExprPrintMode::INFIX, "x"));
+
+    TEST(TestPrint(&arena, &scratch, "3x(x+1) - y/2", ExprPrintMode::LATEX, "3 \\cdot x \\cdot \\left(x + 1\\right) - \\frac{y}{2}"));
+    TEST(TestPrint(&arena, &scratch, "(a+b)/(c-d)*e", ExprPrintMode::LATEX, "\\frac{a + b}{c - d} \\cdot e"));
+    TEST(TestPrint(&arena, &scratch, "-(a+b)", ExprPrintMode::LATEX, "-\\left(a + b\\right)"));
+
+    TEST(TestPrint(&arena, &scratch, "3x(x+1) - y/2", ExprPrintMode::SEXPR, "(- (* 3 x (+ x 1)) (/ y 2))"));
+    TEST(TestPrint(&arena, &scratch, "-x", ExprPrintMode::SEXPR, "(- x)"));
+
+    // Negative literals, which only show up in built trees
+    Expr *ops[] = {ExprPushNum(&arena, -9223372036854775807 - 1), ExprPushVar(&arena, Str8Lit("x"))};
+    Expr *product = ExprPushNary(&arena, ExprKind::MULTIPLY, ops, 2);
+    TEST(Str8Match(ExprPrint(&arena, &scratch, product), Str8Lit("-9223372036854775808*x")));
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(ExprPrintRoundTrip, Ast)
+{
+    BumpAllocator<MB(64)> arena;
+    BumpAllocator<MB(64)> scratch;
+
+    // Long enough to flush the staging buffer many times, and deep
+    U64 depth = 50000;
+    U8 *text = arena.PushArray<U8>(depth * 6 + 5);
+    U64 size = 0;
+    for (U64 i = 0; i < depth; i += 1) { MemoryCopy(text + size, "x - (", 5); size += 5; }
+    MemoryCopy(text + size, "y - z", 5);
+    size += 5;
+    for (U64 i = 0; i < depth; i += 1) { text[size++] = ')'; }
+    Expr *root = Parse(&arena, &scratch, Str8(text, size)).root;
+    TEST(root != nullptr);
+    String8 printed = ExprPrint(&arena, &scratch, root);
+    TEST(Str8Match(printed, Str8(text, size)));
+    TEST_EQ(printed.str[printed.size], 0);
+}
+
+DEFINE_TEST_G(ExprPrintToFile, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    Expr *roots[] = {
+        Parse(&arena, &scratch, Str8Lit("a + b")).root,
+        nullptr,
+        Parse(&arena, &scratch, Str8Lit("2x/y")).root,
+    };
+    FILE *file = tmpfile();
+    TEST(file != nullptr);
+#if defined(_MSC_VER)
+    int fd = _fileno(file);
+#else
+    int fd = fileno(file);
+#endif
+    TEST(ExprPrintFd(fd, &scratch, roots, ArrayCount(roots), ExprPrintMode::SEXPR));
+    char read[64] = {};
+    fseek(file, 0, SEEK_SET);
+    size_t got = fread(read, 1, sizeof(read) - 1, file);
+    fclose(file);
+    TEST(Str8Match(Str8((U8 *)read, got), Str8Lit("(+ a b)\n\n(/ (* 2 x) y)\n")));
+}
+
+//////////////////////
+// Horner tests
+
+// Rewrites source, checks the value is unchanged and returns the operation counts
+internal B32 
+TestHorner(Arena *arena, Arena *scratch, char const *source, HornerReport *report, char const *expected = nullptr)
+{
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    Expr *rewritten = root ? ExprHorner(arena, scratch, root, report) : nullptr;
+    if (!rewritten) { return 0; }
+
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z"), Str8Lit("a"), Str8Lit("b"), Str8Lit("c")};
+    F64 values[] = {1.5, -2.0, 0.25, 3.0, 4.0, -1.0};
+    ExprEnv env = {names, values, (U32)ArrayCount(names)};
+    F64 before = 0.0, after = 0.0;
+    if (!ExprEval(scratch, root, &env, &before) || !ExprEval(scratch, rewritten, &env, &after)) { return 0; }
+    if (after < before - 1e-9 * (1.0 + (before < 0 ? -before : before)) || after > before + 1e-9 * (1.0 + (before < 0 ? -before : before))) { return 0; }
+    return !expected || Str8Match(ExprPrint(arena, scratch, rewritten), Str8C(expected));
+}
+
+DEFINE_TEST_G(HornerRewrite, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    HornerReport r;
+
+    // Univariate: 6 multiplies and 3 adds become 3 and 3
+    TEST(TestHorner(&arena, &scratch, "2x*x*x + 3x*x - 5x + 7", &r, "x*(x*(2*x + 3) - 5) + 7"));
+    TEST_EQ(r.before.muls, 6u);
+    TEST_EQ(r.after.muls, 3u);
+    TEST_EQ(r.after.adds, 3u);
+    TEST_EQ(r.rewritten, 1u);
+
+    // Common factors and like terms
+    TEST(TestHorner(&arena, &scratch, "a*b + a*c", &r, "a*(b + c)"));
+    TEST_EQ(ExprFlopsTotal(r.after), 2u);
+    TEST(TestHorner(&arena, &scratch, "x*y + 2y*x - 3x*y + z", &r, "z"));
+    TEST(TestHorner(&arena, &scratch, "-x - y", &r));
+    TEST(ExprFlopsTotal(r.after) <= ExprFlopsTotal(r.before));
+
+    // x^8 by squaring is 3 multiplies, the squares are shared
+    TEST(TestHorner(&arena, &scratch, "x*x*x*x*x*x*x*x", &r));
+    TEST_EQ(r.before.muls, 7u);
+    TEST_EQ(r.after.muls, 3u);
+
+    // Quotients and nested sums are factors, rewritten on their own
+    TEST(TestHorner(&arena, &scratch, "(a*b + a*c)/(x*x + x*y) + 1", &r, "a*(b + c)/(x*(x + y)) + 1"));
+    TEST(TestHorner(&arena, &scratch, "3x(x+1) + 3x(x+1)*y", &r));
+    TEST(r.after.muls < r.before.muls);
+
+    // Nothing to gain leaves the tree alone
+    TEST(TestHorner(&arena, &scratch, "x + y*z", &r, "x + y*z"));
+    TEST_EQ(r.rewritten, 0u);
+
+    // Coefficients past S64 collect like any other
+    TEST(TestHorner(&arena, &scratch, "9223372036854775807x + 9223372036854775807x", &r, "18446744073709551614*x"));
+    TEST(TestHorner(&arena, &scratch, "-9223372036854775808 - 9223372036854775808x*x - 9223372036854775808x", &r));
+}
+
+//////////////////////
+// Simplifier tests
+
+// Simplifies source, checks the printed result, the value and that the hash is
+// the one a fresh parse of the result gets
+internal B32 
+TestSimplify(Arena *arena, Arena *scratch, char const *source, char const *expected)
+{
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("a"), Str8Lit("b"), Str8Lit("c"), Str8Lit("d")};
+    F64 values[] = {1.5, -2.0, 3.0, 4.0, -1.0, 0.5};
+    ExprEnv env = {names, values, (U32)ArrayCount(names)};
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    F64 before = 0.0, after = 0.0;
+    if (!root || !ExprEval(scratch, root, &env, &before)) { return 0; }
+
+    Expr *simplified = ExprSimplify(arena, scratch, root);
+    if (!simplified || !ExprEval(scratch, simplified, &env, &after) || before != after) { return 0; }
+    String8 printed = ExprPrint(arena, scratch, simplified);
+    Expr *reparsed = Parse(arena, scratch, printed).root;
+    return Str8Match(printed, Str8C(expected)) && reparsed && reparsed->hash == simplified->hash;
+}
+
+DEFINE_TEST_G(SimplifyRules, Ast)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    // Constants
+    TEST(TestSimplify(&arena, &scratch, "2 + 3*4", "14"));
+    TEST(TestSimplify(&arena, &scratch, "x + 1 + 2", "x + 3"));
+    TEST(TestSimplify(&arena, &scratch, "2*(3*x)", "6*x"));
+    TEST(TestSimplify(&arena, &scratch, "12/4 - x", "3 - x"));
+    TEST(TestSimplify(&arena, &scratch, "7/2", "7/2"));
+    TEST(TestSimplify(&arena, &scratch, "6/4*x", "3/2*x"));
+    TEST(TestSimplify(&arena, &scratch, "1/2 + x + 1/4", "x + 3/4"));
+    TEST(TestSimplify(&arena, &scratch, "x + 1/2 + 1/2", "x + 1"));
+    TEST(TestSimplify(&arena, &scratch, "2/(1/4)", "8"));
+    TEST(TestSimplify(&arena, &scratch, "x/0", "x/0"));
+    TEST(TestSimplify(&arena, &scratch, "-(2 - 5)", "3"));
+
+    // Identities and annihilators
+    TEST(TestSimplify(&arena, &scratch, "x*1 + 0", "x"));
+    TEST(TestSimplify(&arena, &scratch, "x*0 + y", "y"));
+    TEST(TestSimplify(&arena, &scratch, "(x + y)*(a - a + 0)", "(x + y)*(a - a)"));
+    TEST(TestSimplify(&arena, &scratch, "x - 0 + 0 - y", "x - y"));
+    TEST(TestSimplify(&arena, &scratch, "x/1/(2 - 1)", "x"));
+    TEST(TestSimplify(&arena, &scratch, "0 - -x", "x"));
+    TEST(TestSimplify(&arena, &scratch, "---x", "-x"));
+
+    // Nested sums and products splice into their parent
+    TEST(TestSimplify(&arena, &scratch, "(a + b) + (c + d)", "a + b + c + d"));
+    TEST(TestSimplify(&arena, &scratch, "a*(b*(c*1))*d", "a*b*c*d"));
+
+    // Folds past S64 carry on exactly
+    TEST(TestSimplify(&arena, &scratch, "9223372036854775807 + 1 + 1", "9223372036854775809"));
+    TEST(TestSimplify(&arena, &scratch, "3037000500*3037000500*x", "9223372037000250000*x"));
+    TEST(TestSimplify(&arena, &scratch, "18446744073709551616/36893488147419103232 + 18446744073709551616", "36893488147419103233/2"));
+}
+
+DEFINE_TEST_G(SimplifyInPlace, Ast)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(16)> scratch;
+    SimplifyReport report;
+
+    // Shrinking keeps the node and its operand array, nothing is allocated
+    Expr *root = Parse(&arena, &scratch, Str8Lit("a + b + 0 + c*1")).root;
+    Expr **operands = root->operands;
+    U64 pos = arena.ArenaGetPos();
+    TEST(ExprSimplify(&arena, &scratch, root, &report) == root);
+    TEST(root->operands == operands);
+    TEST_EQ(root->count, 3u);
+    TEST_EQ(arena.ArenaGetPos(), pos);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+    TEST_EQ(report.identities, 2u);
+
+    // 100k negations in one pass, an even number cancels out
+    U64 depth = 100000;
+    U8 *text = arena.PushArray<U8>(depth + 1);
+    for (U64 i = 0; i < depth; i += 1) { text[i] = '-'; }
+    text[depth] = 'x';
+    root = Parse(&arena, &scratch, Str8(text, depth + 1)).root;
+    Expr *simplified = ExprSimplify(&arena, &scratch, root, &report);
+    TEST(simplified && simplified->kind == ExprKind::VAR);
+    TEST_EQ(report.identities, depth / 2);
+}
+
+// ExprSimplifyCached agrees with ExprSimplify on a fresh parse of source
+internal B32 
+TestSimplifyCached(SimplifyCache *cache, Arena *arena, Arena *scratch, char const *source)
+{
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    String8 before = ExprPrint(arena, scratch, root);
+    Expr *cached = ExprSimplifyCached(cache, scratch, root);
+    Expr *plain = ExprSimplify(arena, scratch, Parse(arena, scratch, Str8C(source)).root);
+    return cached && plain && ExprMatch(scratch, cached, plain) && Str8Match(before, ExprPrint(arena, scratch, root));
+}
+
+DEFINE_TEST_G(SimplifyCache, Ast)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(1)> scratch;
+    BumpAllocator<KB(256)> a;
+    BumpAllocator<KB(256)> b;
+    SimplifyCache cache;
+    TEST(SimplifyCacheInit(&cache, &a, &b, 64));
+
+    // Rows sharing a factor: after the first, the factor is a single hit
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "(x*1 + 0)*(y + 2*3 - 0)*(z/1 + 0) + a*0"));
+    TEST_EQ(cache.stats.hits, 0u);
+    SimplifyCacheStats stats = cache.stats;
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "(x*1 + 0)*(y + 2*3 - 0)*(z/1 + 0) + b*1"));
+    TEST_EQ(cache.stats.hits - stats.hits, 1u);
+    TEST_EQ(cache.stats.nodes_saved - stats.nodes_saved, 18u);
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "2 + 3*4"));
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "---x + (a + b) + (c + d)"));
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "9223372036854775807 + 1 + 1"));
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "x*y*0 - (0 - -x)"));
+
+    // Equal hashes that aren't equal trees stay apart
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "(p + q*1)*(r - 0)"));
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, "(q*1 + p)*(r - 0)"));
+
+    // Requests trimming in between: the table stays at its size, the arenas
+    // take turns, and every entry stays findable
+    char source[128];
+    B32 same = 1, trimmed = 1;
+    U64 most = 0;
+    for (U32 i = 0; i < 300; i += 1)
+    {
+        snprintf(source, sizeof(source), "(x + %u*1)*(y - 0) + (x + %u*1)*(y - 0)", i, i + 1);
+        same &= TestSimplifyCached(&cache, &arena, &scratch, source);
+        most = Max<U64>(most, cache.interner.arena->ArenaGetPos());
+        trimmed &= SimplifyCacheTrim(&cache, &scratch);
+    }
+    TEST(same);
+    TEST(trimmed);
+    TEST(most < a.size);
+    TEST_EQ(cache.entry_count, 64u);
+    TEST(cache.stats.evictions > 0);
+    TEST(cache.stats.trims > 1);
+    Arena *other = cache.interner.arena == &a ? (Arena *)&b : (Arena *)&a;
+    TEST_EQ(other->ArenaGetPos(), 0u);
+    B32 found = 1;
+    for (U64 i = 0; i < cache.entry_count; i += 1) { found &= SimplifyCacheFind(&cache, &scratch, cache.entries[i].key) == &cache.entries[i]; }
+    TEST(found);
+
+    // The last rows' subtrees survived the moves
+    stats = cache.stats;
+    TEST(TestSimplifyCached(&cache, &arena, &scratch, source));
+    TEST_EQ(cache.stats.hits - stats.hits, 1u);
+
+    // Under half full nothing moves
+    Arena *live = cache.interner.arena;
+    TEST(SimplifyCacheTrim(&cache, &scratch));
+    TEST(cache.interner.arena == live);
+    TEST_EQ(cache.stats.trims, stats.trims);
+}
+
+//////////////////////
+// Canonical form tests
+
+// Both sources canonicalize to the same printed tree, and keep their values
+internal B32 
+TestCanonSame(Arena *arena, Arena *scratch, char const *a, char const *b)
+{
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z"), Str8Lit("a"), Str8Lit("b")};
+    F64 values[] = {1.5, -2.0, 0.25, 3.0, 4.0};
+    ExprEnv env = {names, values, (U32)ArrayCount(names)};
+    String8 printed[2];
+    char const *sources[] = {a, b};
+    for (U32 i = 0; i < 2; i += 1)
+    {
+        Expr *root = Parse(arena, scratch, Str8C(sources[i])).root;
+        F64 before = 0.0, after = 0.0;
+        if (!root || !ExprEval(scratch, root, &env, &before)) { return 0; }
+        Expr *canon = ExprCanonicalize(arena, scratch, root);
+        if (!canon || !ExprEval(scratch, canon, &env, &after)) { return 0; }
+        if (after < before - 1e-9 * (1.0 + (before < 0 ? -before : before)) || after > before + 1e-9 * (1.0 + (before < 0 ? -before : before))) { return 0; }
+        printed[i] = ExprPrint(arena, scratch, canon);
+    }
+    return Str8Match(printed[0], printed[1]);
+}
+
+DEFINE_TEST_G(CanonicalForm, Ast)
+{
+    BumpAllocator<MB(32)> arena;
+    BumpAllocator<MB(32)> scratch;
+    CanonReport report;
+
+    // Like terms collect whatever the order and grouping
+    TEST(TestCanonSame(&arena, &scratch, "2x + 3x + y - x", "y + 4x"));
+    TEST(TestCanonSame(&arena, &scratch, "x*y*3 + 2*y*x - x*y", "4*y*x"));
+    TEST(TestCanonSame(&arena, &scratch, "a - (b - a) - -b", "2a"));
+    TEST(TestCanonSame(&arena, &scratch, "z/(y + x) - (x*y - y*x)", "z/(x + y)"));
+    TEST(TestCanonSame(&arena, &scratch, "3*x*y - 2*(y*x) + z", "z + x*y"));
+    TEST(TestCanonSame(&arena, &scratch, "-(x + y) + x", "-y"));
+
+    // Higher degree first, constants last
+    Expr *root = Parse(&arena, &scratch, Str8Lit("3 + x + x*x - 5 + x")).root;
+    root = ExprCanonicalize(&arena, &scratch, root, &report);
+    TEST(root && Str8Match(ExprPrint(&arena, &scratch, root), Str8Lit("x*x + 2*x + -2")));
+    TEST_EQ(report.terms_in, 5u);
+    TEST_EQ(report.terms_out, 3u);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+
+    // Everything cancels
+    root = ExprCanonicalize(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("x - y + y - x")).root);
+    TEST(root && root->kind == ExprKind::NUM && root->num == 0);
+
+    // Coefficients past S64 collect too
+    root = ExprCanonicalize(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("9223372036854775807x + x")).root, &report);
+    TEST(root && report.terms_out == 1);
+    TEST(Str8Match(ExprPrint(&arena, &scratch, root), Str8Lit("9223372036854775808*x")));
+    TEST(TestCanonSame(&arena, &scratch, "9223372036854775808x + 9223372036854775808x - 18446744073709551616x + y", "y"));
+
+    // 100k terms over 100 monomials, past the insertion sort into the radix sort
+    U64 terms = 100000;
+    U8 *text = arena.PushArray<U8>(terms * 8);
+    U64 size = 0;
+    for (U64 i = 0; i < terms; i += 1)
+    {
+        size += (U64)snprintf((char *)text + size, terms * 8 - size, "%s%c*%c", i ? " + " : "", 'a' + (char)(i % 10), 'a' + (char)(i / 10 % 10));
+    }
+    root = ExprCanonicalize(&arena, &scratch, Parse(&arena, &scratch, Str8(text, size)).root, &report);
+    TEST(root && root->kind == ExprKind::PLUS);
+    TEST_EQ(report.terms_in, terms);
+    TEST_EQ(report.terms_out, 55u);             // ab and ba are the same monomial
+}
+
+//////////////////////
+// Polynomial tests
+
+// Expands source, checks the value is unchanged and optionally the printed result
+internal B32 
+TestExpand(Arena *arena, Arena *scratch, char const *source, char const *expected = nullptr)
+{
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z")};
+    F64 values[] = {1.5, -2.0, 0.25};
+    ExprEnv env = {names, values, (U32)ArrayCount(names)};
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    F64 before = 0.0, after = 0.0;
+    if (!root || !ExprEval(scratch, root, &env, &before)) { return 0; }
+    Expr *expanded = ExprExpand(arena, scratch, root);
+    if (!expanded || !ExprEval(scratch, expanded, &env, &after)) { return 0; }
+    if (after < before - 1e-9 * (1.0 + (before < 0 ? -before : before)) || after > before + 1e-9 * (1.0 + (before < 0 ? -before : before))) { return 0; }
+    return !expected || Str8Match(ExprPrint(arena, scratch, expanded), Str8C(expected));
+}
+
+DEFINE_TEST_G(PolyExpand, Ast)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(16)> scratch;
+
+    TEST(TestExpand(&arena, &scratch, "(x + 1)*(x - 1)", "x*x + -1"));
+    TEST(TestExpand(&arena, &scratch, "(y + x)*(x + y)", "x*x + 2*x*y + y*y"));
+    TEST(TestExpand(&arena, &scratch, "-(x - y)*3 + 3x", "3*y"));
+    TEST(TestExpand(&arena, &scratch, "(2x + 4)/2 - 2", "x"));
+    TEST(TestExpand(&arena, &scratch, "(x - y)*(x + y) - x*x + y*y", "0"));
+    TEST(TestExpand(&arena, &scratch, "y + 0*z + (x - x)", "y"));
+    TEST(TestExpand(&arena, &scratch, "(x - 2y)*(3 + z)*(y - 1) - (x + z)*(x - y)"));
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+
+    // Coefficients past S64
+    TEST(TestExpand(&arena, &scratch, "(3037000500x + 1)*(3037000500x + 1)", "9223372037000250000*x*x + 6074001000*x + 1"));
+    TEST(TestExpand(&arena, &scratch, "(9223372036854775807x + 1)*(x - 1)", "9223372036854775807*x*x + -9223372036854775806*x + -1"));
+    TEST(TestExpand(&arena, &scratch, "9223372036854775807x + 1 + 9223372036854775807x + y", "18446744073709551614*x + y + 1"));
+    TEST(TestExpand(&arena, &scratch, "(36893488147419103232x - 18446744073709551616)/18446744073709551616", "2*x + -1"));
+
+    // Not polynomials over the integers
+    TEST(!TestExpand(&arena, &scratch, "(x + 1)/2"));
+    TEST(!TestExpand(&arena, &scratch, "1/x"));
+    TEST(!TestExpand(&arena, &scratch, "(18446744073709551616x + 1)/18446744073709551616"));
+
+    // (x+y+1)^20: 231 terms, coefficients summing to 3^20
+    U8 text[256];
+    U64 size = 0;
+    for (U32 i = 0; i < 20; i += 1) { size += (U64)snprintf((char *)text + size, sizeof(text) - size, "%s(x + y + 1)", i ? "*" : ""); }
+    Expr *root = Parse(&arena, &scratch, Str8(text, size)).root;
+    ExpandReport report = {};
+    PolyRing ring = {};
+    Poly poly = {};
+    TEST(root && PolyRingFromExpr(&arena, &scratch, root, &ring) && PolyFromExpr(&arena, &scratch, &ring, root, &poly, &report));
+    TEST_EQ(poly.count, 231u);
+    TEST_EQ(report.heap_products, 19u);
+    S64 sum = 0;
+    for (U64 i = 0; i < poly.count; i += 1) { sum += poly.terms[i].coef.small; }
+    TEST_EQ(sum, (S64)3486784401);
+    TEST(poly.terms[0].coef.small == 1 && PolyExponent(&ring, poly.terms[0].exps, 0) == 20);
+    TEST(poly.terms[poly.count - 1].exps == 0);
+
+    // Dense univariate products go through Karatsuba and agree with the heap merge
+    U64 cap = KB(64);
+    U8 *dense = arena.PushArray<U8>(cap);
+    size = (U64)snprintf((char *)dense, cap, "1");
+    for (U32 i = 1; i < 100; i += 1)
+    {
+        size += (U64)snprintf((char *)dense + size, cap - size, " %c %u", i % 5 ? '+' : '-', i % 7 + 1);
+        for (U32 e = 0; e < i; e += 1) { size += (U64)snprintf((char *)dense + size, cap - size, "*x"); }
+    }
+    root = Parse(&arena, &scratch, Str8(dense, size)).root;
+    Poly a = {}, product = {}, check = {};
+    TEST(root && PolyRingFromExpr(&arena, &scratch, root, &ring) && PolyFromExpr(&arena, &scratch, &ring, root, &a));
+    TEST_EQ(a.count, 100u);
+    report = {};
+    TEST(PolyMul(&arena, &scratch, &ring, &a, &a, &product, &report));
+    TEST_EQ(report.dense_products, 1u);
+    TEST(PolyMulHeap(&arena, &scratch, &ring, &a, &a, &check));
+    TEST(PolyEqual(&product, &check));
+    TEST(product.count == 199 && product.terms[0].exps == 198 && product.terms[198].coef.small == 1);
+}
+
+//////////////////////
+// Differentiation tests
+
+// Differentiates source by var and checks the printed result
+internal B32 
+TestDiff(Arena *arena, Arena *scratch, ExprInterner *interner, char const *source, char const *var, char const *expected)
+{
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    root = root ? ExprIntern(interner, scratch, root) : nullptr;
+    Expr *derivative = root ? ExprDifferentiate(interner, scratch, root, Str8C(var)) : nullptr;
+    return derivative && Str8Match(ExprPrint(arena, scratch, derivative), Str8C(expected));
+}
+
+internal F64 
+TestBytecodeValue(Arena *arena, Arena *scratch, Expr *root, F64 x)
+{
+    Bytecode code = {};
+    if (!BytecodeCompile(arena, scratch, root, &code)) { return -1.0; }
+    F64 *stack = arena->PushArray<F64>(code.stack_size);
+    return BytecodeEval(&code, &x, stack);
+}
+
+DEFINE_TEST_G(DiffRules, Ast)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(16)> scratch;
+    ExprInterner interner;
+    TEST(ExprInternerInit(&interner, &arena, 0));
+
+    TEST(TestDiff(&arena, &scratch, &interner, "3x + 2", "x", "3"));
+    TEST(TestDiff(&arena, &scratch, &interner, "x*y", "x", "y"));
+    TEST(TestDiff(&arena, &scratch, &interner, "x*y", "y", "x"));
+    TEST(TestDiff(&arena, &scratch, &interner, "x + y*y", "z", "0"));
+    TEST(TestDiff(&arena, &scratch, &interner, "-x", "x", "-1"));
+    TEST(TestDiff(&arena, &scratch, &interner, "x - x", "x", "0"));
+    TEST(TestDiff(&arena, &scratch, &interner, "x/y", "x", "1/y"));
+    TEST(TestDiff(&arena, &scratch, &interner, "2/x", "x", "-(2/(x*x))"));
+    TEST(TestDiff(&arena, &scratch, &interner, "x/(x + 1)", "x", "(x + 1 - x)/((x + 1)*(x + 1))"));
+    TEST(TestDiff(&arena, &scratch, &interner, "5 - 3x*y", "x", "-(3*y)"));
+    TEST(TestDiff(&arena, &scratch, &interner, "x*x*x", "x", "x*x + x*x + x*x"));
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+
+    // The factors of a product are shared, not copied
+    Expr *root = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("(x + 1)*(y + 2)")).root);
+    Expr *dx = root ? ExprDifferentiate(&interner, &scratch, root, Str8Lit("x")) : nullptr;
+    TEST(dx == root->operands[1]);
+
+    // prod (x/i + 1) for i = 1..n: f' = f sum a_i and f'' = f ((sum a_i)^2 - sum a_i^2)
+    // with a_i = 1/(x + i), and both stay linear in n
+    U32 n = 200;
+    U64 cap = KB(8);
+    U8 *text = arena.PushArray<U8>(cap);
+    U64 size = 0;
+    for (U32 i = 1; i <= n; i += 1) { size += (U64)snprintf((char *)text + size, cap - size, "%s(x/%u + 1)", i > 1 ? "*" : "", i); }
+    root = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8(text, size)).root);
+    DiffReport report = {};
+    Expr *d1 = root ? ExprDifferentiate(&interner, &scratch, root, Str8Lit("x"), &report) : nullptr;
+    Expr *d2 = d1 ? ExprDifferentiate(&interner, &scratch, d1, Str8Lit("x"), &report) : nullptr;
+    ExprFlops flops1 = {}, flops2 = {};
+    TEST(d2 && ExprFlopCount(&scratch, d1, &flops1) && ExprFlopCount(&scratch, d2, &flops2));
+    TEST(ExprFlopsTotal(flops1) < 8 * n);
+    TEST(ExprFlopsTotal(flops2) < 40 * n);
+    TEST(report.simplified > 0);
+
+    F64 x = 0.01, f = 1.0, sum = 0.0, squares = 0.0;
+    for (U32 i = 1; i <= n; i += 1)
+    {
+        f *= x / i + 1.0;
+        sum += 1.0 / (x + i);
+        squares += 1.0 / ((x + i) * (x + i));
+    }
+    F64 got1 = TestBytecodeValue(&arena, &scratch, d1, x), want1 = f * sum;
+    F64 got2 = TestBytecodeValue(&arena, &scratch, d2, x), want2 = f * (sum * sum - squares);
+    TEST(got1 > want1 * (1 - 1e-9) && got1 < want1 * (1 + 1e-9));
+    TEST(got2 > want2 * (1 - 1e-9) && got2 < want2 * (1 + 1e-9));
+
+    // Gradient components share nodes and compile into one program
+    root = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("x*y*z + x/y")).root);
+    String8 vars[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z")};
+    Expr *gradient[3] = {};
+    Bytecode code = {};
+    TEST(root && ExprGradient(&interner, &scratch, root, vars, 3, gradient));
+    TEST(BytecodeCompileBatch(&arena, &scratch, gradient, 3, &code));
+    F64 values[3] = {};
+    for (U32 i = 0; i < 3; i += 1)
+    {
+        S32 slot = BytecodeVarSlot(&code, vars[i]);
+        if (slot >= 0) { values[slot] = 1.0 + i; }
+    }
+    F64 *stack = arena.PushArray<F64>(code.stack_size);
+    F64 out[3] = {};
+    BytecodeEval(&code, values, stack);
+    BytecodeReadOutputs(&code, stack, out);
+    TEST(out[0] > 6.5 - 1e-12 && out[0] < 6.5 + 1e-12);        // y*z + 1/y at (1, 2, 3)
+    TEST(out[1] > 2.75 - 1e-12 && out[1] < 2.75 + 1e-12);      // x*z - x/(y*y)
+    TEST(out[2] > 2.0 - 1e-12 && out[2] < 2.0 + 1e-12);        // x*y
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+//////////////////////
+// Rewrite tests
+
+// Rewrites source with rules to a fixpoint and checks the printed result
+internal B32 
+TestRewrite(Arena *arena, Arena *scratch, ExprInterner *interner, RuleSet const *set, char const *source, char const *expected,
+            RewriteReport *report)
+{
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    root = root ? ExprIntern(interner, scratch, root) : nullptr;
+    Expr *rewritten = root ? ExprRewrite(interner, scratch, set, root, 32, report) : nullptr;
+    return rewritten && Str8Match(ExprPrint(arena, scratch, rewritten), Str8C(expected));
+}
+
+DEFINE_TEST_G(RewriteRules, Ast)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(1)> scratch;
+    ExprInterner interner;
+    RuleSet set;
+    TEST(ExprInternerInit(&interner, &arena, 0));
+    TEST(RuleSetInit(&set, &arena));
+
+    String8 text = Str8Lit(
+        "# distribute, then clean up\n"
+        "a*(b + c) -> a*b + a*c\n"
+        "a*1 -> a     # identity\n"
+        "1*a -> a\n"
+        "a*0 -> 0\n"
+        "\n"
+        "a - a -> 0\n"
+        "a + 0 -> a\n"
+        "--a -> a\n");
+    U64 line = 0;
+    TEST(ParseRules(&scratch, text, &set, &line));
+    TEST_EQ(set.rule_count, 7u);
+    TEST(Str8Match(set.rules[1].text, Str8Lit("a*1 -> a")));
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+
+    RewriteReport r = {};
+    TEST(TestRewrite(&arena, &scratch, &interner, &set, "x*(y + z)", "x*y + x*z", &r));
+    TEST(r.fixpoint && !r.cycle);
+    TEST_EQ(r.rewrites, 1u);
+    TEST_EQ(r.passes, 2u);
+    TEST(TestRewrite(&arena, &scratch, &interner, &set, "(x*1)/(y + 0)", "x/y", &r));
+    TEST(TestRewrite(&arena, &scratch, &interner, &set, "--(x*y - x*y) + 0", "0", &r));
+    TEST(TestRewrite(&arena, &scratch, &interner, &set, "x - y", "x - y", &r));
+    TEST_EQ(r.rewrites, 0u);
+    TEST_EQ(r.passes, 1u);
+
+    // Sums of three terms don't fit a + b, nested ones do over two passes
+    TEST(TestRewrite(&arena, &scratch, &interner, &set, "x*(y + z + w)", "x*(y + z + w)", &r));
+    TEST(TestRewrite(&arena, &scratch, &interner, &set, "x*(y + 2*(z + w))", "x*y + (x*(2*z) + x*(2*w))", &r));
+    TEST_EQ(r.passes, 3u);
+
+    // The lower numbered rule wins when two match
+    Expr *binds[RULE_MAX_VARS];
+    Expr *zero_one = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("0*1")).root);
+    Rule const *rule = RuleSetMatch(&set, zero_one, binds);
+    TEST(rule && rule->id == 1 && binds[0]->kind == ExprKind::NUM && binds[0]->num == 0);
+
+    // a + b -> b + a goes round forever, the driver notices the repeat
+    RuleSet swap;
+    TEST(RuleSetInit(&swap, &arena));
+    TEST(ParseRules(&scratch, Str8Lit("a + b -> b + a"), &swap));
+    TEST(TestRewrite(&arena, &scratch, &interner, &swap, "x + y", "x + y", &r));
+    TEST(r.cycle && !r.fixpoint);
+    TEST_EQ(r.passes, 2u);
+
+    // Bad rules and the line they are on
+    RuleSet bad;
+    TEST(RuleSetInit(&bad, &arena));
+    TEST(!ParseRules(&scratch, Str8Lit("a*1 -> a\n\na -> a*1\n"), &bad, &line));
+    TEST_EQ(line, 3u);
+    TEST(!ParseRules(&scratch, Str8Lit("a*b -> c"), &bad, &line));
+    TEST(!ParseRules(&scratch, Str8Lit("a*b"), &bad, &line));
+    TEST(!ParseRules(&scratch, Str8Lit("a* -> b"), &bad, &line));
+    TEST_EQ(bad.rule_count, 1u);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(RewriteIndexes, Ast)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(1)> scratch;
+    ExprInterner interner;
+    RuleSet set;
+    TEST(ExprInternerInit(&interner, &arena, 0));
+    TEST(RuleSetInit(&set, &arena));
+
+    // 100 rules of which a product of two variables fits two: only those are bound
+    char text[8192];
+    U64 size = 0;
+    for (U32 i = 0; i < 98; i += 1) { size += (U64)snprintf(text + size, sizeof(text) - size, "a*%u -> %u*a\n", i + 2, i + 2); }
+    size += (U64)snprintf(text + size, sizeof(text) - size, "a*a -> a\na*b -> b\n");
+    TEST(ParseRules(&scratch, Str8((U8 *)text, size), &set));
+    TEST_EQ(set.rule_count, 100u);
+
+    Expr *binds[RULE_MAX_VARS];
+    RewriteReport r = {};
+    Expr *xy = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("x*y")).root);
+    Rule const *rule = RuleSetMatch(&set, xy, binds, &r);
+    TEST(rule && rule->id == 99);
+    TEST_EQ(r.candidates, 2u);
+
+    // The numbered rules share one path down to their number
+    r = {};
+    Expr *x50 = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("x*50")).root);
+    rule = RuleSetMatch(&set, x50, binds, &r);
+    TEST(rule && rule->id == 48 && binds[0]->kind == ExprKind::VAR);
+    TEST_EQ(r.candidates, 1u);
+    TEST(set.tree_count < 110u);
+}
+
+DEFINE_TEST_G(RewriteProfile, Ast)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(1)> scratch;
+    ExprInterner interner;
+    RuleSet set;
+    TEST(ExprInternerInit(&interner, &arena, 0));
+    TEST(RuleSetInit(&set, &arena));
+    String8 rules = Str8Lit("a*a -> a\n"
+                            "a*b -> b\n"
+                            "a + 0 -> a\n");
+    TEST(ParseRules(&scratch, rules, &set));
+    TEST(RuleSetProfile(&set));
+
+    // a*a shares a*b's bucket and comes first, so every product binds both
+    Expr *binds[RULE_MAX_VARS];
+    RewriteReport r = {};
+    Expr *xy = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("x*y")).root);
+    Expr *xx = ExprIntern(&interner, &scratch, Parse(&arena, &scratch, Str8Lit("x*x")).root);
+    for (U32 i = 0; i < 10; i += 1) { RuleSetMatch(&set, xy, binds, &r); }
+    TEST_EQ(r.candidates, 20u);
+    TEST_EQ(set.stats[0].attempts, 10u);
+    TEST_EQ(set.stats[0].matches, 0u);
+    TEST_EQ(set.stats[1].matches, 10u);
+    TEST_EQ(set.stats[2].attempts, 0u);
+
+    // Only the rule that was tried and never fired is reported
+    String8 report = RuleProfileReport(&arena, &scratch, &set);
+    TEST(report.size > 0 && report.str[report.size - 1] == '\n');
+    U64 at = 0;
+    for (U32 field = 0; field < 2; field += 1)
+    {
+        while (at < report.size && report.str[at] != ' ') { at += 1; }
+        at += 1;
+    }
+    TEST(Str8Match(Str8Substr(report, Min<U64>(at, report.size), report.size), Str8Lit("a*a -> a\n")));
+    TEST_EQ(RuleProfileReport(&arena, &scratch, &set, 11).size, 0u);
+
+    // Counts survive a round trip and add up, and the reordered bucket binds
+    // the rule that fires first
+    char const *path = "test_rule_profile.txt";
+    TEST(RuleProfileSave(&set, &scratch, path));
+    RuleSet loaded;
+    TEST(RuleSetInit(&loaded, &arena));
+    TEST(ParseRules(&scratch, rules, &loaded));
+    TEST(RuleProfileLoad(&loaded, &scratch, path));
+    TEST(RuleProfileLoad(&loaded, &scratch, path));
+    TEST_EQ(loaded.stats[0].attempts, 20u);
+    TEST_EQ(loaded.stats[1].matches, 20u);
+    TEST_EQ(loaded.stats[1].cycles, set.stats[1].cycles * 2);
+    TEST(RuleSetReorder(&loaded, &scratch));
+    TEST_EQ(loaded.rules[1].rank, 0u);
+    TEST_EQ(loaded.rules[0].rank, 1u);
+    TEST_EQ(loaded.rules[2].rank, 2u);
+    r = {};
+    Rule const *rule = RuleSetMatch(&loaded, xy, binds, &r);
+    TEST(rule && rule->id == 1);
+    TEST_EQ(r.candidates, 1u);
+
+    // Where both fit, the higher ranked rule now wins
+    rule = RuleSetMatch(&loaded, xx, binds, &r);
+    TEST(rule && rule->id == 1);
+    rule = RuleSetMatch(&set, xx, binds, &r);
+    TEST(rule && rule->id == 0);
+
+    // Truncated lines are refused without adding the lines before them, missing
+    // files too
+    OSMapping junk;
+    String8 bad = Str8Lit("5 5 5\ta*a -> a\n3 1\tx\n");
+    TEST(OSMapFileCreate(path, bad.size, &junk));
+    MemoryCopy(junk.data, bad.str, bad.size);
+    OSUnmapFile(&junk);
+    TEST(!RuleProfileLoad(&loaded, &scratch, path));
+    TEST_EQ(loaded.stats[0].attempts, 20u);
+    TEST(!RuleProfileLoad(&loaded, &scratch, "test_rule_profile_missing.txt"));
+
+    // Rules written the same keep their own counts
+    RuleSet twice, twice_loaded;
+    TEST(RuleSetInit(&twice, &arena));
+    TEST(RuleSetInit(&twice_loaded, &arena));
+    TEST(ParseRules(&scratch, Str8Lit("a*b -> b\na*b -> b\n"), &twice));
+    TEST(ParseRules(&scratch, Str8Lit("a*b -> b\na*b -> b\n"), &twice_loaded));
+    TEST(RuleSetProfile(&twice));
+    twice.stats[0].attempts = 7;
+    twice.stats[1].attempts = 2;
+    TEST(RuleProfileSave(&twice, &scratch, path));
+    TEST(RuleProfileLoad(&twice_loaded, &scratch, path));
+    TEST_EQ(twice_loaded.stats[0].attempts, 7u);
+    TEST_EQ(twice_loaded.stats[1].attempts, 2u);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+    remove(path);
+}
@@ -0,0 +1,516 @@
+//////////////////////
+// Bytecode tests
+
+// Compiles source and checks the interpreter against the tree walk
+internal B32 
+TestBytecodeMatches(Arena *arena, Arena *scratch, char const *source, ExprEnv const *env)
+{
+    Expr *root = Parse(arena, scratch, Str8C(source)).root;
+    Bytecode code;
+    if (!root || !BytecodeCompile(arena, scratch, root, &code)) { return 0; }
+
+    F64 *vars = arena->PushArray<F64>(code.var_count + 1);
+    for (U32 slot = 0; slot < code.var_count; slot += 1)
+    {
+        for (U32 i = 0; i < env->count; i += 1)
+        {
+            if (Str8Match(env->names[i], code.vars[slot])) { vars[slot] = env->values[i]; }
+        }
+    }
+    F64 *stack = arena->PushArray<F64>(code.stack_size);
+    F64 expected = 0.0;
+    return ExprEval(scratch, root, env, &expected) && BytecodeEval(&code, vars, stack) == expected;
+}
+
+DEFINE_TEST_G(BytecodeEvaluation, Eval)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z")};
+    F64 values[] = {2.0, 8.0, -0.5};
+    ExprEnv env = {names, values, 3};
+
+    char const *sources[] = {
+        "42", "x", "-x", "--x", "x + y", "3x(x+1)", "y - x - 1", "y/x/2", "y/(x/2)", "-x*-(y+1)",
+        "x - (y - (z - 1))", "(x + y)*(y - z)/(z + x) - -(x*y*z)", "1/(x - 2)", "12y/2z + 7 - x/3",
+    };
+    for (char const *source : sources)
+    {
+        TEST(TestBytecodeMatches(&arena, &scratch, source, &env));
+    }
+}
+
+DEFINE_TEST_G(BytecodeLayout, Eval)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    // Leaves on the right fold into the operator: VAR x, MUL_CONST, ADD_VAR y, SUB_CONST, RET
+    Bytecode code;
+    TEST(BytecodeCompile(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("x*3 + y - 3")).root, &code));
+    TEST_EQ(code.count, 5u);
+    TEST(code.code[0].op == BcOp::VAR);
+    TEST(code.code[1].op == BcOp::MUL_CONST);
+    TEST(code.code[2].op == BcOp::ADD_VAR);
+    TEST(code.code[3].op == BcOp::SUB_CONST);
+    TEST(code.code[4].op == BcOp::RET);
+    TEST_EQ(code.const_count, 1u);
+    TEST_EQ(code.var_count, 2u);
+    TEST_EQ(code.stack_size, 1u);
+    TEST_EQ(BytecodeVarSlot(&code, Str8Lit("y")), 1);
+    TEST_EQ(BytecodeVarSlot(&code, Str8Lit("w")), -1);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+
+    // Right nesting is what needs stack
+    TEST(BytecodeCompile(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("a - (b - (c - (d - e)))")).root, &code));
+    TEST_EQ(code.stack_size, 4u);
+}
+
+DEFINE_TEST_G(BytecodeDeep, Eval)
+{
+    BumpAllocator<MB(64)> arena;
+    BumpAllocator<MB(64)> scratch;
+
+    // 100k levels of x - (...), deeper than any recursive compiler survives
+    U64 depth = 100000;
+    U8 *text = arena.PushArray<U8>(depth * 6 + 1);
+    U64 size = 0;
+    for (U64 i = 0; i < depth; i += 1) { MemoryCopy(text + size, "x - (", 5); size += 5; }
+    text[size++] = '1';
+    for (U64 i = 0; i < depth; i += 1) { text[size++] = ')'; }
+    Expr *root = Parse(&arena, &scratch, Str8(text, size)).root;
+    TEST(root != nullptr);
+
+    Bytecode code;
+    TEST(BytecodeCompile(&arena, &scratch, root, &code));
+    TEST_EQ(code.stack_size, depth);
+    F64 x = 3.0;
+    F64 *stack = arena.PushArray<F64>(code.stack_size);
+    TEST_EQ(BytecodeEval(&code, &x, stack), 1.0);      // an even number of x - (x - ...) cancels out
+}
+
+DEFINE_TEST_G(BytecodeSharing, Eval)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z")};
+    F64 values[] = {2.0, 8.0, -0.5};
+    ExprEnv env = {names, values, 3};
+
+    // x + y is computed once: VAR x, ADD_VAR y, STORE, LOAD, MUL, LOAD, DIV_CONST, ADD, RET
+    Expr *root = Parse(&arena, &scratch, Str8Lit("(x + y)*(x + y) + (x + y)/2")).root;
+    Bytecode code, plain;
+    TEST(BytecodeCompile(&arena, &scratch, root, &code));
+    TEST(BytecodeCompile(&arena, &scratch, root, &plain, 0));
+    TEST_EQ(code.count, 9u);
+    TEST(code.code[2].op == BcOp::STORE);
+    TEST(code.code[3].op == BcOp::LOAD);
+    TEST_EQ(code.shared, 1u);
+    TEST_EQ(code.eliminated, 6u);           // 13 tree nodes, 7 distinct
+    TEST_EQ(code.stack_size, 3u);           // two for the stack, one temporary
+    TEST_EQ(plain.count, 10u);
+    TEST_EQ(plain.shared, 0u);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+    F64 *stack = arena.PushArray<F64>(code.stack_size);
+    F64 expected = 0.0;
+    TEST(ExprEval(&scratch, root, &env, &expected));
+    TEST_EQ(BytecodeEval(&code, values, stack), expected);
+    TEST_EQ(BytecodeEval(&plain, values, stack), expected);
+
+    // Squaring 40 times shares each level by address, the tree it stands for has
+    // 2^41 nodes so only the shared form compiles
+    Expr *x = ExprPushVar(&arena, Str8Lit("x"));
+    Expr *power = x;
+    for (U32 i = 0; i < 40; i += 1)
+    {
+        Expr *ops[] = {power, power};
+        power = ExprPushNary(&arena, ExprKind::MULTIPLY, ops, 2);
+    }
+    TEST(BytecodeCompile(&arena, &scratch, power, &code));
+    TEST(code.count < 3 * 40 + 3);
+    TEST_EQ(code.shared, 39u);
+    TEST(!BytecodeCompile(&arena, &scratch, power, &plain, 0));
+    F64 one = 1.0;
+    stack = arena.PushArray<F64>(code.stack_size);
+    TEST_EQ(BytecodeEval(&code, &one, stack), 1.0);
+
+    // Every repeat of a shared product costs a load and an add, past one per edge
+    char const *sources[] = {"x*y + ", "(x + y + 1)*"};
+    U32 repeats[] = {1001, 20};
+    for (U32 s = 0; s < 2; s += 1)
+    {
+        U64 len = Str8C(sources[s]).size;
+        U8 *text = arena.PushArrayNoZero<U8>(len * repeats[s]);
+        for (U32 i = 0; i < repeats[s]; i += 1) { MemoryCopy(text + i * len, sources[s], len); }
+        root = Parse(&arena, &scratch, Str8(text, len * repeats[s] - (s ? 1 : 3))).root;
+        TEST(root != nullptr);
+        TEST(BytecodeCompile(&arena, &scratch, root, &code));
+        TEST_EQ(code.shared, 1u);
+        TEST_EQ(scratch.ArenaGetPos(), 0u);
+        stack = arena.PushArray<F64>(code.stack_size);
+        TEST(ExprEval(&scratch, root, &env, &expected));
+        TEST_EQ(BytecodeEval(&code, values, stack), expected);
+    }
+}
+
+DEFINE_TEST_G(BytecodeBatchRoots, Eval)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z")};
+    F64 values[] = {2.0, 8.0, -0.5};
+    ExprEnv env = {names, values, 3};
+
+    // Shared within and between roots, a root that is a shared node, a leaf root and a repeat
+    char const *sources[] = {"(x + y)*z - z/(x + y)", "(x + y)/z", "x + y", "z", "(x + y)/z"};
+    Expr *roots[ArrayCount(sources)];
+    F64 expected[ArrayCount(sources)];
+    for (U32 i = 0; i < ArrayCount(sources); i += 1)
+    {
+        roots[i] = Parse(&arena, &scratch, Str8C(sources[i])).root;
+        TEST(ExprEval(&scratch, roots[i], &env, &expected[i]));
+    }
+
+    for (B32 cse = 0; cse <= 1; cse += 1)
+    {
+        Bytecode code;
+        TEST(BytecodeCompileBatch(&arena, &scratch, roots, ArrayCount(roots), &code, cse));
+        TEST_EQ(code.output_count, (U32)ArrayCount(roots));
+        TEST_EQ(code.shared, cse ? 2u : 0u);
+        F64 vars[3];
+        for (U32 slot = 0; slot < code.var_count; slot += 1)
+        {
+            for (U32 i = 0; i < 3; i += 1) { if (Str8Match(code.vars[slot], names[i])) { vars[slot] = values[i]; } }
+        }
+        F64 *stack = arena.PushArray<F64>(code.stack_size);
+        F64 out[ArrayCount(sources)] = {};
+        TEST_EQ(BytecodeEval(&code, vars, stack), expected[ArrayCount(sources) - 1]);
+        BytecodeReadOutputs(&code, stack, out);
+        TEST(memcmp(out, expected, sizeof(out)) == 0);
+
+        JitCode jit;
+        JitCompile(&scratch, &code, &jit);
+        MemoryZero(stack, sizeof(F64) * code.stack_size);
+        MemoryZero(out, sizeof(out));
+        TEST_EQ(JitEval(&jit, &code, vars, stack), expected[ArrayCount(sources) - 1]);
+        BytecodeReadOutputs(&code, stack, out);
+        TEST(memcmp(out, expected, sizeof(out)) == 0);
+        JitRelease(&jit);
+    }
+}
+
+//////////////////////
+// Batch tests
+
+DEFINE_TEST_G(BatchMatchesScalar, Eval)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    // Odd row count so both the tile tail and the lane tail run
+    U64 rows = EVAL_BATCH_TILE * 3 + 7;
+    char const *sources[] = {
+        "42", "x", "-x", "x + y", "3x(x+1)", "y/x/2", "-x*-(y+1)", "x - (y - (z - 1))",
+        "(x + y)*(y - z)/(z + x) - -(x*y*z)", "12y/2z + 7 - x/3", "(x + y)*(x + y) - (x + y)/(x*y)",
+    };
+    for (char const *source : sources)
+    {
+        U64 pos = arena.ArenaGetPos();
+        Bytecode code;
+        TEST(BytecodeCompile(&arena, &scratch, Parse(&arena, &scratch, Str8C(source)).root, &code));
+
+        F64 **columns = arena.PushArray<F64 *>(code.var_count + 1);
+        for (U32 slot = 0; slot < code.var_count; slot += 1)
+        {
+            columns[slot] = arena.PushArray<F64>(rows);
+            for (U64 row = 0; row < rows; row += 1) { columns[slot][row] = (F64)(row % 17) - 3.5 * (slot + 1); }
+        }
+        F64 *vars = arena.PushArray<F64>(code.var_count + 1);
+        F64 *stack = arena.PushArray<F64>(code.stack_size);
+        F64 *expected = arena.PushArray<F64>(rows);
+        for (U64 row = 0; row < rows; row += 1)
+        {
+            for (U32 slot = 0; slot < code.var_count; slot += 1) { vars[slot] = columns[slot][row]; }
+            expected[row] = BytecodeEval(&code, vars, stack);
+        }
+
+        void *workspace = arena.PushArray<U8>(BytecodeBatchWorkspaceSize(&code), 64);
+        F64 *out = arena.PushArray<F64>(rows);
+        for (U8 isa = (U8)EvalIsa::SCALAR; isa < (U8)EvalIsa::COUNT; isa += 1)
+        {
+            EvalIsa used = BytecodeEvalBatch(&code, columns, rows, out, workspace, (EvalIsa)isa);
+            TEST(used <= EvalBestIsa());
+            B32 same = 1;
+            for (U64 row = 0; row < rows; row += 1) { same &= out[row] == expected[row] || (out[row] != out[row] && expected[row] != expected[row]); }
+            TEST(same);
+        }
+        arena.ArenaSetPosBack(pos);
+    }
+}
+
+DEFINE_TEST_G(ColumnFileEvaluation, Eval)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(1)> scratch;
+    JobSystem *jobs = JobSystemCreate(4, MB(1));
+    char const *input_path = "test_columns_in.bin";
+    char const *output_path = "test_columns_out.bin";
+
+    // Several chunks plus a partial one, columns stored in a different order to the slots
+    U64 rows = EVAL_COLUMNS_CHUNK_ROWS * 3 + 123;
+    String8 names[] = {Str8Lit("y"), Str8Lit("unused"), Str8Lit("x")};
+    ColumnFile file;
+    TEST(ColumnFileCreate(&arena, input_path, names, 3, rows, &file));
+    for (U64 row = 0; row < rows; row += 1)
+    {
+        file.columns[0][row] = (F64)(row % 101) * 0.25;
+        file.columns[1][row] = -1.0;
+        file.columns[2][row] = (F64)(row % 7) + 0.5;
+    }
+    ColumnFileClose(&file);
+
+    Bytecode code;
+    TEST(BytecodeCompile(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("3x(x+1) - y/x")).root, &code));
+    TEST(EvalColumnFile(jobs, &arena, &code, input_path, output_path, Str8Lit("result")));
+
+    ColumnFile input, output;
+    TEST(ColumnFileOpen(&arena, input_path, &input));
+    TEST(ColumnFileOpen(&arena, output_path, &output));
+    TEST_EQ(output.rows, rows);
+    TEST_EQ(output.column_count, 1u);
+    TEST(Str8Match(output.names[0], Str8Lit("result")));
+    TEST_EQ(ColumnFileFind(&input, Str8Lit("x")), 2);
+    TEST_EQ(ColumnFileFind(&input, Str8Lit("z")), -1);
+    F64 vars[2];
+    F64 stack[4];
+    B32 same = 1;
+    for (U64 row = 0; row < rows; row += 1)
+    {
+        vars[BytecodeVarSlot(&code, Str8Lit("x"))] = input.columns[2][row];
+        vars[BytecodeVarSlot(&code, Str8Lit("y"))] = input.columns[0][row];
+        same &= output.columns[0][row] == BytecodeEval(&code, vars, stack);
+    }
+    TEST(same);
+    ColumnFileClose(&output);
+    ColumnFileClose(&input);
+
+    // Worker scratch too small for the batch workspace fails instead of leaving rows unwritten
+    JobSystem *small = JobSystemCreate(2, KB(1));
+    TEST(BytecodeBatchWorkspaceSize(&code) > KB(1));
+    TEST(!EvalColumnFile(small, &arena, &code, input_path, output_path, Str8Lit("result")));
+    JobSystemDestroy(small);
+
+    // Missing variables and files that are not column files are refused
+    TEST(BytecodeCompile(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("x + z")).root, &code));
+    TEST(!EvalColumnFile(jobs, &arena, &code, input_path, output_path, Str8Lit("result")));
+    OSMapping junk;
+    TEST(OSMapFileCreate(output_path, 100, &junk));
+    OSUnmapFile(&junk);
+    TEST(!ColumnFileOpen(&arena, output_path, &output));
+    TEST(!ColumnFileOpen(&arena, "test_columns_missing.bin", &output));
+
+    // A row count whose byte size wraps to a small stride is refused too
+    ColumnFileHeader header = {};
+    header.magic = COLUMN_FILE_MAGIC;
+    header.rows = 1ull << 61;
+    header.column_stride = 64;
+    header.data_offset = KB(4);
+    header.column_count = 1;
+    header.names_size = 2;
+    TEST(OSMapFileCreate(output_path, KB(4) + 64, &junk));
+    MemoryCopy(junk.data, &header, sizeof(header));
+    MemoryCopy(junk.data + sizeof(header), "x", 2);
+    OSUnmapFile(&junk);
+    TEST(!ColumnFileOpen(&arena, output_path, &output));
+
+    remove(input_path);
+    remove(output_path);
+    JobSystemDestroy(jobs);
+}
+
+//////////////////////
+// JIT tests
+
+// Native code against the interpreter, bit for bit, with and without AVX encodings
+internal B32 
+TestJitMatches(Arena *arena, Arena *scratch, char const *source, U32 *spills)
+{
+    Bytecode code;
+    if (!BytecodeCompile(arena, scratch, Parse(arena, scratch, Str8C(source)).root, &code)) { return 0; }
+    F64 *vars = arena->PushArray<F64>(code.var_count + 1);
+    F64 *stack = arena->PushArray<F64>(code.stack_size);
+    B32 ok = 1;
+    for (B32 avx = 0; avx <= 1; avx += 1)
+    {
+        JitCode jit;
+        if (!JitCompile(scratch, &code, &jit, avx)) { return !ARCH_X64; }
+        *spills = jit.spill_count;
+        for (U32 trial = 0; trial < 4; trial += 1)
+        {
+            for (U32 slot = 0; slot < code.var_count; slot += 1) { vars[slot] = (F64)((slot * 5 + trial * 3) % 11) - 4.0; }
+            F64 expected = BytecodeEval(&code, vars, stack);
+            F64 got = JitEval(&jit, &code, vars, stack);
+            ok &= memcmp(&expected, &got, sizeof(F64)) == 0;
+        }
+        JitRelease(&jit);
+    }
+    return ok;
+}
+
+DEFINE_TEST_G(JitEvaluation, Eval)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    U32 spills = 0;
+
+    // Includes signed zeros and infinities: -x at x = 0 and 1/(x - y) at x = y
+    char const *sources[] = {
+        "42", "x", "-x", "--x", "x + y", "3x(x+1)", "y - x - 1", "y/x/2", "y/(x/2)", "-x*-(y+1)", "1/-x", "1/(x - y)",
+        "x - (y - (z - 1))", "(x + y)*(y - z)/(z + x) - -(x*y*z)", "12y/2z + 7 - x/3", "a*b + c*d - e/f + g*h*-i",
+        "(x + y)*(x + y) - (x + y)/(x*y)",
+    };
+    for (char const *source : sources)
+    {
+        TEST(TestJitMatches(&arena, &scratch, source, &spills));
+        TEST_EQ(spills, 0u);
+    }
+
+    // Right nesting deeper than the register file spills, both sides of an op end up in memory
+    char deep[512] = {};
+    U64 size = 0;
+    for (U32 i = 0; i < 40; i += 1) { size += (U64)snprintf(deep + size, sizeof(deep) - size, "%c - -(", 'a' + i % 7); }
+    deep[size++] = '1';
+    for (U32 i = 0; i < 40; i += 1) { deep[size++] = ')'; }
+    TEST(TestJitMatches(&arena, &scratch, deep, &spills));
+    TEST(!ARCH_X64 || spills > 0);
+}
+
+DEFINE_TEST_G(JitFallback, Eval)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    Bytecode code;
+    TEST(BytecodeCompile(&arena, &scratch, Parse(&arena, &scratch, Str8Lit("x*x - 2")).root, &code));
+
+    // A JitCode that never compiled runs the interpreter
+    JitCode jit = {};
+    F64 vars[] = {3.0};
+    F64 stack[4];
+    TEST_EQ(JitEval(&jit, &code, vars, stack), 7.0);
+    JitRelease(&jit);
+}
+
+//////////////////////
+// Gradient tests
+
+internal B32 
+TestClose(F64 a, F64 b)
+{
+    F64 diff = a - b, scale = 1.0 + (a < 0 ? -a : a);
+    return (diff < 0 ? -diff : diff) <= 1e-12 * scale;
+}
+
+DEFINE_TEST_G(GradientMatchesSymbolic, Eval)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(1)> scratch;
+    String8 names[] = {Str8Lit("x"), Str8Lit("y"), Str8Lit("z")};
+    F64 values[] = {2.0, 8.0, -0.5};
+    ExprEnv env = {names, values, 3};
+
+    // Every partial derivative from one backward sweep agrees with differentiating
+    // the tree and evaluating that
+    char const *sources[] = {
+        "42", "x", "-x", "x + y", "3x(x+1)", "y/x/2", "-x*-(y+1)", "x - (y - (z - 1))",
+        "(x + y)*(y - z)/(z + x) - -(x*y*z)", "12y/2z + 7 - x/3", "(x + y)*(x + y) - (x + y)/(x*y)",
+    };
+    for (char const *source : sources)
+    {
+        U64 pos = arena.ArenaGetPos();
+        Bytecode code;
+        GradTape tape;
+        Expr *root = Parse(&arena, &scratch, Str8C(source)).root;
+        TEST(BytecodeCompile(&arena, &scratch, root, &code));
+        TEST(GradTapeFromBytecode(&arena, &scratch, &code, &tape));
+        TEST_EQ(scratch.ArenaGetPos(), 0u);
+
+        F64 vars[3] = {};
+        for (U32 slot = 0; slot < code.var_count; slot += 1)
+        {
+            for (U32 i = 0; i < 3; i += 1)
+            {
+                if (Str8Match(code.vars[slot], names[i])) { vars[slot] = values[i]; }
+            }
+        }
+        F64 grad[3] = {};
+        F64 *workspace = arena.PushArray<F64>(GradWorkspaceCount(&tape));
+        F64 *stack = arena.PushArray<F64>(code.stack_size);
+        TEST(GradEval(&tape, vars, grad, workspace) == BytecodeEval(&code, vars, stack));
+
+        ExprInterner interner;
+        TEST(ExprInternerInit(&interner, &arena, 0));
+        Expr *interned = ExprIntern(&interner, &scratch, root);
+        for (U32 slot = 0; slot < code.var_count; slot += 1)
+        {
+            Expr *derivative = ExprDifferentiate(&interner, &scratch, interned, code.vars[slot]);
+            F64 expected = 0.0;
+            TEST(derivative && ExprEval(&scratch, derivative, &env, &expected));
+            TEST(TestClose(grad[slot], expected));
+        }
+        arena.ArenaSetPosBack(pos);
+    }
+
+    // Batch code differentiates its last root only, the other roots are dropped
+    Expr *roots[] = {
+        Parse(&arena, &scratch, Str8Lit("x*y*y*z")).root,
+        Parse(&arena, &scratch, Str8Lit("x*y + x")).root,
+    };
+    Bytecode code;
+    GradTape tape;
+    TEST(BytecodeCompileBatch(&arena, &scratch, roots, 2, &code));
+    TEST(GradTapeFromBytecode(&arena, &scratch, &code, &tape));
+    TEST_EQ(BytecodeVarSlot(&code, Str8Lit("z")), 2);
+    TEST(tape.var_nodes[2] == max_U32);
+    F64 vars[3] = {2.0, 8.0, -0.5};
+    F64 grad[3] = {};
+    F64 *workspace = arena.PushArray<F64>(GradWorkspaceCount(&tape));
+    TEST(GradEval(&tape, vars, grad, workspace) == 18.0);
+    TEST(grad[0] == 9.0 && grad[1] == 2.0 && grad[2] == 0.0);
+}
+
+DEFINE_TEST_G(GradientBatch, Eval)
+{
+    BumpAllocator<MB(8)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    // Tile tail included, rows agree with one point at a time
+    U64 rows = GRAD_TILE * 3 + 5;
+    Bytecode code;
+    GradTape tape;
+    Expr *root = Parse(&arena, &scratch, Str8Lit("(x + y)*(x + y)/(z*z + 1) - x*y*z + 3/(x*x + 1)")).root;
+    TEST(BytecodeCompile(&arena, &scratch, root, &code));
+    TEST(GradTapeFromBytecode(&arena, &scratch, &code, &tape));
+
+    F64 *columns[3];
+    F64 *grads[3];
+    for (U32 slot = 0; slot < 3; slot += 1)
+    {
+        columns[slot] = arena.PushArray<F64>(rows);
+        grads[slot] = arena.PushArray<F64>(rows);
+        for (U64 row = 0; row < rows; row += 1) { columns[slot][row] = (F64)(row % 13) * 0.25 - 1.5 * (slot + 1); }
+    }
+    F64 *out = arena.PushArray<F64>(rows);
+    F64 *workspace = arena.PushArray<F64>(GradBatchWorkspaceCount(&tape));
+    GradEvalBatch(&tape, columns, rows, out, grads, workspace);
+
+    F64 *point = arena.PushArray<F64>(GradWorkspaceCount(&tape));
+    B32 same = 1;
+    for (U64 row = 0; row < rows; row += 1)
+    {
+        F64 vars[3] = {columns[0][row], columns[1][row], columns[2][row]};
+        F64 grad[3];
+        same &= TestClose(out[row], GradEval(&tape, vars, grad, point));
+        for (U32 slot = 0; slot < 3; slot += 1) { same &= TestClose(grads[slot][row], grad[slot]); }
+    }
+    TEST(same);
+}
@@ -0,0 +1,230 @@
+//////////////////////
+// Integer tests
+
+internal B32 
+TestIntIs(Arena *arena, Arena *scratch, Integer value, char const *expected)
+{
+    return Str8Match(IntToStr8(arena, scratch, value), Str8C(expected));
+}
+
+// Deterministic limbs for operands, never a zero top limb
+internal void 
+TestFillLimbs(U64 *limbs, U64 count, U64 seed)
+{
+    for (U64 i = 0; i < count; i += 1) { limbs[i] = HashU64(seed * 1000003 + i); }
+    limbs[count - 1] |= 1;
+}
+
+internal Integer 
+TestBigInt(Arena *arena, U64 count, U64 seed, B32 neg)
+{
+    U64 *limbs = arena->PushArray<U64>(count);
+    TestFillLimbs(limbs, count, seed);
+    Integer result;
+    IntFromMag(arena, arena->ArenaGetPos(), limbs, count, neg, &result);
+    return result;
+}
+
+DEFINE_TEST_G(IntegerSmallAndPromotion, Number)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    Integer max = IntFromS64(std::numeric_limits<S64>::max());
+    Integer min = IntFromS64(std::numeric_limits<S64>::min());
+    Integer r;
+
+    // Small values never touch the arena
+    TEST(IntAdd(&arena, IntFromS64(40), IntFromS64(2), &r) && IntIsSmall(r) && r.small == 42);
+    TEST(IntMul(&arena, IntFromS64(-6), IntFromS64(7), &r) && IntIsSmall(r) && r.small == -42);
+    TEST_EQ(arena.ArenaGetPos(), 0u);
+
+    // Overflow promotes, coming back in range demotes
+    TEST(IntAdd(&arena, max, IntFromS64(1), &r) && !IntIsSmall(r));
+    TEST(TestIntIs(&arena, &scratch, r, "9223372036854775808"));
+    TEST(IntSub(&arena, r, IntFromS64(1), &r) && IntIsSmall(r) && IntCompare(r, max) == 0);
+    TEST(IntNegate(&arena, min, &r) && !IntIsSmall(r) && IntSign(r) == 1);
+    TEST(IntNegate(&arena, r, &r) && IntIsSmall(r) && IntCompare(r, min) == 0);
+    TEST(IntSub(&arena, min, IntFromS64(1), &r) && TestIntIs(&arena, &scratch, r, "-9223372036854775809"));
+    TEST(IntCompare(r, min) < 0 && IntCompare(min, r) > 0 && IntCompare(r, max) < 0);
+    TEST(IntMul(&arena, max, max, &r) && TestIntIs(&arena, &scratch, r, "85070591730234615847396907784232501249"));
+
+    // 50! = 30414093201713378043612608166064768844377641568960512000000000000
+    Integer f = IntFromS64(1);
+    for (S64 i = 2; i <= 50; i += 1) { TEST(IntMul(&arena, f, IntFromS64(i), &f)); }
+    TEST(TestIntIs(&arena, &scratch, f, "30414093201713378043612608166064768844377641568960512000000000000"));
+    for (S64 i = 50; i >= 2; i -= 1)
+    {
+        Integer rem;
+        TEST(IntDivMod(&arena, &scratch, f, IntFromS64(i), &f, &rem) && IntSign(rem) == 0);
+    }
+    TEST(IntIsSmall(f) && f.small == 1);
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(IntegerDivision, Number)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(4)> scratch;
+    Integer q, r;
+
+    // Truncating, remainder follows the dividend
+    TEST(IntDivMod(&arena, &scratch, IntFromS64(-7), IntFromS64(2), &q, &r) && q.small == -3 && r.small == -1);
+    TEST(IntDivMod(&arena, &scratch, IntFromS64(7), IntFromS64(-2), &q, &r) && q.small == -3 && r.small == 1);
+    TEST(!IntDivMod(&arena, &scratch, IntFromS64(7), IntFromS64(0), &q, &r));
+    TEST(IntDivMod(&arena, &scratch, IntFromS64(std::numeric_limits<S64>::min()), IntFromS64(-1), &q, &r));
+    TEST(TestIntIs(&arena, &scratch, q, "9223372036854775808") && r.small == 0);
+
+    // (a b + c) / b gives back a and c when c has the product's sign, over sizes that hit the one-limb path,
+    // the qhat corrections and the add-back
+    for (U64 a_count = 1; a_count < 12; a_count += 1)
+    {
+        for (U64 b_count = 1; b_count < 6; b_count += 1)
+        {
+            Integer a = TestBigInt(&arena, a_count, a_count * 31 + b_count, a_count & 1);
+            U64 *b_limbs = arena.PushArray<U64>(b_count);
+            U64 *c_limbs = arena.PushArray<U64>(b_count);
+            TestFillLimbs(b_limbs, b_count, b_count * 17 + a_count);
+            TestFillLimbs(c_limbs, b_count, b_count * 7 + a_count * 3);
+            c_limbs[b_count - 1] = b_limbs[b_count - 1] / 2;
+            Integer b, c;
+            TEST(IntFromMag(&arena, arena.ArenaGetPos(), b_limbs, b_count, b_count & 2, &b));
+            TEST(IntFromMag(&arena, arena.ArenaGetPos(), c_limbs, b_count, (a_count & 1) != (b_count & 2) / 2, &c));
+            Integer n;
+            TEST(IntMul(&arena, a, b, &n) && IntAdd(&arena, n, c, &n));
+            TEST(IntDivMod(&arena, &scratch, n, b, &q, &r));
+            TEST(IntCompare(q, a) == 0 && IntCompare(r, c) == 0);
+        }
+    }
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(IntegerKaratsuba, Number)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(4)> scratch;
+    U64 sizes[][2] = {{32, 32}, {100, 70}, {257, 129}, {300, 40}, {64, 33}};
+    for (auto const &size : sizes)
+    {
+        U64 *a = arena.PushArray<U64>(size[0]);
+        U64 *b = arena.PushArray<U64>(size[1]);
+        U64 *fast = arena.PushArray<U64>(size[0] + size[1]);
+        U64 *slow = arena.PushArray<U64>(size[0] + size[1]);
+        TestFillLimbs(a, size[0], size[0]);
+        TestFillLimbs(b, size[1], size[1] + 1);
+        TEST(BigMagMul(&scratch, fast, a, size[0], b, size[1]));
+        BigMagMulSchoolbook(slow, a, size[0], b, size[1]);
+        TEST(memcmp(fast, slow, sizeof(U64) * (size[0] + size[1])) == 0);
+
+        // All ones, every carry goes the full length
+        memset(a, 0xFF, sizeof(U64) * size[0]);
+        memset(b, 0xFF, sizeof(U64) * size[1]);
+        TEST(BigMagMul(&scratch, fast, a, size[0], b, size[1]));
+        BigMagMulSchoolbook(slow, a, size[0], b, size[1]);
+        TEST(memcmp(fast, slow, sizeof(U64) * (size[0] + size[1])) == 0);
+        TEST_EQ(scratch.ArenaGetPos(), 0u);
+    }
+}
+
+DEFINE_TEST_G(IntegerGcd, Number)
+{
+    BumpAllocator<MB(4)> arena;
+    BumpAllocator<MB(4)> scratch;
+    Integer g;
+    TEST(IntGcd(&arena, &scratch, IntFromS64(0), IntFromS64(0), &g) && g.small == 0);
+    TEST(IntGcd(&arena, &scratch, IntFromS64(-12), IntFromS64(18), &g) && g.small == 6);
+    TEST(IntGcd(&arena, &scratch, IntFromS64(std::numeric_limits<S64>::min()), IntFromS64(0), &g));
+    TEST(TestIntIs(&arena, &scratch, g, "9223372036854775808"));
+
+    // Consecutive Fibonacci numbers are coprime and the worst case for Euclid
+    Integer f0 = IntFromS64(0), f1 = IntFromS64(1);
+    for (U32 i = 0; i < 2000; i += 1)
+    {
+        Integer next;
+        TEST(IntAdd(&arena, f0, f1, &next));
+        f0 = f1;
+        f1 = next;
+    }
+    TEST(IntGcd(&arena, &scratch, f0, f1, &g) && IntIsSmall(g) && g.small == 1);
+
+    // gcd(a g, b g) against a plain Euclid loop, a and b share factors of their own
+    Integer common = TestBigInt(&arena, 5, 99, 0);
+    for (U64 seed = 1; seed < 20; seed += 1)
+    {
+        Integer a, b;
+        TEST(IntMul(&arena, TestBigInt(&arena, 3 + seed % 7, seed, seed & 1), common, &a));
+        TEST(IntMul(&arena, TestBigInt(&arena, 2 + seed % 5, seed + 50, 0), common, &b));
+        TEST(IntGcd(&arena, &scratch, a, b, &g));
+        Integer x = a, y = b;
+        if (IntSign(x) < 0) { TEST(IntNegate(&arena, x, &x)); }
+        while (IntSign(y) != 0)
+        {
+            Integer r;
+            TEST(IntDivMod(&arena, &scratch, x, y, nullptr, &r));
+            x = y;
+            y = r;
+        }
+        TEST(IntCompare(g, x) == 0);
+    }
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(IntegerText, Number)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    char const *texts[] = {
+        "0", "-1", "9223372036854775807", "-9223372036854775808", "18446744073709551616",
+        "-123456789012345678901234567890123456789012345678901234567890",
+        "10000000000000000000000000000000000000",
+    };
+    for (char const *text : texts)
+    {
+        Integer value;
+        TEST(IntFromStr8(&arena, Str8C(text), &value) && TestIntIs(&arena, &scratch, value, text));
+    }
+    Integer value;
+    TEST(IntFromStr8(&arena, Str8Lit("-0"), &value) && IntIsSmall(value) && value.small == 0);
+    TEST(IntFromStr8(&arena, Str8Lit("0009"), &value) && value.small == 9);
+    TEST(!IntFromStr8(&arena, Str8Lit("12a"), &value));
+    TEST(!IntFromStr8(&arena, Str8Lit("-"), &value));
+    TEST(!IntFromStr8(&arena, Str8Lit(""), &value));
+}
+
+//////////////////////
+// Rational tests
+
+DEFINE_TEST_G(RationalArithmetic, Number)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+    Rational third, sixth, r;
+    TEST(RatFromFraction(&arena, &scratch, IntFromS64(2), IntFromS64(6), &third));
+    TEST(RatFromFraction(&arena, &scratch, IntFromS64(-1), IntFromS64(-6), &sixth));
+    TEST(Str8Match(RatToStr8(&arena, &scratch, third), Str8Lit("1/3")));
+    TEST(RatAdd(&arena, &scratch, third, sixth, &r) && Str8Match(RatToStr8(&arena, &scratch, r), Str8Lit("1/2")));
+    TEST(RatSub(&arena, &scratch, sixth, third, &r) && Str8Match(RatToStr8(&arena, &scratch, r), Str8Lit("-1/6")));
+    TEST(RatMul(&arena, &scratch, third, RatFromInt(IntFromS64(3)), &r) && RatIsInteger(r) && r.num.small == 1);
+    TEST(RatDiv(&arena, &scratch, sixth, third, &r) && Str8Match(RatToStr8(&arena, &scratch, r), Str8Lit("1/2")));
+    TEST(!RatDiv(&arena, &scratch, third, RatFromInt(IntFromS64(0)), &r));
+    TEST(!RatFromFraction(&arena, &scratch, IntFromS64(1), IntFromS64(0), &r));
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+
+    // Exact evaluation keeps quotients and large products
+    struct { char const *source; char const *expected; } cases[] = {
+        {"1/3 + 1/6", "1/2"},
+        {"7/2/7 - 1/2", "0"},
+        {"-(2/4)*6", "-3"},
+        {"9223372036854775807*9223372036854775807/3", "85070591730234615847396907784232501249/3"},
+        {"9223372036854775807*9223372036854775807*2/4", "85070591730234615847396907784232501249/2"},
+    };
+    for (auto const &c : cases)
+    {
+        Expr *root = Parse(&arena, &scratch, Str8C(c.source)).root;
+        TEST(root && ExprEvalExact(&arena, &scratch, root, &r));
+        TEST(Str8Match(RatToStr8(&arena, &scratch, r), Str8C(c.expected)));
+    }
+    Expr *root = Parse(&arena, &scratch, Str8Lit("x + 1")).root;
+    TEST(!ExprEvalExact(&arena, &scratch, root, &r));
+    root = Parse(&arena, &scratch, Str8Lit("1/(2 - 2)")).root;
+    TEST(!ExprEvalExact(&arena, &scratch, root, &r));
+}
@@ -0,0 +1,353 @@
+//////////////////////
+// Parser tests
+
+internal ParseResult 
+TestParse(Arena *arena, Arena *scratch, char const *source, U64 max_depth = 0)
+{
+    ParseParams params = {max_depth};
+    return Parse(arena, scratch, Str8C(source), &params);
+}
+
+DEFINE_TEST_G(ParseFlattensSums, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    Expr *root = TestParse(&arena, &scratch, "a + b + c + d").root;
+    TEST(root != nullptr);
+    TEST(root->kind == ExprKind::PLUS);
+    TEST_EQ(root->count, 4u);
+    TEST(Str8Match(root->operands[3]->var, Str8Lit("d")));
+
+    // Parentheses on the left flatten too, on the right they stay nested
+    root = TestParse(&arena, &scratch, "(a*b)*c*(d*e)").root;
+    TEST(root->kind == ExprKind::MULTIPLY);
+    TEST_EQ(root->count, 4u);
+    TEST(root->operands[3]->kind == ExprKind::MULTIPLY);
+}
+
+DEFINE_TEST_G(ParseImplicitMultiplication, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    Expr *root = TestParse(&arena, &scratch, "3x(x+1)").root;
+    TEST(root != nullptr);
+    TEST(root->kind == ExprKind::MULTIPLY);
+    TEST_EQ(root->count, 3u);
+    TEST_EQ(root->operands[0]->num, 3);
+    TEST(root->operands[1]->kind == ExprKind::VAR);
+    TEST(root->operands[2]->kind == ExprKind::PLUS);
+
+    // Implicit multiplication binds tighter than '/'
+    root = TestParse(&arena, &scratch, "a/2x").root;
+    TEST(root->kind == ExprKind::QUOTIENT);
+    TEST(root->bin.right->kind == ExprKind::MULTIPLY);
+
+    // Multi letter runs are one symbol, and a number after a symbol is not multiplied
+    root = TestParse(&arena, &scratch, "xy").root;
+    TEST(Str8Match(root->var, Str8Lit("xy")));
+    ParseResult res = TestParse(&arena, &scratch, "x2");
+    TEST(res.error.code == ParseErrorCode::UNEXPECTED_TOKEN);
+    TEST_EQ(res.error.offset, 1u);
+}
+
+DEFINE_TEST_G(ParseBigNumbers, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    // Literals past S64 promote to exact integers instead of failing
+    Expr *root = TestParse(&arena, &scratch, "9223372036854775807").root;
+    TEST(root != nullptr);
+    TEST(root->kind == ExprKind::NUM);
+    root = TestParse(&arena, &scratch, "9223372036854775808").root;
+    TEST(root != nullptr);
+    TEST(root->kind == ExprKind::BIG_NUM);
+    TEST(Str8Match(ExprPrint(&arena, &scratch, root), Str8Lit("9223372036854775808")));
+
+    root = TestParse(&arena, &scratch, "99999999999999999999999999999x + 1").root;
+    TEST(root != nullptr);
+    TEST(root->operands[0]->operands[0]->kind == ExprKind::BIG_NUM);
+    TEST(Str8Match(ExprPrint(&arena, &scratch, root), Str8Lit("99999999999999999999999999999*x + 1")));
+}
+
+DEFINE_TEST_G(ParsePrecedence, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    Expr *root = TestParse(&arena, &scratch, "a - b * c").root;
+    TEST(root->kind == ExprKind::DIFFERENCE);
+    TEST(root->bin.right->kind == ExprKind::MULTIPLY);
+
+    // Left associative
+    root = TestParse(&arena, &scratch, "a - b - c").root;
+    TEST(root->kind == ExprKind::DIFFERENCE);
+    TEST(root->bin.left->kind == ExprKind::DIFFERENCE);
+    TEST(root->bin.right->kind == ExprKind::VAR);
+
+    // Unary minus binds tightest, -2x is (-2)*x
+    root = TestParse(&arena, &scratch, "-2x").root;
+    TEST(root->kind == ExprKind::MULTIPLY);
+    TEST(root->operands[0]->kind == ExprKind::PRE_UNARY_MINUS);
+    TEST_EQ(root->operands[0]->operand->num, 2);
+
+    root = TestParse(&arena, &scratch, "a*-b").root;
+    TEST(root->kind == ExprKind::MULTIPLY);
+    TEST(root->operands[1]->kind == ExprKind::PRE_UNARY_MINUS);
+}
+
+DEFINE_TEST_G(ParseDeepNesting, Parse)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(64)> scratch;
+    U64 depth = Thousand(200);
+
+    char *source = arena.PushArray<char>(depth * 2 + 2);
+    for (U64 i = 0; i < depth; i += 1) { source[i] = '('; source[depth + 1 + i] = ')'; }
+    source[depth] = 'x';
+    Expr *root = TestParse(&arena, &scratch, source).root;
+    TEST(root != nullptr);
+    TEST(root->kind == ExprKind::VAR);
+
+    char *minus = arena.PushArray<char>(depth + 2);
+    for (U64 i = 0; i < depth; i += 1) { minus[i] = '-'; }
+    minus[depth] = 'x';
+    root = TestParse(&arena, &scratch, minus).root;
+    U64 negs = 0;
+    for (Expr *e = root; e && e->kind == ExprKind::PRE_UNARY_MINUS; e = e->operand) { negs += 1; }
+    TEST_EQ(negs, depth);
+
+    ParseResult res = TestParse(&arena, &scratch, "((((((x))))))", 5);
+    TEST(res.root == nullptr);
+    TEST(res.error.code == ParseErrorCode::TOO_DEEP);
+    TEST_EQ(res.error.offset, 5u);
+}
+
+DEFINE_TEST_G(ParseLongSum, Parse)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(16)> scratch;
+    U64 terms = Thousand(100);
+
+    char *source = arena.PushArray<char>(terms * 2 + 1);
+    for (U64 i = 0; i < terms; i += 1) { source[i*2] = 'x'; source[i*2 + 1] = '+'; }
+    source[terms*2 - 1] = 0;
+
+    Expr *root = TestParse(&arena, &scratch, source).root;
+    TEST(root != nullptr);
+    TEST(root->kind == ExprKind::PLUS);
+    TEST_EQ(root->count, terms);
+
+    // Scratch stacks are given back once parsing finishes
+    TEST_EQ(scratch.ArenaGetPos(), 0u);
+}
+
+DEFINE_TEST_G(ParseErrors, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    struct { char const *source; ParseErrorCode code; U64 offset; } cases[] = {
+        {"",                      ParseErrorCode::EXPECTED_OPERAND,  0},
+        {"1 +",                   ParseErrorCode::EXPECTED_OPERAND,  3},
+        {"(a + b",                ParseErrorCode::MISSING_RPAREN,    6},
+        {"a + b)",                ParseErrorCode::UNMATCHED_RPAREN,  5},
+        {"(a)(b)",                ParseErrorCode::UNEXPECTED_TOKEN,  3},
+        {"a # b",                 ParseErrorCode::ILLEGAL_CHARACTER, 2},
+    };
+    for (auto &c : cases)
+    {
+        ParseResult res = TestParse(&arena, &scratch, c.source);
+        TEST(res.root == nullptr);
+        TEST(res.error.code == c.code);
+        TEST_EQ(res.error.offset, c.offset);
+    }
+
+    // '$' still terminates input like the old lexer
+    TEST(TestParse(&arena, &scratch, "a+b$ junk").root != nullptr);
+}
+
+//////////////////////
+// Parallel parse tests
+
+internal B32 
+TestParallelMatchesSerial(JobSystem *jobs, Arena **worker_arenas, Arena *arena, Arena *scratch, String8 source, U32 max_depth = 0)
+{
+    ParseParallelParams params = {};
+    params.min_bytes = 1;
+    params.job_bytes = 8;
+    params.parse.max_depth = max_depth;
+    ParseResult serial = Parse(arena, scratch, source, &params.parse);
+    ParseResult parallel = ParseParallel(jobs, arena, worker_arenas, source, &params);
+    if (serial.error.code != parallel.error.code || serial.error.offset != parallel.error.offset) { return 0; }
+    return serial.root == nullptr || ExprMatch(scratch, serial.root, parallel.root);
+}
+
+DEFINE_TEST_G(ParseSplitScan, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    U64 *splits;
+    U64 count;
+
+    // Only binary operators outside parentheses, also past the 16 byte SIMD blocks
+    String8 source = Str8Lit("-a + (b - c)*-d - 2x(y+z) + (((((((((((((((((((q))))))))))))))))))) - w");
+    TEST(ParseSplitTopLevel(&arena, source, &splits, &count));
+    TEST_EQ(count, 4u);
+    TEST_EQ(source.str[splits[0]], '+');
+    TEST_EQ(splits[0], 3u);
+    TEST_EQ(source.str[splits[1]], '-');
+    TEST_EQ(source.str[splits[3]], '-');
+    TEST_EQ(splits[3], source.size - 3);
+
+    TEST_FAIL(ParseSplitTopLevel(&arena, Str8Lit("a + b) + (c"), &splits, &count));
+}
+
+DEFINE_TEST_G(ParseParallelMatchesSerial, Parse)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(16)> scratch;
+    JobSystem *jobs = JobSystemCreate(4, MB(4));
+    Arena *worker_arenas[4];
+    for (U32 i = 0; i < 4; i += 1) { worker_arenas[i] = new Arena(MB(8)); }
+
+    char const *sources[] = {
+        "a + b + c - d + e + f",
+        "(a + b) + c - (d + e) + f",
+        "-x + y - -z + 3x(x+1) - 12y/2z + (a+b)*c",
+        "x*y + z - w$ - ignored",
+        "a + (b",           // errors come from the serial parser
+        "a + * b",
+        "a + b) + c",
+    };
+    for (char const *source : sources)
+    {
+        TEST(TestParallelMatchesSerial(jobs, worker_arenas, &arena, &scratch, Str8C(source)));
+    }
+
+    // Depth limits hold the same, down to 1
+    for (U32 depth = 1; depth <= 7; depth += 1)
+    {
+        TEST(TestParallelMatchesSerial(jobs, worker_arenas, &arena, &scratch, Str8Lit("a + ((((b))))"), depth));
+        TEST(TestParallelMatchesSerial(jobs, worker_arenas, &arena, &scratch, Str8Lit("(a) - (b) + -c"), depth));
+    }
+
+    // A few thousand terms so every worker gets several jobs
+    U64 terms = 5000;
+    char const *pieces[] = {"3x(x+1)", " + ", "(a+b)", " - ", "-y/2z", " + ", "7", " + "};
+    U8 *text = arena.PushArray<U8>(terms * 8);
+    U64 size = 0;
+    for (U64 i = 0; i < terms; i += 1)
+    {
+        char const *piece = pieces[i % ArrayCount(pieces)];
+        MemoryCopy(text + size, piece, std::strlen(piece));
+        size += std::strlen(piece);
+    }
+    size -= 3; // drop the trailing operator
+    TEST(TestParallelMatchesSerial(jobs, worker_arenas, &arena, &scratch, Str8(text, size)));
+
+    for (U32 i = 0; i < 4; i += 1) { delete worker_arenas[i]; }
+    JobSystemDestroy(jobs);
+}
+
+DEFINE_TEST_G(ParseBatchMatchesSerial, Parse)
+{
+    BumpAllocator<MB(16)> arena;
+    BumpAllocator<MB(16)> scratch;
+    JobSystem *jobs = JobSystemCreate(4, MB(4));
+    Arena *worker_arenas[4];
+    for (U32 i = 0; i < 4; i += 1) { worker_arenas[i] = new Arena(MB(8)); }
+
+    char const *pieces[] = {"a + b + c", "3x(x+1) - y/2z", "a + (b", "-(-x)", "a + * b", "12", "a + b) + c"};
+    U64 count = 20000;
+    String8 *sources = arena.PushArray<String8>(count);
+    for (U64 i = 0; i < count; i += 1) { sources[i] = Str8C(pieces[i % ArrayCount(pieces)]); }
+
+    ParseBatchResult batch = ParseBatch(jobs, &arena, worker_arenas, sources, count);
+    TEST_EQ(batch.count, count);
+    U64 errors = 0;
+    B32 match = 1;
+    for (U64 i = 0; i < count; i += 1)
+    {
+        ParseResult serial = Parse(&arena, &scratch, sources[i]);
+        match &= serial.error.code == batch.errors[i].code && serial.error.offset == batch.errors[i].offset;
+        match &= serial.root ? ExprMatch(&scratch, serial.root, batch.roots[i]) : batch.roots[i] == nullptr;
+        errors += serial.error.code != ParseErrorCode::NONE;
+    }
+    TEST(match);
+    TEST_EQ(batch.error_count, errors);
+
+    batch = ParseBatch(jobs, &arena, worker_arenas, sources, 0);
+    TEST_EQ(batch.count, 0u);
+
+    for (U32 i = 0; i < 4; i += 1) { delete worker_arenas[i]; }
+    JobSystemDestroy(jobs);
+}
+
+DEFINE_TEST_G(ParseErrorFormatting, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    String8 source = Str8Lit("a + (b");
+    ParseResult res = Parse(&arena, &scratch, source);
+    String8 text = ParseErrorFormat(&arena, source, res.error);
+    TEST(Str8Match(text, Str8Lit("offset 6: missing ')'\na + (b\n      ^")));
+
+    // Only the line holding the offset is echoed
+    source = Str8Lit("a +\n\tb $");
+    ParseError error = {ParseErrorCode::ILLEGAL_CHARACTER, 6};
+    text = ParseErrorFormat(&arena, source, error);
+    TEST(Str8Match(text, Str8Lit("offset 6: illegal character\n\tb $\n\t ^")));
+}
+
+//////////////////////
+// Compile-time parsing
+
+// The type tree against Parse on the same text, both the Expr it builds and its value
+template <StaticString S>
+internal B32 
+TestStaticMatches(Arena *arena, Arena *scratch)
+{
+    using E = StaticExpr<S>;
+    Expr *parsed = Parse(arena, scratch, Str8C(S.chars)).root;
+    Expr *built = E::ToExpr(arena);
+    if (!parsed || !built || !ExprMatch(scratch, parsed, built)) { return 0; }
+
+    String8 names[E::var_count + 1];
+    F64 values[E::var_count + 1];
+    for (U32 slot = 0; slot < E::var_count; slot += 1)
+    {
+        names[slot] = E::VarName(slot);
+        values[slot] = 1.5 + slot * 2.0;
+    }
+    ExprEnv env = {names, values, E::var_count};
+    F64 expected = 0.0;
+    return ExprEval(scratch, parsed, &env, &expected) && E::Eval(values) == expected;
+}
+
+DEFINE_TEST_G(StaticParse, Parse)
+{
+    BumpAllocator<MB(1)> arena;
+    BumpAllocator<MB(1)> scratch;
+
+    TEST(TestStaticMatches<"42">(&arena, &scratch));
+    TEST(TestStaticMatches<"3x(x+1)">(&arena, &scratch));
+    TEST(TestStaticMatches<"a + b + c - d">(&arena, &scratch));
+    TEST(TestStaticMatches<"(a + b) + c">(&arena, &scratch));
+    TEST(TestStaticMatches<"a + (b + c)">(&arena, &scratch));
+    TEST(TestStaticMatches<"a/2x + 12y(z - 1)">(&arena, &scratch));
+    TEST(TestStaticMatches<"--x * -(y - -z) / 7">(&arena, &scratch));
+    TEST(TestStaticMatches<" ( (x) ) $ ignored">(&arena, &scratch));
+    TEST(TestStaticMatches<"alpha*beta*alpha - 9223372036854775807">(&arena, &scratch));
+
+    // Slots in order of first appearance, looked up at compile time
+    auto f = DSP_EXPR("3x(x+1) - y");
+    static_assert(f.var_count == 2, "x and y");
+    static_assert(f.VarSlot("y") == 1 && f.VarSlot("x") == 0 && f.VarSlot("z") == -1, "slots");
+    F64 vars[f.var_count];
+    vars[f.VarSlot("x")] = 2.0;
+    vars[f.VarSlot("y")] = 1.0;
+    TEST_EQ(f(vars), 17.0);
+}
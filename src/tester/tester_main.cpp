@@ -2,15 +2,27 @@
 // Headers
 #include "simpletest.h"
 #include "base_inc.hpp"
+#include "ast/ast_inc.hpp"
+#include "job/job_inc.hpp"
+#include "parse/parse_inc.hpp"
+#include "eval/eval_inc.hpp"
 
 //////////////////////
 // Implementations
 #include "simpletest.cpp"
 #include "base_inc.cpp"
+#include "ast/ast_inc.cpp"
+#include "job/job_inc.cpp"
+#include "parse/parse_inc.cpp"
+#include "eval/eval_inc.cpp"
 
 
 char const *groups[] = {
     "Bump",
+    "Ast",
+    "Parse",
+    "Eval",
+    "Number",
 };
 
 // Test basic arena construction and destruction
@@ -298,6 +310,13 @@ DEFINE_TEST_G(ArenaLargeAllocation, Bump)
     }
 }
 
+//////////////////////
+// Layer tests
+#include "test_ast.cpp"
+#include "test_parse.cpp"
+#include "test_eval.cpp"
+#include "test_number.cpp"
+
 int main(void) 
 {
     bool pass = true;